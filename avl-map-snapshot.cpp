@@ -0,0 +1,203 @@
+/**
+ * @file avl-map-snapshot.cpp
+ * @brief This implements the snapshot file format with standard file streams. The writer builds the entries as nodes
+ *        in a buffer and writes them a batch at a time, the reader checks the header and reads the entries back
+ *        in one call into storage laid out like the file.
+ */
+
+#include "avl-map-snapshot.h"
+
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <new>
+#include <stdexcept>
+
+/**
+ * @brief Writes a snapshot file: the header, then the entries in order, built as nodes in a buffer and
+ *        written a batch at a time. The file is written under a temporary name and renamed over path at the end.
+ *
+ * @param path - file to write
+ * @param first - first element of a forward range sorted by key with distinct keys (pairs, or nodes with Key() and Value())
+ * @param last - end of the range
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE >
+template< typename ITER >
+void CS280::AVLmap_snapshot<KEY_TYPE,VALUE_TYPE>::write(std::string const& path, ITER first, ITER last)
+{
+    std::string temporary = path + ".tmp";
+    std::ofstream out(temporary, std::ios::binary | std::ios::trunc);
+
+    if(!out)
+        throw std::runtime_error("can't write " + temporary);
+
+    FileHeader header;
+    std::memset(&header, 0, sizeof(header));
+    std::memcpy(header.magic, MAGIC, sizeof(MAGIC));
+    header.version = VERSION;
+    header.byteOrder = ENDIAN_MARK;
+    header.count = static_cast<std::uint64_t>(std::distance(first, last));
+    header.entriesOffset = ENTRIES_OFFSET;
+    header.keySize = sizeof(KEY_TYPE);
+    header.valueSize = sizeof(VALUE_TYPE);
+    header.nodeSize = sizeof(Node);
+    header.nodeAlign = alignof(Node);
+
+    char padding[ENTRIES_OFFSET] = {};
+    out.write(reinterpret_cast<char const*>(&header), sizeof(header));
+    out.write(padding, ENTRIES_OFFSET - sizeof(header));
+
+    // Zeroed once, so the padding inside the nodes is written as zeros
+    std::vector<char> buffer(WRITE_BATCH * sizeof(Node));
+
+    while(first != last && out)
+    {
+        std::size_t used = 0;
+
+        for(; first != last && used < WRITE_BATCH; ++first, ++used)
+        {
+            ::new(static_cast<void*>(buffer.data() + used * sizeof(Node))) Node(ElementKey(*first), ElementValue(*first));
+        }
+
+        out.write(buffer.data(), static_cast<std::streamsize>(used * sizeof(Node)));
+    }
+
+    out.close();
+
+    if(!out || std::rename(temporary.c_str(), path.c_str()) != 0)
+    {
+        std::remove(temporary.c_str());
+        throw std::runtime_error("can't write " + path);
+    }
+}
+
+/**
+ * @brief Reads a snapshot file with file streams. The header is checked against this type, then the entries
+ *        are read in one call; the storage holds them exactly as a mapping of the file would.
+ *
+ * @param path - file written by write
+ * @return storage for the entries, one element per entry
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE >
+std::vector<typename CS280::AVLmap_snapshot<KEY_TYPE,VALUE_TYPE>::NodeStorage> CS280::AVLmap_snapshot<KEY_TYPE,VALUE_TYPE>::read(std::string const& path)
+{
+    std::ifstream in(path, std::ios::binary | std::ios::ate);
+
+    if(!in)
+        throw std::runtime_error("can't open " + path);
+
+    std::streamoff length = in.tellg();
+    FileHeader header;
+
+    in.seekg(0);
+
+    if(length < static_cast<std::streamoff>(sizeof(FileHeader)) ||
+       !in.read(reinterpret_cast<char*>(&header), sizeof(header)) ||
+       !valid(header, static_cast<std::size_t>(length)))
+    {
+        throw std::runtime_error(path + " is not a snapshot of this map type");
+    }
+
+    std::vector<NodeStorage> entries(static_cast<std::size_t>(header.count));
+
+    in.seekg(static_cast<std::streamoff>(header.entriesOffset));
+
+    if(!in.read(reinterpret_cast<char*>(entries.data()), static_cast<std::streamsize>(entries.size() * sizeof(Node))))
+        throw std::runtime_error("can't read " + path);
+
+    return entries;
+}
+
+/**
+ * @brief Checks a header read from a file against this type and against the file's length
+ *
+ * @param header - first bytes of the file
+ * @param length - length of the file
+ * @return whether the file holds header.count entries of this type
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE >
+bool CS280::AVLmap_snapshot<KEY_TYPE,VALUE_TYPE>::valid(FileHeader const& header, std::size_t length)
+{
+    return std::memcmp(header.magic, MAGIC, sizeof(MAGIC)) == 0 &&
+           header.version == VERSION &&
+           header.byteOrder == ENDIAN_MARK &&
+           header.keySize == sizeof(KEY_TYPE) &&
+           header.valueSize == sizeof(VALUE_TYPE) &&
+           header.nodeSize == sizeof(Node) &&
+           header.nodeAlign == alignof(Node) &&
+           header.entriesOffset >= sizeof(FileHeader) &&
+           header.entriesOffset % alignof(Node) == 0 &&
+           header.entriesOffset <= length &&
+           header.count <= (length - header.entriesOffset) / sizeof(Node);
+}
+
+/**
+ * @brief Returns the key of a pair in a written range
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE >
+template< typename FIRST, typename SECOND >
+FIRST const& CS280::AVLmap_snapshot<KEY_TYPE,VALUE_TYPE>::ElementKey(std::pair<FIRST, SECOND> const& item)
+{
+    return item.first;
+}
+
+/**
+ * @brief Returns the key of a node in a written range
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE >
+template< typename NODE >
+auto CS280::AVLmap_snapshot<KEY_TYPE,VALUE_TYPE>::ElementKey(NODE const& node) -> decltype(node.Key())
+{
+    return node.Key();
+}
+
+/**
+ * @brief Returns the value of a pair in a written range
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE >
+template< typename FIRST, typename SECOND >
+SECOND const& CS280::AVLmap_snapshot<KEY_TYPE,VALUE_TYPE>::ElementValue(std::pair<FIRST, SECOND> const& item)
+{
+    return item.second;
+}
+
+/**
+ * @brief Returns the value of a node in a written range
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE >
+template< typename NODE >
+auto CS280::AVLmap_snapshot<KEY_TYPE,VALUE_TYPE>::ElementValue(NODE const& node) -> decltype(node.Value())
+{
+    return node.Value();
+}
+
+/**
+ * @brief Construct a node
+ *
+ * @param k - key
+ * @param val - value
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE >
+CS280::AVLmap_snapshot<KEY_TYPE,VALUE_TYPE>::Node::Node(KEY_TYPE const& k, VALUE_TYPE const& val) : key(k), value(val)
+{
+
+}
+
+/**
+ * @brief Returns the key of the node
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE >
+KEY_TYPE const& CS280::AVLmap_snapshot<KEY_TYPE,VALUE_TYPE>::Node::Key() const
+{
+    return key;
+}
+
+/**
+ * @brief Returns the value of the node
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE >
+VALUE_TYPE const& CS280::AVLmap_snapshot<KEY_TYPE,VALUE_TYPE>::Node::Value() const
+{
+    return value;
+}
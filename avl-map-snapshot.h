@@ -0,0 +1,89 @@
+/**
+ * @file avl-map-snapshot.h
+ * @brief The snapshot file format shared by AVLmap::save/load and MappedAVLmap. A file is a fixed header followed by
+ *        the entries sorted by key in one array, laid out like the nodes below, so it can be mapped and used in place
+ *        (MappedAVLmap) or read back with plain file streams (AVLmap::load). Only standard headers are used here,
+ *        the memory mapping lives in mapped-avl-map.h. Keys and values must be trivially copyable.
+ */
+
+#ifndef AVLMAP_SNAPSHOT_H
+#define AVLMAP_SNAPSHOT_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace CS280 {
+
+    // The file is in the machine's byte order and layout, it is checked on open but not converted
+    template< typename KEY_TYPE, typename VALUE_TYPE >
+    class AVLmap_snapshot {
+			static_assert(std::is_trivially_copyable<KEY_TYPE>::value && std::is_trivially_copyable<VALUE_TYPE>::value,
+			              "snapshots need trivially copyable keys and values");
+		public:
+
+			// one entry of the file, so iterators can be used like AVLmap's (it->Key(), it->Value())
+			class Node
+			{
+				public:
+					Node( KEY_TYPE const& k, VALUE_TYPE const& val );
+
+					KEY_TYPE const & Key() const;   // return a const reference
+					VALUE_TYPE const & Value() const; // return a const reference
+				private:
+					KEY_TYPE    key;
+					VALUE_TYPE  value;
+			};
+
+			// start of every snapshot file, the entries follow at entriesOffset
+			struct FileHeader
+			{
+				char            magic[8];
+				std::uint32_t   version;
+				std::uint32_t   byteOrder; // ENDIAN_MARK as the writer saw it
+				std::uint64_t   count; // number of entries
+				std::uint64_t   entriesOffset;
+				std::uint32_t   keySize;
+				std::uint32_t   valueSize;
+				std::uint32_t   nodeSize; // entry stride, padding included
+				std::uint32_t   nodeAlign;
+			};
+
+			// raw storage for one entry, the entries read from a file are used through it
+			typedef typename std::aligned_storage<sizeof(Node), alignof(Node)>::type NodeStorage;
+
+			//writes a range sorted by key, with distinct keys, as a snapshot file (pairs or nodes with Key() and Value())
+			//the file is written next to path and renamed over it when complete, so readers never see a partial file
+			template< typename ITER >
+			static void write(std::string const& path, ITER first, ITER last);
+			//reads the entries of a snapshot file into storage, throws std::runtime_error if it isn't a snapshot of this type
+			static std::vector<NodeStorage> read(std::string const& path);
+			//whether a header read from a file of the given length describes a snapshot of this type
+			static bool valid(FileHeader const& header, std::size_t length);
+		private:
+			static constexpr char MAGIC[8] = { 'C', 'S', '2', '8', '0', 'A', 'V', 'L' };
+			static constexpr std::uint32_t VERSION = 1;
+			static constexpr std::uint32_t ENDIAN_MARK = 0x01020304;
+			// the entries start on a cache line, which is enough for any node the format allows
+			static constexpr std::uint64_t ENTRIES_OFFSET = 64;
+			static constexpr std::size_t WRITE_BATCH = 4096; // entries written per call
+
+			static_assert(sizeof(FileHeader) <= ENTRIES_OFFSET && alignof(Node) <= ENTRIES_OFFSET,
+			              "entries must fit the fixed offset and alignment");
+
+			template< typename FIRST, typename SECOND >
+			static FIRST const& ElementKey(std::pair<FIRST, SECOND> const& item);
+			template< typename NODE >
+			static auto ElementKey(NODE const& node) -> decltype(node.Key());
+			template< typename FIRST, typename SECOND >
+			static SECOND const& ElementValue(std::pair<FIRST, SECOND> const& item);
+			template< typename NODE >
+			static auto ElementValue(NODE const& node) -> decltype(node.Value());
+	};
+}
+
+#include "avl-map-snapshot.cpp"
+#endif
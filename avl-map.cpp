@@ -9,20 +9,34 @@
 
 #include "avl-map.h"
 
-// static data members
-template< typename KEY_TYPE, typename VALUE_TYPE >
-typename CS280::AVLmap<KEY_TYPE,VALUE_TYPE>::AVLmap_iterator        
-		CS280::AVLmap<KEY_TYPE,VALUE_TYPE>::end_it        = CS280::AVLmap<KEY_TYPE,VALUE_TYPE>::AVLmap_iterator(nullptr);
+/**
+ * @brief Construct AVL, sets root to null
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename COMPARE, typename ALLOCATOR, typename TRAITS >
+CS280::AVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR,TRAITS>::AVLmap() : mRoot(nullptr)
+{
+    
+}
 
-template< typename KEY_TYPE, typename VALUE_TYPE >
-typename CS280::AVLmap<KEY_TYPE,VALUE_TYPE>::AVLmap_iterator_const  
-		CS280::AVLmap<KEY_TYPE,VALUE_TYPE>::const_end_it  = CS280::AVLmap<KEY_TYPE,VALUE_TYPE>::AVLmap_iterator_const(nullptr);
+/**
+ * @brief Construct AVL whose node pool gets its chunks from the given allocator
+ * 
+ * @param alloc - allocator for the node chunks
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename COMPARE, typename ALLOCATOR, typename TRAITS >
+CS280::AVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR,TRAITS>::AVLmap(ALLOCATOR const& alloc) : mRoot(nullptr), mAlloc(alloc)
+{
+    
+}
 
 /**
- * @brief Construct AVL, sets root to null
+ * @brief Construct AVL that orders its keys with the given comparator
+ * 
+ * @param comp - key comparator
+ * @param alloc - allocator for the node chunks
  */
-template< typename KEY_TYPE, typename VALUE_TYPE >
-CS280::AVLmap<KEY_TYPE,VALUE_TYPE>::AVLmap() : mRoot(nullptr)
+template< typename KEY_TYPE, typename VALUE_TYPE, typename COMPARE, typename ALLOCATOR, typename TRAITS >
+CS280::AVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR,TRAITS>::AVLmap(COMPARE const& comp, ALLOCATOR const& alloc) : mRoot(nullptr), mCompare(comp), mAlloc(alloc)
 {
     
 }
@@ -32,10 +46,46 @@ CS280::AVLmap<KEY_TYPE,VALUE_TYPE>::AVLmap() : mRoot(nullptr)
  * 
  * @param rhs - copy
  */
-template< typename KEY_TYPE, typename VALUE_TYPE >
-CS280::AVLmap<KEY_TYPE,VALUE_TYPE>::AVLmap(const AVLmap& rhs) : mRoot(nullptr)
+template< typename KEY_TYPE, typename VALUE_TYPE, typename COMPARE, typename ALLOCATOR, typename TRAITS >
+CS280::AVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR,TRAITS>::AVLmap(const AVLmap& rhs)
+    : mRoot(nullptr), mCompare(rhs.mCompare), mAlloc(std::allocator_traits<ALLOCATOR>::select_on_container_copy_construction(rhs.mAlloc))
+{
+    try
+    {
+        DeepCopyTree(rhs.mRoot);
+    }
+    catch(...)
+    {
+        // The destructor won't run for a constructor that throws, free what was copied so far
+        ClearTree(mRoot);
+        throw;
+    }
+}
+
+/**
+ * @brief Builds a perfectly balanced map from a range sorted by key in O(n). Elements can be pairs or
+ *        nodes of another map. Only the first of equal keys is kept. If the range turns out not to be sorted,
+ *        the elements are inserted one by one instead.
+ * 
+ * @param first - start of the range
+ * @param last - end of the range
+ * @param comp - key comparator
+ * @param alloc - allocator for the node chunks
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename COMPARE, typename ALLOCATOR, typename TRAITS >
+template< typename ITER >
+CS280::AVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR,TRAITS>::AVLmap(ITER first, ITER last, COMPARE const& comp, ALLOCATOR const& alloc) : mRoot(nullptr), mCompare(comp), mAlloc(alloc)
 {
-    DeepCopyTree(rhs.mRoot);
+    try
+    {
+        BuildTree(first, last, typename std::iterator_traits<ITER>::iterator_category());
+    }
+    catch(...)
+    {
+        // The destructor won't run for a constructor that throws, free what was built so far
+        ClearTree(mRoot);
+        throw;
+    }
 }
 
 /**
@@ -43,24 +93,40 @@ CS280::AVLmap<KEY_TYPE,VALUE_TYPE>::AVLmap(const AVLmap& rhs) : mRoot(nullptr)
  * 
  * @param rhs - data to move
  */
-template< typename KEY_TYPE, typename VALUE_TYPE >
-CS280::AVLmap<KEY_TYPE,VALUE_TYPE>::AVLmap(AVLmap&& rhs) : mRoot(std::move(rhs.mRoot)), size_(rhs.size_)
+template< typename KEY_TYPE, typename VALUE_TYPE, typename COMPARE, typename ALLOCATOR, typename TRAITS >
+CS280::AVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR,TRAITS>::AVLmap(AVLmap&& rhs)
+    : mRoot(std::move(rhs.mRoot)), size_(rhs.size_), mCompare(rhs.mCompare), mAlloc(rhs.mAlloc), mPool(std::move(rhs.mPool)),
+      mFirst(rhs.mFirst), mLast(rhs.mLast)
 {
     rhs.size_ = 0;
     rhs.mRoot = nullptr;
+    rhs.mFirst = nullptr;
+    rhs.mLast = nullptr;
 }
 
 /**
- * @brief Assignment operator
+ * @brief Assignment operator. If a key or value copy throws, the map is left empty.
  */
-template< typename KEY_TYPE, typename VALUE_TYPE >
-typename CS280::AVLmap<KEY_TYPE,VALUE_TYPE>::AVLmap& CS280::AVLmap<KEY_TYPE,VALUE_TYPE>::AVLmap::operator=(const AVLmap& rhs)
+template< typename KEY_TYPE, typename VALUE_TYPE, typename COMPARE, typename ALLOCATOR, typename TRAITS >
+typename CS280::AVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR,TRAITS>::AVLmap& CS280::AVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR,TRAITS>::AVLmap::operator=(const AVLmap& rhs)
 {
     if(this != &rhs)
     {
         ClearTree(mRoot);
 
-        DeepCopyTree(rhs.mRoot);
+        // The copied shape is ordered by rhs's comparator
+        mCompare = rhs.mCompare;
+
+        try
+        {
+            DeepCopyTree(rhs.mRoot);
+        }
+        catch(...)
+        {
+            // The partial copy has rhs's heights without all of rhs's subtrees, leave the map empty instead
+            ClearTree(mRoot);
+            throw;
+        }
     }
 
     return *this;
@@ -70,13 +136,18 @@ typename CS280::AVLmap<KEY_TYPE,VALUE_TYPE>::AVLmap& CS280::AVLmap<KEY_TYPE,VALU
  * @brief Move assignment operator. Moves data from rhs into this map via operator=
  * 
  * @param rhs - map to move into this map
- * @return CS280::AVLmap<KEY_TYPE,VALUE_TYPE>::AVLmap& 
+ * @return CS280::AVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR,TRAITS>::AVLmap& 
  */
-template< typename KEY_TYPE, typename VALUE_TYPE >
-typename CS280::AVLmap<KEY_TYPE,VALUE_TYPE>::AVLmap& CS280::AVLmap<KEY_TYPE,VALUE_TYPE>::AVLmap::operator=(AVLmap&& rhs)
+template< typename KEY_TYPE, typename VALUE_TYPE, typename COMPARE, typename ALLOCATOR, typename TRAITS >
+typename CS280::AVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR,TRAITS>::AVLmap& CS280::AVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR,TRAITS>::AVLmap::operator=(AVLmap&& rhs)
 {
     std::swap(mRoot, rhs.mRoot); // Swap root
     std::swap(size_, rhs.size_); // Swap size
+    std::swap(mCompare, rhs.mCompare); // Swap comparator
+    std::swap(mAlloc, rhs.mAlloc); // Swap allocator
+    std::swap(mPool, rhs.mPool); // Swap the pool that owns the nodes
+    std::swap(mFirst, rhs.mFirst); // Swap the cached ends
+    std::swap(mLast, rhs.mLast);
 
     return *this;
 }
@@ -84,8 +155,8 @@ typename CS280::AVLmap<KEY_TYPE,VALUE_TYPE>::AVLmap& CS280::AVLmap<KEY_TYPE,VALU
 /**
  * @brief Destructor. Clears the tree
  */
-template< typename KEY_TYPE, typename VALUE_TYPE >
-CS280::AVLmap<KEY_TYPE,VALUE_TYPE>::~AVLmap()
+template< typename KEY_TYPE, typename VALUE_TYPE, typename COMPARE, typename ALLOCATOR, typename TRAITS >
+CS280::AVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR,TRAITS>::~AVLmap()
 {
     ClearTree(mRoot);
 }
@@ -93,37 +164,41 @@ CS280::AVLmap<KEY_TYPE,VALUE_TYPE>::~AVLmap()
 /**
  * @brief Returns the size (number of nodes) in the map
  */
-template< typename KEY_TYPE, typename VALUE_TYPE >
-unsigned int CS280::AVLmap<KEY_TYPE,VALUE_TYPE>::size()
+template< typename KEY_TYPE, typename VALUE_TYPE, typename COMPARE, typename ALLOCATOR, typename TRAITS >
+unsigned int CS280::AVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR,TRAITS>::size()
 {
     return size_;
 }
 
+/**
+ * @brief Returns the comparator that orders the keys
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename COMPARE, typename ALLOCATOR, typename TRAITS >
+COMPARE CS280::AVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR,TRAITS>::key_comp() const
+{
+    return mCompare;
+}
+
+/**
+ * @brief Returns the allocator the node chunks come from
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename COMPARE, typename ALLOCATOR, typename TRAITS >
+ALLOCATOR CS280::AVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR,TRAITS>::get_allocator() const
+{
+    return mAlloc;
+}
+
 /**
  * @brief Returns the value corresponding to the given key. If a node with the given key does not exist, a node will be inserted into the tree.
  * 
  * @param key - key of value to return
  * @return VALUE_TYPE& - value
  */
-template< typename KEY_TYPE, typename VALUE_TYPE >
-VALUE_TYPE& CS280::AVLmap<KEY_TYPE, VALUE_TYPE>::operator[](KEY_TYPE const& key)
+template< typename KEY_TYPE, typename VALUE_TYPE, typename COMPARE, typename ALLOCATOR, typename TRAITS >
+VALUE_TYPE& CS280::AVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR,TRAITS>::operator[](KEY_TYPE const& key)
 {
-    Node* node = FindNode(mRoot, key); // Attempt to find the node
-
-    if(node != nullptr)
-    {
-        return node->value; // Return the node's value if it exists
-    }
-
-    std::stack<Node*> nodes;
-
-    InsertItem(mRoot, mRoot, key, VALUE_TYPE{}, nodes); // If the node did not exist, insert it
-
-    BalanceTree(nodes, true);
-
-    Node* insert = FindNode(mRoot, key); // Find the inserted node
-
-    return insert->value; // Return the inserted node's value
+    // Find the node or insert a default value in the same descent
+    return TryEmplace(key).first.mNode->value;
 }
 
 ////////////////////////////////////////////////////////////
@@ -132,665 +207,4618 @@ VALUE_TYPE& CS280::AVLmap<KEY_TYPE, VALUE_TYPE>::operator[](KEY_TYPE const& key)
 /**
  * @brief Returns the begin iterator of the map
  */
-template< typename KEY_TYPE, typename VALUE_TYPE >
-typename CS280::AVLmap<KEY_TYPE,VALUE_TYPE>::AVLmap_iterator CS280::AVLmap<KEY_TYPE,VALUE_TYPE>::begin() {
-	if (mRoot) return AVLmap<KEY_TYPE,VALUE_TYPE>::AVLmap_iterator(mRoot->first());
-	else       return end_it;
+template< typename KEY_TYPE, typename VALUE_TYPE, typename COMPARE, typename ALLOCATOR, typename TRAITS >
+typename CS280::AVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR,TRAITS>::AVLmap_iterator CS280::AVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR,TRAITS>::begin() {
+	if constexpr(TRAITS::threaded) return AVLmap_iterator(mFirst, this);
+	if (mRoot) return AVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR,TRAITS>::AVLmap_iterator(mRoot->first(), this);
+	else       return AVLmap_iterator(nullptr, this);
+}
+
+/**
+ * @brief Returns the reverse begin iterator (the last node)
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename COMPARE, typename ALLOCATOR, typename TRAITS >
+typename CS280::AVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR,TRAITS>::reverse_iterator CS280::AVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR,TRAITS>::rbegin() {
+    return reverse_iterator(end());
+}
+
+/**
+ * @brief Returns the reverse end iterator (before the first node)
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename COMPARE, typename ALLOCATOR, typename TRAITS >
+typename CS280::AVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR,TRAITS>::reverse_iterator CS280::AVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR,TRAITS>::rend() {
+    return reverse_iterator(begin());
 }
 
 /**
  * @brief Returns the end iterator
  */
-template< typename KEY_TYPE, typename VALUE_TYPE >
-typename CS280::AVLmap<KEY_TYPE,VALUE_TYPE>::AVLmap_iterator CS280::AVLmap<KEY_TYPE,VALUE_TYPE>::end() {
-    return end_it;
+template< typename KEY_TYPE, typename VALUE_TYPE, typename COMPARE, typename ALLOCATOR, typename TRAITS >
+typename CS280::AVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR,TRAITS>::AVLmap_iterator CS280::AVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR,TRAITS>::end() {
+    return AVLmap_iterator(nullptr, this);
 }
 
 /**
  * @brief Finds the node of given key and returns as an iterator
  * 
  * @param type - key of iterator to return
- * @return CS280::AVLmap<KEY_TYPE,VALUE_TYPE>::AVLmap_iterator 
+ * @return CS280::AVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR,TRAITS>::AVLmap_iterator 
  */
-template< typename KEY_TYPE, typename VALUE_TYPE >
-typename CS280::AVLmap<KEY_TYPE,VALUE_TYPE>::AVLmap_iterator CS280::AVLmap<KEY_TYPE, VALUE_TYPE>::find(KEY_TYPE const& type)
+template< typename KEY_TYPE, typename VALUE_TYPE, typename COMPARE, typename ALLOCATOR, typename TRAITS >
+typename CS280::AVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR,TRAITS>::AVLmap_iterator CS280::AVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR,TRAITS>::find(KEY_TYPE const& type)
 {
+    LatencyTimer timer(this, AVLmap_stats::FIND);
     Node* foundNode = FindNode(mRoot, type);
-    return AVLmap_iterator(foundNode);
+    return AVLmap_iterator(foundNode, this);
 }
 
 /**
- * @brief Erase a node from the map based off the given iterator
+ * @brief Finds the node of a key of another type, only when COMPARE is transparent (e.g. std::less<>)
+ * 
+ * @param key - key of iterator to return, compared without converting it to KEY_TYPE
  */
-template< typename KEY_TYPE, typename VALUE_TYPE >
-void CS280::AVLmap<KEY_TYPE, VALUE_TYPE>::erase(AVLmap_iterator it)
+template< typename KEY_TYPE, typename VALUE_TYPE, typename COMPARE, typename ALLOCATOR, typename TRAITS >
+template< typename KEY_ARG, typename CMP, typename >
+typename CS280::AVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR,TRAITS>::AVLmap_iterator CS280::AVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR,TRAITS>::find(KEY_ARG const& key)
 {
-    if (it == end_it)
-        return;
-		
-    std::stack<Node*> nodes;
-    GetVisitedNodes(it.mNode, nodes);
+    LatencyTimer timer(this, AVLmap_stats::FIND);
+    return AVLmap_iterator(FindNode(mRoot, key), this);
+}
 
-    DeleteItem(it.mNode, it.mNode->key);
+/**
+ * @brief Finds many keys at once. The lookups walk down the tree side by side, so their cache misses
+ *        overlap instead of each one waiting on its own chain of nodes.
+ * 
+ * @param keys - keys to find
+ * @param count - number of keys
+ * @param results - set to the node of each key, or end if it is missing
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename COMPARE, typename ALLOCATOR, typename TRAITS >
+void CS280::AVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR,TRAITS>::find_batch(KEY_TYPE const* keys, std::size_t count, AVLmap_iterator* results)
+{
+    Node* found[BATCH_LANES];
 
-    BalanceTree(nodes, false);
-}
+    for(std::size_t first = 0; first < count; first += BATCH_LANES)
+    {
+        std::size_t lanes = std::min(count - first, BATCH_LANES);
 
-template< typename KEY_TYPE, typename VALUE_TYPE >
-typename CS280::AVLmap<KEY_TYPE,VALUE_TYPE>::AVLmap_iterator_const CS280::AVLmap<KEY_TYPE,VALUE_TYPE>::begin() const {
-	if (mRoot) return AVLmap<KEY_TYPE,VALUE_TYPE>::AVLmap_iterator_const(mRoot->first());
-	else       return const_end_it;
-}
+        FindNodes(keys + first, lanes, found);
 
-template< typename KEY_TYPE, typename VALUE_TYPE >
-typename CS280::AVLmap<KEY_TYPE,VALUE_TYPE>::AVLmap_iterator_const CS280::AVLmap<KEY_TYPE,VALUE_TYPE>::end() const {
-	return const_end_it;
+        for(std::size_t lane = 0; lane < lanes; ++lane)
+        {
+            results[first + lane] = AVLmap_iterator(found[lane], this);
+        }
+    }
 }
 
 /**
- * @brief Finds the node of given key and returns as a const iterator
+ * @brief Erases the node with the given key.
  * 
- * @param type - key of iterator to return
- * @return CS280::AVLmap<KEY_TYPE,VALUE_TYPE>::AVLmap_iterator_const
+ * @param key - key to erase
+ * @return number of nodes erased (0 or 1)
  */
-template< typename KEY_TYPE, typename VALUE_TYPE >
-typename CS280::AVLmap<KEY_TYPE,VALUE_TYPE>::AVLmap_iterator_const CS280::AVLmap<KEY_TYPE, VALUE_TYPE>::find(KEY_TYPE const& type) const
+template< typename KEY_TYPE, typename VALUE_TYPE, typename COMPARE, typename ALLOCATOR, typename TRAITS >
+unsigned int CS280::AVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR,TRAITS>::erase(KEY_TYPE const& key)
 {
-    Node* foundNode = FindNode(mRoot, type);
-    return AVLmap_iterator_const(foundNode);
+    return EraseKey(key);
 }
 
 /**
- * @brief Returns the height of a node.
+ * @brief Erases the node with a key of another type, only when COMPARE is transparent (e.g. std::less<>)
+ * 
+ * @param key - key to erase, compared without converting it to KEY_TYPE
+ * @return number of nodes erased (0 or 1)
  */
-template< typename KEY_TYPE, typename VALUE_TYPE >
-int CS280::AVLmap<KEY_TYPE,VALUE_TYPE>::getdepth(const Node* node) const {
-	return node->height;
+template< typename KEY_TYPE, typename VALUE_TYPE, typename COMPARE, typename ALLOCATOR, typename TRAITS >
+template< typename KEY_ARG, typename CMP, typename, typename >
+unsigned int CS280::AVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR,TRAITS>::erase(KEY_ARG const& key)
+{
+    return EraseKey(key);
 }
 
-////////////////////////////////////////////////////////////
-// do not change this code from here to the end of the file
-/* figure out whether node is left or right child or root 
- * used in print_backwards_padded 
+/**
+ * @brief Erase a node from the map based off the given iterator. The other nodes stay where they are,
+ *        so iterators to them (including the returned one) stay valid.
+ * 
+ * @param it - node to erase
+ * @return the node after the erased one
  */
-template< typename KEY_TYPE, typename VALUE_TYPE >
-char CS280::AVLmap<KEY_TYPE,VALUE_TYPE>::getedgesymbol(const Node* node) const {
-	const Node* parent = node->parent;
-	if ( parent == nullptr) return '-';
-	else                 return ( parent->left == node)?'\\':'/';
-}
+template< typename KEY_TYPE, typename VALUE_TYPE, typename COMPARE, typename ALLOCATOR, typename TRAITS >
+typename CS280::AVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR,TRAITS>::AVLmap_iterator CS280::AVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR,TRAITS>::erase(AVLmap_iterator it)
+{
+    if (it.mNode == nullptr)
+        return it;
 
-/* this is another "ASCII-graphical" print, but using 
- * iterative function. 
- * Left branch of the tree is at the bottom
- */
-template< typename KEY_TYPE, typename VALUE_TYPE >
-std::ostream& CS280::operator<<(std::ostream& os, AVLmap<KEY_TYPE,VALUE_TYPE> const& map) {
-	map.print(os);
-	return os;
-}
+    LatencyTimer timer(this, AVLmap_stats::ERASE);
+    Node* next = it.mNode->increment();
 
-template< typename KEY_TYPE, typename VALUE_TYPE >
-void CS280::AVLmap<KEY_TYPE,VALUE_TYPE>::print(std::ostream& os, bool print_value ) const {
-	if (mRoot) {
-		AVLmap<KEY_TYPE,VALUE_TYPE>::Node* b = mRoot->last();
-		while ( b ) { 
-			int depth = getdepth(b);
-			int i;
-			/* printf(b); */
+    EraseNode(it.mNode);
 
-			char edge = getedgesymbol(b);
-			switch (edge) {
-				case '-': 
-					for (i=0; i<depth; ++i) std::printf("       ");
-					os << b->key;
-                    if ( print_value ) { os << " -> " << b->value; }
-                    os << std::endl;
-					break;
-				case '\\': 
-					for (i=0; i<depth; ++i) std::printf("       ");
-					os << edge << std::endl;
-					for (i=0; i<depth; ++i) std::printf("       ");
-					os << b->key;
-                    if ( print_value ) { os << " -> " << b->value; }
-                    os << std::endl;
-					break;
-				case '/': 
-					for (i=0; i<depth; ++i) std::printf("       ");
-					os << b->key;
-                    if ( print_value ) { os << " -> " << b->value; }
-                    os << std::endl;
-					for (i=0; i<depth; ++i) std::printf("       ");
-					os << edge << std::endl;
-					break;
-			}
-			b = b->decrement();
-		}
-	}
-	std::printf("\n");
+    return AVLmap_iterator(next, this);
 }
 
 /**
- * @brief Finds a node in the tree with the given key.
+ * @brief Erases the nodes in [first, last) in O(k + log n): the tree is split in front of first and in front
+ *        of last, the piece in between is freed in one walk and the two other pieces are joined back around last.
+ *        Nothing is rebalanced per node.
  * 
- * @param tree - node to start search at
- * @param key - key to find
- * @return the found node
+ * @param first - first node to erase
+ * @param last - node after the last one to erase (end() erases up to the end)
+ * @return last
  */
-template< typename KEY_TYPE, typename VALUE_TYPE >
-typename CS280::AVLmap<KEY_TYPE,VALUE_TYPE>::Node* CS280::AVLmap<KEY_TYPE,VALUE_TYPE>::FindNode(Node* tree, KEY_TYPE key)
+template< typename KEY_TYPE, typename VALUE_TYPE, typename COMPARE, typename ALLOCATOR, typename TRAITS >
+typename CS280::AVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR,TRAITS>::AVLmap_iterator CS280::AVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR,TRAITS>::erase(AVLmap_iterator first, AVLmap_iterator last)
 {
-    // If the key has been found, return the node.
-    if(tree == nullptr || tree->key == key)
+    if(first == last)
+        return last;
+
+    if(first.mNode == begin().mNode && last.mNode == nullptr)
     {
-        return tree;
+        ClearTree(mRoot);
+        return end();
     }
-    
-    // If this node's key is less than the key, search the right subtree
-    if(tree->key < key)
+
+    // Where last goes back into the in-order list once the nodes in between are gone
+    Node* before = nullptr;
+
+    if constexpr(TRAITS::threaded)
+    {
+        before = first.mNode->prev;
+    }
+
+    // The pieces are split and joined detached, none of them is the root while the rotations run
+    Node* tree = mRoot;
+    mRoot = nullptr;
+
+    Node* lower;
+    Node* upper;
+    Node* doomed = SplitTree(tree, first.mNode->key, lower, upper);
+    unsigned int erased = 1;
+
+    if(last.mNode == nullptr)
+    {
+        erased += DestroySubtree(upper, true);
+        mRoot = lower;
+    }
+    else
     {
-        return FindNode(tree->right, key);
+        Node* middle;
+        Node* rest;
+        SplitTree(upper, last.mNode->key, middle, rest);
+
+        // The split cut last out of the in-order list
+        if constexpr(TRAITS::threaded)
+        {
+            Stitch(before, last.mNode);
+            Stitch(last.mNode, rest ? rest->first() : nullptr);
+        }
+
+        erased += DestroySubtree(middle, true);
+        mRoot = JoinTrees(lower, last.mNode, rest);
     }
 
-    // If this node's key is more than the key, search the left subtree
-    return FindNode(tree->left, key);
+    DestroyNode(doomed);
+    size_ -= erased;
+
+    CacheEnds();
+
+    return last;
 }
 
 /**
- * @brief Inserts an item into the tree
+ * @brief Replaces the contents of the map with a range sorted by key, see the range constructor.
  * 
- * @param tree - tree to insert
- * @param parentNode - keeps track of parent node
- * @param key - key to insert
- * @param value - value to insert
- * @return CS280::AVLmap<KEY_TYPE,VALUE_TYPE>::Node* 
+ * @param first - start of the range
+ * @param last - end of the range
  */
-template< typename KEY_TYPE, typename VALUE_TYPE >
-typename CS280::AVLmap<KEY_TYPE,VALUE_TYPE>::Node* CS280::AVLmap<KEY_TYPE,VALUE_TYPE>::InsertItem(Node* tree, Node* parentNode, KEY_TYPE key, VALUE_TYPE value, std::stack<Node*>& nodes)
+template< typename KEY_TYPE, typename VALUE_TYPE, typename COMPARE, typename ALLOCATOR, typename TRAITS >
+template< typename ITER >
+void CS280::AVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR,TRAITS>::assign(ITER first, ITER last)
 {
-    // Once the spot to insert has been found
-    if(tree == nullptr)
-    {
-        int height = 0;
-        
-        // Calculate the height of the node
-        if(parentNode != nullptr)
-        {
-            height = parentNode->height + 1;
-        }
+    ClearTree(mRoot);
 
-        // Create the node
-        tree = new Node(key, value, parentNode, height, 0, nullptr, nullptr);
+    BuildTree(first, last, typename std::iterator_traits<ITER>::iterator_category());
+}
 
-        ++size_;
+/**
+ * @brief Joins two maps around a pivot in O(log n): the shorter tree is hung off the taller one's spine
+ *        at the matching height and rebalanced from there up. No node is copied. If the keys are not
+ *        ordered left < pivot < right, the maps are merged and the pivot inserted instead, O(m log(n/m + 1))
+ *        like merge: of equal keys left's is kept, right's are destroyed with right, and the pivot is dropped
+ *        if its key is already there.
+ * 
+ * @param left - map with the keys less than the pivot's
+ * @param pivot - key and value between the two maps
+ * @param right - map with the keys greater than the pivot's
+ * @return the joined map (left and right are left empty either way)
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename COMPARE, typename ALLOCATOR, typename TRAITS >
+typename CS280::AVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR,TRAITS>::AVLmap CS280::AVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR,TRAITS>::join(AVLmap&& left, value_type pivot, AVLmap&& right)
+{
+    AVLmap joined(std::move(left));
 
-        // If it's the first node, set it to root
-        if(mRoot == nullptr)
-        {
-            mRoot = tree;
-        }
+    bool ordered = (joined.mRoot == nullptr || joined.mCompare(joined.mRoot->last()->key, pivot.first)) &&
+                   (right.mRoot == nullptr || joined.mCompare(pivot.first, right.mRoot->first()->key));
 
-        return tree;
-    }
-    else if(key < tree->key)
+    if(!ordered)
     {
-        nodes.push(tree);
+        joined.merge(right);
+        right.ClearTree(right.mRoot);
+        joined.TryEmplace(std::move(pivot.first), std::move(pivot.second));
+        return joined;
+    }
+
+    Node* node = joined.CreateNode(nullptr, std::move(pivot.first), std::move(pivot.second));
 
-        // Keep going down the left side of the tree
-        tree->left = InsertItem(tree->left, tree, key, value, nodes);
+    unsigned int size = joined.size_ + right.size_ + 1;
+    Node* upper = nullptr;
+
+    // Taking right's tree copies it when the pools can't be shared, the unlinked pivot must not leak if that throws
+    try
+    {
+        upper = joined.TakeTree(right);
     }
-    else if(key > tree->key)
+    catch(...)
     {
-        nodes.push(tree);
+        joined.DestroyNode(node);
+        throw;
+    }
+
+    Node* lower = joined.mRoot;
 
-        // Keep going down the right side of the tree
-        tree->right = InsertItem(tree->right, tree, key, value, nodes);
+    if constexpr(TRAITS::threaded)
+    {
+        Stitch(joined.mLast, node);
+        Stitch(node, upper ? upper->first() : nullptr);
     }
 
-    return tree;
+    // The trees are joined detached, none of them is the root while the rotations run
+    joined.mRoot = nullptr;
+    joined.mRoot = joined.JoinTrees(lower, node, upper);
+    joined.size_ = size;
+    joined.CacheEnds();
+
+    return joined;
 }
 
 /**
- * @brief Deletes an item from the tree.
+ * @brief Splits the map by joining the subtrees hanging off the search path for the key, bottom up,
+ *        into a lower and an upper tree, O(log n). No node is copied, both halves share this map's pool,
+ *        which locks from then on so each half can go to its own thread. The sizes come from the subtree counts
+ *        when TRAITS::order_statistics is on, otherwise the smaller half is counted, which makes the split
+ *        O(log n + min(k, n - k)) for k keys in the lower half.
  * 
- * @param tree - tree to find item in
- * @param key - key's item to delete
+ * @param key - first key of the upper half
+ * @return the map of keys less than the key, and the map of the other keys (this map is left empty)
  */
-template< typename KEY_TYPE, typename VALUE_TYPE >
-void CS280::AVLmap<KEY_TYPE,VALUE_TYPE>::DeleteItem(Node* tree, KEY_TYPE key)
+template< typename KEY_TYPE, typename VALUE_TYPE, typename COMPARE, typename ALLOCATOR, typename TRAITS >
+std::pair<typename CS280::AVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR,TRAITS>::AVLmap, typename CS280::AVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR,TRAITS>::AVLmap> CS280::AVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR,TRAITS>::split(KEY_TYPE const& key)
 {
-    if(tree == nullptr)
+    std::pair<AVLmap, AVLmap> halves(AVLmap(mCompare, mAlloc), AVLmap(mCompare, mAlloc));
+
+    Node* tree = mRoot;
+    unsigned int total = size_;
+
+    mRoot = nullptr;
+    size_ = 0;
+
+    Node* lower;
+    Node* upper;
+    Node* match = SplitTree(tree, key, lower, upper);
+
+    // The key itself belongs to the upper half, as its first node
+    if(match != nullptr)
     {
-        return;
+        if constexpr(TRAITS::threaded)
+        {
+            Stitch(match, upper ? upper->first() : nullptr);
+        }
+
+        upper = JoinTrees(nullptr, match, upper);
     }
-    else if(key < tree->key)
+
+    halves.first.mRoot = lower;
+    halves.second.mRoot = upper;
+
+    if constexpr(TRAITS::order_statistics)
     {
-        DeleteItem(tree->left, key);
+        halves.first.size_ = GetSubtreeCount(lower);
     }
-    else if(key > tree->key)
+    else
     {
-        DeleteItem(tree->right, key);
+        halves.first.size_ = CountLower(lower, upper, total);
     }
-    else // If this key is the tree's key
-    {
-        // If the node is a leaf node
-        if(tree->left == nullptr && tree->right == nullptr)
-        {
-            DeleteLeafNode(tree);
-        }
-        else if(tree->left != nullptr && tree->right != nullptr) // Ihe node to be deleted has both children non-empty.
-        {
-            Node* pred = tree->decrement(); // Find the node's predecessor under inorder traversal
 
-            // Set the data in the node to the predecessor's data
-            tree->value = pred->value;
-            tree->key = pred->key;
+    halves.second.size_ = total - halves.first.size_;
 
-            // Delete the predecessor's node
-            DeleteItem(tree->left, tree->key);
-        }
-        else // If the node to be deleted has only one empty child.
-        {
-            Node* child = tree->left ? tree->left : tree->right; // Get the empty child
-
-            // Replace the deleted node with its child
-            if(tree != mRoot)
-            {
-                if(tree == tree->parent->left)
-                {
-                    tree->parent->left = child;
-                }
-                else
-                {
-                    tree->parent->right = child;
-                }
+    if(mPool)
+    {
+        mPool->share();
+    }
 
-                // Update the parent to point to the updated tree.
-                child->parent = tree->parent;
-            }
-            else
-            {
-                // If it's just the root and a child, set the child to root.
-                mRoot = child;
+    halves.first.mPool = mPool;
+    halves.second.mPool = std::move(mPool);
 
-                mRoot->parent = nullptr;
-            }
+    halves.first.CacheEnds();
+    halves.second.CacheEnds();
+    mFirst = nullptr;
+    mLast = nullptr;
 
-            FreeNode(tree);
-        }
-    }
+    return halves;
 }
 
 /**
- * @brief Delete's a leaf node (no left or right pointer) from the tree
+ * @brief Moves other's nodes into this map, the way std::map::merge does: nodes whose keys are already here
+ *        stay in other. Key ranges that don't overlap are joined in O(log n), otherwise the trees are united
+ *        by splitting this one around other's nodes and joining the pieces back, O(m log(n/m + 1)).
+ *        Nodes keep their memory unless the two pools can't be shared (see TakeTree). The duplicates go back
+ *        into a fresh pool of other's, so other never allocates from this map's pool afterwards.
  * 
- * @param node - leaf node
+ * @param other - map to take the nodes from
  */
-template< typename KEY_TYPE, typename VALUE_TYPE >
-void CS280::AVLmap<KEY_TYPE,VALUE_TYPE>::DeleteLeafNode(Node* node)
+template< typename KEY_TYPE, typename VALUE_TYPE, typename COMPARE, typename ALLOCATOR, typename TRAITS >
+void CS280::AVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR,TRAITS>::merge(AVLmap& other)
 {
-    // If the node is the root, set root to null
-    if(node == mRoot)
+    if(&other == this || other.mRoot == nullptr)
+        return;
+
+    unsigned int theirSize = other.size_;
+
+    Node* theirs = TakeTree(other);
+    Node* mine = mRoot;
+    Node* duplicates = nullptr;
+
+    if(mine == nullptr)
+    {
+        mRoot = theirs;
+        size_ = theirSize;
+    }
+    else if(mCompare(mine->last()->key, theirs->first()->key))
     {
         mRoot = nullptr;
+        mRoot = ConcatTrees(mine, theirs);
+        size_ += theirSize;
     }
-    else
+    else if(mCompare(theirs->last()->key, mine->first()->key))
     {
-        // Update the node's parent pointers
-        if(node == node->parent->left)
+        mRoot = nullptr;
+        mRoot = ConcatTrees(theirs, mine);
+        size_ += theirSize;
+    }
+    else if constexpr(TRAITS::threaded)
+    {
+        // Uniting the trees would regroup runs of both in-order lists, link other's nodes one by one instead
+        for(Node* node = theirs->first(); node != nullptr; )
         {
-            node->parent->left = nullptr;
+            Node* next = node->next;
+
+            if(LinkNode(node) != node)
+            {
+                node->right = duplicates;
+                duplicates = node;
+            }
+
+            node = next;
         }
-        else
+    }
+    else
+    {
+        mRoot = nullptr;
+        mRoot = UnionTrees(mine, theirs, duplicates);
+        size_ += theirSize;
+
+        for(Node* node = duplicates; node != nullptr; node = node->right)
         {
-            node->parent->right = nullptr;
+            --size_;
         }
     }
 
-    FreeNode(node);
+    CacheEnds();
+
+    ReturnDuplicates(duplicates, other);
 }
 
 /**
- * @brief Frees a node
+ * @brief Moves the nodes of a temporary map into this map (see merge(AVLmap&)).
  * 
- * @param node - node to free
+ * @param other - map to take the nodes from
  */
-template< typename KEY_TYPE, typename VALUE_TYPE >
-void CS280::AVLmap<KEY_TYPE,VALUE_TYPE>::FreeNode(Node* node)
+template< typename KEY_TYPE, typename VALUE_TYPE, typename COMPARE, typename ALLOCATOR, typename TRAITS >
+void CS280::AVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR,TRAITS>::merge(AVLmap&& other)
 {
-    delete node;
-    node = nullptr;
-    --size_;
+    merge(other);
 }
 
 /**
- * @brief Deep copies the tree using preorder traversal
+ * @brief Inserts a batch of pairs (or nodes of another map) in any order, keeping the keys already in the map
+ *        and the first of equal keys in the batch, like inserting them one by one. The batch is sorted and
+ *        built into a balanced tree in O(k log k), then merged in, so the whole batch costs O(k log(n/k + 1))
+ *        tree work instead of k descents and rebalancing passes. Each element is copied once into the staging
+ *        buffer and moved from there into its node; pass move_iterators to move instead of copying.
  * 
- * @param node - current node (should be called with root)
+ * @param first - start of the batch
+ * @param last - end of the batch
+ * @return number of keys inserted
  */
-template< typename KEY_TYPE, typename VALUE_TYPE >
-void CS280::AVLmap<KEY_TYPE,VALUE_TYPE>::DeepCopyTree(Node* root)
+template< typename KEY_TYPE, typename VALUE_TYPE, typename COMPARE, typename ALLOCATOR, typename TRAITS >
+template< typename ITER >
+unsigned int CS280::AVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR,TRAITS>::insert_batch(ITER first, ITER last)
 {
-    if(root == nullptr)
-        return;
+    std::vector<value_type> batch;
+
+    for(; first != last; ++first)
+    {
+        batch.emplace_back(ElementKey(*first), ElementValue(*first));
+    }
+
+    // Stable so the first of equal keys is the one the build keeps
+    std::stable_sort(batch.begin(), batch.end(), [this](value_type const& a, value_type const& b)
+    {
+        return mCompare(a.first, b.first);
+    });
 
-    (*this)[root->key] = root->value; // Copy the current node
-    DeepCopyTree(root->left); // Copy the current node's left
-    DeepCopyTree(root->right); // Copy the current node's right
+    // Built on our pool, so the merge takes its nodes as they are, and moved out of the batch so each element is copied once
+    AVLmap delta(mCompare, mAlloc);
+    Pool();
+    delta.mPool = mPool;
+    delta.BuildTree(std::make_move_iterator(batch.begin()), std::make_move_iterator(batch.end()), std::forward_iterator_tag());
+
+    unsigned int before = size_;
+    merge(delta);
+
+    return size_ - before;
 }
 
 /**
- * @brief Clears the tree using preorder traversal
+ * @brief Erases a batch of keys in any order. The keys are sorted, then the tree is split at the middle key,
+ *        each half loses its half of the keys the same way and the halves are joined back. Subtrees no key
+ *        falls into are never visited, so the batch costs O(k log(n/k + 1)) tree work.
  * 
- * @param node - current node (should be called with root)
+ * @param first - start of the keys
+ * @param last - end of the keys
+ * @return number of nodes erased
  */
-template< typename KEY_TYPE, typename VALUE_TYPE >
-void CS280::AVLmap<KEY_TYPE,VALUE_TYPE>::ClearTree(Node* node)
+template< typename KEY_TYPE, typename VALUE_TYPE, typename COMPARE, typename ALLOCATOR, typename TRAITS >
+template< typename ITER >
+unsigned int CS280::AVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR,TRAITS>::erase_batch(ITER first, ITER last)
 {
-    if(node == nullptr)
+    std::vector<KEY_TYPE> keys(first, last);
+
+    std::sort(keys.begin(), keys.end(), mCompare);
+    keys.erase(std::unique(keys.begin(), keys.end(), [this](KEY_TYPE const& a, KEY_TYPE const& b)
+    {
+        return !mCompare(a, b);
+    }), keys.end());
+
+    if(mRoot == nullptr || keys.empty())
+        return 0;
+
+    unsigned int erased = 0;
+
+    // The pieces are split and joined detached, none of them is the root while the rotations run
+    Node* tree = mRoot;
+    mRoot = nullptr;
+    mRoot = DifferenceTrees(tree, keys.data(), keys.data() + keys.size(), erased);
+    size_ -= erased;
+
+    CacheEnds();
+
+    return erased;
+}
+
+/**
+ * @brief Inserts a copy of the pair if its key is not in the map yet.
+ * 
+ * @param item - key and value to insert
+ * @return the node with the key, and whether it was inserted
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename COMPARE, typename ALLOCATOR, typename TRAITS >
+std::pair<typename CS280::AVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR,TRAITS>::AVLmap_iterator, bool> CS280::AVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR,TRAITS>::insert(value_type const& item)
+{
+    return TryEmplace(item.first, item.second);
+}
+
+/**
+ * @brief Inserts the pair, moving the key and value into the node, if its key is not in the map yet.
+ * 
+ * @param item - key and value to insert
+ * @return the node with the key, and whether it was inserted
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename COMPARE, typename ALLOCATOR, typename TRAITS >
+std::pair<typename CS280::AVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR,TRAITS>::AVLmap_iterator, bool> CS280::AVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR,TRAITS>::insert(value_type&& item)
+{
+    return TryEmplace(std::move(item.first), std::move(item.second));
+}
+
+/**
+ * @brief Builds a node from the arguments and links it if its key is not in the map yet.
+ *        The first argument builds the key, the remaining ones build the value.
+ * 
+ * @param args - key argument followed by the value's constructor arguments
+ * @return the node with the key, and whether it was inserted
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename COMPARE, typename ALLOCATOR, typename TRAITS >
+template< typename... ARGS >
+std::pair<typename CS280::AVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR,TRAITS>::AVLmap_iterator, bool> CS280::AVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR,TRAITS>::emplace(ARGS&&... args)
+{
+    Node* node = CreateNode(nullptr, std::forward<ARGS>(args)...);
+
+    Node* parent = nullptr;
+    bool left = false;
+    Node* found = FindSlot(node->key, parent, left);
+
+    // The key already exists, throw away the node that was built
+    if(found != nullptr)
+    {
+        DestroyNode(node);
+        return std::pair<AVLmap_iterator, bool>(AVLmap_iterator(found, this), false);
+    }
+
+    return std::pair<AVLmap_iterator, bool>(AVLmap_iterator(InsertItem(node, parent, left), this), true);
+}
+
+/**
+ * @brief Builds the value in place from the arguments if the key is not in the map yet.
+ *        Nothing is built (or moved from) if the key already exists.
+ * 
+ * @param key - key to insert
+ * @param args - the value's constructor arguments
+ * @return the node with the key, and whether it was inserted
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename COMPARE, typename ALLOCATOR, typename TRAITS >
+template< typename... ARGS >
+std::pair<typename CS280::AVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR,TRAITS>::AVLmap_iterator, bool> CS280::AVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR,TRAITS>::try_emplace(KEY_TYPE const& key, ARGS&&... args)
+{
+    return TryEmplace(key, std::forward<ARGS>(args)...);
+}
+
+/**
+ * @brief Same as above, the key is moved into the node if it gets inserted.
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename COMPARE, typename ALLOCATOR, typename TRAITS >
+template< typename... ARGS >
+std::pair<typename CS280::AVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR,TRAITS>::AVLmap_iterator, bool> CS280::AVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR,TRAITS>::try_emplace(KEY_TYPE&& key, ARGS&&... args)
+{
+    return TryEmplace(std::move(key), std::forward<ARGS>(args)...);
+}
+
+/**
+ * @brief Builds a node from the arguments and links it right before the hint if its key belongs there,
+ *        without descending from the root. Otherwise it is inserted like emplace. The first argument builds
+ *        the key, the remaining ones build the value.
+ * 
+ * @param hint - node the key should come right before, end() to append after the last node
+ * @param args - key argument followed by the value's constructor arguments
+ * @return the node with the key (the node that was built is thrown away if the key already exists)
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename COMPARE, typename ALLOCATOR, typename TRAITS >
+template< typename... ARGS >
+typename CS280::AVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR,TRAITS>::AVLmap_iterator CS280::AVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR,TRAITS>::emplace_hint(AVLmap_iterator hint, ARGS&&... args)
+{
+    Node* node = CreateNode(nullptr, std::forward<ARGS>(args)...);
+
+    Node* parent = nullptr;
+    bool left = false;
+    Node* found = HintSlot(hint.mNode, node->key, parent, left);
+
+    if(found != nullptr)
+    {
+        DestroyNode(node);
+        return AVLmap_iterator(found, this);
+    }
+
+    return AVLmap_iterator(InsertItem(node, parent, left), this);
+}
+
+/**
+ * @brief Inserts a copy of the pair right before the hint if its key belongs there and is not in the map yet,
+ *        see emplace_hint. Nothing is copied if the key already exists.
+ * 
+ * @param hint - node the key should come right before, end() to append after the last node
+ * @param item - key and value to insert
+ * @return the node with the key
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename COMPARE, typename ALLOCATOR, typename TRAITS >
+typename CS280::AVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR,TRAITS>::AVLmap_iterator CS280::AVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR,TRAITS>::insert(AVLmap_iterator hint, value_type const& item)
+{
+    return TryEmplaceHint(hint.mNode, item.first, item.second);
+}
+
+/**
+ * @brief Same as above, the key and value are moved into the node if it gets inserted.
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename COMPARE, typename ALLOCATOR, typename TRAITS >
+typename CS280::AVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR,TRAITS>::AVLmap_iterator CS280::AVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR,TRAITS>::insert(AVLmap_iterator hint, value_type&& item)
+{
+    return TryEmplaceHint(hint.mNode, std::move(item.first), std::move(item.second));
+}
+
+/**
+ * @brief Unlinks a node and rebalances, without destroying it. The returned handle owns the node until it is
+ *        inserted into a map of the same type.
+ * 
+ * @param it - node to extract
+ * @return handle holding the node, empty if it is end
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename COMPARE, typename ALLOCATOR, typename TRAITS >
+typename CS280::AVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR,TRAITS>::node_type CS280::AVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR,TRAITS>::extract(AVLmap_iterator it)
+{
+    if(it.mNode == nullptr)
+        return node_type();
+
+    return ExtractNode(it.mNode);
+}
+
+/**
+ * @brief Unlinks the node with the given key, see extract(AVLmap_iterator).
+ * 
+ * @param key - key of the node to extract
+ * @return handle holding the node, empty if the key is missing
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename COMPARE, typename ALLOCATOR, typename TRAITS >
+typename CS280::AVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR,TRAITS>::node_type CS280::AVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR,TRAITS>::extract(KEY_TYPE const& key)
+{
+    Node* node = FindNode(mRoot, key);
+
+    if(node == nullptr)
+        return node_type();
+
+    return ExtractNode(node);
+}
+
+/**
+ * @brief Links the node of a handle into the map unless its key is already there. The node itself is linked,
+ *        nothing is allocated or copied, when the map can use the pool it comes from (see AdoptNode).
+ * 
+ * @param node - handle of the node to insert, left empty if it is inserted
+ * @return the node with the key, whether it was inserted, and the handle's node if it was not
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename COMPARE, typename ALLOCATOR, typename TRAITS >
+typename CS280::AVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR,TRAITS>::insert_return_type CS280::AVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR,TRAITS>::insert(node_type&& node)
+{
+    insert_return_type result{ end(), false, node_type() };
+
+    if(node.empty())
+        return result;
+
+    Node* parent = nullptr;
+    bool left = false;
+    Node* found = FindSlot(node.mNode->key, parent, left);
+
+    if(found != nullptr)
+    {
+        result.position = AVLmap_iterator(found, this);
+        result.node = std::move(node);
+        return result;
+    }
+
+    result.position = AVLmap_iterator(InsertItem(AdoptNode(node), parent, left), this);
+    result.inserted = true;
+
+    return result;
+}
+
+/**
+ * @brief Links the node of a handle right before the hint if its key belongs there, see emplace_hint and insert(node_type&&).
+ * 
+ * @param hint - node the key should come right before, end() to append after the last node
+ * @param node - handle of the node to insert, left as it is if the key is already there
+ * @return the node with the key (end() if the handle was empty)
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename COMPARE, typename ALLOCATOR, typename TRAITS >
+typename CS280::AVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR,TRAITS>::AVLmap_iterator CS280::AVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR,TRAITS>::insert(AVLmap_iterator hint, node_type&& node)
+{
+    if(node.empty())
+        return end();
+
+    Node* parent = nullptr;
+    bool left = false;
+    Node* found = HintSlot(hint.mNode, node.mNode->key, parent, left);
+
+    if(found != nullptr)
+        return AVLmap_iterator(found, this);
+
+    return AVLmap_iterator(InsertItem(AdoptNode(node), parent, left), this);
+}
+
+/**
+ * @brief Assigns the value if the key exists, otherwise inserts a node built from the key and value.
+ * 
+ * @param key - key to insert or assign
+ * @param obj - value to assign or build the node's value from
+ * @return the node with the key, and whether it was inserted
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename COMPARE, typename ALLOCATOR, typename TRAITS >
+template< typename M >
+std::pair<typename CS280::AVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR,TRAITS>::AVLmap_iterator, bool> CS280::AVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR,TRAITS>::insert_or_assign(KEY_TYPE const& key, M&& obj)
+{
+    return InsertOrAssign(key, std::forward<M>(obj));
+}
+
+/**
+ * @brief Same as above, the key is moved into the node if it gets inserted.
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename COMPARE, typename ALLOCATOR, typename TRAITS >
+template< typename M >
+std::pair<typename CS280::AVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR,TRAITS>::AVLmap_iterator, bool> CS280::AVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR,TRAITS>::insert_or_assign(KEY_TYPE&& key, M&& obj)
+{
+    return InsertOrAssign(std::move(key), std::forward<M>(obj));
+}
+
+template< typename KEY_TYPE, typename VALUE_TYPE, typename COMPARE, typename ALLOCATOR, typename TRAITS >
+typename CS280::AVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR,TRAITS>::AVLmap_iterator_const CS280::AVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR,TRAITS>::begin() const {
+	if constexpr(TRAITS::threaded) return AVLmap_iterator_const(mFirst, this);
+	if (mRoot) return AVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR,TRAITS>::AVLmap_iterator_const(mRoot->first(), this);
+	else       return AVLmap_iterator_const(nullptr, this);
+}
+
+template< typename KEY_TYPE, typename VALUE_TYPE, typename COMPARE, typename ALLOCATOR, typename TRAITS >
+typename CS280::AVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR,TRAITS>::AVLmap_iterator_const CS280::AVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR,TRAITS>::end() const {
+	return AVLmap_iterator_const(nullptr, this);
+}
+
+/**
+ * @brief Returns the const reverse begin iterator (the last node)
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename COMPARE, typename ALLOCATOR, typename TRAITS >
+typename CS280::AVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR,TRAITS>::const_reverse_iterator CS280::AVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR,TRAITS>::rbegin() const {
+    return const_reverse_iterator(end());
+}
+
+/**
+ * @brief Returns the const reverse end iterator (before the first node)
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename COMPARE, typename ALLOCATOR, typename TRAITS >
+typename CS280::AVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR,TRAITS>::const_reverse_iterator CS280::AVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR,TRAITS>::rend() const {
+    return const_reverse_iterator(begin());
+}
+
+/**
+ * @brief Finds the node of given key and returns as a const iterator
+ * 
+ * @param type - key of iterator to return
+ * @return CS280::AVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR,TRAITS>::AVLmap_iterator_const
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename COMPARE, typename ALLOCATOR, typename TRAITS >
+typename CS280::AVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR,TRAITS>::AVLmap_iterator_const CS280::AVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR,TRAITS>::find(KEY_TYPE const& type) const
+{
+    LatencyTimer timer(this, AVLmap_stats::FIND);
+    Node* foundNode = FindNode(mRoot, type);
+    return AVLmap_iterator_const(foundNode, this);
+}
+
+/**
+ * @brief Finds many keys at once, see the non-const find_batch
+ * 
+ * @param keys - keys to find
+ * @param count - number of keys
+ * @param results - set to the node of each key, or end if it is missing
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename COMPARE, typename ALLOCATOR, typename TRAITS >
+void CS280::AVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR,TRAITS>::find_batch(KEY_TYPE const* keys, std::size_t count, AVLmap_iterator_const* results) const
+{
+    Node* found[BATCH_LANES];
+
+    for(std::size_t first = 0; first < count; first += BATCH_LANES)
+    {
+        std::size_t lanes = std::min(count - first, BATCH_LANES);
+
+        FindNodes(keys + first, lanes, found);
+
+        for(std::size_t lane = 0; lane < lanes; ++lane)
+        {
+            results[first + lane] = AVLmap_iterator_const(found[lane], this);
+        }
+    }
+}
+
+/**
+ * @brief Checks many keys at once, with the same interleaved descent as find_batch
+ * 
+ * @param keys - keys to look for
+ * @param count - number of keys
+ * @param results - set to whether each key is in the map
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename COMPARE, typename ALLOCATOR, typename TRAITS >
+void CS280::AVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR,TRAITS>::contains_batch(KEY_TYPE const* keys, std::size_t count, bool* results) const
+{
+    Node* found[BATCH_LANES];
+
+    for(std::size_t first = 0; first < count; first += BATCH_LANES)
+    {
+        std::size_t lanes = std::min(count - first, BATCH_LANES);
+
+        FindNodes(keys + first, lanes, found);
+
+        for(std::size_t lane = 0; lane < lanes; ++lane)
+        {
+            results[first + lane] = found[lane] != nullptr;
+        }
+    }
+}
+
+/**
+ * @brief Returns the first node whose key is not less than the given key
+ * 
+ * @param key - key to search for
+ * @return CS280::AVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR,TRAITS>::AVLmap_iterator 
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename COMPARE, typename ALLOCATOR, typename TRAITS >
+typename CS280::AVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR,TRAITS>::AVLmap_iterator CS280::AVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR,TRAITS>::lower_bound(KEY_TYPE const& key)
+{
+    return AVLmap_iterator(LowerBound(mRoot, key), this);
+}
+
+/**
+ * @brief Returns the first node whose key is greater than the given key
+ * 
+ * @param key - key to search for
+ * @return CS280::AVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR,TRAITS>::AVLmap_iterator 
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename COMPARE, typename ALLOCATOR, typename TRAITS >
+typename CS280::AVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR,TRAITS>::AVLmap_iterator CS280::AVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR,TRAITS>::upper_bound(KEY_TYPE const& key)
+{
+    return AVLmap_iterator(UpperBound(key), this);
+}
+
+/**
+ * @brief Returns the range of nodes with the given key (empty or a single node), as lower_bound and upper_bound
+ * 
+ * @param key - key to search for
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename COMPARE, typename ALLOCATOR, typename TRAITS >
+std::pair<typename CS280::AVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR,TRAITS>::AVLmap_iterator, typename CS280::AVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR,TRAITS>::AVLmap_iterator> CS280::AVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR,TRAITS>::equal_range(KEY_TYPE const& key)
+{
+    Node* lower = nullptr;
+    Node* upper = nullptr;
+    EqualRange(key, lower, upper);
+
+    return std::pair<AVLmap_iterator, AVLmap_iterator>(AVLmap_iterator(lower, this), AVLmap_iterator(upper, this));
+}
+
+/**
+ * @brief Returns an iterable range of the nodes with lo <= key < hi. Walking it costs O(log n + k).
+ * 
+ * @param lo - smallest key in the range
+ * @param hi - first key past the range
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename COMPARE, typename ALLOCATOR, typename TRAITS >
+typename CS280::AVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR,TRAITS>::range_type CS280::AVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR,TRAITS>::range(KEY_TYPE const& lo, KEY_TYPE const& hi)
+{
+    AVLmap_iterator first = lower_bound(lo);
+
+    // An inverted range is empty
+    if(!mCompare(lo, hi))
+        return range_type(first, first);
+
+    return range_type(first, lower_bound(hi));
+}
+
+template< typename KEY_TYPE, typename VALUE_TYPE, typename COMPARE, typename ALLOCATOR, typename TRAITS >
+typename CS280::AVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR,TRAITS>::AVLmap_iterator_const CS280::AVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR,TRAITS>::lower_bound(KEY_TYPE const& key) const
+{
+    return AVLmap_iterator_const(LowerBound(mRoot, key), this);
+}
+
+template< typename KEY_TYPE, typename VALUE_TYPE, typename COMPARE, typename ALLOCATOR, typename TRAITS >
+typename CS280::AVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR,TRAITS>::AVLmap_iterator_const CS280::AVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR,TRAITS>::upper_bound(KEY_TYPE const& key) const
+{
+    return AVLmap_iterator_const(UpperBound(key), this);
+}
+
+template< typename KEY_TYPE, typename VALUE_TYPE, typename COMPARE, typename ALLOCATOR, typename TRAITS >
+std::pair<typename CS280::AVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR,TRAITS>::AVLmap_iterator_const, typename CS280::AVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR,TRAITS>::AVLmap_iterator_const> CS280::AVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR,TRAITS>::equal_range(KEY_TYPE const& key) const
+{
+    Node* lower = nullptr;
+    Node* upper = nullptr;
+    EqualRange(key, lower, upper);
+
+    return std::pair<AVLmap_iterator_const, AVLmap_iterator_const>(AVLmap_iterator_const(lower, this), AVLmap_iterator_const(upper, this));
+}
+
+template< typename KEY_TYPE, typename VALUE_TYPE, typename COMPARE, typename ALLOCATOR, typename TRAITS >
+typename CS280::AVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR,TRAITS>::const_range_type CS280::AVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR,TRAITS>::range(KEY_TYPE const& lo, KEY_TYPE const& hi) const
+{
+    AVLmap_iterator_const first = lower_bound(lo);
+
+    // An inverted range is empty
+    if(!mCompare(lo, hi))
+        return const_range_type(first, first);
+
+    return const_range_type(first, lower_bound(hi));
+}
+
+/**
+ * @brief lower_bound for a key of another type, only when COMPARE is transparent
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename COMPARE, typename ALLOCATOR, typename TRAITS >
+template< typename KEY_ARG, typename CMP, typename >
+typename CS280::AVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR,TRAITS>::AVLmap_iterator CS280::AVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR,TRAITS>::lower_bound(KEY_ARG const& key)
+{
+    return AVLmap_iterator(LowerBound(mRoot, key), this);
+}
+
+/**
+ * @brief upper_bound for a key of another type, only when COMPARE is transparent
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename COMPARE, typename ALLOCATOR, typename TRAITS >
+template< typename KEY_ARG, typename CMP, typename >
+typename CS280::AVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR,TRAITS>::AVLmap_iterator CS280::AVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR,TRAITS>::upper_bound(KEY_ARG const& key)
+{
+    return AVLmap_iterator(UpperBound(key), this);
+}
+
+/**
+ * @brief equal_range for a key of another type, only when COMPARE is transparent
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename COMPARE, typename ALLOCATOR, typename TRAITS >
+template< typename KEY_ARG, typename CMP, typename >
+std::pair<typename CS280::AVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR,TRAITS>::AVLmap_iterator, typename CS280::AVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR,TRAITS>::AVLmap_iterator> CS280::AVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR,TRAITS>::equal_range(KEY_ARG const& key)
+{
+    Node* lower = nullptr;
+    Node* upper = nullptr;
+    EqualRange(key, lower, upper);
+
+    return std::pair<AVLmap_iterator, AVLmap_iterator>(AVLmap_iterator(lower, this), AVLmap_iterator(upper, this));
+}
+
+/**
+ * @brief find for a key of another type, only when COMPARE is transparent
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename COMPARE, typename ALLOCATOR, typename TRAITS >
+template< typename KEY_ARG, typename CMP, typename >
+typename CS280::AVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR,TRAITS>::AVLmap_iterator_const CS280::AVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR,TRAITS>::find(KEY_ARG const& key) const
+{
+    LatencyTimer timer(this, AVLmap_stats::FIND);
+    return AVLmap_iterator_const(FindNode(mRoot, key), this);
+}
+
+/**
+ * @brief lower_bound for a key of another type, only when COMPARE is transparent
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename COMPARE, typename ALLOCATOR, typename TRAITS >
+template< typename KEY_ARG, typename CMP, typename >
+typename CS280::AVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR,TRAITS>::AVLmap_iterator_const CS280::AVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR,TRAITS>::lower_bound(KEY_ARG const& key) const
+{
+    return AVLmap_iterator_const(LowerBound(mRoot, key), this);
+}
+
+/**
+ * @brief upper_bound for a key of another type, only when COMPARE is transparent
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename COMPARE, typename ALLOCATOR, typename TRAITS >
+template< typename KEY_ARG, typename CMP, typename >
+typename CS280::AVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR,TRAITS>::AVLmap_iterator_const CS280::AVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR,TRAITS>::upper_bound(KEY_ARG const& key) const
+{
+    return AVLmap_iterator_const(UpperBound(key), this);
+}
+
+/**
+ * @brief equal_range for a key of another type, only when COMPARE is transparent
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename COMPARE, typename ALLOCATOR, typename TRAITS >
+template< typename KEY_ARG, typename CMP, typename >
+std::pair<typename CS280::AVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR,TRAITS>::AVLmap_iterator_const, typename CS280::AVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR,TRAITS>::AVLmap_iterator_const> CS280::AVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR,TRAITS>::equal_range(KEY_ARG const& key) const
+{
+    Node* lower = nullptr;
+    Node* upper = nullptr;
+    EqualRange(key, lower, upper);
+
+    return std::pair<AVLmap_iterator_const, AVLmap_iterator_const>(AVLmap_iterator_const(lower, this), AVLmap_iterator_const(upper, this));
+}
+
+/**
+ * @brief Returns the node at the given position in key order. Needs TRAITS::order_statistics.
+ * 
+ * @param index - 0-based position
+ * @return the node, or end() if the index is past the last node
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename COMPARE, typename ALLOCATOR, typename TRAITS >
+typename CS280::AVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR,TRAITS>::AVLmap_iterator CS280::AVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR,TRAITS>::nth(unsigned int index)
+{
+    return AVLmap_iterator(NthNode(index), this);
+}
+
+/**
+ * @brief Returns the node at the given position in key order. Needs TRAITS::order_statistics.
+ * 
+ * @param index - 0-based position
+ * @return the node, or end() if the index is past the last node
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename COMPARE, typename ALLOCATOR, typename TRAITS >
+typename CS280::AVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR,TRAITS>::AVLmap_iterator_const CS280::AVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR,TRAITS>::nth(unsigned int index) const
+{
+    return AVLmap_iterator_const(NthNode(index), this);
+}
+
+/**
+ * @brief Returns how many keys are less than the given key (its position if it is in the map). Needs TRAITS::order_statistics.
+ * 
+ * @param key - key to rank
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename COMPARE, typename ALLOCATOR, typename TRAITS >
+unsigned int CS280::AVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR,TRAITS>::rank(KEY_TYPE const& key) const
+{
+    static_assert(TRAITS::order_statistics, "rank needs TRAITS::order_statistics");
+
+    unsigned int less = 0;
+    Node* walker = mRoot;
+    unsigned int depth = 0;
+
+    while(walker != nullptr)
+    {
+        ++depth;
+
+        if(Less(walker->key, key))
+        {
+            // This node and its whole left subtree are less than the key
+            less += GetSubtreeCount(walker->left) + 1;
+            walker = walker->right;
+        }
+        else
+        {
+            walker = walker->left;
+        }
+    }
+
+    CountSearch(depth);
+
+    return less;
+}
+
+/**
+ * @brief Returns how many keys are in the range lo <= key < hi. Needs TRAITS::order_statistics.
+ * 
+ * @param lo - smallest key in the range
+ * @param hi - first key past the range
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename COMPARE, typename ALLOCATOR, typename TRAITS >
+unsigned int CS280::AVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR,TRAITS>::count(KEY_TYPE const& lo, KEY_TYPE const& hi) const
+{
+    // An inverted range is empty
+    if(!mCompare(lo, hi))
+        return 0;
+
+    return rank(hi) - rank(lo);
+}
+
+/**
+ * @brief Takes a read-only snapshot of the map for lookup heavy use. The keys and values are copied into flat
+ *        arrays in Eytzinger order, later changes to the map don't show in the snapshot. O(n).
+ *
+ * @return the snapshot
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename COMPARE, typename ALLOCATOR, typename TRAITS >
+CS280::FrozenAVLmap<KEY_TYPE,VALUE_TYPE,COMPARE> CS280::AVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR,TRAITS>::freeze() const
+{
+    return FrozenAVLmap<KEY_TYPE,VALUE_TYPE,COMPARE>(begin(), end(), mCompare);
+}
+
+/**
+ * @brief Writes the map to a snapshot file, the entries in key order in the layout MappedAVLmap reads in place.
+ *        The file is only replaced once it is complete. O(n).
+ *
+ * @param path - file to write
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename COMPARE, typename ALLOCATOR, typename TRAITS >
+void CS280::AVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR,TRAITS>::save(std::string const& path) const
+{
+    AVLmap_snapshot<KEY_TYPE,VALUE_TYPE>::write(path, begin(), end());
+}
+
+/**
+ * @brief Replaces the contents with a snapshot file. The entries are read with file streams, so this works
+ *        wherever the standard library does, and their sorted order is built into a balanced tree in one pass,
+ *        without a search per key. O(n).
+ *
+ * @param path - file written by save
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename COMPARE, typename ALLOCATOR, typename TRAITS >
+void CS280::AVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR,TRAITS>::load(std::string const& path)
+{
+    typedef AVLmap_snapshot<KEY_TYPE,VALUE_TYPE> Snapshot;
+
+    std::vector<typename Snapshot::NodeStorage> entries = Snapshot::read(path);
+    typename Snapshot::Node const* first = reinterpret_cast<typename Snapshot::Node const*>(entries.data());
+
+    assign(first, first + entries.size());
+}
+
+/**
+ * @brief Returns a copy of the counters, with height set to the current height of the tree (the root's
+ *        rank + 1 with weak balancing, which is at least the height). Needs TRAITS::statistics.
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename COMPARE, typename ALLOCATOR, typename TRAITS >
+typename CS280::AVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR,TRAITS>::stats_type CS280::AVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR,TRAITS>::stats() const
+{
+    static_assert(TRAITS::statistics, "stats needs TRAITS::statistics");
+
+    stats_type snapshot = mStats;
+    snapshot.comparisons = mLookups.comparisons.load(std::memory_order_relaxed);
+    snapshot.searches = mLookups.searches.load(std::memory_order_relaxed);
+    snapshot.searchDepth = mLookups.searchDepth.load(std::memory_order_relaxed);
+    snapshot.maxSearchDepth = mLookups.maxSearchDepth.load(std::memory_order_relaxed);
+
+    for(std::size_t operation = 0; operation < AVLmap_stats::OPERATIONS; ++operation)
+    {
+        for(std::size_t bucket = 0; bucket < AVLmap_stats::LATENCY_BUCKETS; ++bucket)
+        {
+            snapshot.latency[operation][bucket] = mLookups.latency[operation][bucket].load(std::memory_order_relaxed);
+        }
+    }
+
+    snapshot.height = mRoot ? static_cast<unsigned int>(mRoot->height) + 1 : 0;
+
+    return snapshot;
+}
+
+/**
+ * @brief Sets every counter back to zero. Needs TRAITS::statistics.
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename COMPARE, typename ALLOCATOR, typename TRAITS >
+void CS280::AVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR,TRAITS>::reset_stats()
+{
+    static_assert(TRAITS::statistics, "reset_stats needs TRAITS::statistics");
+
+    mStats = stats_type();
+    mLookups.comparisons.store(0, std::memory_order_relaxed);
+    mLookups.searches.store(0, std::memory_order_relaxed);
+    mLookups.searchDepth.store(0, std::memory_order_relaxed);
+    mLookups.maxSearchDepth.store(0, std::memory_order_relaxed);
+
+    for(auto& histogram : mLookups.latency)
+    {
+        for(auto& bucket : histogram)
+        {
+            bucket.store(0, std::memory_order_relaxed);
+        }
+    }
+}
+
+/**
+ * @brief Calls f on every node from several threads, see RunTasks. The values can be changed, the keys can't.
+ * 
+ * @param f - called as f(node) with a Node&, must be safe to call from several threads at once
+ * @param threads - number of threads to use, 0 for every hardware thread
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename COMPARE, typename ALLOCATOR, typename TRAITS >
+template< typename FUNC >
+void CS280::AVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR,TRAITS>::parallel_for_each(FUNC f, unsigned int threads)
+{
+    unsigned int count = ParallelThreads(threads, size_);
+    std::vector<Node*> bounds;
+
+    SplitRanges(count == 1 ? 1 : count * RANGES_PER_THREAD, bounds);
+
+    auto task = [&f, &bounds](std::size_t range)
+    {
+        for(Node* node = bounds[range]; node != bounds[range + 1]; node = node->increment())
+        {
+            f(*node);
+        }
+    };
+
+    RunTasks(bounds.empty() ? 0 : bounds.size() - 1, count, task);
+}
+
+/**
+ * @brief Calls f on every node from several threads, see the non-const parallel_for_each
+ * 
+ * @param f - called as f(node) with a Node const&, must be safe to call from several threads at once
+ * @param threads - number of threads to use, 0 for every hardware thread
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename COMPARE, typename ALLOCATOR, typename TRAITS >
+template< typename FUNC >
+void CS280::AVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR,TRAITS>::parallel_for_each(FUNC f, unsigned int threads) const
+{
+    unsigned int count = ParallelThreads(threads, size_);
+    std::vector<Node*> bounds;
+
+    SplitRanges(count == 1 ? 1 : count * RANGES_PER_THREAD, bounds);
+
+    auto task = [&f, &bounds](std::size_t range)
+    {
+        for(Node* node = bounds[range]; node != bounds[range + 1]; node = node->increment())
+        {
+            f(static_cast<Node const&>(*node));
+        }
+    };
+
+    RunTasks(bounds.empty() ? 0 : bounds.size() - 1, count, task);
+}
+
+/**
+ * @brief Reduces the map from several threads. Each range is folded into its own result, in key order,
+ *        and the results are combined left to right afterwards, so the answer is the one a sequential
+ *        fold would give whenever combine(fold(a, x), b) and fold(combine(a, b), x) agree.
+ * 
+ * @param identity - starting value of every range, must be an identity of combine
+ * @param fold - called as fold(result, node) with a Node const&, returns the new result
+ * @param combine - called as combine(left, right) on the results of neighbouring ranges
+ * @param threads - number of threads to use, 0 for every hardware thread
+ * @return the combined result, identity for an empty map
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename COMPARE, typename ALLOCATOR, typename TRAITS >
+template< typename T, typename FOLD, typename COMBINE >
+T CS280::AVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR,TRAITS>::parallel_reduce(T identity, FOLD fold, COMBINE combine, unsigned int threads) const
+{
+    unsigned int count = ParallelThreads(threads, size_);
+    std::vector<Node*> bounds;
+
+    SplitRanges(count == 1 ? 1 : count * RANGES_PER_THREAD, bounds);
+
+    // Wrapped so every range writes its own object, even for T = bool
+    struct Partial
+    {
+        T value;
+    };
+    std::vector<Partial> results(bounds.empty() ? 0 : bounds.size() - 1, Partial{identity});
+
+    auto task = [&fold, &results, &bounds](std::size_t range)
+    {
+        T result = results[range].value;
+
+        for(Node* node = bounds[range]; node != bounds[range + 1]; node = node->increment())
+        {
+            result = fold(std::move(result), static_cast<Node const&>(*node));
+        }
+
+        results[range].value = std::move(result);
+    };
+
+    RunTasks(results.size(), count, task);
+
+    T total = std::move(identity);
+
+    for(Partial& result : results)
+    {
+        total = combine(std::move(total), std::move(result.value));
+    }
+
+    return total;
+}
+
+/**
+ * @brief Returns the depth of a node (number of edges up to the root).
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename COMPARE, typename ALLOCATOR, typename TRAITS >
+int CS280::AVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR,TRAITS>::getdepth(const Node* node) const {
+	int depth = 0;
+
+	while(node->parent)
+	{
+		node = node->parent;
+		++depth;
+	}
+
+	return depth;
+}
+
+////////////////////////////////////////////////////////////
+// do not change this code from here to the end of the file
+/* figure out whether node is left or right child or root 
+ * used in print_backwards_padded 
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename COMPARE, typename ALLOCATOR, typename TRAITS >
+char CS280::AVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR,TRAITS>::getedgesymbol(const Node* node) const {
+	const Node* parent = node->parent;
+	if ( parent == nullptr) return '-';
+	else                 return ( parent->left == node)?'\\':'/';
+}
+
+/* this is another "ASCII-graphical" print, but using 
+ * iterative function. 
+ * Left branch of the tree is at the bottom
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename COMPARE, typename ALLOCATOR, typename TRAITS >
+std::ostream& CS280::operator<<(std::ostream& os, AVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR,TRAITS> const& map) {
+	map.print(os);
+	return os;
+}
+
+template< typename KEY_TYPE, typename VALUE_TYPE, typename COMPARE, typename ALLOCATOR, typename TRAITS >
+void CS280::AVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR,TRAITS>::print(std::ostream& os, bool print_value ) const {
+	if (mRoot) {
+		AVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR,TRAITS>::Node* b = mRoot->last();
+		while ( b ) { 
+			int depth = getdepth(b);
+			int i;
+			/* printf(b); */
+
+			char edge = getedgesymbol(b);
+			switch (edge) {
+				case '-': 
+					for (i=0; i<depth; ++i) std::printf("       ");
+					os << b->key;
+                    if ( print_value ) { os << " -> " << b->value; }
+                    os << std::endl;
+					break;
+				case '\\': 
+					for (i=0; i<depth; ++i) std::printf("       ");
+					os << edge << std::endl;
+					for (i=0; i<depth; ++i) std::printf("       ");
+					os << b->key;
+                    if ( print_value ) { os << " -> " << b->value; }
+                    os << std::endl;
+					break;
+				case '/': 
+					for (i=0; i<depth; ++i) std::printf("       ");
+					os << b->key;
+                    if ( print_value ) { os << " -> " << b->value; }
+                    os << std::endl;
+					for (i=0; i<depth; ++i) std::printf("       ");
+					os << edge << std::endl;
+					break;
+			}
+			b = b->decrement();
+		}
+	}
+	std::printf("\n");
+}
+
+/**
+ * @brief Checks the whole tree in one in-order walk through the parent pointers, so it needs no stack and
+ *        visits each link a constant number of times. Each node's cached data is checked against its children's
+ *        cached data, which is enough: leaves are checked directly, so by induction every cached height is right.
+ *        The walk only goes down links whose parent pointer was checked and stops after size_ nodes, so it
+ *        finishes even on a corrupt tree. O(n).
+ * 
+ * @return whether every invariant holds
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename COMPARE, typename ALLOCATOR, typename TRAITS >
+bool CS280::AVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR,TRAITS>::sanityCheck() const
+{
+    if(mRoot == nullptr)
+        return size_ == 0 && mFirst == nullptr && mLast == nullptr;
+
+    if(mRoot->parent != nullptr)
+        return false;
+
+    Node* walker = mRoot;
+    Node* previous = nullptr;
+    unsigned int count = 0;
+
+    // Every step down checks the child points back, so a node can't be reached twice
+    while(walker->left != nullptr)
+    {
+        if(walker->left->parent != walker)
+            return false;
+
+        walker = walker->left;
+    }
+
+    if constexpr(TRAITS::threaded)
+    {
+        if(mFirst != walker)
+            return false;
+    }
+
+    while(walker != nullptr)
+    {
+        // CheckNode also checks the children point back, so the step right stays on real links
+        if(++count > size_ || !CheckNode(walker))
+            return false;
+
+        if(previous != nullptr && !mCompare(previous->key, walker->key))
+            return false;
+
+        if constexpr(TRAITS::threaded)
+        {
+            if(walker->prev != previous || (previous != nullptr && previous->next != walker))
+                return false;
+        }
+
+        previous = walker;
+
+        // Step to the successor
+        if(walker->right != nullptr)
+        {
+            walker = walker->right;
+
+            while(walker->left != nullptr)
+            {
+                if(walker->left->parent != walker)
+                    return false;
+
+                walker = walker->left;
+            }
+        }
+        else
+        {
+            Node* child = walker;
+            walker = walker->parent;
+
+            while(walker != nullptr && walker->right == child)
+            {
+                child = walker;
+                walker = walker->parent;
+            }
+        }
+    }
+
+    if constexpr(TRAITS::threaded)
+    {
+        if(previous->next != nullptr)
+            return false;
+    }
+
+    return mLast == previous && count == size_;
+}
+
+/**
+ * @brief Finds a node in the tree with the given key. Does one comparison per level: it walks down to the
+ *        lower bound, which is the key's node unless the key is less than it.
+ * 
+ * @param tree - node to start search at
+ * @param key - key to find (KEY_TYPE, or any type COMPARE can compare with it when it is transparent)
+ * @return the found node
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename COMPARE, typename ALLOCATOR, typename TRAITS >
+template< typename KEY_ARG >
+typename CS280::AVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR,TRAITS>::Node* CS280::AVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR,TRAITS>::FindNode(Node* tree, KEY_ARG const& key) const
+{
+    Node* bound = LowerBound(tree, key);
+
+    if(bound != nullptr && !Less(key, bound->key))
+        return bound;
+
+    return nullptr;
+}
+
+/**
+ * @brief Finds up to BATCH_LANES keys in lockstep. Every round moves each unfinished lookup one level down
+ *        and prefetches the node it lands on, so by the time the round gets back to that lookup its node is
+ *        usually in cache. Each lane does the same single comparison per level as LowerBound.
+ * 
+ * @param keys - keys to find
+ * @param count - number of keys, at most BATCH_LANES
+ * @param found - set to the node of each key, or null if it is missing
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename COMPARE, typename ALLOCATOR, typename TRAITS >
+void CS280::AVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR,TRAITS>::FindNodes(KEY_TYPE const* keys, std::size_t count, Node** found) const
+{
+    Node* walkers[BATCH_LANES];
+    unsigned int depths[BATCH_LANES];
+
+    for(std::size_t lane = 0; lane < count; ++lane)
+    {
+        walkers[lane] = mRoot;
+        found[lane] = nullptr;
+        depths[lane] = 0;
+    }
+
+    // the lanes of a balanced tree finish within a level or two of each other, so few rounds are wasted
+    for(bool walking = mRoot != nullptr; walking; )
+    {
+        walking = false;
+
+        for(std::size_t lane = 0; lane < count; ++lane)
+        {
+            Node* walker = walkers[lane];
+
+            if(walker == nullptr)
+                continue;
+
+            ++depths[lane];
+
+            if(Less(walker->key, keys[lane]))
+            {
+                walker = walker->right;
+            }
+            else
+            {
+                found[lane] = walker;
+                walker = walker->left;
+            }
+
+            walkers[lane] = walker;
+
+            if(walker != nullptr)
+            {
+                PrefetchNode(walker);
+                walking = true;
+            }
+        }
+    }
+
+    // each bound is not less than its key, so it is the key's node unless the key is less than it
+    for(std::size_t lane = 0; lane < count; ++lane)
+    {
+        if(found[lane] != nullptr && Less(keys[lane], found[lane]->key))
+            found[lane] = nullptr;
+
+        CountSearch(depths[lane]);
+    }
+}
+
+/**
+ * @brief Starts loading a node into cache, its links too when they are on another cache line.
+ *        Does nothing when the compiler has no prefetch builtin.
+ * 
+ * @param node - node the next round will look at
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename COMPARE, typename ALLOCATOR, typename TRAITS >
+void CS280::AVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR,TRAITS>::PrefetchNode(Node const* node)
+{
+#if defined(__GNUC__)
+    __builtin_prefetch(&node->key);
+
+    if constexpr(sizeof(Node) > 64)
+        __builtin_prefetch(&node->left);
+#else
+    (void)node;
+#endif
+}
+
+/**
+ * @brief Compares two keys with mCompare, counting the comparison when TRAITS::statistics is on.
+ *        Searches compare through here, bulk operations use mCompare directly.
+ * 
+ * @return whether lhs is ordered before rhs
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename COMPARE, typename ALLOCATOR, typename TRAITS >
+template< typename LHS, typename RHS >
+bool CS280::AVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR,TRAITS>::Less(LHS const& lhs, RHS const& rhs) const
+{
+    if constexpr(TRAITS::statistics)
+    {
+        mLookups.comparisons.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    return mCompare(lhs, rhs);
+}
+
+/**
+ * @brief Counts a finished descent when TRAITS::statistics is on.
+ * 
+ * @param depth - number of nodes the descent visited
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename COMPARE, typename ALLOCATOR, typename TRAITS >
+void CS280::AVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR,TRAITS>::CountSearch(unsigned int depth) const
+{
+    if constexpr(TRAITS::statistics)
+    {
+        mLookups.searches.fetch_add(1, std::memory_order_relaxed);
+        mLookups.searchDepth.fetch_add(depth, std::memory_order_relaxed);
+
+        unsigned int deepest = mLookups.maxSearchDepth.load(std::memory_order_relaxed);
+
+        while(depth > deepest && !mLookups.maxSearchDepth.compare_exchange_weak(deepest, depth, std::memory_order_relaxed))
+        {
+        }
+    }
+    else
+    {
+        (void)depth;
+    }
+}
+
+/**
+ * @brief Checks the invariants of one node that only depend on it and its children: the children's parent
+ *        pointers, the key order between them, the cached height, balance and subtree count, and the balance
+ *        rule of TRAITS::balancing (with weak balancing: the rank differences to the children and a leaf's rank).
+ * 
+ * @param node - node to check
+ * @return whether they hold
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename COMPARE, typename ALLOCATOR, typename TRAITS >
+bool CS280::AVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR,TRAITS>::CheckNode(Node const* node) const
+{
+    Node* left = node->left;
+    Node* right = node->right;
+
+    if(left != nullptr && (left->parent != node || !mCompare(left->key, node->key)))
+        return false;
+
+    if(right != nullptr && (right->parent != node || !mCompare(node->key, right->key)))
+        return false;
+
+    int leftHeight = GetSubtreeHeight(left);
+    int rightHeight = GetSubtreeHeight(right);
+
+    if(node->balance != leftHeight - rightHeight)
+        return false;
+
+    if constexpr(TRAITS::balancing == AVLmap_balancing::weak)
+    {
+        int leftGap = node->height - leftHeight;
+        int rightGap = node->height - rightHeight;
+
+        if(leftGap < 1 || leftGap > 2 || rightGap < 1 || rightGap > 2)
+            return false;
+
+        if(left == nullptr && right == nullptr && node->height != 0)
+            return false;
+    }
+    else
+    {
+        if(node->height != 1 + std::max(leftHeight, rightHeight))
+            return false;
+
+        if(node->balance < -MAX_BALANCE || node->balance > MAX_BALANCE)
+            return false;
+    }
+
+    if constexpr(TRAITS::order_statistics)
+    {
+        if(node->count != 1 + GetSubtreeCount(left) + GetSubtreeCount(right))
+            return false;
+    }
+
+    return true;
+}
+
+/**
+ * @brief Checks a subtree BalanceTree just rotated when TRAITS::debug_checks is on: the promoted node is linked
+ *        to its parent and it and both of its children pass CheckNode. The rest of the tree isn't touched, O(1).
+ * 
+ * @param top - node the rotation promoted
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename COMPARE, typename ALLOCATOR, typename TRAITS >
+void CS280::AVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR,TRAITS>::CheckRotation(Node const* top) const
+{
+    if constexpr(TRAITS::debug_checks)
+    {
+        Node const* parent = top->parent;
+        bool linked = parent == nullptr || parent->left == top || parent->right == top;
+
+        if(!linked || !CheckNode(top) || (top->left != nullptr && !CheckNode(top->left)) ||
+           (top->right != nullptr && !CheckNode(top->right)))
+        {
+            throw std::logic_error("AVLmap: a rotation broke the tree's invariants");
+        }
+    }
+    else
+    {
+        (void)top;
+    }
+}
+
+/**
+ * @brief Counts a rebalancing rotation when TRAITS::statistics is on.
+ * 
+ * @param isDouble - whether it was a double rotation (counted once, not as two singles)
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename COMPARE, typename ALLOCATOR, typename TRAITS >
+void CS280::AVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR,TRAITS>::CountRotation(bool isDouble)
+{
+    if constexpr(TRAITS::statistics)
+    {
+        if(isDouble)
+        {
+            ++mStats.doubleRotations;
+        }
+        else
+        {
+            ++mStats.singleRotations;
+        }
+    }
+    else
+    {
+        (void)isDouble;
+    }
+}
+
+/**
+ * @brief Finds the node with the given key, or the spot where it would be linked if it is missing.
+ *        Does one comparison per level, equal keys go right so the last node we went right at is the only possible match.
+ * 
+ * @param key - key to find
+ * @param parent - set to the node the key would be linked under (null if the tree is empty)
+ * @param left - set to whether the key would be the parent's left child
+ * @return the node with the key, or null if it is missing
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename COMPARE, typename ALLOCATOR, typename TRAITS >
+typename CS280::AVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR,TRAITS>::Node* CS280::AVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR,TRAITS>::FindSlot(KEY_TYPE const& key, Node*& parent, bool& left) const
+{
+    Node* walker = mRoot;
+    Node* candidate = nullptr;
+    unsigned int depth = 0;
+
+    while(walker != nullptr)
+    {
+        parent = walker;
+        ++depth;
+
+        if(Less(key, walker->key))
+        {
+            left = true;
+            walker = walker->left;
+        }
+        else
+        {
+            left = false;
+            candidate = walker;
+            walker = walker->right;
+        }
+    }
+
+    CountSearch(depth);
+
+    // The candidate is not greater than the key, so it is the key if it is not less either
+    if(candidate != nullptr && !Less(candidate->key, key))
+        return candidate;
+
+    return nullptr;
+}
+
+/**
+ * @brief Like FindSlot, but first checks whether the key goes right between the hint and its predecessor.
+ *        If it does, the slot is the hint's empty left link or else its predecessor's empty right link (the
+ *        predecessor is then the last node of the hint's left subtree), found with two comparisons and no descent.
+ *        Appending uses the cached last node, so it is O(1) before rebalancing.
+ * 
+ * @param hint - node the key should come right before, null to append after the last node
+ * @param key - key to find
+ * @param parent - set to the node the key would be linked under (null if the tree is empty)
+ * @param left - set to whether the key would be the parent's left child
+ * @return the node with the key, or null if it is missing
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename COMPARE, typename ALLOCATOR, typename TRAITS >
+typename CS280::AVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR,TRAITS>::Node* CS280::AVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR,TRAITS>::HintSlot(Node* hint, KEY_TYPE const& key, Node*& parent, bool& left) const
+{
+    Node* before = hint ? hint->decrement() : mLast;
+
+    bool afterBefore = before == nullptr || Less(before->key, key);
+    bool beforeHint = hint == nullptr || Less(key, hint->key);
+
+    if(afterBefore && beforeHint)
+    {
+        if(hint != nullptr && hint->left == nullptr)
+        {
+            parent = hint;
+            left = true;
+        }
+        else
+        {
+            parent = before;
+            left = false;
+        }
+
+        return nullptr;
+    }
+
+    // The key is the hint's or its predecessor's
+    if(!beforeHint && !Less(hint->key, key))
+        return hint;
+
+    if(!afterBefore && !Less(key, before->key))
+        return before;
+
+    return FindSlot(key, parent, left);
+}
+
+/**
+ * @brief Finds the first node in a subtree whose key is not less than the given key.
+ * 
+ * @param tree - subtree to search
+ * @param key - key to search for
+ * @return the found node, or null if every key is less
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename COMPARE, typename ALLOCATOR, typename TRAITS >
+template< typename KEY_ARG >
+typename CS280::AVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR,TRAITS>::Node* CS280::AVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR,TRAITS>::LowerBound(Node* tree, KEY_ARG const& key) const
+{
+    Node* walker = tree;
+    Node* bound = nullptr;
+    unsigned int depth = 0;
+
+    while(walker != nullptr)
+    {
+        ++depth;
+
+        if(Less(walker->key, key))
+        {
+            walker = walker->right;
+        }
+        else
+        {
+            // This node is a candidate, look for a smaller one on the left
+            bound = walker;
+            walker = walker->left;
+        }
+    }
+
+    CountSearch(depth);
+
+    return bound;
+}
+
+/**
+ * @brief Finds the first node whose key is greater than the given key.
+ * 
+ * @param key - key to search for
+ * @return the found node, or null if no key is greater
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename COMPARE, typename ALLOCATOR, typename TRAITS >
+template< typename KEY_ARG >
+typename CS280::AVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR,TRAITS>::Node* CS280::AVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR,TRAITS>::UpperBound(KEY_ARG const& key) const
+{
+    Node* walker = mRoot;
+    Node* bound = nullptr;
+    unsigned int depth = 0;
+
+    while(walker != nullptr)
+    {
+        ++depth;
+
+        if(Less(key, walker->key))
+        {
+            // This node is a candidate, look for a smaller one on the left
+            bound = walker;
+            walker = walker->left;
+        }
+        else
+        {
+            walker = walker->right;
+        }
+    }
+
+    CountSearch(depth);
+
+    return bound;
+}
+
+/**
+ * @brief Finds both bounds of a key in one descent. Keys are unique, so if the lower bound is the key
+ *        the upper bound is its successor, otherwise both bounds are the same node.
+ * 
+ * @param key - key to search for
+ * @param lower - set to the lower bound
+ * @param upper - set to the upper bound
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename COMPARE, typename ALLOCATOR, typename TRAITS >
+template< typename KEY_ARG >
+void CS280::AVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR,TRAITS>::EqualRange(KEY_ARG const& key, Node*& lower, Node*& upper) const
+{
+    lower = LowerBound(mRoot, key);
+    upper = lower;
+
+    if(lower != nullptr && !Less(key, lower->key))
+        upper = lower->increment();
+}
+
+/**
+ * @brief Finds and erases the node with the given key.
+ * 
+ * @param key - key to erase
+ * @return number of nodes erased (0 or 1)
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename COMPARE, typename ALLOCATOR, typename TRAITS >
+template< typename KEY_ARG >
+unsigned int CS280::AVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR,TRAITS>::EraseKey(KEY_ARG const& key)
+{
+    LatencyTimer timer(this, AVLmap_stats::ERASE);
+    Node* node = FindNode(mRoot, key);
+
+    if(node == nullptr)
+        return 0;
+
+    EraseNode(node);
+
+    return 1;
+}
+
+/**
+ * @brief Unlinks and frees a node, then rebalances from where the tree lost it.
+ * 
+ * @param node - node to erase
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename COMPARE, typename ALLOCATOR, typename TRAITS >
+void CS280::AVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR,TRAITS>::EraseNode(Node* node)
+{
+    Node* removedParent = UnlinkItem(node);
+    FreeNode(node);
+
+    AddToCounts(removedParent, -1);
+    BalanceAfterUnlink(removedParent);
+}
+
+/**
+ * @brief Finds the key, and only if it is missing builds a node from the key and arguments and links it.
+ * 
+ * @param key - key to find or insert
+ * @param args - the value's constructor arguments
+ * @return the node with the key, and whether it was inserted
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename COMPARE, typename ALLOCATOR, typename TRAITS >
+template< typename KEY_ARG, typename... ARGS >
+std::pair<typename CS280::AVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR,TRAITS>::AVLmap_iterator, bool> CS280::AVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR,TRAITS>::TryEmplace(KEY_ARG&& key, ARGS&&... args)
+{
+    LatencyTimer timer(this, AVLmap_stats::INSERT);
+    Node* parent = nullptr;
+    bool left = false;
+    Node* found = FindSlot(key, parent, left);
+
+    if(found != nullptr)
+    {
+        return std::pair<AVLmap_iterator, bool>(AVLmap_iterator(found, this), false);
+    }
+
+    // Build the node in place
+    Node* node = CreateNode(nullptr, std::forward<KEY_ARG>(key), std::forward<ARGS>(args)...);
+
+    return std::pair<AVLmap_iterator, bool>(AVLmap_iterator(InsertItem(node, parent, left), this), true);
+}
+
+/**
+ * @brief Finds the key, assigns its value if it exists, otherwise builds a node from the key and value and links it.
+ * 
+ * @param key - key to find or insert
+ * @param obj - value to assign or build the node's value from
+ * @return the node with the key, and whether it was inserted
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename COMPARE, typename ALLOCATOR, typename TRAITS >
+template< typename KEY_ARG, typename M >
+std::pair<typename CS280::AVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR,TRAITS>::AVLmap_iterator, bool> CS280::AVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR,TRAITS>::InsertOrAssign(KEY_ARG&& key, M&& obj)
+{
+    LatencyTimer timer(this, AVLmap_stats::INSERT);
+    Node* parent = nullptr;
+    bool left = false;
+    Node* found = FindSlot(key, parent, left);
+
+    if(found != nullptr)
+    {
+        found->value = std::forward<M>(obj);
+        return std::pair<AVLmap_iterator, bool>(AVLmap_iterator(found, this), false);
+    }
+
+    Node* node = CreateNode(nullptr, std::forward<KEY_ARG>(key), std::forward<M>(obj));
+
+    return std::pair<AVLmap_iterator, bool>(AVLmap_iterator(InsertItem(node, parent, left), this), true);
+}
+
+/**
+ * @brief Finds the slot for a key starting from a hint, and only if the key is missing builds a node from the key
+ *        and arguments and links it.
+ * 
+ * @param hint - node the key should come right before, null to append
+ * @param key - key to find or insert
+ * @param args - the value's constructor arguments
+ * @return the node with the key
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename COMPARE, typename ALLOCATOR, typename TRAITS >
+template< typename KEY_ARG, typename... ARGS >
+typename CS280::AVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR,TRAITS>::AVLmap_iterator CS280::AVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR,TRAITS>::TryEmplaceHint(Node* hint, KEY_ARG&& key, ARGS&&... args)
+{
+    LatencyTimer timer(this, AVLmap_stats::INSERT);
+    Node* parent = nullptr;
+    bool left = false;
+    Node* found = HintSlot(hint, key, parent, left);
+
+    if(found != nullptr)
+        return AVLmap_iterator(found, this);
+
+    Node* node = CreateNode(nullptr, std::forward<KEY_ARG>(key), std::forward<ARGS>(args)...);
+
+    return AVLmap_iterator(InsertItem(node, parent, left), this);
+}
+
+/**
+ * @brief Unlinks a node, rebalances, and hands it to a node handle as a leaf ready to be linked again.
+ * 
+ * @param node - node to extract
+ * @return handle holding the node and sharing this map's pool
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename COMPARE, typename ALLOCATOR, typename TRAITS >
+typename CS280::AVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR,TRAITS>::node_type CS280::AVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR,TRAITS>::ExtractNode(Node* node)
+{
+    Node* removedParent = UnlinkItem(node);
+    --size_;
+
+    AddToCounts(removedParent, -1);
+    BalanceAfterUnlink(removedParent);
+
+    // Make it a leaf again
+    node->parent = nullptr;
+    node->left = nullptr;
+    node->right = nullptr;
+    node->height = 0;
+    node->balance = 0;
+
+    if constexpr(TRAITS::order_statistics)
+    {
+        node->count = 1;
+    }
+
+    // The handle can be inserted or dropped on another thread, the pool locks from now on
+    mPool->share();
+
+    node_type handle;
+    handle.mNode = node;
+    handle.mPool = mPool;
+
+    return handle;
+}
+
+/**
+ * @brief Takes the node out of a handle to link it into this map. The node is used as it is if it comes from this
+ *        map's pool, or if this map's pool has no other user and can be spliced into the node's pool: the map then
+ *        shares that pool with the map the node came from, and later moves between the two are free. The pool was
+ *        marked shared by extract, so the two maps lock it and can be used from different threads.
+ *        Otherwise the key and value are moved into a new node of this map's pool.
+ * 
+ * @param handle - handle holding the node, left empty
+ * @return the node to link
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename COMPARE, typename ALLOCATOR, typename TRAITS >
+typename CS280::AVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR,TRAITS>::Node* CS280::AVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR,TRAITS>::AdoptNode(node_type& handle)
+{
+    Node* node = handle.mNode;
+
+    if(handle.mPool != mPool)
+    {
+        if(mPool == nullptr || (mPool.use_count() == 1 && handle.mPool->splice(*mPool)))
+        {
+            mPool = handle.mPool;
+        }
+        else
+        {
+            node = CreateNode(nullptr, std::move(handle.mNode->key), std::move(handle.mNode->value));
+            handle.mPool->deallocate(handle.mNode);
+
+            if constexpr(TRAITS::statistics)
+            {
+                ++mStats.frees;
+            }
+        }
+    }
+
+    handle.mNode = nullptr;
+    handle.mPool.reset();
+
+    return node;
+}
+
+/**
+ * @brief Links a new node into the spot found by FindSlot and rebalances the tree.
+ * 
+ * @param node - node to link
+ * @param parent - node to link it under (null if the tree is empty)
+ * @param left - whether the node becomes the parent's left child
+ * @return the linked node
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename COMPARE, typename ALLOCATOR, typename TRAITS >
+typename CS280::AVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR,TRAITS>::Node* CS280::AVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR,TRAITS>::InsertItem(Node* node, Node* parent, bool left)
+{
+    node->parent = parent;
+
+    ++size_;
+
+    // If it's the first node, set it to root
+    if(parent == nullptr)
+    {
+        mRoot = node;
+        ThreadNode(node);
+        return node;
+    }
+
+    if(left)
+    {
+        parent->left = node;
+    }
+    else
+    {
+        parent->right = node;
+    }
+
+    ThreadNode(node);
+
+    // Every ancestor's subtree grew by one, then rebalance from the new node's parent up
+    AddToCounts(parent, 1);
+    BalanceTree(parent, true);
+
+    return node;
+}
+
+/**
+ * @brief Unlinks a node from the tree without freeing it or rebalancing. The other nodes keep their keys and values.
+ * 
+ * @param tree - node to unlink
+ * @return the lowest node whose subtree lost a node (where rebalancing starts)
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename COMPARE, typename ALLOCATOR, typename TRAITS >
+typename CS280::AVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR,TRAITS>::Node* CS280::AVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR,TRAITS>::UnlinkItem(Node* tree)
+{
+    // The node leaves the in-order list, the order of the others is unchanged
+    UnthreadNode(tree);
+
+    if(tree->left != nullptr && tree->right != nullptr) // Ihe node to be deleted has both children non-empty.
+    {
+        return RelinkPredecessor(tree);
+    }
+
+    // If the node is a leaf node
+    if(tree->left == nullptr && tree->right == nullptr)
+    {
+        return UnlinkLeafNode(tree);
+    }
+
+    // The node to be deleted has only one empty child.
+    Node* child = tree->left ? tree->left : tree->right; // Get the non-empty child
+    Node* parent = tree->parent;
+
+    // Replace the deleted node with its child
+    if(tree != mRoot)
+    {
+        if(tree == parent->left)
+        {
+            parent->left = child;
+        }
+        else
+        {
+            parent->right = child;
+        }
+
+        // Update the parent to point to the updated tree.
+        child->parent = parent;
+    }
+    else
+    {
+        // If it's just the root and a child, set the child to root.
+        mRoot = child;
+
+        mRoot->parent = nullptr;
+    }
+
+    return parent;
+}
+
+/**
+ * @brief Unlinks a node with two children by moving its inorder predecessor (which has no right child) into its
+ *        place. The nodes are relinked, no key or value is copied, so every other node stays where it is.
+ * 
+ * @param tree - node to unlink, already taken out of the in-order list
+ * @return the node rebalancing starts at: the predecessor's old parent, or the predecessor itself if that was tree
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename COMPARE, typename ALLOCATOR, typename TRAITS >
+typename CS280::AVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR,TRAITS>::Node* CS280::AVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR,TRAITS>::RelinkPredecessor(Node* tree)
+{
+    Node* pred = tree->left->last();
+    Node* parent = pred->parent;
+    Node* start = parent;
+
+    if(parent == tree)
+    {
+        // The predecessor is tree's left child and keeps its own left subtree
+        start = pred;
+    }
+    else
+    {
+        // The predecessor's left subtree takes its place, then it adopts tree's left subtree
+        parent->right = pred->left;
+
+        if(pred->left != nullptr)
+            pred->left->parent = parent;
+
+        pred->left = tree->left;
+        pred->left->parent = pred;
+    }
+
+    pred->right = tree->right;
+    pred->right->parent = pred;
+
+    pred->parent = tree->parent;
+
+    if(tree == mRoot)
+    {
+        mRoot = pred;
+    }
+    else if(tree == tree->parent->left)
+    {
+        tree->parent->left = pred;
+    }
+    else
+    {
+        tree->parent->right = pred;
+    }
+
+    // The predecessor now roots tree's old subtree, the rebalance from start refreshes what changed
+    pred->height = tree->height;
+    pred->balance = tree->balance;
+
+    if constexpr(TRAITS::order_statistics)
+    {
+        pred->count = tree->count;
+    }
+
+    return start;
+}
+
+/**
+ * @brief Unlinks a leaf node (no left or right pointer) from the tree
+ * 
+ * @param node - leaf node
+ * @return the parent of the unlinked node
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename COMPARE, typename ALLOCATOR, typename TRAITS >
+typename CS280::AVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR,TRAITS>::Node* CS280::AVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR,TRAITS>::UnlinkLeafNode(Node* node)
+{
+    Node* parent = node->parent;
+
+    // If the node is the root, set root to null
+    if(node == mRoot)
+    {
+        mRoot = nullptr;
+    }
+    else
+    {
+        // Update the node's parent pointers
+        if(node == node->parent->left)
+        {
+            node->parent->left = nullptr;
+        }
+        else
+        {
+            node->parent->right = nullptr;
+        }
+    }
+
+    return parent;
+}
+
+/**
+ * @brief Replaces the contents with the elements of several unsorted buffers, built on several threads.
+ *        The buffers are cut into pieces of about the same size and each piece is copied and stable sorted
+ *        on its own. Keys sampled evenly from the sorted pieces cut them all into the same key ranges, each
+ *        range's parts are merged (ties go to the earlier piece) and built into a balanced subtree, which also
+ *        drops the later of equal keys. The subtrees' pools are spliced into this map's and the subtrees are
+ *        concatenated in key order, O(ranges log n). The tree is within one level of the one assign builds.
+ * 
+ * @param buffers - range of containers of pairs or nodes, e.g. a std::vector of std::vector<value_type>
+ * @param threads - number of threads to use, 0 for every hardware thread
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename COMPARE, typename ALLOCATOR, typename TRAITS >
+template< typename BUFFERS >
+void CS280::AVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR,TRAITS>::parallel_assign(BUFFERS const& buffers, unsigned int threads)
+{
+    typedef decltype(std::begin(*std::begin(buffers))) ITER;
+
+    std::size_t total = 0;
+
+    for(auto const& buffer : buffers)
+    {
+        total += static_cast<std::size_t>(std::distance(std::begin(buffer), std::end(buffer)));
+    }
+
+    ClearTree(mRoot);
+
+    unsigned int count = ParallelThreads(threads, total);
+
+    if(count == 1)
+    {
+        // Keys already there are kept, so the earlier buffers win as in the parallel build
+        for(auto const& buffer : buffers)
+        {
+            insert_batch(std::begin(buffer), std::end(buffer));
+        }
+
+        return;
+    }
+
+    std::size_t ranges = count * RANGES_PER_THREAD;
+    std::size_t length = (total + ranges - 1) / ranges;
+    std::vector< std::pair<ITER, ITER> > pieces;
+
+    for(auto const& buffer : buffers)
+    {
+        ITER first = std::begin(buffer);
+        std::size_t left = static_cast<std::size_t>(std::distance(first, std::end(buffer)));
+
+        while(left > 0)
+        {
+            std::size_t taken = std::min(left, length);
+            ITER last = std::next(first, static_cast<typename std::iterator_traits<ITER>::difference_type>(taken));
+
+            pieces.emplace_back(first, last);
+            first = last;
+            left -= taken;
+        }
+    }
+
+    auto less = [this](value_type const& a, value_type const& b)
+    {
+        return mCompare(a.first, b.first);
+    };
+
+    // Stable so the first of equal keys stays in front
+    std::vector< std::vector<value_type> > runs(pieces.size());
+
+    auto sortTask = [this, &pieces, &runs, &less](std::size_t index)
+    {
+        std::vector<value_type>& run = runs[index];
+
+        run.reserve(static_cast<std::size_t>(std::distance(pieces[index].first, pieces[index].second)));
+
+        for(ITER it = pieces[index].first; it != pieces[index].second; ++it)
+        {
+            run.emplace_back(ElementKey(*it), ElementValue(*it));
+        }
+
+        std::stable_sort(run.begin(), run.end(), less);
+    };
+
+    RunTasks(runs.size(), count, sortTask);
+
+    // Every run gives the same number of evenly spaced samples, so the splitters follow the keys' distribution
+    std::vector<KEY_TYPE const*> samples;
+
+    for(std::vector<value_type> const& run : runs)
+    {
+        for(std::size_t range = 1; range < ranges; ++range)
+        {
+            samples.push_back(&run[range * run.size() / ranges].first);
+        }
+    }
+
+    std::sort(samples.begin(), samples.end(), [this](KEY_TYPE const* a, KEY_TYPE const* b)
+    {
+        return mCompare(*a, *b);
+    });
+
+    // cuts[run * (ranges + 1) + range] is where the range starts in the run, equal keys always land in one range
+    std::vector<std::size_t> cuts(runs.size() * (ranges + 1));
+
+    for(std::size_t run = 0; run < runs.size(); ++run)
+    {
+        std::size_t* cut = &cuts[run * (ranges + 1)];
+
+        cut[0] = 0;
+        cut[ranges] = runs[run].size();
+
+        for(std::size_t range = 1; range < ranges; ++range)
+        {
+            KEY_TYPE const& splitter = *samples[range * samples.size() / ranges];
+
+            cut[range] = static_cast<std::size_t>(std::lower_bound(runs[run].begin(), runs[run].end(), splitter,
+                [this](value_type const& item, KEY_TYPE const& key)
+                {
+                    return mCompare(item.first, key);
+                }) - runs[run].begin());
+        }
+    }
+
+    // Each range is built on its own pool, so the threads never allocate from the same one
+    std::vector<AVLmap> parts;
+    parts.reserve(ranges);
+
+    for(std::size_t range = 0; range < ranges; ++range)
+    {
+        parts.emplace_back(mCompare, mAlloc);
+    }
+
+    auto buildTask = [this, &runs, &cuts, &parts, ranges](std::size_t range)
+    {
+        std::vector<std::size_t> next(runs.size());
+        std::vector<std::size_t> heap;
+        std::size_t size = 0;
+
+        for(std::size_t run = 0; run < runs.size(); ++run)
+        {
+            next[run] = cuts[run * (ranges + 1) + range];
+            size += cuts[run * (ranges + 1) + range + 1] - next[run];
+
+            if(next[run] != cuts[run * (ranges + 1) + range + 1])
+                heap.push_back(run);
+        }
+
+        // Whether run a's next element comes after run b's, so the heap's top is the smallest key of the earliest run
+        auto after = [this, &runs, &next](std::size_t a, std::size_t b)
+        {
+            KEY_TYPE const& keyA = runs[a][next[a]].first;
+            KEY_TYPE const& keyB = runs[b][next[b]].first;
+
+            return mCompare(keyB, keyA) || (!mCompare(keyA, keyB) && b < a);
+        };
+
+        std::vector<value_type> merged;
+        merged.reserve(size);
+
+        std::make_heap(heap.begin(), heap.end(), after);
+
+        while(!heap.empty())
+        {
+            std::pop_heap(heap.begin(), heap.end(), after);
+
+            std::size_t run = heap.back();
+            merged.push_back(std::move(runs[run][next[run]]));
+
+            if(++next[run] != cuts[run * (ranges + 1) + range + 1])
+            {
+                std::push_heap(heap.begin(), heap.end(), after);
+            }
+            else
+            {
+                heap.pop_back();
+            }
+        }
+
+        parts[range].BuildTree(std::make_move_iterator(merged.begin()), std::make_move_iterator(merged.end()), std::forward_iterator_tag());
+    };
+
+    RunTasks(ranges, count, buildTask);
+
+    // A range's last node and the next range's first are stitched by the concatenation
+    for(AVLmap& part : parts)
+    {
+        unsigned int partSize = part.size_;
+
+        Node* taken = TakeTree(part);
+        Node* tree = mRoot;
+        mRoot = nullptr;
+        mRoot = ConcatTrees(tree, taken);
+        size_ += partSize;
+
+        AddStats(part);
+    }
+
+    CacheEnds();
+}
+
+/**
+ * @brief Merges several maps into this one, uniting their key ranges on several threads. The maps' trees are
+ *        taken onto this map's pool (see TakeTree), then every tree is split at the keys of the largest tree's
+ *        nodes a few levels down. Each key range unites its pieces in map order, this map's first, so of equal keys
+ *        the earliest map's node is kept as with merge, and the united ranges are concatenated in key order.
+ *        The nodes whose keys were taken go back to their maps afterwards.
+ * 
+ * @param maps - range of maps of this type (a std::vector<AVLmap>, say), this map itself is skipped
+ * @param threads - number of threads to use, 0 for every hardware thread
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename COMPARE, typename ALLOCATOR, typename TRAITS >
+template< typename MAPS >
+void CS280::AVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR,TRAITS>::parallel_merge(MAPS& maps, unsigned int threads)
+{
+    std::size_t total = size_;
+
+    for(AVLmap& other : maps)
+    {
+        if(&other != this)
+            total += other.size_;
+    }
+
+    unsigned int count = ParallelThreads(threads, total);
+
+    if(count == 1)
+    {
+        for(AVLmap& other : maps)
+        {
+            merge(other);
+        }
+
+        return;
+    }
+
+    std::vector<Node*> trees(1, mRoot);
+    std::vector<AVLmap*> sources(1, this);
+    Node* largest = mRoot;
+    unsigned int largestSize = size_;
+
+    for(AVLmap& other : maps)
+    {
+        if(&other == this || other.mRoot == nullptr)
+            continue;
+
+        unsigned int theirSize = other.size_;
+
+        trees.push_back(TakeTree(other));
+        sources.push_back(&other);
+
+        if(theirSize > largestSize)
+        {
+            largest = trees.back();
+            largestSize = theirSize;
+        }
+    }
+
+    mRoot = nullptr;
+
+    unsigned int depth = 0;
+
+    while((std::size_t(1) << depth) < count * RANGES_PER_THREAD)
+    {
+        ++depth;
+    }
+
+    // The splitter nodes move between the pieces but their keys stay where they are
+    std::vector<Node*> splitters;
+    CollectLevel(largest, depth, splitters);
+
+    std::size_t ranges = splitters.size() + 1;
+    std::size_t width = trees.size();
+    std::vector<Node*> pieces(ranges * width); // pieces[range * width + tree]
+
+    for(std::size_t tree = 0; tree < width; ++tree)
+    {
+        Node* rest = trees[tree];
+
+        for(std::size_t range = 0; range + 1 < ranges; ++range)
+        {
+            Node* lower;
+            Node* upper;
+            Node* match = SplitTree(rest, splitters[range]->key, lower, upper);
+
+            pieces[range * width + tree] = lower;
+            rest = match != nullptr ? JoinTrees(nullptr, match, upper) : upper;
+        }
+
+        pieces[(ranges - 1) * width + tree] = rest;
+    }
+
+    // The ranges' nodes are disjoint, each range is united by its own worker map so the counters don't race
+    std::vector<AVLmap> workers;
+    workers.reserve(ranges);
+
+    for(std::size_t range = 0; range < ranges; ++range)
+    {
+        workers.emplace_back(mCompare, mAlloc);
+    }
+
+    std::vector<Node*> united(ranges);
+    std::vector<Node*> duplicates(ranges * width, nullptr);
+
+    auto uniteTask = [&pieces, &workers, &united, &duplicates, width](std::size_t range)
+    {
+        AVLmap& worker = workers[range];
+        Node* tree = pieces[range * width];
+
+        for(std::size_t other = 1; other < width; ++other)
+        {
+            tree = worker.UnionTrees(tree, pieces[range * width + other], duplicates[range * width + other]);
+        }
+
+        // Uniting regroups the in-order lists, they are rebuilt within the range
+        if constexpr(TRAITS::threaded)
+        {
+            worker.mRoot = tree;
+            worker.ThreadTree();
+            worker.mRoot = nullptr;
+        }
+
+        united[range] = tree;
+    };
+
+    RunTasks(ranges, count, uniteTask);
+
+    size_ = static_cast<unsigned int>(total);
+
+    for(std::size_t range = 0; range < ranges; ++range)
+    {
+        Node* tree = mRoot;
+        mRoot = nullptr;
+        mRoot = ConcatTrees(tree, united[range]);
+
+        for(std::size_t other = 1; other < width; ++other)
+        {
+            for(Node* node = duplicates[range * width + other]; node != nullptr; node = node->right)
+            {
+                --size_;
+            }
+        }
+
+        AddStats(workers[range]);
+    }
+
+    CacheEnds();
+
+    for(std::size_t range = 0; range < ranges; ++range)
+    {
+        for(std::size_t other = 1; other < width; ++other)
+        {
+            ReturnDuplicates(duplicates[range * width + other], *sources[other]);
+        }
+    }
+}
+
+/**
+ * @brief Builds a node in a slot from the pool
+ * 
+ * @param args - node constructor arguments
+ * @return the new node
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename COMPARE, typename ALLOCATOR, typename TRAITS >
+template< typename... ARGS >
+typename CS280::AVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR,TRAITS>::Node* CS280::AVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR,TRAITS>::CreateNode(ARGS&&... args)
+{
+    Node* node = Pool().allocate(std::forward<ARGS>(args)...);
+
+    if constexpr(TRAITS::statistics)
+    {
+        ++mStats.allocations;
+    }
+
+    return node;
+}
+
+/**
+ * @brief Destroys a node and gives its slot back to the pool
+ * 
+ * @param node - node to destroy
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename COMPARE, typename ALLOCATOR, typename TRAITS >
+void CS280::AVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR,TRAITS>::DestroyNode(Node* node)
+{
+    mPool->deallocate(node);
+
+    if constexpr(TRAITS::statistics)
+    {
+        ++mStats.frees;
+    }
+}
+
+/**
+ * @brief Frees a node
+ * 
+ * @param node - node to free
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename COMPARE, typename ALLOCATOR, typename TRAITS >
+void CS280::AVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR,TRAITS>::FreeNode(Node* node)
+{
+    DestroyNode(node);
+    --size_;
+}
+
+/**
+ * @brief Returns the node pool, creating it on first use (maps that were moved from have none).
+ *        A pool this map no longer shares with anyone stops locking.
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename COMPARE, typename ALLOCATOR, typename TRAITS >
+typename CS280::AVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR,TRAITS>::NodePool& CS280::AVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR,TRAITS>::Pool()
+{
+    if(!mPool)
+    {
+        mPool = std::allocate_shared<NodePool>(mAlloc, mAlloc);
+    }
+    else if(mPool->shared() && mPool.use_count() == 1)
+    {
+        // The maps and handles that shared the pool are gone, stop locking
+        mPool->unshare();
+    }
+
+    return *mPool;
+}
+
+/**
+ * @brief Deep copies the tree shape for shape using preorder traversal. The source is already balanced,
+ *        so every node is cloned with its height and balance and linked directly, without comparisons or rotations.
+ *        This tree must be empty. If a copy throws, the nodes copied so far stay linked and counted.
+ *        With MOVE_VALUES the keys and values are moved out of the source instead (the source nodes stay linked).
+ * 
+ * @param node - current node (should be called with root)
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename COMPARE, typename ALLOCATOR, typename TRAITS >
+template< bool MOVE_VALUES >
+void CS280::AVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR,TRAITS>::DeepCopyTree(Node* root)
+{
+    if(root == nullptr)
+        return;
+
+    Node* source = root;
+    Node* copy = CloneNode<MOVE_VALUES>(source, nullptr);
+
+    mRoot = copy;
+    ++size_;
+
+    // Walk both trees in lockstep through the parent pointers
+    while(true)
+    {
+        if(source->left != nullptr && copy->left == nullptr)
+        {
+            // Copy the current node's left
+            source = source->left;
+            copy->left = CloneNode<MOVE_VALUES>(source, copy);
+            copy = copy->left;
+            ++size_;
+        }
+        else if(source->right != nullptr && copy->right == nullptr)
+        {
+            // Copy the current node's right
+            source = source->right;
+            copy->right = CloneNode<MOVE_VALUES>(source, copy);
+            copy = copy->right;
+            ++size_;
+        }
+        else if(source == root)
+        {
+            break; // Both subtrees of the root have been copied
+        }
+        else
+        {
+            // This subtree is done, go back up
+            source = source->parent;
+            copy = copy->parent;
+        }
+    }
+
+    ThreadTree();
+}
+
+/**
+ * @brief Clears the tree. If no other map shares the pool, the chunks are released whole
+ *        (without visiting the nodes at all when they are trivially destructible).
+ * 
+ * @param node - current node (should be called with root)
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename COMPARE, typename ALLOCATOR, typename TRAITS >
+void CS280::AVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR,TRAITS>::ClearTree(Node* node)
+{
+    if(node == nullptr)
+        return;
+
+    if(mPool.use_count() == 1)
+    {
+        if(!std::is_trivially_destructible<Node>::value)
+        {
+            DestroySubtree(node, false); // Run the destructors, the slots go with their chunks
+        }
+
+        mPool->release();
+
+        if constexpr(TRAITS::statistics)
+        {
+            mStats.frees += size_;
+        }
+    }
+    else
+    {
+        DestroySubtree(node, true); // Other maps still use the pool, give the slots back one by one
+    }
+
+    mRoot = nullptr;
+    size_ = 0;
+    mFirst = nullptr;
+    mLast = nullptr;
+}
+
+/**
+ * @brief Destroys every node of a subtree using postorder traversal. Each node is unlinked from its parent
+ *        before it is destroyed, so the walk only needs parent pointers.
+ * 
+ * @param node - subtree to destroy
+ * @param freeSlots - whether to also give each node's slot back to the pool
+ * @return number of nodes destroyed
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename COMPARE, typename ALLOCATOR, typename TRAITS >
+unsigned int CS280::AVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR,TRAITS>::DestroySubtree(Node* node, bool freeSlots)
+{
+    Node* walker = node;
+    unsigned int destroyed = 0;
+
+    while(walker != nullptr)
+    {
+        // Go down until a leaf is found
+        if(walker->left != nullptr)
+        {
+            walker = walker->left;
+            continue;
+        }
+
+        if(walker->right != nullptr)
+        {
+            walker = walker->right;
+            continue;
+        }
+
+        // Unlink the leaf, unless it is the subtree's root
+        Node* parent = (walker == node) ? nullptr : walker->parent;
+
+        if(parent != nullptr)
+        {
+            if(parent->left == walker)
+            {
+                parent->left = nullptr;
+            }
+            else
+            {
+                parent->right = nullptr;
+            }
+        }
+
+        if(freeSlots)
+        {
+            DestroyNode(walker);
+        }
+        else
+        {
+            walker->~Node();
+        }
+
+        ++destroyed;
+        walker = parent;
+    }
+
+    return destroyed;
+}
+
+/**
+ * @brief Takes other's whole tree for this map and leaves other empty, without a pool of its own until it allocates
+ *        again, so an emptied map refilled on another thread never allocates from this map's pool. The nodes stay
+ *        where they are when both maps can end up on one pool: other already shares this map's pool, or one of the
+ *        two pools has a single owner and its chunks are spliced into the other one. Otherwise (both pools are also
+ *        used by other maps, or their allocators can't free each other's memory) the keys and values are moved into
+ *        nodes of this map's pool.
+ * 
+ * @param other - map to take the tree from
+ * @return root of the taken tree, detached
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename COMPARE, typename ALLOCATOR, typename TRAITS >
+typename CS280::AVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR,TRAITS>::Node* CS280::AVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR,TRAITS>::TakeTree(AVLmap& other)
+{
+    Node* root = other.mRoot;
+
+    // Nothing to do when the nodes already come from our pool
+    if(root != nullptr && mPool != other.mPool)
+    {
+        if(mPool == nullptr)
+        {
+            mPool = std::move(other.mPool);
+        }
+        else if(other.mPool.use_count() == 1 && mPool->splice(*other.mPool))
+        {
+            // other's chunks are ours now, its emptied pool is dropped below
+        }
+        else if(mPool.use_count() == 1 && other.mPool->splice(*mPool))
+        {
+            mPool = std::move(other.mPool);
+        }
+        else
+        {
+            AVLmap moved(mCompare, mAlloc);
+            moved.mPool = mPool;
+            moved.DeepCopyTree<true>(root);
+
+            other.ClearTree(root);
+            other.mPool.reset();
+
+            root = moved.mRoot;
+            moved.mRoot = nullptr;
+            moved.size_ = 0;
+
+            return root;
+        }
+    }
+
+    other.mRoot = nullptr;
+    other.size_ = 0;
+    other.mFirst = nullptr;
+    other.mLast = nullptr;
+    other.mPool.reset();
+
+    return root;
+}
+
+/**
+ * @brief Gives the nodes a merge took out of other's tree back to other, once this map is consistent again.
+ *        TakeTree left other without a pool, so the keys and values are moved into nodes of a fresh pool of other's
+ *        rather than leaving other on this map's pool.
+ * 
+ * @param duplicates - nodes whose keys this map already had, chained through their right pointers
+ * @param other - map the nodes came from
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename COMPARE, typename ALLOCATOR, typename TRAITS >
+void CS280::AVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR,TRAITS>::ReturnDuplicates(Node* duplicates, AVLmap& other)
+{
+    while(duplicates != nullptr)
+    {
+        Node* next = duplicates->right;
+
+        other.TryEmplace(std::move(duplicates->key), std::move(duplicates->value));
+        DestroyNode(duplicates);
+
+        duplicates = next;
+    }
+}
+
+/**
+ * @brief Adds the counters of a map that did part of a parallel update for this map. Nothing to do unless
+ *        TRAITS::statistics is on.
+ * 
+ * @param worker - map that built or united the part
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename COMPARE, typename ALLOCATOR, typename TRAITS >
+void CS280::AVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR,TRAITS>::AddStats(AVLmap const& worker)
+{
+    if constexpr(TRAITS::statistics)
+    {
+        mLookups.comparisons.fetch_add(worker.mLookups.comparisons.load(std::memory_order_relaxed), std::memory_order_relaxed);
+        mStats.singleRotations += worker.mStats.singleRotations;
+        mStats.doubleRotations += worker.mStats.doubleRotations;
+        mStats.allocations += worker.mStats.allocations;
+        mStats.frees += worker.mStats.frees;
+    }
+    else
+    {
+        (void)worker;
+    }
+}
+
+/**
+ * @brief Rebuilds every node's in-order links and the cached ends with one inorder walk through the tree links,
+ *        after a whole tree was built or copied. O(n). Without TRAITS::threaded only the last node is found again, O(log n).
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename COMPARE, typename ALLOCATOR, typename TRAITS >
+void CS280::AVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR,TRAITS>::ThreadTree()
+{
+    if constexpr(TRAITS::threaded)
+    {
+        Node* previous = nullptr;
+        Node* walker = mRoot ? mRoot->first() : nullptr;
+
+        mFirst = walker;
+
+        while(walker != nullptr)
+        {
+            Stitch(previous, walker);
+            previous = walker;
+
+            // Step to the successor without the links that are being rebuilt
+            if(walker->right != nullptr)
+            {
+                walker = walker->right->first();
+            }
+            else
+            {
+                Node* child = walker;
+                walker = walker->parent;
+
+                while(walker != nullptr && walker->right == child)
+                {
+                    child = walker;
+                    walker = walker->parent;
+                }
+            }
+        }
+
+        Stitch(previous, nullptr);
+        mLast = previous;
+    }
+    else
+    {
+        mLast = mRoot ? mRoot->last() : nullptr;
+    }
+}
+
+/**
+ * @brief Puts a node that was just linked as a leaf into the in-order list, next to its parent, and updates
+ *        the cached ends. O(1). Without TRAITS::threaded only the cached last node is updated.
+ * 
+ * @param node - new leaf
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename COMPARE, typename ALLOCATOR, typename TRAITS >
+void CS280::AVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR,TRAITS>::ThreadNode(Node* node)
+{
+    if constexpr(TRAITS::threaded)
+    {
+        Node* parent = node->parent;
+
+        if(parent == nullptr)
+        {
+            Stitch(nullptr, node);
+            Stitch(node, nullptr);
+        }
+        else if(node == parent->left)
+        {
+            // A left leaf comes right before its parent
+            Stitch(parent->prev, node);
+            Stitch(node, parent);
+        }
+        else
+        {
+            Stitch(node, parent->next);
+            Stitch(parent, node);
+        }
+
+        if(node->prev == nullptr)
+            mFirst = node;
+
+        if(node->next == nullptr)
+            mLast = node;
+    }
+    else if(node->parent == nullptr || (node->parent == mLast && node == node->parent->right))
+    {
+        mLast = node;
+    }
+}
+
+/**
+ * @brief Takes a node that is about to be unlinked from the tree out of the in-order list, and updates
+ *        the cached ends. O(1). Without TRAITS::threaded only the cached last node is updated.
+ * 
+ * @param node - node to take out
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename COMPARE, typename ALLOCATOR, typename TRAITS >
+void CS280::AVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR,TRAITS>::UnthreadNode(Node* node)
+{
+    if constexpr(TRAITS::threaded)
+    {
+        Stitch(node->prev, node->next);
+
+        if(mFirst == node)
+            mFirst = node->next;
+
+        if(mLast == node)
+            mLast = node->prev;
+    }
+    else if(mLast == node)
+    {
+        // The last node has no right child, its predecessor is in its left subtree or is its parent
+        mLast = node->left ? node->left->last() : node->parent;
+    }
+}
+
+/**
+ * @brief Finds the first and last node again after the tree was joined or split. O(log n).
+ *        The first node is only kept when TRAITS::threaded is on.
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename COMPARE, typename ALLOCATOR, typename TRAITS >
+void CS280::AVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR,TRAITS>::CacheEnds()
+{
+    if constexpr(TRAITS::threaded)
+    {
+        mFirst = mRoot ? mRoot->first() : nullptr;
+    }
+
+    mLast = mRoot ? mRoot->last() : nullptr;
+}
+
+/**
+ * @brief Makes two nodes neighbours in the in-order list. Nothing to do unless TRAITS::threaded is on.
+ * 
+ * @param before - node that comes first (null if after becomes the first node)
+ * @param after - node that comes next (null if before becomes the last node)
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename COMPARE, typename ALLOCATOR, typename TRAITS >
+void CS280::AVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR,TRAITS>::Stitch(Node* before, Node* after)
+{
+    if constexpr(TRAITS::threaded)
+    {
+        if(before != nullptr)
+            before->next = after;
+
+        if(after != nullptr)
+            after->prev = before;
+    }
+    else
+    {
+        (void)before;
+        (void)after;
+    }
+}
+
+/**
+ * @brief Links a node that is in no tree (but comes from this map's pool) into the tree, unless its key is already there.
+ * 
+ * @param node - node to link
+ * @return the linked node, or the node that already had the key (the given node is left as it was)
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename COMPARE, typename ALLOCATOR, typename TRAITS >
+typename CS280::AVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR,TRAITS>::Node* CS280::AVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR,TRAITS>::LinkNode(Node* node)
+{
+    Node* parent = nullptr;
+    bool left = false;
+
+    Node* existing = FindSlot(node->key, parent, left);
+
+    if(existing != nullptr)
+        return existing;
+
+    // Make it a leaf again
+    node->left = nullptr;
+    node->right = nullptr;
+    node->height = 0;
+    node->balance = 0;
+
+    if constexpr(TRAITS::order_statistics)
+    {
+        node->count = 1;
+    }
+
+    return InsertItem(node, parent, left);
+}
+
+/**
+ * @brief Joins two detached trees around a detached pivot, every key of left is less than the pivot's and every key
+ *        of right greater. Goes down the inner spine of the taller tree to the first subtree at most one taller than
+ *        the shorter tree, puts the pivot in its place holding it and the shorter tree, and rebalances from there up
+ *        (the subtree grew by at most one, as after an insert). O(height difference).
+ * 
+ * @param left - tree of the smaller keys (may be empty)
+ * @param pivot - node between the two trees
+ * @param right - tree of the greater keys (may be empty)
+ * @return root of the joined tree, detached
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename COMPARE, typename ALLOCATOR, typename TRAITS >
+typename CS280::AVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR,TRAITS>::Node* CS280::AVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR,TRAITS>::JoinTrees(Node* left, Node* pivot, Node* right)
+{
+    int leftHeight = GetSubtreeHeight(left);
+    int rightHeight = GetSubtreeHeight(right);
+    bool leftTaller = leftHeight > rightHeight + 1;
+
+    Node* parent = nullptr;
+
+    if(leftTaller)
+    {
+        while(GetSubtreeHeight(left) > rightHeight + 1)
+        {
+            parent = left;
+            left = left->right;
+        }
+    }
+    else if(rightHeight > leftHeight + 1)
+    {
+        while(GetSubtreeHeight(right) > leftHeight + 1)
+        {
+            parent = right;
+            right = right->left;
+        }
+    }
+
+    unsigned int replaced = GetSubtreeCount(leftTaller ? left : right);
+
+    pivot->parent = parent;
+    pivot->left = left;
+    pivot->right = right;
+
+    if(left != nullptr)
+        left->parent = pivot;
+
+    if(right != nullptr)
+        right->parent = pivot;
+
+    UpdateHeight(pivot);
+
+    // Heights within one, the pivot is the root
+    if(parent == nullptr)
+        return pivot;
+
+    if(leftTaller)
+    {
+        parent->right = pivot;
+    }
+    else
+    {
+        parent->left = pivot;
+    }
+
+    // The ancestors gained the pivot and the whole shorter tree
+    AddToCounts(parent, static_cast<int>(GetSubtreeCount(pivot) - replaced));
+    BalanceTree(parent, false);
+
+    return FindRoot(parent);
+}
+
+/**
+ * @brief Joins two detached trees where every key of left is less than every key of right,
+ *        using the first node of right as the pivot. O(log n).
+ * 
+ * @param left - tree of the smaller keys
+ * @param right - tree of the greater keys
+ * @return root of the joined tree, detached
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename COMPARE, typename ALLOCATOR, typename TRAITS >
+typename CS280::AVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR,TRAITS>::Node* CS280::AVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR,TRAITS>::ConcatTrees(Node* left, Node* right)
+{
+    if(left == nullptr)
+        return right;
+
+    if(right == nullptr)
+        return left;
+
+    Node* pivot = RemoveFirst(right);
+
+    // The pivot is still linked to the rest of right's in-order list
+    if constexpr(TRAITS::threaded)
+    {
+        Stitch(left->last(), pivot);
+    }
+
+    return JoinTrees(left, pivot, right);
+}
+
+/**
+ * @brief Unlinks the first node of a detached tree and rebalances what is left. O(log n).
+ *        The in-order links are left alone, the node still points to its old successor.
+ * 
+ * @param tree - root of the tree, set to the new root
+ * @return the unlinked node
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename COMPARE, typename ALLOCATOR, typename TRAITS >
+typename CS280::AVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR,TRAITS>::Node* CS280::AVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR,TRAITS>::RemoveFirst(Node*& tree)
+{
+    Node* first = tree->first();
+    Node* parent = first->parent;
+    Node* child = first->right;
+
+    if(child != nullptr)
+        child->parent = parent;
+
+    if(parent == nullptr)
+    {
+        tree = child;
+        return first;
+    }
+
+    parent->left = child;
+
+    AddToCounts(parent, -1);
+    BalanceAfterUnlink(parent);
+
+    tree = FindRoot(parent);
+    return first;
+}
+
+/**
+ * @brief Splits a detached tree around a key. Goes down the search path, then back up it joining each node
+ *        and the subtree off the path on its side either into the lower tree or into the upper tree.
+ *        The joins telescope, so the whole split is O(log n).
+ * 
+ * @param tree - tree to split (its nodes end up in the two halves)
+ * @param key - key to split at
+ * @param lower - set to the detached tree of the keys less than the key
+ * @param upper - set to the detached tree of the keys greater than the key
+ * @return the detached node with the key, null if there is none
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename COMPARE, typename ALLOCATOR, typename TRAITS >
+typename CS280::AVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR,TRAITS>::Node* CS280::AVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR,TRAITS>::SplitTree(Node* tree, KEY_TYPE const& key, Node*& lower, Node*& upper)
+{
+    lower = nullptr;
+    upper = nullptr;
+
+    Node* walker = tree;
+    Node* bottom = nullptr;
+    Node* match = nullptr;
+    Node* lowerLast = nullptr; // last node we went right at
+    Node* upperFirst = nullptr; // last node we went left at
+
+    while(walker != nullptr)
+    {
+        bottom = walker;
+
+        if(mCompare(walker->key, key))
+        {
+            lowerLast = walker;
+            walker = walker->right;
+        }
+        else if(mCompare(key, walker->key))
+        {
+            upperFirst = walker;
+            walker = walker->left;
+        }
+        else
+        {
+            match = walker;
+            break;
+        }
+    }
+
+    // The match's subtrees are the bottom of the two halves
+    if(match != nullptr)
+    {
+        lower = DetachSubtree(match->left);
+        upper = DetachSubtree(match->right);
+        bottom = match->parent;
+    }
+
+    // The halves keep the in-order links of the tree, cut them where the key goes
+    if constexpr(TRAITS::threaded)
+    {
+        if(match != nullptr)
+        {
+            lowerLast = match->prev;
+            upperFirst = match->next;
+
+            Stitch(nullptr, match);
+            Stitch(match, nullptr);
+        }
+
+        Stitch(lowerLast, nullptr);
+        Stitch(nullptr, upperFirst);
+    }
+
+    // Each node's parent is read before the join relinks it
+    for(walker = bottom; walker != nullptr; )
+    {
+        Node* next = walker->parent;
+
+        if(mCompare(walker->key, key))
+        {
+            lower = JoinTrees(DetachSubtree(walker->left), walker, lower);
+        }
+        else
+        {
+            upper = JoinTrees(upper, walker, DetachSubtree(walker->right));
+        }
+
+        walker = next;
+    }
+
+    return match;
+}
+
+/**
+ * @brief Unites two detached trees: other's root splits this tree, the two sides are united recursively
+ *        and joined back around it. The recursion is as deep as other's tree. O(m log(n/m + 1)).
+ * 
+ * @param mine - this map's tree
+ * @param theirs - the other map's tree
+ * @param duplicates - other's nodes whose keys are in mine are pushed here, chained through their right pointers
+ * @return root of the united tree, detached
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename COMPARE, typename ALLOCATOR, typename TRAITS >
+typename CS280::AVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR,TRAITS>::Node* CS280::AVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR,TRAITS>::UnionTrees(Node* mine, Node* theirs, Node*& duplicates)
+{
+    if(theirs == nullptr)
+        return mine;
+
+    if(mine == nullptr)
+        return theirs;
+
+    Node* pivot = theirs;
+    Node* theirsLeft = DetachSubtree(pivot->left);
+    Node* theirsRight = DetachSubtree(pivot->right);
+
+    Node* mineLeft;
+    Node* mineRight;
+    Node* match = SplitTree(mine, pivot->key, mineLeft, mineRight);
+
+    Node* left = UnionTrees(mineLeft, theirsLeft, duplicates);
+    Node* right = UnionTrees(mineRight, theirsRight, duplicates);
+
+    // Our node wins, theirs goes back
+    if(match != nullptr)
+    {
+        pivot->right = duplicates;
+        duplicates = pivot;
+        pivot = match;
+    }
+
+    return JoinTrees(left, pivot, right);
+}
+
+/**
+ * @brief Removes a sorted run of distinct keys from a detached tree: the middle key splits the tree, the keys
+ *        before it are removed from the lower half and the keys after it from the upper half, and the halves are
+ *        concatenated again. The recursion is log k deep, O(k log(n/k + 1)).
+ * 
+ * @param tree - tree to remove the keys from
+ * @param first - first key of the run
+ * @param last - end of the run
+ * @param erased - increased by the number of nodes freed
+ * @return root of the remaining tree, detached
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename COMPARE, typename ALLOCATOR, typename TRAITS >
+typename CS280::AVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR,TRAITS>::Node* CS280::AVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR,TRAITS>::DifferenceTrees(Node* tree, KEY_TYPE const* first, KEY_TYPE const* last, unsigned int& erased)
+{
+    if(tree == nullptr || first == last)
+        return tree;
+
+    KEY_TYPE const* middle = first + (last - first) / 2;
+
+    Node* lower;
+    Node* upper;
+    Node* match = SplitTree(tree, *middle, lower, upper);
+
+    lower = DifferenceTrees(lower, first, middle, erased);
+    upper = DifferenceTrees(upper, middle + 1, last, erased);
+
+    if(match != nullptr)
+    {
+        DestroyNode(match);
+        ++erased;
+    }
+
+    return ConcatTrees(lower, upper);
+}
+
+/**
+ * @brief Cuts a subtree off its parent (the parent's child pointer is left for the caller to overwrite).
+ * 
+ * @param node - subtree root, may be null
+ * @return the subtree root
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename COMPARE, typename ALLOCATOR, typename TRAITS >
+typename CS280::AVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR,TRAITS>::Node* CS280::AVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR,TRAITS>::DetachSubtree(Node* node)
+{
+    if(node != nullptr)
+        node->parent = nullptr;
+
+    return node;
+}
+
+/**
+ * @brief Follows the parent pointers to the root of the tree holding a node.
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename COMPARE, typename ALLOCATOR, typename TRAITS >
+typename CS280::AVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR,TRAITS>::Node* CS280::AVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR,TRAITS>::FindRoot(Node* node)
+{
+    while(node->parent != nullptr)
+    {
+        node = node->parent;
+    }
+
+    return node;
+}
+
+/**
+ * @brief Counts the nodes of the lower of two trees by walking both in order at the same time,
+ *        so only the smaller one is walked to its end. O(min(lower, upper)).
+ * 
+ * @param lower - first tree
+ * @param upper - second tree
+ * @param total - number of nodes in both
+ * @return number of nodes in lower
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename COMPARE, typename ALLOCATOR, typename TRAITS >
+unsigned int CS280::AVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR,TRAITS>::CountLower(Node* lower, Node* upper, unsigned int total)
+{
+    Node* a = lower ? lower->first() : nullptr;
+    Node* b = upper ? upper->first() : nullptr;
+    unsigned int walked = 0;
+
+    while(a != nullptr && b != nullptr)
+    {
+        a = a->increment();
+        b = b->increment();
+        ++walked;
+    }
+
+    return a == nullptr ? walked : total - walked;
+}
+
+/**
+ * @brief Builds the tree from a single pass range. The elements are buffered first since the build needs their count.
+ * 
+ * @param first - start of the range
+ * @param last - end of the range
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename COMPARE, typename ALLOCATOR, typename TRAITS >
+template< typename ITER >
+void CS280::AVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR,TRAITS>::BuildTree(ITER first, ITER last, std::input_iterator_tag)
+{
+    std::vector<value_type> buffer;
+
+    for(; first != last; ++first)
+    {
+        buffer.emplace_back(ElementKey(*first), ElementValue(*first));
+    }
+
+    BuildTree(std::make_move_iterator(buffer.begin()), std::make_move_iterator(buffer.end()), std::forward_iterator_tag());
+}
+
+/**
+ * @brief Builds the tree from a range sorted by key. The tree must be empty.
+ *        The first pass counts the distinct keys (and checks the order), the second builds the tree in order.
+ * 
+ * @param first - start of the range
+ * @param last - end of the range
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename COMPARE, typename ALLOCATOR, typename TRAITS >
+template< typename ITER >
+void CS280::AVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR,TRAITS>::BuildTree(ITER first, ITER last, std::forward_iterator_tag)
+{
+    if(first == last)
+        return;
+
+    std::size_t count = 1;
+    ITER previous = first;
+
+    for(ITER it = std::next(first); it != last; ++it)
+    {
+        if(mCompare(ElementKey(*it), ElementKey(*previous)))
+        {
+            // Not sorted, fall back to inserting the elements one by one
+            for(; first != last; ++first)
+            {
+                try_emplace(ElementKey(*first), ElementValue(*first));
+            }
+
+            return;
+        }
+
+        // Equal keys are only counted once
+        if(mCompare(ElementKey(*previous), ElementKey(*it)))
+        {
+            ++count;
+        }
+
+        previous = it;
+    }
+
+    mRoot = BuildSubtree(first, last, count, nullptr);
+    size_ = static_cast<unsigned int>(count);
+
+    ThreadTree();
+}
+
+/**
+ * @brief Builds a perfectly balanced subtree from the next count distinct keys of the range, using inorder traversal.
+ *        The left half is built first so the elements are consumed in order. If a copy throws, the nodes built so far are freed.
+ * 
+ * @param it - next element of the range, moved past the elements used
+ * @param last - end of the range
+ * @param count - number of distinct keys to build the subtree from
+ * @param parent - parent of the subtree
+ * @return the root of the subtree
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename COMPARE, typename ALLOCATOR, typename TRAITS >
+template< typename ITER >
+typename CS280::AVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR,TRAITS>::Node* CS280::AVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR,TRAITS>::BuildSubtree(ITER& it, ITER last, std::size_t count, Node* parent)
+{
+    if(count == 0)
+        return nullptr;
+
+    // Halves differ in size by at most one, so their heights do too
+    std::size_t leftCount = (count - 1) / 2;
+
+    Node* left = BuildSubtree(it, last, leftCount, nullptr);
+    Node* node = nullptr;
+
+    try
+    {
+        node = CreateNode(parent, ElementKey(*it), ElementValue(*it));
+    }
+    catch(...)
+    {
+        DestroySubtree(left, true);
+        throw;
+    }
+
+    // Skip the rest of the elements with this key, compared with the node's copy since a moved range's key is gone
+    for(++it; it != last && !mCompare(node->Key(), ElementKey(*it)); ++it)
+    {
+    }
+
+    node->left = left;
+
+    if(left != nullptr)
+        left->parent = node;
+
+    try
+    {
+        node->right = BuildSubtree(it, last, count - 1 - leftCount, node);
+    }
+    catch(...)
+    {
+        DestroySubtree(node, true);
+        throw;
+    }
+
+    UpdateHeight(node);
+
+    return node;
+}
+
+/**
+ * @brief Returns the key of a range element that is a pair.
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename COMPARE, typename ALLOCATOR, typename TRAITS >
+template< typename FIRST, typename SECOND >
+FIRST const& CS280::AVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR,TRAITS>::ElementKey(std::pair<FIRST, SECOND> const& item)
+{
+    return item.first;
+}
+
+/**
+ * @brief Returns the key of a range element that is a pair being moved from (a move_iterator's element).
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename COMPARE, typename ALLOCATOR, typename TRAITS >
+template< typename FIRST, typename SECOND >
+FIRST&& CS280::AVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR,TRAITS>::ElementKey(std::pair<FIRST, SECOND>&& item)
+{
+    return std::move(item.first);
+}
+
+/**
+ * @brief Returns the key of a range element that is a node (of this or another map).
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename COMPARE, typename ALLOCATOR, typename TRAITS >
+template< typename NODE >
+auto CS280::AVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR,TRAITS>::ElementKey(NODE const& node) -> decltype(node.Key())
+{
+    return node.Key();
+}
+
+/**
+ * @brief Returns the value of a range element that is a pair.
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename COMPARE, typename ALLOCATOR, typename TRAITS >
+template< typename FIRST, typename SECOND >
+SECOND const& CS280::AVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR,TRAITS>::ElementValue(std::pair<FIRST, SECOND> const& item)
+{
+    return item.second;
+}
+
+/**
+ * @brief Returns the value of a range element that is a pair being moved from (a move_iterator's element).
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename COMPARE, typename ALLOCATOR, typename TRAITS >
+template< typename FIRST, typename SECOND >
+SECOND&& CS280::AVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR,TRAITS>::ElementValue(std::pair<FIRST, SECOND>&& item)
+{
+    return std::move(item.second);
+}
+
+/**
+ * @brief Returns the value of a range element that is a node (of this or another map).
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename COMPARE, typename ALLOCATOR, typename TRAITS >
+template< typename NODE >
+auto CS280::AVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR,TRAITS>::ElementValue(NODE const& node) -> decltype(node.Value())
+{
+    return node.Value();
+}
+
+/**
+ * @brief Balances the tree. Walks up from the given node through the parent pointers, refreshing heights
+ *        and rotating where a node's children differ in height by more than MAX_BALANCE, and stops as soon
+ *        as a subtree's height is the same as before. The rotations restore the bound when it is passed by one,
+ *        whatever it is. With weak balancing the heights are ranks, growing subtrees are rebalanced the same way.
+ * 
+ * @param y - parent of the node that was inserted/deleted
+ * @param inserting - whether or not node is being inserted (if false then deleted)
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename COMPARE, typename ALLOCATOR, typename TRAITS >
+void CS280::AVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR,TRAITS>::BalanceTree(Node* y, bool inserting)
+{
+    while(y != nullptr)
+    {
+        Node* leftSubtree = y->left;
+        Node* rightSubtree = y->right;
+
+        int oldHeight = y->height;
+
+        // A child of y changed, so refresh y's cached height and balance
+        UpdateHeight(y);
+
+        // Find the balance of y
+        int balance = GetSubtreeBalance(y);
+
+        if(balance > MAX_BALANCE)
+        {
+            if(GetSubtreeHeight(leftSubtree->left) >= GetSubtreeHeight(leftSubtree->right))
+            {
+                RotateRight(y);
+                CountRotation(false);
+            }
+            else
+            {
+                RotateLeft(leftSubtree);
+                RotateRight(y);
+                CountRotation(true);
+            }
+
+            CheckRotation(y);
+
+            // A rotation after an insert always restores the subtree's old height
+            if(inserting)
+                break;
+        }
+        else if(balance < -MAX_BALANCE)
+        {
+            if(GetSubtreeHeight(rightSubtree->right) >= GetSubtreeHeight(rightSubtree->left))
+            {
+                RotateLeft(y);
+                CountRotation(false);
+            }
+            else
+            {
+                RotateRight(rightSubtree);
+                RotateLeft(y);
+                CountRotation(true);
+            }
+
+            CheckRotation(y);
+
+            // A rotation after an insert always restores the subtree's old height
+            if(inserting)
+                break;
+        }
+
+        // If the subtree (rotated or not) kept its height, none of the ancestors change
+        if(y->height == oldHeight)
+            break;
+
+        y = y->parent;
+    }
+}
+
+/**
+ * @brief Rebalances the tree after a node was unlinked below y (a subtree of y is one shorter, or one rank lower).
+ *        Weak balancing has its own rules, see BalanceWeakTree, otherwise it is BalanceTree's walk up.
+ * 
+ * @param y - lowest node whose subtree lost a node
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename COMPARE, typename ALLOCATOR, typename TRAITS >
+void CS280::AVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR,TRAITS>::BalanceAfterUnlink(Node* y)
+{
+    if constexpr(TRAITS::balancing == AVLmap_balancing::weak)
+    {
+        BalanceWeakTree(y);
+    }
+    else
+    {
+        BalanceTree(y, false);
+    }
+}
+
+/**
+ * @brief Rebalances a weak AVL tree after an unlink, with the WAVL deletion rules (Haeupler, Sen and Tarjan).
+ *        Every child is one or two ranks below its parent and every leaf has rank 0. An unlink leaves y with a
+ *        child three ranks down, or y a leaf of rank 1. y is demoted (when its other child is two down, or one
+ *        down with both of its own children two down, which is demoted too) and the walk goes on at y's parent,
+ *        or a single or double rotation fixes the ranks for good. Unlike strict AVL a subtree of a node is allowed
+ *        to get shorter without the node being demoted, so most unlinks stop right away: at most two rotations
+ *        per unlink and O(1) demotions amortized.
+ * 
+ * @param y - lowest node whose subtree lost a node
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename COMPARE, typename ALLOCATOR, typename TRAITS >
+void CS280::AVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR,TRAITS>::BalanceWeakTree(Node* y)
+{
+    while(y != nullptr)
+    {
+        int rank = y->height;
+        int leftRank = GetSubtreeHeight(y->left);
+        int rightRank = GetSubtreeHeight(y->right);
+
+        UpdateBalance(y);
+
+        // A leaf that lost its last child
+        if(y->left == nullptr && y->right == nullptr)
+        {
+            if(rank == 0)
+                break;
+
+            y->height = 0;
+            y = y->parent;
+            continue;
+        }
+
+        if(rank - leftRank <= 2 && rank - rightRank <= 2)
+            break;
+
+        // One child is three ranks down, the sibling is on the other side
+        bool leftShort = rank - leftRank == 3;
+        Node* sibling = leftShort ? y->right : y->left;
+        int siblingRank = leftShort ? rightRank : leftRank;
+
+        if(rank - siblingRank == 2)
+        {
+            --y->height;
+            y = y->parent;
+            continue;
+        }
+
+        Node* outer = leftShort ? sibling->right : sibling->left;
+        Node* inner = leftShort ? sibling->left : sibling->right;
+        int outerRank = GetSubtreeHeight(outer);
+        int innerRank = GetSubtreeHeight(inner);
+
+        if(siblingRank - outerRank == 2 && siblingRank - innerRank == 2)
+        {
+            --sibling->height;
+            --y->height;
+            UpdateBalance(y);
+            y = y->parent;
+            continue;
+        }
+
+        // The rotations refresh the counts, the ranks are set by the rules afterwards
+        Node* top = y;
+
+        if(siblingRank - outerRank == 1)
+        {
+            if(leftShort)
+            {
+                RotateLeft(top);
+            }
+            else
+            {
+                RotateRight(top);
+            }
+
+            CountRotation(false);
+
+            // The sibling takes y's rank, y goes one down, or to 0 if it is a leaf now
+            sibling->height = rank;
+            y->height = (y->left == nullptr && y->right == nullptr) ? 0 : rank - 1;
+
+            UpdateBalance(y);
+            UpdateBalance(sibling);
+        }
+        else
+        {
+            Node* middle = sibling;
+
+            if(leftShort)
+            {
+                RotateRight(middle);
+                RotateLeft(top);
+            }
+            else
+            {
+                RotateLeft(middle);
+                RotateRight(top);
+            }
+
+            CountRotation(true);
+
+            // The inner child takes y's rank, y goes two down and the sibling one
+            inner->height = rank;
+            y->height = rank - 2;
+            sibling->height = siblingRank - 1;
+
+            UpdateBalance(y);
+            UpdateBalance(sibling);
+            UpdateBalance(inner);
+        }
+
+        CheckRotation(top);
+        break;
+    }
+}
+
+/**
+ * @brief Recomputes a node's cached balance from its children's cached heights (or ranks), leaving its own alone.
+ * @param node - node to update
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename COMPARE, typename ALLOCATOR, typename TRAITS >
+void CS280::AVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR,TRAITS>::UpdateBalance(Node* node)
+{
+    node->balance = GetSubtreeHeight(node->left) - GetSubtreeHeight(node->right);
+}
+
+/**
+ * @brief Returns the height of a subtree (cached in the node, -1 for an empty subtree).
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename COMPARE, typename ALLOCATOR, typename TRAITS >
+int CS280::AVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR,TRAITS>::GetSubtreeHeight(Node* node)
+{
+    if(node == nullptr)
+        return -1;
+    else
+        return node->height;
+}
+
+/**
+ * @brief Returns the balance of a subtree (cached in the node).
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename COMPARE, typename ALLOCATOR, typename TRAITS >
+int CS280::AVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR,TRAITS>::GetSubtreeBalance(Node* node)
+{
+    if(node == nullptr)
+        return 0;
+    else
+        return node->balance;
+}
+
+/**
+ * @brief Rotates a node right. Also works on the root of a detached subtree (no parent and not mRoot).
+ * 
+ * @param node - node to rotate, set to the node promoted in its place
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename COMPARE, typename ALLOCATOR, typename TRAITS >
+void CS280::AVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR,TRAITS>::RotateRight(Node*& node)
+{
+    // If the root is being rotated
+    if(node == mRoot)
+    {
+        RotateRootRight();
+        node = mRoot;
+        return;
+    }
+
+    Node* temp = node;
+
+    Node* nodeParent = node->parent;
+
+    // Update the node parent child pointer (a detached subtree's root has none)
+    if(nodeParent != nullptr)
+    {
+        if(node == nodeParent->left)
+        {
+            nodeParent->left = node->left;
+        }
+        else
+        {
+            nodeParent->right = node->left;
+        }
+    }
+
+    // Promote the left child
+    node = node->left;
+
+    // Update the promoted node's parent pointer
+    node->parent = nodeParent;
+
+    // Update the old node's parent pointer
+    temp->parent = node;
+
+    // Update the old node's child pointer
+    temp->left = node->right;
+
+    // Update the old node's child's parent pointer
+    if(temp->left)
+        temp->left->parent = temp;
+
+    // Update the promoted node's child pointer
+    node->right = temp;
+
+    // Only the two rotated nodes changed height, the demoted one is now below the promoted one
+    UpdateHeight(temp);
+    UpdateHeight(node);
+}
+
+/**
+ * @brief Rotates a node left. Also works on the root of a detached subtree (no parent and not mRoot).
+ * 
+ * @param node - node to rotate, set to the node promoted in its place
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename COMPARE, typename ALLOCATOR, typename TRAITS >
+void CS280::AVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR,TRAITS>::RotateLeft(Node*& node)
+{
+    // If the root is being rotated
+    if(node == mRoot)
+    {
+        RotateRootLeft();
+        node = mRoot;
         return;
+    }
+
+    Node* temp = node;
+
+    Node* nodeParent = node->parent;
+
+    // Update the node parent child pointer (a detached subtree's root has none)
+    if(nodeParent != nullptr)
+    {
+        if(node == nodeParent->left)
+        {
+            nodeParent->left = node->right;
+        }
+        else
+        {
+            nodeParent->right = node->right;
+        }
+    }
+
+    // Promote the right child
+    node = node->right;
+
+    // Update the promoted node's parent pointer
+    node->parent = nodeParent;
+
+    // Update the old node's parent pointer
+    temp->parent = node;
+
+    // Update the old node's child pointer
+    temp->right = node->left;
+
+    // Update the old node's child's parent pointer
+    if(temp->right)
+        temp->right->parent = temp;
+
+    // Update the promoted node's child pointer
+    node->left = temp;
 
-    Node* tempLeft = node->left;
-    Node* tempRight = node->right;
+    // Only the two rotated nodes changed height, the demoted one is now below the promoted one
+    UpdateHeight(temp);
+    UpdateHeight(node);
+}
+
+/**
+ * @brief Rotates the root node right.
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename COMPARE, typename ALLOCATOR, typename TRAITS >
+void CS280::AVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR,TRAITS>::RotateRootRight()
+{
+    Node* temp = mRoot;
 
-    FreeNode(node); // Free the node
+    Node* newRoot = mRoot->left;
 
-    ClearTree(tempLeft); // Free the left node
-    ClearTree(tempRight); // Free the right node
+    // Promote the left child as the root
+    mRoot = mRoot->left;
 
-    mRoot = nullptr;
+    // Update the root node's parent pointer
+    mRoot->parent = nullptr;
+
+    // Update the old root's parent pointer
+    temp->parent = newRoot;
+
+    // Update the old root's child pointer
+    temp->left = newRoot->right;
+
+    // Update the old root's child's parent pointer
+    if(temp->left)
+        temp->left->parent = temp;
+
+    // Update the promoted root's child pointer
+    newRoot->right = temp;
+
+    // Only the two rotated nodes changed height, the old root is now below the new one
+    UpdateHeight(temp);
+    UpdateHeight(mRoot);
+}
+
+
+/**
+ * @brief Rotates the root node left.
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename COMPARE, typename ALLOCATOR, typename TRAITS >
+void CS280::AVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR,TRAITS>::RotateRootLeft()
+{
+    Node* temp = mRoot;
+
+    Node* newRoot = mRoot->right;
+
+    // Promote the right child as the root
+    mRoot = mRoot->right;
+
+    // Update the root node's parent pointer
+    mRoot->parent = nullptr;
+
+    // Update the old root's parent pointer
+    temp->parent = newRoot;
+
+    // Update the old root's child pointer
+    temp->right = newRoot->left;
+
+    // Update the old root's child's parent pointer
+    if(temp->right)
+        temp->right->parent = temp;
+
+    // Update the promoted root's child pointer
+    newRoot->left = temp;
+
+    // Only the two rotated nodes changed height, the old root is now below the new one
+    UpdateHeight(temp);
+    UpdateHeight(mRoot);
+}
+
+/**
+ * @brief Recomputes a node's cached height and balance from its children's cached heights. O(1).
+ * @param node - node to update
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename COMPARE, typename ALLOCATOR, typename TRAITS >
+void CS280::AVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR,TRAITS>::UpdateHeight(Node* node)
+{
+    int leftHeight = GetSubtreeHeight(node->left);
+    int rightHeight = GetSubtreeHeight(node->right);
+
+    node->height = 1 + std::max(leftHeight, rightHeight);
+    node->balance = leftHeight - rightHeight;
+
+    if constexpr(TRAITS::order_statistics)
+    {
+        node->count = 1 + GetSubtreeCount(node->left) + GetSubtreeCount(node->right);
+    }
+}
+
+/**
+ * @brief Returns the number of nodes in a subtree (cached in the node when TRAITS::order_statistics is on, 0 otherwise).
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename COMPARE, typename ALLOCATOR, typename TRAITS >
+unsigned int CS280::AVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR,TRAITS>::GetSubtreeCount(Node* node)
+{
+    if constexpr(TRAITS::order_statistics)
+    {
+        return node ? node->count : 0;
+    }
+    else
+    {
+        return 0;
+    }
 }
 
 /**
- * @brief Balances the tree. Finds the correct node to be rotated.
+ * @brief Adds to the subtree size of the node and all its parents after a node was linked or unlinked below it.
+ *        Nothing to do unless TRAITS::order_statistics is on.
  * 
- * @param nodes - the nodes that were visited up until the recently inserted/deleted node.
- * @param inserting - whether or not node is being inserted (if false then deleted)
+ * @param node - lowest node whose subtree changed
+ * @param change - number of nodes added (negative when removed)
  */
-template< typename KEY_TYPE, typename VALUE_TYPE >
-void CS280::AVLmap<KEY_TYPE,VALUE_TYPE>::BalanceTree(std::stack<Node*>& nodes, bool inserting)
+template< typename KEY_TYPE, typename VALUE_TYPE, typename COMPARE, typename ALLOCATOR, typename TRAITS >
+void CS280::AVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR,TRAITS>::AddToCounts(Node* node, int change)
 {
-    // Go through the stack
-    while(!nodes.empty())
+    if constexpr(TRAITS::order_statistics)
+    {
+        for(; node != nullptr; node = node->parent)
+        {
+            node->count += change;
+        }
+    }
+    else
     {
-        // Remove the top node pointer from the stack and call it y.
-        Node* y = nodes.top();
-        nodes.pop();
+        (void)node;
+        (void)change;
+    }
+}
 
-        Node* leftSubtree = y->left;
-        Node* rightSubtree = y->right;
+/**
+ * @brief Finds the node at the given position by walking down with the subtree sizes.
+ * 
+ * @param index - 0-based position
+ * @return the node, or null if the index is past the last node
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename COMPARE, typename ALLOCATOR, typename TRAITS >
+typename CS280::AVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR,TRAITS>::Node* CS280::AVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR,TRAITS>::NthNode(unsigned int index) const
+{
+    static_assert(TRAITS::order_statistics, "nth needs TRAITS::order_statistics");
 
-        // Find the balance of y
-        int balance = GetSubtreeBalance(y);
-        int leftSubtreeHeight = GetSubtreeHeight(leftSubtree);
-        int rightSubtreeHeight = GetSubtreeHeight(rightSubtree);
+    Node* walker = mRoot;
 
-        // If the height of left and right subtree are equal or differ by no more than 1 (hence, balanced), go to the next node on the stack
-        if(std::abs(leftSubtreeHeight - rightSubtreeHeight) <= 1)
+    while(walker != nullptr)
+    {
+        unsigned int leftCount = GetSubtreeCount(walker->left);
+
+        if(index < leftCount)
         {
-            continue;
+            walker = walker->left;
+        }
+        else if(index == leftCount)
+        {
+            return walker;
+        }
+        else
+        {
+            // Skip this node and its left subtree
+            index -= leftCount + 1;
+            walker = walker->right;
         }
+    }
+
+    return nullptr;
+}
+
+/**
+ * @brief Returns how many threads a parallel operation uses: the number asked for (every hardware thread for 0),
+ *        but no more than there are PARALLEL_GRAIN sized shares of the work.
+ * 
+ * @param threads - number of threads asked for
+ * @param items - number of nodes or elements the operation goes through
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename COMPARE, typename ALLOCATOR, typename TRAITS >
+unsigned int CS280::AVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR,TRAITS>::ParallelThreads(unsigned int threads, std::size_t items)
+{
+    if(threads == 0)
+        threads = std::max(1u, std::thread::hardware_concurrency());
 
-        if(balance > 1)
+    std::size_t shares = std::max<std::size_t>(1, items / PARALLEL_GRAIN);
+
+    return static_cast<unsigned int>(std::min<std::size_t>(threads, shares));
+}
+
+/**
+ * @brief Cuts the tree into about the given number of in-order ranges. Range i is [bounds[i], bounds[i + 1]),
+ *        the last bound is null (the end). With TRAITS::order_statistics the bounds are found by position, so
+ *        the ranges are equal. Otherwise the bounds are the nodes of the first level with enough of them: an
+ *        AVL tree's subtrees at one depth differ little in size, and each range is one of them plus its neighbours'
+ *        ancestors. No bounds for an empty tree. O(ranges log n).
+ * 
+ * @param ranges - number of ranges wanted
+ * @param bounds - set to the bounds
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename COMPARE, typename ALLOCATOR, typename TRAITS >
+void CS280::AVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR,TRAITS>::SplitRanges(std::size_t ranges, std::vector<Node*>& bounds) const
+{
+    bounds.clear();
+
+    if(mRoot == nullptr)
+        return;
+
+    bounds.push_back(mRoot->first());
+
+    if(ranges > 1)
+    {
+        if constexpr(TRAITS::order_statistics)
         {
-            if(GetSubtreeHeight(leftSubtree->left) >= GetSubtreeHeight(leftSubtree->right))
-            {
-                RotateRight(y);
-            }
-            else
+            for(std::size_t range = 1; range < ranges; ++range)
             {
-                RotateLeft(leftSubtree);
-                RotateRight(y);
+                Node* bound = NthNode(static_cast<unsigned int>(range * size_ / ranges));
+
+                if(bound != bounds.back())
+                    bounds.push_back(bound);
             }
         }
-
-        if(balance < -1)
+        else
         {
-            if(GetSubtreeHeight(rightSubtree->right) >= GetSubtreeHeight(rightSubtree->left))
+            unsigned int depth = 0;
+
+            while((std::size_t(1) << depth) < ranges)
             {
-                RotateLeft(y);
+                ++depth;
             }
-            else
+
+            std::vector<Node*> level;
+            CollectLevel(mRoot, depth, level);
+
+            for(Node* bound : level)
             {
-                RotateRight(rightSubtree);
-                RotateLeft(y);
+                if(bound != bounds.back())
+                    bounds.push_back(bound);
             }
         }
-
-        if(inserting)
-            break;
     }
-}
 
-/**
- * @brief Returns the height of a subtree.
- */
-template< typename KEY_TYPE, typename VALUE_TYPE >
-int CS280::AVLmap<KEY_TYPE,VALUE_TYPE>::GetSubtreeHeight(Node* node)
-{
-    if(node == nullptr)
-        return -1;
-    else
-        return (1 + std::max(GetSubtreeHeight(node->left), GetSubtreeHeight(node->right)));
+    bounds.push_back(nullptr);
 }
 
 /**
- * @brief Returns the balance of a subtree.
+ * @brief Appends the nodes at the given depth below node, in key order. Only walks the levels above it.
+ * 
+ * @param node - subtree root
+ * @param depth - depth below node
+ * @param nodes - gets the nodes
  */
-template< typename KEY_TYPE, typename VALUE_TYPE >
-int CS280::AVLmap<KEY_TYPE,VALUE_TYPE>::GetSubtreeBalance(Node* node)
+template< typename KEY_TYPE, typename VALUE_TYPE, typename COMPARE, typename ALLOCATOR, typename TRAITS >
+void CS280::AVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR,TRAITS>::CollectLevel(Node* node, unsigned int depth, std::vector<Node*>& nodes)
 {
     if(node == nullptr)
-        return -1;
-    else
-        return GetSubtreeHeight(node->left) - GetSubtreeHeight(node->right);
+        return;
+
+    if(depth == 0)
+    {
+        nodes.push_back(node);
+        return;
+    }
+
+    CollectLevel(node->left, depth - 1, nodes);
+    CollectLevel(node->right, depth - 1, nodes);
 }
 
 /**
- * @brief Rotates a node right.
+ * @brief Runs task(index) for every index below tasks on the given number of threads. The threads take
+ *        the next index from a shared counter until none are left, so a thread with cheap tasks just
+ *        takes more of them. On an exception the other threads stop taking tasks and the first one is rethrown.
+ * 
+ * @param tasks - number of tasks (ranges made by SplitRanges, pieces of a build or a merge)
+ * @param threads - number of threads, the calling thread is one of them
+ * @param task - called once per index
  */
-template< typename KEY_TYPE, typename VALUE_TYPE >
-void CS280::AVLmap<KEY_TYPE,VALUE_TYPE>::RotateRight(Node*& node)
+template< typename KEY_TYPE, typename VALUE_TYPE, typename COMPARE, typename ALLOCATOR, typename TRAITS >
+template< typename TASK >
+void CS280::AVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR,TRAITS>::RunTasks(std::size_t tasks, unsigned int threads, TASK& task)
 {
-    // If the root is being rotated
-    if(node == mRoot)
+    if(threads <= 1 || tasks <= 1)
     {
-        RotateRootRight();
+        for(std::size_t index = 0; index < tasks; ++index)
+        {
+            task(index);
+        }
+
         return;
     }
 
-    Node* temp = node;
+    std::atomic<std::size_t> next(0);
+    std::atomic<bool> failed(false);
+    std::exception_ptr error;
+    std::mutex errorLock;
 
-    Node* nodeParent = node->parent;
+    auto work = [&]()
+    {
+        try
+        {
+            for(std::size_t index = next++; index < tasks && !failed; index = next++)
+            {
+                task(index);
+            }
+        }
+        catch(...)
+        {
+            std::lock_guard<std::mutex> lock(errorLock);
+
+            if(!error)
+                error = std::current_exception();
 
-    // Update the node parent child pointer
-    if(node == nodeParent->left)
+            failed = true;
+        }
+    };
+
+    std::vector<std::thread> workers;
+    workers.reserve(threads - 1);
+
+    try
     {
-        nodeParent->left = node->left;
+        for(unsigned int i = 1; i < threads; ++i)
+        {
+            workers.emplace_back(work);
+        }
     }
-    else
+    catch(...)
     {
-        nodeParent->right = node->left;
+        // Couldn't start them all, the ones that did start and this thread do the ranges
     }
 
-    // Promote the left child
-    node = node->left;
+    work();
 
-    // Update the promoted node's parent pointer
-    node->parent = nodeParent;
+    for(std::thread& worker : workers)
+    {
+        worker.join();
+    }
 
-    // Update the old node's parent pointer
-    temp->parent = node;
+    if(error)
+        std::rethrow_exception(error);
+}
 
-    // Update the old node's child pointer
-    temp->left = node->right;
+/**
+ * @brief Copies (or with MOVE_VALUES moves) a node's key, value and cached subtree data into a new unlinked node.
+ * 
+ * @param source - node to copy
+ * @param parent - parent of the copy
+ * @return the copy
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename COMPARE, typename ALLOCATOR, typename TRAITS >
+template< bool MOVE_VALUES >
+typename CS280::AVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR,TRAITS>::Node* CS280::AVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR,TRAITS>::CloneNode(Node* source, Node* parent)
+{
+    Node* copy;
 
-    // Update the old node's child's parent pointer
-    if(temp->left)
-        temp->left->parent = temp;
+    if constexpr(MOVE_VALUES)
+    {
+        copy = CreateNode(parent, std::move(source->key), std::move(source->value));
+        copy->height = source->height;
+        copy->balance = source->balance;
+    }
+    else
+    {
+        copy = CreateNode(source->key, source->value, parent, source->height, source->balance, nullptr, nullptr);
+    }
 
-    // Update the promoted node's child pointer
-    node->right = temp;
+    if constexpr(TRAITS::order_statistics)
+    {
+        copy->count = source->count;
+    }
 
-    // Update all node heights
-    UpdateSubtreeHeights(node);
+    return copy;
 }
 
 /**
- * @brief Rotates a node left.
+ * @brief Node pool constructor
+ * 
+ * @param alloc - allocator the chunks come from
  */
-template< typename KEY_TYPE, typename VALUE_TYPE >
-void CS280::AVLmap<KEY_TYPE,VALUE_TYPE>::RotateLeft(Node*& node)
+template< typename KEY_TYPE, typename VALUE_TYPE, typename COMPARE, typename ALLOCATOR, typename TRAITS >
+CS280::AVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR,TRAITS>::NodePool::NodePool(ALLOCATOR const& alloc) : alloc(alloc)
 {
-    // If the root is being rotated
-    if(node == mRoot)
+
+}
+
+/**
+ * @brief Node pool destructor. Gives every chunk back to the allocator.
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename COMPARE, typename ALLOCATOR, typename TRAITS >
+CS280::AVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR,TRAITS>::NodePool::~NodePool()
+{
+    release();
+}
+
+/**
+ * @brief Builds a node in a free slot. The slot is given back if the constructor throws.
+ * 
+ * @param args - node constructor arguments
+ * @return the new node
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename COMPARE, typename ALLOCATOR, typename TRAITS >
+template< typename... ARGS >
+typename CS280::AVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR,TRAITS>::Node* CS280::AVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR,TRAITS>::NodePool::allocate(ARGS&&... args)
+{
+    Slot* slot;
+
     {
-        RotateRootLeft();
-        return;
-    }
+        std::unique_lock<std::mutex> guard(lock, std::defer_lock);
 
-    Node* temp = node;
+        if(shared())
+            guard.lock();
 
-    Node* nodeParent = node->parent;
+        slot = GetSlot();
+    }
 
-    // Update the node parent child pointer
-    if(node == nodeParent->left)
+    // The node is built outside the lock
+    try
     {
-        nodeParent->left = node->right;
+        return ::new (static_cast<void*>(slot->node)) Node(std::forward<ARGS>(args)...);
     }
-    else
+    catch(...)
     {
-        nodeParent->right = node->right;
+        PushFree(slot);
+        throw;
     }
+}
 
-    // Promote the right child
-    node = node->right;
-
-    // Update the promoted node's parent pointer
-    node->parent = nodeParent;
+/**
+ * @brief Destroys a node and puts its slot on the free list
+ * 
+ * @param node - node to destroy
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename COMPARE, typename ALLOCATOR, typename TRAITS >
+void CS280::AVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR,TRAITS>::NodePool::deallocate(Node* node)
+{
+    node->~Node();
 
-    // Update the old node's parent pointer
-    temp->parent = node;
+    PushFree(reinterpret_cast<Slot*>(node));
+}
 
-    // Update the old node's child pointer
-    temp->right = node->left;
+/**
+ * @brief Gives every chunk back to the allocator. The nodes in them must already be destroyed.
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename COMPARE, typename ALLOCATOR, typename TRAITS >
+void CS280::AVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR,TRAITS>::NodePool::release()
+{
+    std::unique_lock<std::mutex> guard(lock, std::defer_lock);
 
-    // Update the old node's child's parent pointer
-    if(temp->right)
-        temp->right->parent = temp;
+    if(shared())
+        guard.lock();
 
-    // Update the promoted node's child pointer
-    node->left = temp;
+    while(chunks != nullptr)
+    {
+        Slot* next = chunks->chunk.next;
+        std::allocator_traits<SlotAllocator>::deallocate(alloc, chunks, chunks->chunk.slots);
+        chunks = next;
+    }
 
-    // Update all node heights
-    UpdateSubtreeHeights(node);
+    freeList = nullptr;
+    freeTail = nullptr;
+    unused = nullptr;
+    unusedEnd = nullptr;
 }
 
 /**
- * @brief Rotates the root node right.
+ * @brief Takes over every chunk of another pool, so the nodes living in them now belong to this pool
+ *        and none of them move. The other pool's free and unused slots join this pool's free list. O(chunks).
+ * 
+ * @param other - pool to empty into this one
+ * @return whether the chunks were taken (not when the allocators can't free each other's memory)
  */
-template< typename KEY_TYPE, typename VALUE_TYPE >
-void CS280::AVLmap<KEY_TYPE,VALUE_TYPE>::RotateRootRight()
+template< typename KEY_TYPE, typename VALUE_TYPE, typename COMPARE, typename ALLOCATOR, typename TRAITS >
+bool CS280::AVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR,TRAITS>::NodePool::splice(NodePool& other)
 {
-    Node* temp = mRoot;
+    if(&other == this || !(alloc == other.alloc))
+        return false;
 
-    Node* newRoot = mRoot->left;
+    std::unique_lock<std::mutex> mine(lock, std::defer_lock);
+    std::unique_lock<std::mutex> theirs(other.lock, std::defer_lock);
 
-    // Promote the left child as the root
-    mRoot = mRoot->left;
+    if(shared() && other.shared())
+    {
+        std::lock(mine, theirs);
+    }
+    else if(shared())
+    {
+        mine.lock();
+    }
+    else if(other.shared())
+    {
+        theirs.lock();
+    }
 
-    // Update the root node's parent pointer
-    mRoot->parent = nullptr;
+    if(other.chunks == nullptr)
+        return true;
 
-    // Update the old root's parent pointer
-    temp->parent = newRoot;
+    // The slots of the other pool's newest chunk that were never handed out become free slots
+    for(; other.unused != other.unusedEnd; ++other.unused)
+    {
+        other.unused->next = other.freeList;
 
-    // Update the old root's child pointer
-    temp->left = newRoot->right;
+        if(other.freeList == nullptr)
+            other.freeTail = other.unused;
 
-    // Update the old root's child's parent pointer
-    if(temp->left)
-        temp->left->parent = temp;
+        other.freeList = other.unused;
+    }
 
-    // Update the promoted root's child pointer
-    newRoot->right = temp;
+    if(other.freeList != nullptr)
+    {
+        other.freeTail->next = freeList;
 
-    // Update all node heights
-    UpdateSubtreeHeights(mRoot);
-}
+        if(freeList == nullptr)
+            freeTail = other.freeTail;
 
+        freeList = other.freeList;
+    }
 
-/**
- * @brief Rotates the root node left.
- */
-template< typename KEY_TYPE, typename VALUE_TYPE >
-void CS280::AVLmap<KEY_TYPE,VALUE_TYPE>::RotateRootLeft()
-{
-    Node* temp = mRoot;
+    // Put the other chain of chunks in front of this one
+    Slot* oldest = other.chunks;
 
-    Node* newRoot = mRoot->right;
+    while(oldest->chunk.next != nullptr)
+    {
+        oldest = oldest->chunk.next;
+    }
 
-    // Promote the right child as the root
-    mRoot = mRoot->right;
+    oldest->chunk.next = chunks;
+    chunks = other.chunks;
 
-    // Update the root node's parent pointer
-    mRoot->parent = nullptr;
+    nextChunkSlots = std::max(nextChunkSlots, other.nextChunkSlots);
 
-    // Update the old root's parent pointer
-    temp->parent = newRoot;
+    other.chunks = nullptr;
+    other.freeList = nullptr;
+    other.freeTail = nullptr;
+    other.unused = nullptr;
+    other.unusedEnd = nullptr;
 
-    // Update the old root's child pointer
-    temp->right = newRoot->left;
+    return true;
+}
 
-    // Update the old root's child's parent pointer
-    if(temp->right)
-        temp->right->parent = temp;
+/**
+ * @brief Marks the pool as shared, called by its only owner before handing it to a second one (a map or a node
+ *        handle), so the calls of the owners, on whatever threads, lock from then on
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename COMPARE, typename ALLOCATOR, typename TRAITS >
+void CS280::AVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR,TRAITS>::NodePool::share()
+{
+    isShared.store(true, std::memory_order_release);
+}
 
-    // Update the promoted root's child pointer
-    newRoot->left = temp;
+/**
+ * @brief Stops the locking, called by the only owner left. Taking the lock once makes the last calls
+ *        of the other owners visible to this thread.
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename COMPARE, typename ALLOCATOR, typename TRAITS >
+void CS280::AVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR,TRAITS>::NodePool::unshare()
+{
+    std::lock_guard<std::mutex> guard(lock);
+    isShared.store(false, std::memory_order_relaxed);
+}
 
-    // Update all node heights
-    UpdateSubtreeHeights(mRoot);
+/**
+ * @brief Returns whether the calls lock
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename COMPARE, typename ALLOCATOR, typename TRAITS >
+bool CS280::AVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR,TRAITS>::NodePool::shared() const
+{
+    return isShared.load(std::memory_order_acquire);
 }
 
 /**
- * @brief Traverses a subtree through preorder traversal and updates the height values.
- * @param subtree - subtree to traverse
+ * @brief Puts a slot on the free list, under the lock while the pool is shared
  */
-template< typename KEY_TYPE, typename VALUE_TYPE >
-void CS280::AVLmap<KEY_TYPE,VALUE_TYPE>::UpdateSubtreeHeights(Node* subtree)
+template< typename KEY_TYPE, typename VALUE_TYPE, typename COMPARE, typename ALLOCATOR, typename TRAITS >
+void CS280::AVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR,TRAITS>::NodePool::PushFree(Slot* slot)
 {
-    if(subtree == nullptr)
-        return;
+    std::unique_lock<std::mutex> guard(lock, std::defer_lock);
+
+    if(shared())
+        guard.lock();
 
-    subtree->height = subtree->parent ? subtree->parent->height + 1 : 0;
-    UpdateSubtreeHeights(subtree->left);
-    UpdateSubtreeHeights(subtree->right);
+    slot->next = freeList;
+
+    if(freeList == nullptr)
+        freeTail = slot;
+
+    freeList = slot;
 }
 
 /**
- * @brief Adds all parent pointers all the way up to the root to the given stack.
- * 
- * @param node - the node to find visited nodes for
- * @param stack - stack to add nodes to
+ * @brief Returns a free slot. Reuses freed slots first, then the newest chunk's unused slots,
+ *        and only then allocates a new chunk (each one twice as big as the last, up to a cap).
  */
-template< typename KEY_TYPE, typename VALUE_TYPE >
-void CS280::AVLmap<KEY_TYPE,VALUE_TYPE>::GetVisitedNodes(Node* node, std::stack<Node*>& stack)
+template< typename KEY_TYPE, typename VALUE_TYPE, typename COMPARE, typename ALLOCATOR, typename TRAITS >
+typename CS280::AVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR,TRAITS>::NodePool::Slot* CS280::AVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR,TRAITS>::NodePool::GetSlot()
 {
-    if(!node->parent)
-        return;
-
-    // Start with the nodes parents
-    Node* parentWalker = node->parent;
+    if(freeList != nullptr)
+    {
+        Slot* slot = freeList;
+        freeList = freeList->next;
+        return slot;
+    }
 
-    while(parentWalker != nullptr)
+    if(unused == unusedEnd)
     {
-        // Add parents to stack
-        stack.push(parentWalker);
+        Slot* chunk = std::allocator_traits<SlotAllocator>::allocate(alloc, nextChunkSlots);
 
-        // Go to next parent
-        parentWalker = parentWalker->parent;
+        // The first slot of the chunk links it to the previous one
+        chunk->chunk.next = chunks;
+        chunk->chunk.slots = nextChunkSlots;
+        chunks = chunk;
+
+        unused = chunk + 1;
+        unusedEnd = chunk + nextChunkSlots;
+
+        if(nextChunkSlots < MAX_CHUNK_SLOTS)
+        {
+            nextChunkSlots *= 2;
+        }
     }
+
+    return unused++;
 }
 
 /**
@@ -804,18 +4832,33 @@ void CS280::AVLmap<KEY_TYPE,VALUE_TYPE>::GetVisitedNodes(Node* node, std::stack<
  * @param l - left
  * @param r - right
  */
-template< typename KEY_TYPE, typename VALUE_TYPE >
-CS280::AVLmap<KEY_TYPE, VALUE_TYPE>::Node::Node(KEY_TYPE k, VALUE_TYPE val, Node* p, int h, int b, Node* l, Node* r)
+template< typename KEY_TYPE, typename VALUE_TYPE, typename COMPARE, typename ALLOCATOR, typename TRAITS >
+CS280::AVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR,TRAITS>::Node::Node(KEY_TYPE const& k, VALUE_TYPE const& val, Node* p, int h, int b, Node* l, Node* r)
     : key(k), value(val), height(h), balance(b), parent(p), left(l), right(r)
 {
 
 }
 
+/**
+ * @brief Node constructor that builds a leaf in place
+ * 
+ * @param p - parent
+ * @param k - argument the key is built from
+ * @param val - arguments the value is built from
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename COMPARE, typename ALLOCATOR, typename TRAITS >
+template< typename KEY_ARG, typename... VALUE_ARGS >
+CS280::AVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR,TRAITS>::Node::Node(Node* p, KEY_ARG&& k, VALUE_ARGS&&... val)
+    : key(std::forward<KEY_ARG>(k)), value(std::forward<VALUE_ARGS>(val)...), height(0), balance(0), parent(p), left(nullptr), right(nullptr)
+{
+
+}
+
 /**
  * @brief Returns the node's key
  */
-template< typename KEY_TYPE, typename VALUE_TYPE >
-KEY_TYPE const& CS280::AVLmap<KEY_TYPE, VALUE_TYPE>::Node::Key() const
+template< typename KEY_TYPE, typename VALUE_TYPE, typename COMPARE, typename ALLOCATOR, typename TRAITS >
+KEY_TYPE const& CS280::AVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR,TRAITS>::Node::Key() const
 {
     return key;
 }
@@ -823,8 +4866,17 @@ KEY_TYPE const& CS280::AVLmap<KEY_TYPE, VALUE_TYPE>::Node::Key() const
 /**
  * @brief Returns the node's value
  */
-template< typename KEY_TYPE, typename VALUE_TYPE >
-VALUE_TYPE& CS280::AVLmap<KEY_TYPE, VALUE_TYPE>::Node::Value()
+template< typename KEY_TYPE, typename VALUE_TYPE, typename COMPARE, typename ALLOCATOR, typename TRAITS >
+VALUE_TYPE& CS280::AVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR,TRAITS>::Node::Value()
+{
+    return value;
+}
+
+/**
+ * @brief Returns the node's value
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename COMPARE, typename ALLOCATOR, typename TRAITS >
+VALUE_TYPE const& CS280::AVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR,TRAITS>::Node::Value() const
 {
     return value;
 }
@@ -832,41 +4884,46 @@ VALUE_TYPE& CS280::AVLmap<KEY_TYPE, VALUE_TYPE>::Node::Value()
 /**
  * @brief Returns the node as from left from this node as possible.
  */
-template< typename KEY_TYPE, typename VALUE_TYPE >
-typename CS280::AVLmap<KEY_TYPE, VALUE_TYPE>::Node* CS280::AVLmap<KEY_TYPE, VALUE_TYPE>::Node::first()
+template< typename KEY_TYPE, typename VALUE_TYPE, typename COMPARE, typename ALLOCATOR, typename TRAITS >
+typename CS280::AVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR,TRAITS>::Node* CS280::AVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR,TRAITS>::Node::first()
 {
-    if(left == nullptr)
-    {
-        return this;
-    }
-    else
+    Node* walker = this;
+
+    while(walker->left != nullptr)
     {
-        return left->first();
+        walker = walker->left;
     }
+
+    return walker;
 }
 
 /**
  * @brief Returns the node as from right from this node as possible.
  */
-template< typename KEY_TYPE, typename VALUE_TYPE >
-typename CS280::AVLmap<KEY_TYPE, VALUE_TYPE>::Node* CS280::AVLmap<KEY_TYPE, VALUE_TYPE>::Node::last()
+template< typename KEY_TYPE, typename VALUE_TYPE, typename COMPARE, typename ALLOCATOR, typename TRAITS >
+typename CS280::AVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR,TRAITS>::Node* CS280::AVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR,TRAITS>::Node::last()
 {
-    if(right == nullptr)
-    {
-        return this;
-    }
-    else
+    Node* walker = this;
+
+    while(walker->right != nullptr)
     {
-        return right->last();
+        walker = walker->right;
     }
+
+    return walker;
 }
 
 /**
  * @brief Returns the next key in the tree after this node.
  */
-template< typename KEY_TYPE, typename VALUE_TYPE >
-typename CS280::AVLmap<KEY_TYPE, VALUE_TYPE>::Node* CS280::AVLmap<KEY_TYPE, VALUE_TYPE>::Node::increment()
+template< typename KEY_TYPE, typename VALUE_TYPE, typename COMPARE, typename ALLOCATOR, typename TRAITS >
+typename CS280::AVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR,TRAITS>::Node* CS280::AVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR,TRAITS>::Node::increment()
 {
+    if constexpr(TRAITS::threaded)
+    {
+        return this->next;
+    }
+
     // If the right exists, get the minimum value after this node's value
     if(right != nullptr)
     {
@@ -892,9 +4949,14 @@ typename CS280::AVLmap<KEY_TYPE, VALUE_TYPE>::Node* CS280::AVLmap<KEY_TYPE, VALU
 /**
  * @brief Returns the previous key in the tree before this node.
  */
-template< typename KEY_TYPE, typename VALUE_TYPE >
-typename CS280::AVLmap<KEY_TYPE, VALUE_TYPE>::Node* CS280::AVLmap<KEY_TYPE, VALUE_TYPE>::Node::decrement()
+template< typename KEY_TYPE, typename VALUE_TYPE, typename COMPARE, typename ALLOCATOR, typename TRAITS >
+typename CS280::AVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR,TRAITS>::Node* CS280::AVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR,TRAITS>::Node::decrement()
 {
+    if constexpr(TRAITS::threaded)
+    {
+        return this->prev;
+    }
+
     // If the right exists, get the maximum value before this node's value
     if(left != nullptr)
     {
@@ -917,10 +4979,10 @@ typename CS280::AVLmap<KEY_TYPE, VALUE_TYPE>::Node* CS280::AVLmap<KEY_TYPE, VALU
     return parentWalker;
 }
 
-template< typename KEY_TYPE, typename VALUE_TYPE >
-void CS280::AVLmap<KEY_TYPE, VALUE_TYPE>::Node::print(std::ostream& os, bool print_value) const
+template< typename KEY_TYPE, typename VALUE_TYPE, typename COMPARE, typename ALLOCATOR, typename TRAITS >
+void CS280::AVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR,TRAITS>::Node::print(std::ostream& os, bool print_value) const
 {
-    for (int i=0; i < height; ++i) std::printf("       ");
+    for (const Node* p = parent; p != nullptr; p = p->parent) std::printf("       ");
 
     os << key;
 
@@ -929,13 +4991,194 @@ void CS280::AVLmap<KEY_TYPE, VALUE_TYPE>::Node::print(std::ostream& os, bool pri
     os << std::endl;
 }
 
+/**
+ * @brief Constructor for a range of nodes
+ * 
+ * @param first - first node of the range
+ * @param last - node past the range
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename COMPARE, typename ALLOCATOR, typename TRAITS >
+template< typename ITERATOR >
+CS280::AVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR,TRAITS>::AVLmap_range<ITERATOR>::AVLmap_range(ITERATOR first, ITERATOR last) : mFirst(first), mLast(last)
+{
+
+}
+
+/**
+ * @brief Returns the iterator to the first node of the range
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename COMPARE, typename ALLOCATOR, typename TRAITS >
+template< typename ITERATOR >
+ITERATOR CS280::AVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR,TRAITS>::AVLmap_range<ITERATOR>::begin() const
+{
+    return mFirst;
+}
+
+/**
+ * @brief Returns the iterator past the last node of the range
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename COMPARE, typename ALLOCATOR, typename TRAITS >
+template< typename ITERATOR >
+ITERATOR CS280::AVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR,TRAITS>::AVLmap_range<ITERATOR>::end() const
+{
+    return mLast;
+}
+
+/**
+ * @brief Returns whether the range has no nodes
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename COMPARE, typename ALLOCATOR, typename TRAITS >
+template< typename ITERATOR >
+bool CS280::AVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR,TRAITS>::AVLmap_range<ITERATOR>::empty() const
+{
+    ITERATOR first = mFirst;
+    return first == mLast;
+}
+
+/**
+ * @brief Constructor for an empty node handle
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename COMPARE, typename ALLOCATOR, typename TRAITS >
+CS280::AVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR,TRAITS>::AVLmap_node_handle::AVLmap_node_handle()
+{
+
+}
+
+/**
+ * @brief Move constructor, takes rhs's node and leaves rhs empty
+ * 
+ * @param rhs - handle to take the node from
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename COMPARE, typename ALLOCATOR, typename TRAITS >
+CS280::AVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR,TRAITS>::AVLmap_node_handle::AVLmap_node_handle(AVLmap_node_handle&& rhs) : mNode(rhs.mNode), mPool(std::move(rhs.mPool))
+{
+    rhs.mNode = nullptr;
+}
+
+/**
+ * @brief Move assignment, destroys the node held so far and takes rhs's node
+ * 
+ * @param rhs - handle to take the node from
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename COMPARE, typename ALLOCATOR, typename TRAITS >
+typename CS280::AVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR,TRAITS>::AVLmap_node_handle& CS280::AVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR,TRAITS>::AVLmap_node_handle::operator=(AVLmap_node_handle&& rhs)
+{
+    if(this != &rhs)
+    {
+        if(mNode != nullptr)
+            mPool->deallocate(mNode);
+
+        mNode = rhs.mNode;
+        mPool = std::move(rhs.mPool);
+        rhs.mNode = nullptr;
+    }
+
+    return *this;
+}
+
+/**
+ * @brief Destroys the node if it was never inserted into a map
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename COMPARE, typename ALLOCATOR, typename TRAITS >
+CS280::AVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR,TRAITS>::AVLmap_node_handle::~AVLmap_node_handle()
+{
+    if(mNode != nullptr)
+        mPool->deallocate(mNode);
+}
+
+/**
+ * @brief Returns whether the handle holds no node
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename COMPARE, typename ALLOCATOR, typename TRAITS >
+bool CS280::AVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR,TRAITS>::AVLmap_node_handle::empty() const
+{
+    return mNode == nullptr;
+}
+
+/**
+ * @brief Returns whether the handle holds a node
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename COMPARE, typename ALLOCATOR, typename TRAITS >
+CS280::AVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR,TRAITS>::AVLmap_node_handle::operator bool() const
+{
+    return mNode != nullptr;
+}
+
+/**
+ * @brief Returns the node's key, which may be changed before the node is inserted
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename COMPARE, typename ALLOCATOR, typename TRAITS >
+KEY_TYPE& CS280::AVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR,TRAITS>::AVLmap_node_handle::key() const
+{
+    return mNode->key;
+}
+
+/**
+ * @brief Returns the node's value
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename COMPARE, typename ALLOCATOR, typename TRAITS >
+VALUE_TYPE& CS280::AVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR,TRAITS>::AVLmap_node_handle::mapped() const
+{
+    return mNode->value;
+}
+
+/**
+ * @brief Returns the mean number of nodes a search visited (0 before the first search)
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename COMPARE, typename ALLOCATOR, typename TRAITS >
+double CS280::AVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR,TRAITS>::AVLmap_stats::averageSearchDepth() const
+{
+    if(searches == 0)
+        return 0.0;
+
+    return static_cast<double>(searchDepth) / static_cast<double>(searches);
+}
+
+/**
+ * @brief Starts timing an operation, reads the clock only when TRAITS::latency_histograms is on
+ * 
+ * @param map - map whose histogram counts the operation
+ * @param operation - histogram to count it in
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename COMPARE, typename ALLOCATOR, typename TRAITS >
+CS280::AVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR,TRAITS>::LatencyTimer::LatencyTimer(AVLmap const* map, typename AVLmap_stats::Operation operation)
+    : mMap(map), mOperation(operation)
+{
+    if constexpr(TRAITS::latency_histograms)
+    {
+        mStart = std::chrono::steady_clock::now();
+    }
+}
+
+/**
+ * @brief Counts the operation in the bucket of its power of two of nanoseconds
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename COMPARE, typename ALLOCATOR, typename TRAITS >
+CS280::AVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR,TRAITS>::LatencyTimer::~LatencyTimer()
+{
+    if constexpr(TRAITS::latency_histograms)
+    {
+        auto elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - mStart).count();
+        std::size_t bucket = 0;
+
+        while(elapsed > 1 && bucket + 1 < AVLmap_stats::LATENCY_BUCKETS)
+        {
+            elapsed >>= 1;
+            ++bucket;
+        }
+
+        mMap->mLookups.latency[mOperation][bucket].fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
 /**
  * @brief Constructor for iterator
  * 
  * @param p - node for iterator
+ * @param map - map the node is in (null end iterators can't be decremented)
  */
-template< typename KEY_TYPE, typename VALUE_TYPE >
-CS280::AVLmap<KEY_TYPE, VALUE_TYPE>::AVLmap_iterator::AVLmap_iterator(Node* p) : mNode(p)
+template< typename KEY_TYPE, typename VALUE_TYPE, typename COMPARE, typename ALLOCATOR, typename TRAITS >
+CS280::AVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR,TRAITS>::AVLmap_iterator::AVLmap_iterator(Node* p, AVLmap* map) : mNode(p), mMap(map)
 {
 
 }
@@ -945,8 +5188,8 @@ CS280::AVLmap<KEY_TYPE, VALUE_TYPE>::AVLmap_iterator::AVLmap_iterator(Node* p) :
  * 
  * @param rhs - iterator to copy
  */
-template< typename KEY_TYPE, typename VALUE_TYPE >
-CS280::AVLmap<KEY_TYPE, VALUE_TYPE>::AVLmap_iterator::AVLmap_iterator(const AVLmap_iterator& rhs) : mNode(rhs.mNode)
+template< typename KEY_TYPE, typename VALUE_TYPE, typename COMPARE, typename ALLOCATOR, typename TRAITS >
+CS280::AVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR,TRAITS>::AVLmap_iterator::AVLmap_iterator(const AVLmap_iterator& rhs) : mNode(rhs.mNode), mMap(rhs.mMap)
 {
     
 }
@@ -956,20 +5199,21 @@ CS280::AVLmap<KEY_TYPE, VALUE_TYPE>::AVLmap_iterator::AVLmap_iterator(const AVLm
  * 
  * @param rhs - iterator to assign this to.
  */
-template< typename KEY_TYPE, typename VALUE_TYPE >
-typename CS280::AVLmap<KEY_TYPE, VALUE_TYPE>::AVLmap_iterator& CS280::AVLmap<KEY_TYPE, VALUE_TYPE>::AVLmap_iterator::operator=(const AVLmap_iterator& rhs)
+template< typename KEY_TYPE, typename VALUE_TYPE, typename COMPARE, typename ALLOCATOR, typename TRAITS >
+typename CS280::AVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR,TRAITS>::AVLmap_iterator& CS280::AVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR,TRAITS>::AVLmap_iterator::operator=(const AVLmap_iterator& rhs)
 {
     mNode = rhs.mNode;
+    mMap = rhs.mMap;
     return *this;
 }
 
 /**
  * @brief Prefix increment operator for iterators
  * 
- * @return CS280::AVLmap<KEY_TYPE, VALUE_TYPE>::AVLmap_iterator& 
+ * @return CS280::AVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR,TRAITS>::AVLmap_iterator& 
  */
-template< typename KEY_TYPE, typename VALUE_TYPE >
-typename CS280::AVLmap<KEY_TYPE, VALUE_TYPE>::AVLmap_iterator& CS280::AVLmap<KEY_TYPE, VALUE_TYPE>::AVLmap_iterator::operator++()
+template< typename KEY_TYPE, typename VALUE_TYPE, typename COMPARE, typename ALLOCATOR, typename TRAITS >
+typename CS280::AVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR,TRAITS>::AVLmap_iterator& CS280::AVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR,TRAITS>::AVLmap_iterator::operator++()
 {
     mNode = mNode->increment();
     return *this;
@@ -978,21 +5222,54 @@ typename CS280::AVLmap<KEY_TYPE, VALUE_TYPE>::AVLmap_iterator& CS280::AVLmap<KEY
 /**
  * @brief Postfix increment operator for iterators
  * 
- * @return CS280::AVLmap<KEY_TYPE, VALUE_TYPE>::AVLmap_iterator& 
+ * @return CS280::AVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR,TRAITS>::AVLmap_iterator& 
  */
-template< typename KEY_TYPE, typename VALUE_TYPE >
-typename CS280::AVLmap<KEY_TYPE, VALUE_TYPE>::AVLmap_iterator CS280::AVLmap<KEY_TYPE, VALUE_TYPE>::AVLmap_iterator::operator++(int)
+template< typename KEY_TYPE, typename VALUE_TYPE, typename COMPARE, typename ALLOCATOR, typename TRAITS >
+typename CS280::AVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR,TRAITS>::AVLmap_iterator CS280::AVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR,TRAITS>::AVLmap_iterator::operator++(int)
 {
     AVLmap_iterator temp = *this;
     mNode = mNode->increment();
     return temp;
 }
 
+/**
+ * @brief Prefix decrement operator for iterators. Decrementing end gives the last node.
+ * 
+ * @return CS280::AVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR,TRAITS>::AVLmap_iterator& 
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename COMPARE, typename ALLOCATOR, typename TRAITS >
+typename CS280::AVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR,TRAITS>::AVLmap_iterator& CS280::AVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR,TRAITS>::AVLmap_iterator::operator--()
+{
+    if(mNode != nullptr)
+    {
+        mNode = mNode->decrement();
+    }
+    else if(mMap != nullptr)
+    {
+        mNode = mMap->mLast;
+    }
+
+    return *this;
+}
+
+/**
+ * @brief Postfix decrement operator for iterators
+ * 
+ * @return CS280::AVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR,TRAITS>::AVLmap_iterator 
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename COMPARE, typename ALLOCATOR, typename TRAITS >
+typename CS280::AVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR,TRAITS>::AVLmap_iterator CS280::AVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR,TRAITS>::AVLmap_iterator::operator--(int)
+{
+    AVLmap_iterator temp = *this;
+    --*this;
+    return temp;
+}
+
 /**
  * @brief Dereference operator for iterator
  */
-template< typename KEY_TYPE, typename VALUE_TYPE >
-typename CS280::AVLmap<KEY_TYPE, VALUE_TYPE>::Node& CS280::AVLmap<KEY_TYPE, VALUE_TYPE>::AVLmap_iterator::operator*()
+template< typename KEY_TYPE, typename VALUE_TYPE, typename COMPARE, typename ALLOCATOR, typename TRAITS >
+typename CS280::AVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR,TRAITS>::Node& CS280::AVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR,TRAITS>::AVLmap_iterator::operator*() const
 {
     return *mNode;
 }
@@ -1000,8 +5277,8 @@ typename CS280::AVLmap<KEY_TYPE, VALUE_TYPE>::Node& CS280::AVLmap<KEY_TYPE, VALU
 /**
  * @brief Arrow operator for iterator
  */
-template< typename KEY_TYPE, typename VALUE_TYPE >
-typename CS280::AVLmap<KEY_TYPE, VALUE_TYPE>::Node* CS280::AVLmap<KEY_TYPE, VALUE_TYPE>::AVLmap_iterator::operator->()
+template< typename KEY_TYPE, typename VALUE_TYPE, typename COMPARE, typename ALLOCATOR, typename TRAITS >
+typename CS280::AVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR,TRAITS>::Node* CS280::AVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR,TRAITS>::AVLmap_iterator::operator->() const
 {
     return mNode;
 }
@@ -1010,8 +5287,8 @@ typename CS280::AVLmap<KEY_TYPE, VALUE_TYPE>::Node* CS280::AVLmap<KEY_TYPE, VALU
  * @brief Not equal operator for iterator.
  * @param rhs - check value against
  */
-template< typename KEY_TYPE, typename VALUE_TYPE >
-bool CS280::AVLmap<KEY_TYPE, VALUE_TYPE>::AVLmap_iterator::operator!=(const AVLmap_iterator& rhs)
+template< typename KEY_TYPE, typename VALUE_TYPE, typename COMPARE, typename ALLOCATOR, typename TRAITS >
+bool CS280::AVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR,TRAITS>::AVLmap_iterator::operator!=(const AVLmap_iterator& rhs) const
 {
     return mNode != rhs.mNode;
 }
@@ -1020,40 +5297,52 @@ bool CS280::AVLmap<KEY_TYPE, VALUE_TYPE>::AVLmap_iterator::operator!=(const AVLm
  * @brief Equal operator for iterator.
  * @param rhs - check value against
  */
-template< typename KEY_TYPE, typename VALUE_TYPE >
-bool CS280::AVLmap<KEY_TYPE, VALUE_TYPE>::AVLmap_iterator::operator==(const AVLmap_iterator& rhs)
+template< typename KEY_TYPE, typename VALUE_TYPE, typename COMPARE, typename ALLOCATOR, typename TRAITS >
+bool CS280::AVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR,TRAITS>::AVLmap_iterator::operator==(const AVLmap_iterator& rhs) const
 {
     return mNode == rhs.mNode;
 }
 
 
 
-template< typename KEY_TYPE, typename VALUE_TYPE >
-CS280::AVLmap<KEY_TYPE, VALUE_TYPE>::AVLmap_iterator_const::AVLmap_iterator_const(Node* p) : mNode(p)
+template< typename KEY_TYPE, typename VALUE_TYPE, typename COMPARE, typename ALLOCATOR, typename TRAITS >
+CS280::AVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR,TRAITS>::AVLmap_iterator_const::AVLmap_iterator_const(Node* p, AVLmap const* map) : mNode(p), mMap(map)
 {
 
 }
 
-template< typename KEY_TYPE, typename VALUE_TYPE >
-CS280::AVLmap<KEY_TYPE, VALUE_TYPE>::AVLmap_iterator_const::AVLmap_iterator_const(const AVLmap_iterator_const& rhs) : mNode(rhs.mNode)
+template< typename KEY_TYPE, typename VALUE_TYPE, typename COMPARE, typename ALLOCATOR, typename TRAITS >
+CS280::AVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR,TRAITS>::AVLmap_iterator_const::AVLmap_iterator_const(const AVLmap_iterator_const& rhs) : mNode(rhs.mNode), mMap(rhs.mMap)
 {
     
 }
 
-template< typename KEY_TYPE, typename VALUE_TYPE >
-typename CS280::AVLmap<KEY_TYPE, VALUE_TYPE>::AVLmap_iterator_const& CS280::AVLmap<KEY_TYPE, VALUE_TYPE>::AVLmap_iterator_const::operator=(const AVLmap_iterator_const& rhs)
+/**
+ * @brief Converts an iterator to a const iterator
+ * 
+ * @param rhs - iterator to convert
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename COMPARE, typename ALLOCATOR, typename TRAITS >
+CS280::AVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR,TRAITS>::AVLmap_iterator_const::AVLmap_iterator_const(const AVLmap_iterator& rhs) : mNode(rhs.mNode), mMap(rhs.mMap)
+{
+
+}
+
+template< typename KEY_TYPE, typename VALUE_TYPE, typename COMPARE, typename ALLOCATOR, typename TRAITS >
+typename CS280::AVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR,TRAITS>::AVLmap_iterator_const& CS280::AVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR,TRAITS>::AVLmap_iterator_const::operator=(const AVLmap_iterator_const& rhs)
 {
     mNode = rhs.mNode;
+    mMap = rhs.mMap;
     return *this;
 }
 
 /**
  * @brief Prefix increment operator for const iterators
  * 
- * @return CS280::AVLmap<KEY_TYPE, VALUE_TYPE>::AVLmap_iterator_const& 
+ * @return CS280::AVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR,TRAITS>::AVLmap_iterator_const& 
  */
-template< typename KEY_TYPE, typename VALUE_TYPE >
-typename CS280::AVLmap<KEY_TYPE, VALUE_TYPE>::AVLmap_iterator_const& CS280::AVLmap<KEY_TYPE, VALUE_TYPE>::AVLmap_iterator_const::operator++()
+template< typename KEY_TYPE, typename VALUE_TYPE, typename COMPARE, typename ALLOCATOR, typename TRAITS >
+typename CS280::AVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR,TRAITS>::AVLmap_iterator_const& CS280::AVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR,TRAITS>::AVLmap_iterator_const::operator++()
 {
     mNode = mNode->increment();
     return *this;
@@ -1062,36 +5351,69 @@ typename CS280::AVLmap<KEY_TYPE, VALUE_TYPE>::AVLmap_iterator_const& CS280::AVLm
 /**
  * @brief Postfix increment operator for const iterators
  * 
- * @return CS280::AVLmap<KEY_TYPE, VALUE_TYPE>::AVLmap_iterator_const& 
+ * @return CS280::AVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR,TRAITS>::AVLmap_iterator_const& 
  */
-template< typename KEY_TYPE, typename VALUE_TYPE >
-typename CS280::AVLmap<KEY_TYPE, VALUE_TYPE>::AVLmap_iterator_const CS280::AVLmap<KEY_TYPE, VALUE_TYPE>::AVLmap_iterator_const::operator++(int)
+template< typename KEY_TYPE, typename VALUE_TYPE, typename COMPARE, typename ALLOCATOR, typename TRAITS >
+typename CS280::AVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR,TRAITS>::AVLmap_iterator_const CS280::AVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR,TRAITS>::AVLmap_iterator_const::operator++(int)
 {
-    AVLmap_iterator temp = *this;
+    AVLmap_iterator_const temp = *this;
     mNode = mNode->increment();
     return temp;
 }
 
-template< typename KEY_TYPE, typename VALUE_TYPE >
-typename CS280::AVLmap<KEY_TYPE, VALUE_TYPE>::Node const& CS280::AVLmap<KEY_TYPE, VALUE_TYPE>::AVLmap_iterator_const::operator*()
+/**
+ * @brief Prefix decrement operator for const iterators. Decrementing end gives the last node.
+ * 
+ * @return CS280::AVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR,TRAITS>::AVLmap_iterator_const& 
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename COMPARE, typename ALLOCATOR, typename TRAITS >
+typename CS280::AVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR,TRAITS>::AVLmap_iterator_const& CS280::AVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR,TRAITS>::AVLmap_iterator_const::operator--()
+{
+    if(mNode != nullptr)
+    {
+        mNode = mNode->decrement();
+    }
+    else if(mMap != nullptr)
+    {
+        mNode = mMap->mLast;
+    }
+
+    return *this;
+}
+
+/**
+ * @brief Postfix decrement operator for const iterators
+ * 
+ * @return CS280::AVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR,TRAITS>::AVLmap_iterator_const 
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename COMPARE, typename ALLOCATOR, typename TRAITS >
+typename CS280::AVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR,TRAITS>::AVLmap_iterator_const CS280::AVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR,TRAITS>::AVLmap_iterator_const::operator--(int)
+{
+    AVLmap_iterator_const temp = *this;
+    --*this;
+    return temp;
+}
+
+template< typename KEY_TYPE, typename VALUE_TYPE, typename COMPARE, typename ALLOCATOR, typename TRAITS >
+typename CS280::AVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR,TRAITS>::Node const& CS280::AVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR,TRAITS>::AVLmap_iterator_const::operator*() const
 {
     return *mNode;
 }
 
-template< typename KEY_TYPE, typename VALUE_TYPE >
-typename CS280::AVLmap<KEY_TYPE, VALUE_TYPE>::Node const* CS280::AVLmap<KEY_TYPE, VALUE_TYPE>::AVLmap_iterator_const::operator->()
+template< typename KEY_TYPE, typename VALUE_TYPE, typename COMPARE, typename ALLOCATOR, typename TRAITS >
+typename CS280::AVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR,TRAITS>::Node const* CS280::AVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR,TRAITS>::AVLmap_iterator_const::operator->() const
 {
     return mNode;
 }
 
-template< typename KEY_TYPE, typename VALUE_TYPE >
-bool CS280::AVLmap<KEY_TYPE, VALUE_TYPE>::AVLmap_iterator_const::operator!=(const AVLmap_iterator_const& rhs)
+template< typename KEY_TYPE, typename VALUE_TYPE, typename COMPARE, typename ALLOCATOR, typename TRAITS >
+bool CS280::AVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR,TRAITS>::AVLmap_iterator_const::operator!=(const AVLmap_iterator_const& rhs) const
 {
     return mNode != rhs.mNode;
 }
 
-template< typename KEY_TYPE, typename VALUE_TYPE >
-bool CS280::AVLmap<KEY_TYPE, VALUE_TYPE>::AVLmap_iterator_const::operator==(const AVLmap_iterator_const& rhs)
+template< typename KEY_TYPE, typename VALUE_TYPE, typename COMPARE, typename ALLOCATOR, typename TRAITS >
+bool CS280::AVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR,TRAITS>::AVLmap_iterator_const::operator==(const AVLmap_iterator_const& rhs) const
 {
     return mNode == rhs.mNode;
 }
\ No newline at end of file
@@ -10,25 +10,104 @@
 #ifndef AVLMAP_H
 #define AVLMAP_H
 
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <exception>
+#include <functional>
 #include <iostream>
-#include <stack>
+#include <iterator>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "frozen-avl-map.h"
+#include "avl-map-snapshot.h"
 
 namespace CS280 {
 
-    template< typename KEY_TYPE, typename VALUE_TYPE >
+    // How AVLmap rebalances its tree, see AVLmap_traits::balancing
+    enum class AVLmap_balancing { strict, weak, bounded };
+
+    // Compile time options for AVLmap. Derive from this and hide a member to turn a feature on, e.g.
+    //     struct RankedTraits : CS280::AVLmap_traits { static constexpr bool order_statistics = true; };
+    struct AVLmap_traits
+    {
+        // every node keeps the size of its subtree, for nth, rank and count(lo, hi) in O(log n)
+        static constexpr bool order_statistics = false;
+        // every node links to its in-order neighbours and the map caches its first and last node,
+        // so iterator steps are one load and begin() is O(1)
+        static constexpr bool threaded = false;
+        // the map counts the key comparisons and depths of its searches, its rotations and its node
+        // allocations and frees, read with stats(). Lookups count with relaxed atomic adds, so const calls
+        // stay safe from several threads at once, at the price of a shared cache line
+        static constexpr bool statistics = false;
+        // with statistics, stats() also has latency histograms of finds, inserts and erases
+        // (two clock reads per operation)
+        static constexpr bool latency_histograms = false;
+        // after every rebalancing rotation the map checks the rotated nodes' links, key order and cached
+        // heights (O(1) per rotation) and throws std::logic_error if one is wrong, for canary and test builds
+        static constexpr bool debug_checks = false;
+        // strict is AVL: a node's children differ in height by at most one. weak is WAVL: nodes keep ranks
+        // (children one or two ranks down) instead of heights, the same tree as strict until the first erase,
+        // then an erase rotates at most twice and does amortized O(1) rebalancing steps, for a height under 2 log n.
+        // bounded lets the children's heights differ by up to max_imbalance before a rotation, so most updates
+        // settle without one, for a taller tree. It still rebalances eagerly: the update that passes the bound
+        // rotates right away, nothing is left for a later pass
+        static constexpr AVLmap_balancing balancing = AVLmap_balancing::strict;
+        static constexpr int max_imbalance = 2; // only used by bounded balancing
+    };
+
+    // COMPARE orders the keys (lookups with other key types are allowed when it has is_transparent, e.g. std::less<>)
+    // ALLOCATOR only supplies the memory for the node pool's chunks, it is rebound internally
+    template< typename KEY_TYPE, typename VALUE_TYPE, typename COMPARE = std::less<KEY_TYPE>,
+              typename ALLOCATOR = std::allocator< std::pair<const KEY_TYPE, VALUE_TYPE> >, typename TRAITS = AVLmap_traits >
     class AVLmap {
+			static_assert(TRAITS::statistics || !TRAITS::latency_histograms, "latency_histograms needs TRAITS::statistics");
+			static_assert(TRAITS::balancing != AVLmap_balancing::bounded || TRAITS::max_imbalance >= 1, "max_imbalance must be at least 1");
+		private:
+
+			// per node data that is only there when TRAITS turns it on (empty bases take no space)
+			struct SubtreeCount
+			{
+				unsigned int count = 1; // number of nodes in the subtree
+			};
+			struct NoSubtreeCount
+			{
+			};
+			template< typename NODE >
+			struct ThreadLinks
+			{
+				NODE* prev = nullptr; // in-order predecessor
+				NODE* next = nullptr; // in-order successor
+			};
+			struct NoThreadLinks
+			{
+			};
+
 		public:
 
-			class Node 
+			class Node : public std::conditional<TRAITS::order_statistics, SubtreeCount, NoSubtreeCount>::type,
+			             public std::conditional<TRAITS::threaded, ThreadLinks<Node>, NoThreadLinks>::type
             {
 				public:
-					Node( KEY_TYPE k, VALUE_TYPE val, Node* p, int h, int b, Node* l, Node* r);
+					Node( KEY_TYPE const& k, VALUE_TYPE const& val, Node* p, int h, int b, Node* l, Node* r);
+					// builds a leaf in place: the key from k, the value from val...
+					template< typename KEY_ARG, typename... VALUE_ARGS >
+					Node( Node* p, KEY_ARG&& k, VALUE_ARGS&&... val );
 
 					Node(const Node&)               = delete;
 					Node* operator=(const Node&)    = delete;
 					
                     KEY_TYPE const & Key() const;   // return a const reference
                     VALUE_TYPE  &    Value();       // return a reference
+                    VALUE_TYPE const & Value() const; // return a const reference
 
 					Node*  first(); // minimum - follow left as far as possible
 					Node*  last(); // maximum - follow right as far as possible
@@ -38,7 +117,7 @@ namespace CS280 {
 				private:
                     KEY_TYPE    key;
 					VALUE_TYPE  value;
-					int         height,balance; // optional
+					int         height,balance; // subtree height (leaf is 0), its rank with weak balancing, and left height - right height
 					Node        *parent;
 					Node        *left;
 					Node        *right;
@@ -48,59 +127,255 @@ namespace CS280 {
 
         private:
 
+			// Fixed-size slab pool for nodes. Nodes are carved out of contiguous chunks
+			// and freed nodes go on a free list, so the allocator is only hit once per chunk.
+			// A pool with one owner takes no lock. Once a second map or a node handle shares it (see share)
+			// every call locks its mutex, so the sharing maps can be used from different threads,
+			// until the last other owner is gone and the map left calls unshare.
+			class NodePool
+			{
+				public:
+					explicit NodePool(ALLOCATOR const& alloc);
+					~NodePool();
+
+					NodePool(const NodePool&)               = delete;
+					NodePool& operator=(const NodePool&)    = delete;
+
+					template< typename... ARGS >
+					Node*  allocate(ARGS&&... args); // builds a node in a free slot
+					void   deallocate(Node* node); // destroys the node and puts its slot on the free list
+					void   release(); // gives every chunk back, the nodes in them must already be destroyed
+					bool   splice(NodePool& other); // takes over all of other's chunks, false if the allocators differ
+					void   share(); // called before a second owner gets the pool, the calls lock from then on
+					void   unshare(); // called by the only owner left, the calls stop locking
+					bool   shared() const;
+				private:
+					union Slot;
+
+					struct ChunkHeader
+					{
+						Slot*          next; // previously allocated chunk
+						std::size_t    slots; // number of slots in this chunk, header included
+					};
+
+					union Slot
+					{
+						Slot*          next; // next slot on the free list
+						ChunkHeader    chunk; // first slot of every chunk
+						alignas(Node) unsigned char node[sizeof(Node)];
+					};
+
+					typedef typename std::allocator_traits<ALLOCATOR>::template rebind_alloc<Slot> SlotAllocator;
+
+					static constexpr std::size_t FIRST_CHUNK_SLOTS = 8;
+					static constexpr std::size_t MAX_CHUNK_SLOTS = 4096;
+
+					SlotAllocator  alloc;
+					Slot*          chunks = nullptr; // most recent chunk, chained through their headers
+					Slot*          freeList = nullptr;
+					Slot*          freeTail = nullptr; // last slot on the free list, so whole lists can be spliced
+					Slot*          unused = nullptr; // slots of the newest chunk that were never handed out
+					Slot*          unusedEnd = nullptr;
+					std::size_t    nextChunkSlots = FIRST_CHUNK_SLOTS;
+					std::mutex         lock; // taken by every call while the pool is shared
+					std::atomic<bool>  isShared{false};
+
+					Slot*  GetSlot();
+					void   PushFree(Slot* slot);
+			};
+
+			struct AVLmap_iterator_const;
+
 			struct AVLmap_iterator 
             {
 				private:
 					Node* mNode;
+					AVLmap* mMap; // map the node is in, so end can step back to the last node
 				public:
-					AVLmap_iterator(Node* p=nullptr);
+					typedef std::bidirectional_iterator_tag iterator_category;
+					typedef Node                      value_type;
+					typedef std::ptrdiff_t            difference_type;
+					typedef Node*                     pointer;
+					typedef Node&                     reference;
+
+					AVLmap_iterator(Node* p=nullptr, AVLmap* map=nullptr);
                     AVLmap_iterator(const AVLmap_iterator& rhs);
 					AVLmap_iterator& operator=(const AVLmap_iterator& rhs);
 					AVLmap_iterator& operator++();
 					AVLmap_iterator operator++(int);
-                    Node & operator*();
-					Node * operator->();
-					bool operator!=(const AVLmap_iterator& rhs);
-                    bool operator==(const AVLmap_iterator& rhs);
+					AVLmap_iterator& operator--();
+					AVLmap_iterator operator--(int);
+                    Node & operator*() const;
+					Node * operator->() const;
+					bool operator!=(const AVLmap_iterator& rhs) const;
+                    bool operator==(const AVLmap_iterator& rhs) const;
 					friend class AVLmap;
+					friend struct AVLmap_iterator_const;
 			};
 
 			struct AVLmap_iterator_const 
             {
 				private:
 					Node* mNode;
+					AVLmap const* mMap; // map the node is in, so end can step back to the last node
 				public:
-					AVLmap_iterator_const(Node* p=nullptr);
+					typedef std::bidirectional_iterator_tag iterator_category;
+					typedef Node                      value_type;
+					typedef std::ptrdiff_t            difference_type;
+					typedef Node const*               pointer;
+					typedef Node const&               reference;
+
+					AVLmap_iterator_const(Node* p=nullptr, AVLmap const* map=nullptr);
                     AVLmap_iterator_const(const AVLmap_iterator_const& rhs);
+					AVLmap_iterator_const(const AVLmap_iterator& rhs);
 					AVLmap_iterator_const& operator=(const AVLmap_iterator_const& rhs);
 					AVLmap_iterator_const& operator++();
 					AVLmap_iterator_const operator++(int);
-                    Node const& operator*();
-					Node const* operator->();
-					bool operator!=(const AVLmap_iterator_const& rhs);
-					bool operator==(const AVLmap_iterator_const& rhs);
+					AVLmap_iterator_const& operator--();
+					AVLmap_iterator_const operator--(int);
+                    Node const& operator*() const;
+					Node const* operator->() const;
+					bool operator!=(const AVLmap_iterator_const& rhs) const;
+					bool operator==(const AVLmap_iterator_const& rhs) const;
 					friend class AVLmap;
 			};
 
+			// iterable half open range of nodes [first, last), for range-for over a key range
+			template< typename ITERATOR >
+			struct AVLmap_range
+			{
+				private:
+					ITERATOR mFirst;
+					ITERATOR mLast;
+				public:
+					AVLmap_range(ITERATOR first, ITERATOR last);
+					ITERATOR begin() const;
+					ITERATOR end() const;
+					bool empty() const;
+			};
+
+			// owns a node taken out of a map by extract until it is inserted into a map (or destroyed with it).
+			// extract marks the map's pool shared, so a handle can be inserted or dropped on another thread
+			class AVLmap_node_handle
+			{
+				public:
+					AVLmap_node_handle();
+					AVLmap_node_handle(AVLmap_node_handle&& rhs);
+					AVLmap_node_handle& operator=(AVLmap_node_handle&& rhs);
+					~AVLmap_node_handle();
+
+					AVLmap_node_handle(const AVLmap_node_handle&)               = delete;
+					AVLmap_node_handle& operator=(const AVLmap_node_handle&)    = delete;
+
+					bool empty() const;
+					explicit operator bool() const;
+					KEY_TYPE& key() const; // the key can be changed before the node is inserted again
+					VALUE_TYPE& mapped() const;
+				private:
+					Node* mNode = nullptr;
+					std::shared_ptr<NodePool> mPool; // pool the node lives in, kept alive with it
+					friend class AVLmap;
+			};
+
+			// result of inserting a node handle, node holds the node again if its key was already there
+			struct AVLmap_insert_return
+			{
+				AVLmap_iterator     position;
+				bool                inserted;
+				AVLmap_node_handle  node;
+			};
+
+			// counters of a map with TRAITS::statistics on, stats() returns a copy
+			struct AVLmap_stats
+			{
+				enum Operation { FIND, INSERT, ERASE, OPERATIONS };
+				// bucket b counts the operations that took [2^b, 2^(b+1)) nanoseconds, bucket 0 also the faster ones
+				static constexpr std::size_t LATENCY_BUCKETS = 32;
+
+				unsigned long long  comparisons = 0; // key comparisons made by searches
+				unsigned long long  searches = 0; // root to leaf descents
+				unsigned long long  searchDepth = 0; // nodes visited by all descents together
+				unsigned int        maxSearchDepth = 0; // most nodes visited by one descent
+				unsigned int        height = 0; // nodes on the longest root path, as of the stats() call (at most this with weak balancing)
+				unsigned long long  singleRotations = 0;
+				unsigned long long  doubleRotations = 0;
+				unsigned long long  allocations = 0; // nodes built
+				unsigned long long  frees = 0; // nodes destroyed
+				unsigned long long  latency[OPERATIONS][LATENCY_BUCKETS] = {}; // only counted with TRAITS::latency_histograms
+
+				double averageSearchDepth() const;
+			};
+			// the counters const calls write too, relaxed atomics so concurrent reads of one map don't race
+			struct LookupCounters
+			{
+				std::atomic<unsigned long long>  comparisons{0};
+				std::atomic<unsigned long long>  searches{0};
+				std::atomic<unsigned long long>  searchDepth{0};
+				std::atomic<unsigned int>        maxSearchDepth{0};
+				std::atomic<unsigned long long>  latency[AVLmap_stats::OPERATIONS][AVLmap_stats::LATENCY_BUCKETS] = {};
+			};
+			struct NoStats
+			{
+			};
+
+			// times one operation into its latency histogram, does nothing unless TRAITS::latency_histograms is on
+			class LatencyTimer
+			{
+				public:
+					LatencyTimer(AVLmap const* map, typename AVLmap_stats::Operation operation);
+					~LatencyTimer();
+
+					LatencyTimer(const LatencyTimer&)               = delete;
+					LatencyTimer& operator=(const LatencyTimer&)    = delete;
+				private:
+					AVLmap const*                           mMap;
+					typename AVLmap_stats::Operation        mOperation;
+					std::chrono::steady_clock::time_point   mStart;
+			};
+
+            // largest height difference allowed between a node's children before BalanceTree rotates
+            static constexpr int MAX_BALANCE = TRAITS::balancing == AVLmap_balancing::bounded ? TRAITS::max_imbalance : 1;
+            // lookups find_batch walks down the tree side by side
+            static constexpr std::size_t BATCH_LANES = 16;
+            // fewest nodes per thread that is worth starting a thread for
+            static constexpr std::size_t PARALLEL_GRAIN = 16384;
+            // ranges handed out per thread, so threads that finish early take over the rest
+            static constexpr std::size_t RANGES_PER_THREAD = 4;
+
             // AVLmap implementation
 			Node* mRoot = nullptr;
             unsigned int size_ = 0;
-			// end iterators are same for all AVLmaps, thus static
-			// make AVLmap_iterator a friend
-			// to allow AVLmap_iterator to access end iterators 
-			static AVLmap_iterator end_it;
-			static AVLmap_iterator_const const_end_it;
+            COMPARE mCompare;
+            ALLOCATOR mAlloc;
+            // only kept when TRAITS::statistics is on, the counters only updates change
+            // (declared here so that without it the empty member shares padding with size_)
+            typename std::conditional<TRAITS::statistics, AVLmap_stats, NoStats>::type mStats;
+            // the counters lookups change as well, mutable and atomic so const calls can count from several threads
+            mutable typename std::conditional<TRAITS::statistics, LookupCounters, NoStats>::type mLookups;
+            // shared so split maps and node handles can keep their nodes' chunks alive
+            std::shared_ptr<NodePool> mPool;
+            // first node, only kept when TRAITS::threaded is on
+            Node* mFirst = nullptr;
+            // last node, always kept so appends at end() skip the descent
+            Node* mLast = nullptr;
 
 		public:
 			//BIG FOUR
 			AVLmap();
+			explicit AVLmap(ALLOCATOR const& alloc);
+			explicit AVLmap(COMPARE const& comp, ALLOCATOR const& alloc = ALLOCATOR());
 			AVLmap(const AVLmap& rhs);
             AVLmap(AVLmap&& rhs);
+			//linear time build from a range of pairs or nodes sorted by key (the first of equal keys is kept)
+			template< typename ITER >
+			AVLmap(ITER first, ITER last, COMPARE const& comp = COMPARE(), ALLOCATOR const& alloc = ALLOCATOR());
 			AVLmap& operator=(const AVLmap& rhs);
             AVLmap& operator=(AVLmap&& rhs);
 			virtual ~AVLmap();
 
             unsigned int size();
+            COMPARE key_comp() const;
+            ALLOCATOR get_allocator() const;
 
 			//value setter and getter
 			VALUE_TYPE& operator[](KEY_TYPE const& key);
@@ -112,17 +387,158 @@ namespace CS280 {
 			//standard names for iterator types
 			typedef AVLmap_iterator       iterator;
 			typedef AVLmap_iterator_const const_iterator;
+			typedef std::pair<KEY_TYPE, VALUE_TYPE> value_type;
+			typedef AVLmap_range<AVLmap_iterator>       range_type;
+			typedef AVLmap_range<AVLmap_iterator_const> const_range_type;
+			typedef std::reverse_iterator<AVLmap_iterator>       reverse_iterator;
+			typedef std::reverse_iterator<AVLmap_iterator_const> const_reverse_iterator;
+			typedef AVLmap_node_handle   node_type;
+			typedef AVLmap_insert_return insert_return_type;
+			typedef AVLmap_stats         stats_type;
 
 			//AVLmap methods dealing with non-const iterator 
 			AVLmap_iterator begin();
 			AVLmap_iterator end();
+			reverse_iterator rbegin(); // last node, walking towards the first
+			reverse_iterator rend();
 			AVLmap_iterator find(KEY_TYPE const& key);
-			void erase(AVLmap_iterator it);
+			//finds count keys with their descents interleaved, results[i] is the node of keys[i] or end
+			void find_batch(KEY_TYPE const* keys, std::size_t count, AVLmap_iterator* results);
+			AVLmap_iterator erase(AVLmap_iterator it); // returns the node after it
+			AVLmap_iterator erase(AVLmap_iterator first, AVLmap_iterator last); // erases [first, last) in O(k + log n), returns last
+			unsigned int erase(KEY_TYPE const& key); // returns the number of nodes erased
+
+			//lookups with a key of another type, only when COMPARE is transparent
+			template< typename KEY_ARG, typename CMP = COMPARE, typename = typename CMP::is_transparent >
+			AVLmap_iterator find(KEY_ARG const& key);
+			template< typename KEY_ARG, typename CMP = COMPARE, typename = typename CMP::is_transparent,
+			          typename = typename std::enable_if< !std::is_convertible<KEY_ARG const&, AVLmap_iterator>::value >::type >
+			unsigned int erase(KEY_ARG const& key);
+			template< typename KEY_ARG, typename CMP = COMPARE, typename = typename CMP::is_transparent >
+			AVLmap_iterator lower_bound(KEY_ARG const& key);
+			template< typename KEY_ARG, typename CMP = COMPARE, typename = typename CMP::is_transparent >
+			AVLmap_iterator upper_bound(KEY_ARG const& key);
+			template< typename KEY_ARG, typename CMP = COMPARE, typename = typename CMP::is_transparent >
+			std::pair<AVLmap_iterator, AVLmap_iterator> equal_range(KEY_ARG const& key);
+
+			//ordered searches, each is a single descent
+			AVLmap_iterator lower_bound(KEY_TYPE const& key); // first node with key >= given key
+			AVLmap_iterator upper_bound(KEY_TYPE const& key); // first node with key > given key
+			std::pair<AVLmap_iterator, AVLmap_iterator> equal_range(KEY_TYPE const& key);
+			range_type range(KEY_TYPE const& lo, KEY_TYPE const& hi); // nodes with lo <= key < hi
+
+			//order statistics, only available when TRAITS::order_statistics is on
+			AVLmap_iterator nth(unsigned int index); // node at the given 0-based position, end() if out of range
+			//replaces the contents with a range sorted by key, same as the range constructor
+			template< typename ITER >
+			void assign(ITER first, ITER last);
+
+			//whole map operations, the nodes change maps without being copied or reallocated. Maps that end up sharing
+			//a node pool (the halves of a split) can be used from different threads, the pool locks while it is shared
+			//every key of left must be less than the pivot's and every key of right greater for O(log n), otherwise they
+			//are merged: right's duplicate keys are destroyed and the pivot is dropped if its key is there. Both are left empty
+			static AVLmap join(AVLmap&& left, value_type pivot, AVLmap&& right);
+			//moves the keys less than the given key into first and the rest into second, this map is left empty.
+			//O(log n) with TRAITS::order_statistics, otherwise the smaller half is counted, O(min(k, n - k)) for k lower keys
+			std::pair<AVLmap, AVLmap> split(KEY_TYPE const& key);
+			//moves the nodes whose keys are missing here out of other, the rest stay in other. An emptied other
+			//(or the emptied maps of join) gets a pool of its own, so it can be refilled on another thread
+			void merge(AVLmap& other);
+			void merge(AVLmap&& other);
+			//apply a batch of updates given in any order with one merge against the tree instead of k single operations
+			template< typename ITER >
+			unsigned int insert_batch(ITER first, ITER last); // pairs, existing keys are kept, returns the number inserted
+			template< typename ITER >
+			unsigned int erase_batch(ITER first, ITER last); // keys, returns the number of nodes erased
+
+			//insertion in a single descent, returns the node with the key and whether it was inserted
+			std::pair<AVLmap_iterator, bool> insert(value_type const& item);
+			std::pair<AVLmap_iterator, bool> insert(value_type&& item);
+			//first argument builds the key, the rest build the value (node is built before the lookup)
+			template< typename... ARGS >
+			std::pair<AVLmap_iterator, bool> emplace(ARGS&&... args);
+			//value is only built if the key is missing
+			template< typename... ARGS >
+			std::pair<AVLmap_iterator, bool> try_emplace(KEY_TYPE const& key, ARGS&&... args);
+			template< typename... ARGS >
+			std::pair<AVLmap_iterator, bool> try_emplace(KEY_TYPE&& key, ARGS&&... args);
+			//value is assigned if the key exists, built otherwise
+			template< typename M >
+			std::pair<AVLmap_iterator, bool> insert_or_assign(KEY_TYPE const& key, M&& obj);
+			template< typename M >
+			std::pair<AVLmap_iterator, bool> insert_or_assign(KEY_TYPE&& key, M&& obj);
+			//insertion right before hint (end() appends), returns the node with the key
+			//a correct hint links the node without a descent, a wrong one costs a normal insert
+			template< typename... ARGS >
+			AVLmap_iterator emplace_hint(AVLmap_iterator hint, ARGS&&... args);
+			AVLmap_iterator insert(AVLmap_iterator hint, value_type const& item);
+			AVLmap_iterator insert(AVLmap_iterator hint, value_type&& item);
+
+			//node handles move nodes between maps without freeing, allocating or copying them
+			node_type extract(AVLmap_iterator it); // unlinks the node, the handle owns it
+			node_type extract(KEY_TYPE const& key); // empty handle if the key is missing
+			insert_return_type insert(node_type&& node); // links the node unless its key is already there
+			AVLmap_iterator insert(AVLmap_iterator hint, node_type&& node); // the node stays in the handle if its key is there
 
 			//AVLmap methods dealing with const iterator 
 			AVLmap_iterator_const begin() const;
 			AVLmap_iterator_const end() const;
+			const_reverse_iterator rbegin() const;
+			const_reverse_iterator rend() const;
 			AVLmap_iterator_const find(KEY_TYPE const& key) const;
+			void find_batch(KEY_TYPE const* keys, std::size_t count, AVLmap_iterator_const* results) const;
+			void contains_batch(KEY_TYPE const* keys, std::size_t count, bool* results) const;
+			AVLmap_iterator_const lower_bound(KEY_TYPE const& key) const;
+			AVLmap_iterator_const upper_bound(KEY_TYPE const& key) const;
+			std::pair<AVLmap_iterator_const, AVLmap_iterator_const> equal_range(KEY_TYPE const& key) const;
+			const_range_type range(KEY_TYPE const& lo, KEY_TYPE const& hi) const;
+			template< typename KEY_ARG, typename CMP = COMPARE, typename = typename CMP::is_transparent >
+			AVLmap_iterator_const find(KEY_ARG const& key) const;
+			template< typename KEY_ARG, typename CMP = COMPARE, typename = typename CMP::is_transparent >
+			AVLmap_iterator_const lower_bound(KEY_ARG const& key) const;
+			template< typename KEY_ARG, typename CMP = COMPARE, typename = typename CMP::is_transparent >
+			AVLmap_iterator_const upper_bound(KEY_ARG const& key) const;
+			template< typename KEY_ARG, typename CMP = COMPARE, typename = typename CMP::is_transparent >
+			std::pair<AVLmap_iterator_const, AVLmap_iterator_const> equal_range(KEY_ARG const& key) const;
+			AVLmap_iterator_const nth(unsigned int index) const;
+			unsigned int rank(KEY_TYPE const& key) const; // number of keys less than the given key
+			unsigned int count(KEY_TYPE const& lo, KEY_TYPE const& hi) const; // number of keys with lo <= key < hi
+			//read-only copy with flat, branchless lookups for maps that are built once and then only read
+			FrozenAVLmap<KEY_TYPE, VALUE_TYPE, COMPARE> freeze() const;
+			//binary snapshot of the entries in key order, for trivially copyable keys and values
+			//it can be opened in place as a MappedAVLmap (mapped-avl-map.h, POSIX only), or read back with load.
+			//save and load only use file streams. Throws std::runtime_error on failure.
+			void save(std::string const& path) const;
+			//replaces the contents with a snapshot written by save, O(n) like assign
+			void load(std::string const& path);
+			//counters since the map was built or reset_stats was called, only available when TRAITS::statistics is on
+			//a copy or move constructed map starts from zero, assignment keeps the target's counters
+			stats_type stats() const;
+			void reset_stats();
+
+			//parallel traversal: the tree is cut at nodes near the root into ranges of about the same size
+			//(exactly the same with TRAITS::order_statistics) and the ranges are handed out to threads,
+			//the calling thread included. threads = 0 uses every hardware thread, small maps use fewer.
+			//The map must not change meanwhile, an exception from f or fold is rethrown once all threads stop.
+			//calls f(node) for every node, from several threads at once, in key order within a range
+			template< typename FUNC >
+			void parallel_for_each(FUNC f, unsigned int threads = 0);
+			template< typename FUNC >
+			void parallel_for_each(FUNC f, unsigned int threads = 0) const;
+			//folds every range in key order, starting with identity, with result = fold(result, node), then
+			//combines the ranges' results in key order, so combine needs to be associative but not commutative
+			template< typename T, typename FOLD, typename COMBINE = std::plus<> >
+			T parallel_reduce(T identity, FOLD fold, COMBINE combine = COMBINE(), unsigned int threads = 0) const;
+			//parallel bulk updates, threads as above, small inputs are done by the calling thread alone
+			//replaces the contents with the pairs (or nodes) of several unsorted buffers, e.g. one per producer, and keeps
+			//the first of equal keys (buffers in order). Pieces of the buffers are sorted on their own, merged into key
+			//ranges and each range is built into a balanced subtree on its own thread, then the subtrees are joined.
+			template< typename BUFFERS >
+			void parallel_assign(BUFFERS const& buffers, unsigned int threads = 0);
+			//merges a range of maps at once, same result as merging them one by one in order (see merge): every map is
+			//cut at the same keys, the key ranges are united on their own threads and joined back, O(k log n) serial work
+			template< typename MAPS >
+			void parallel_merge(MAPS& maps, unsigned int threads = 0);
 			//do not need this one (why)
 			//AVLmap_iterator_const erase(AVLmap_iterator& it) const;
 
@@ -131,33 +547,113 @@ namespace CS280 {
             char getedgesymbol(const Node* node) const;
 
 			void print(std::ostream& os, bool print_value = false) const;
-			bool sanityCheck();
+			//one O(n) pass without recursion: key order, parent and child links, cached heights, balances
+			//and subtree counts, the in-order links and cached ends, and size
+			bool sanityCheck() const;
 
 			//inner class (AVLmap_iterator) doesn't have any special priveleges
 			//in accessing private data/methods of the outer class (AVLmap)
-			//so need friendship to allow AVLmap_iterator to access private "AVLmap::end_it"
+			//so need friendship to allow AVLmap_iterator to step back from end through private "AVLmap::mRoot"
 			//BTW - same is true for outer class accessing inner class private data
 			friend class AVLmap_iterator;
 			friend class AVLmap_iterator_const;
 		private:
             // ...
 
-            Node* FindNode(Node* tree, KEY_TYPE key);
-
-            Node* InsertItem(Node* tree, Node* parentNode, KEY_TYPE key, VALUE_TYPE value, std::stack<Node*>& nodes);
-
-            void DeleteItem(Node* tree, KEY_TYPE key);
-            void DeleteLeafNode(Node* node);
-
+            template< typename KEY_ARG >
+            Node* FindNode(Node* tree, KEY_ARG const& key) const;
+            void FindNodes(KEY_TYPE const* keys, std::size_t count, Node** found) const;
+            static void PrefetchNode(Node const* node);
+            template< typename LHS, typename RHS >
+            bool Less(LHS const& lhs, RHS const& rhs) const; // mCompare, counted when TRAITS::statistics is on
+            void CountSearch(unsigned int depth) const;
+            void CountRotation(bool isDouble);
+            bool CheckNode(Node const* node) const;
+            void CheckRotation(Node const* top) const;
+            Node* FindSlot(KEY_TYPE const& key, Node*& parent, bool& left) const;
+            Node* HintSlot(Node* hint, KEY_TYPE const& key, Node*& parent, bool& left) const;
+            template< typename KEY_ARG >
+            Node* LowerBound(Node* tree, KEY_ARG const& key) const;
+            template< typename KEY_ARG >
+            Node* UpperBound(KEY_ARG const& key) const;
+            template< typename KEY_ARG >
+            void EqualRange(KEY_ARG const& key, Node*& lower, Node*& upper) const;
+            template< typename KEY_ARG >
+            unsigned int EraseKey(KEY_ARG const& key);
+            void EraseNode(Node* node);
+
+            template< typename KEY_ARG, typename... ARGS >
+            std::pair<AVLmap_iterator, bool> TryEmplace(KEY_ARG&& key, ARGS&&... args);
+            template< typename KEY_ARG, typename M >
+            std::pair<AVLmap_iterator, bool> InsertOrAssign(KEY_ARG&& key, M&& obj);
+            template< typename KEY_ARG, typename... ARGS >
+            AVLmap_iterator TryEmplaceHint(Node* hint, KEY_ARG&& key, ARGS&&... args);
+            node_type ExtractNode(Node* node);
+            Node* AdoptNode(node_type& handle);
+
+            Node* InsertItem(Node* node, Node* parent, bool left);
+
+            Node* UnlinkItem(Node* tree);
+            Node* RelinkPredecessor(Node* tree);
+            Node* UnlinkLeafNode(Node* node);
+
+            template< typename... ARGS >
+            Node* CreateNode(ARGS&&... args);
+            void DestroyNode(Node* node);
             void FreeNode(Node* node);
+            NodePool& Pool();
 
+            template< bool MOVE_VALUES = false >
             void DeepCopyTree(Node* root);
             void ClearTree(Node* node);
-
-            void BalanceTree(std::stack<Node*>& nodes, bool inserting);
-
-            int GetSubtreeHeight(Node* node);
-            int GetSubtreeBalance(Node* node);
+            unsigned int DestroySubtree(Node* node, bool freeSlots);
+            Node* TakeTree(AVLmap& other);
+            void ReturnDuplicates(Node* duplicates, AVLmap& other);
+            void AddStats(AVLmap const& worker);
+            void ThreadTree();
+            void ThreadNode(Node* node);
+            void UnthreadNode(Node* node);
+            void CacheEnds();
+            static void Stitch(Node* before, Node* after);
+            Node* LinkNode(Node* node);
+
+            Node* JoinTrees(Node* left, Node* pivot, Node* right);
+            Node* ConcatTrees(Node* left, Node* right);
+            Node* RemoveFirst(Node*& tree);
+            Node* SplitTree(Node* tree, KEY_TYPE const& key, Node*& lower, Node*& upper);
+            Node* UnionTrees(Node* mine, Node* theirs, Node*& duplicates);
+            Node* DifferenceTrees(Node* tree, KEY_TYPE const* first, KEY_TYPE const* last, unsigned int& erased);
+            static Node* DetachSubtree(Node* node);
+            static Node* FindRoot(Node* node);
+            static unsigned int CountLower(Node* lower, Node* upper, unsigned int total);
+
+            template< typename ITER >
+            void BuildTree(ITER first, ITER last, std::input_iterator_tag);
+            template< typename ITER >
+            void BuildTree(ITER first, ITER last, std::forward_iterator_tag);
+            template< typename ITER >
+            Node* BuildSubtree(ITER& it, ITER last, std::size_t count, Node* parent);
+
+            template< typename FIRST, typename SECOND >
+            static FIRST const& ElementKey(std::pair<FIRST, SECOND> const& item);
+            template< typename FIRST, typename SECOND >
+            static FIRST&& ElementKey(std::pair<FIRST, SECOND>&& item);
+            template< typename NODE >
+            static auto ElementKey(NODE const& node) -> decltype(node.Key());
+            template< typename FIRST, typename SECOND >
+            static SECOND const& ElementValue(std::pair<FIRST, SECOND> const& item);
+            template< typename FIRST, typename SECOND >
+            static SECOND&& ElementValue(std::pair<FIRST, SECOND>&& item);
+            template< typename NODE >
+            static auto ElementValue(NODE const& node) -> decltype(node.Value());
+
+            void BalanceTree(Node* y, bool inserting);
+            void BalanceAfterUnlink(Node* y);
+            void BalanceWeakTree(Node* y);
+            static void UpdateBalance(Node* node);
+
+            static int GetSubtreeHeight(Node* node);
+            static int GetSubtreeBalance(Node* node);
 
             void RotateRight(Node*& node);
             void RotateLeft(Node*& node);
@@ -165,15 +661,25 @@ namespace CS280 {
             void RotateRootLeft();
             void RotateRootRight();
 
-            void UpdateSubtreeHeights(Node* subtree);
+            void UpdateHeight(Node* node);
+
+            static unsigned int GetSubtreeCount(Node* node);
+            void AddToCounts(Node* node, int change);
+            Node* NthNode(unsigned int index) const;
 
-            void GetVisitedNodes(Node* node, std::stack<Node*>& stack);
+            static unsigned int ParallelThreads(unsigned int threads, std::size_t items);
+            void SplitRanges(std::size_t ranges, std::vector<Node*>& bounds) const;
+            static void CollectLevel(Node* node, unsigned int depth, std::vector<Node*>& nodes);
+            template< typename TASK >
+            static void RunTasks(std::size_t tasks, unsigned int threads, TASK& task);
+            template< bool MOVE_VALUES = false >
+            Node* CloneNode(Node* source, Node* parent);
             
 	};
 
 	//notice that it doesn't need to be friend
-    template< typename KEY_TYPE, typename VALUE_TYPE >
-	std::ostream& operator<<(std::ostream& os, AVLmap<KEY_TYPE, VALUE_TYPE> const& map);
+    template< typename KEY_TYPE, typename VALUE_TYPE, typename COMPARE, typename ALLOCATOR, typename TRAITS >
+	std::ostream& operator<<(std::ostream& os, AVLmap<KEY_TYPE, VALUE_TYPE, COMPARE, ALLOCATOR, TRAITS> const& map);
 }
 
 #include "avl-map.cpp"
@@ -0,0 +1,649 @@
+/**
+ * @file avl-map-bench.cpp
+ * @brief Benchmarks AVLmap against std::map and a sorted std::vector. Every operation (insert, find, erase,
+ *        iteration, copy and operator[]) runs on every key pattern (sequential, random, Zipfian and adversarial)
+ *        at every size, and each row reports the time per operation, the allocations per operation and the
+ *        bytes each entry of the container takes. Allocations are counted by replacing the global operator new.
+ *
+ *        Usage: avl-map-bench [--quick] [--csv] [--sizes=N,...] [--ops=NAME,...] [--patterns=NAME,...]
+ *               [--containers=NAME,...]
+ */
+
+#include "avl-map.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <new>
+#include <optional>
+#include <random>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace {
+
+    // allocation counters, updated by the replaced operator new and delete below
+    struct AllocationCounters
+    {
+        std::size_t allocations = 0;
+        std::size_t liveBytes = 0;
+    };
+
+    AllocationCounters gCounters;
+
+    // every block is prefixed with its size so delete can take it off the live bytes
+    constexpr std::size_t BLOCK_HEADER = alignof(std::max_align_t);
+
+    void* Allocate(std::size_t size, std::size_t align)
+    {
+        std::size_t header = std::max(BLOCK_HEADER, align);
+        void* block = nullptr;
+
+        if(align <= alignof(std::max_align_t))
+            block = std::malloc(header + size);
+        else
+            block = std::aligned_alloc(align, ((header + size + align - 1) / align) * align);
+
+        if(block == nullptr)
+            throw std::bad_alloc();
+
+        ++gCounters.allocations;
+        gCounters.liveBytes += size;
+
+        char* user = static_cast<char*>(block) + header;
+        std::memcpy(user - sizeof(std::size_t) * 2, &size, sizeof(std::size_t));
+        std::memcpy(user - sizeof(std::size_t), &header, sizeof(std::size_t));
+
+        return user;
+    }
+
+    void Deallocate(void* pointer)
+    {
+        if(pointer == nullptr)
+            return;
+
+        char* user = static_cast<char*>(pointer);
+        std::size_t size;
+        std::size_t header;
+        std::memcpy(&size, user - sizeof(std::size_t) * 2, sizeof(std::size_t));
+        std::memcpy(&header, user - sizeof(std::size_t), sizeof(std::size_t));
+
+        gCounters.liveBytes -= size;
+        std::free(user - header);
+    }
+}
+
+void* operator new(std::size_t size) { return Allocate(size, alignof(std::max_align_t)); }
+void* operator new[](std::size_t size) { return Allocate(size, alignof(std::max_align_t)); }
+void* operator new(std::size_t size, std::align_val_t align) { return Allocate(size, static_cast<std::size_t>(align)); }
+void* operator new[](std::size_t size, std::align_val_t align) { return Allocate(size, static_cast<std::size_t>(align)); }
+void operator delete(void* pointer) noexcept { Deallocate(pointer); }
+void operator delete[](void* pointer) noexcept { Deallocate(pointer); }
+void operator delete(void* pointer, std::size_t) noexcept { Deallocate(pointer); }
+void operator delete[](void* pointer, std::size_t) noexcept { Deallocate(pointer); }
+void operator delete(void* pointer, std::align_val_t) noexcept { Deallocate(pointer); }
+void operator delete[](void* pointer, std::align_val_t) noexcept { Deallocate(pointer); }
+void operator delete(void* pointer, std::size_t, std::align_val_t) noexcept { Deallocate(pointer); }
+void operator delete[](void* pointer, std::size_t, std::align_val_t) noexcept { Deallocate(pointer); }
+
+namespace {
+
+    typedef std::uint64_t Key;
+    typedef std::uint64_t Value;
+
+    // results are folded into this so the compiler can't drop the work being timed
+    volatile Value gSink;
+
+    // sorted vectors insert and erase in O(n), so those runs stop at this size
+    constexpr std::size_t VECTOR_EDIT_LIMIT = 200000;
+    // small sizes are repeated until one measurement covers about this many operations
+    constexpr std::size_t OPERATIONS_PER_MEASUREMENT = 2000000;
+    // the same for sorted vector inserts and erases, each of which moves half the vector on average
+    constexpr std::size_t LINEAR_OPERATIONS_PER_MEASUREMENT = 20000;
+    constexpr double ZIPF_THETA = 0.99;
+
+    // AVLmap, std::map and the sorted vector behind one interface
+    struct AVLmapAdapter
+    {
+        typedef CS280::AVLmap<Key, Value> Container;
+        static constexpr char const* NAME = "AVLmap";
+        static constexpr bool EDITS_IN_LINEAR_TIME = false;
+
+        static void Insert(Container& map, Key key, Value value) { map.insert(Container::value_type(key, value)); }
+        static void Erase(Container& map, Key key) { map.erase(key); }
+        static Value& Index(Container& map, Key key) { return map[key]; }
+        static Value Find(Container& map, Key key)
+        {
+            auto it = map.find(key);
+            return it != map.end() ? it->Value() : 0;
+        }
+        static Value Iterate(Container& map)
+        {
+            Value sum = 0;
+
+            for(auto it = map.begin(); it != map.end(); ++it)
+                sum += it->Value();
+
+            return sum;
+        }
+        static std::size_t Size(Container& map) { return map.size(); }
+    };
+
+    struct StdMapAdapter
+    {
+        typedef std::map<Key, Value> Container;
+        static constexpr char const* NAME = "std::map";
+        static constexpr bool EDITS_IN_LINEAR_TIME = false;
+
+        static void Insert(Container& map, Key key, Value value) { map.insert(Container::value_type(key, value)); }
+        static void Erase(Container& map, Key key) { map.erase(key); }
+        static Value& Index(Container& map, Key key) { return map[key]; }
+        static Value Find(Container& map, Key key)
+        {
+            auto it = map.find(key);
+            return it != map.end() ? it->second : 0;
+        }
+        static Value Iterate(Container& map)
+        {
+            Value sum = 0;
+
+            for(auto const& item : map)
+                sum += item.second;
+
+            return sum;
+        }
+        static std::size_t Size(Container& map) { return map.size(); }
+    };
+
+    struct SortedVectorAdapter
+    {
+        typedef std::vector<std::pair<Key, Value>> Container;
+        static constexpr char const* NAME = "sorted vector";
+        static constexpr bool EDITS_IN_LINEAR_TIME = true;
+
+        static Container::iterator Bound(Container& items, Key key)
+        {
+            return std::lower_bound(items.begin(), items.end(), key, [](std::pair<Key, Value> const& item, Key k)
+            {
+                return item.first < k;
+            });
+        }
+        static void Insert(Container& items, Key key, Value value)
+        {
+            auto it = Bound(items, key);
+
+            if(it == items.end() || it->first != key)
+                items.emplace(it, key, value);
+        }
+        static void Erase(Container& items, Key key)
+        {
+            auto it = Bound(items, key);
+
+            if(it != items.end() && it->first == key)
+                items.erase(it);
+        }
+        static Value& Index(Container& items, Key key)
+        {
+            auto it = Bound(items, key);
+
+            if(it == items.end() || it->first != key)
+                it = items.emplace(it, key, Value());
+
+            return it->second;
+        }
+        static Value Find(Container& items, Key key)
+        {
+            auto it = Bound(items, key);
+            return it != items.end() && it->first == key ? it->second : 0;
+        }
+        static Value Iterate(Container& items)
+        {
+            Value sum = 0;
+
+            for(auto const& item : items)
+                sum += item.second;
+
+            return sum;
+        }
+        static std::size_t Size(Container& items) { return items.size(); }
+    };
+
+    enum class Operation { INSERT, FIND, ERASE, ITERATE, COPY, INDEX };
+    enum class Pattern { SEQUENTIAL, RANDOM, ZIPFIAN, ADVERSARIAL };
+
+    char const* const OPERATION_NAMES[] = { "insert", "find", "erase", "iterate", "copy", "operator[]" };
+    char const* const PATTERN_NAMES[] = { "sequential", "random", "zipfian", "adversarial" };
+    char const* const CONTAINER_NAMES[] = { "avl", "map", "vector" };
+
+    struct Options
+    {
+        std::vector<std::size_t> sizes = { 1000, 10000, 100000, 1000000, 10000000, 50000000 };
+        std::vector<bool> operations = std::vector<bool>(6, true);
+        std::vector<bool> patterns = std::vector<bool>(4, true);
+        std::vector<bool> containers = std::vector<bool>(3, true);
+        bool csv = false;
+    };
+
+    struct Result
+    {
+        double nsPerOperation = 0;
+        double allocationsPerOperation = 0;
+        double bytesPerEntry = 0;
+        bool skipped = false;
+    };
+
+    /**
+     * @brief Draws ranks 0..n-1 with probability proportional to 1/(rank+1)^theta, in O(1) per draw
+     *        (Gray et al., "Quickly generating billion-record synthetic databases"). Building it is O(n).
+     */
+    class ZipfGenerator
+    {
+        public:
+            ZipfGenerator(std::size_t n, double theta) : mN(n), mTheta(theta)
+            {
+                double zeta2 = 0;
+
+                for(std::size_t i = 1; i <= n; ++i)
+                {
+                    mZetaN += 1.0 / std::pow(static_cast<double>(i), theta);
+
+                    if(i == 2)
+                        zeta2 = mZetaN;
+                }
+
+                mAlpha = 1.0 / (1.0 - theta);
+                mEta = (1.0 - std::pow(2.0 / static_cast<double>(n), 1.0 - theta)) / (1.0 - zeta2 / mZetaN);
+            }
+
+            template< typename RNG >
+            std::size_t operator()(RNG& rng)
+            {
+                double u = std::uniform_real_distribution<double>(0.0, 1.0)(rng);
+                double uz = u * mZetaN;
+
+                if(uz < 1.0)
+                    return 0;
+
+                if(uz < 1.0 + std::pow(0.5, mTheta))
+                    return std::min<std::size_t>(1, mN - 1);
+
+                std::size_t rank = static_cast<std::size_t>(static_cast<double>(mN) * std::pow(mEta * u - mEta + 1.0, mAlpha));
+                return std::min(rank, mN - 1);
+            }
+        private:
+            std::size_t mN;
+            double      mTheta;
+            double      mZetaN = 0;
+            double      mAlpha = 0;
+            double      mEta = 0;
+    };
+
+    /**
+     * @brief Returns the keys an operation uses, in the order it uses them. The map always holds the keys 0..n-1.
+     *        Sequential goes up in order, random is a shuffle, Zipfian draws with repeats so a few hot keys
+     *        (scattered over the key range) take most of the operations, and adversarial alternates between
+     *        the two ends of the range, so every insert lands next to the previous one on the other side of
+     *        the tree and the balancing works on both outer paths.
+     */
+    std::vector<Key> MakeKeys(Pattern pattern, std::size_t n)
+    {
+        std::vector<Key> keys(n);
+        std::mt19937_64 rng(n * 31 + static_cast<std::size_t>(pattern));
+
+        switch(pattern)
+        {
+            case Pattern::SEQUENTIAL:
+                for(std::size_t i = 0; i < n; ++i)
+                    keys[i] = i;
+                break;
+
+            case Pattern::RANDOM:
+                for(std::size_t i = 0; i < n; ++i)
+                    keys[i] = i;
+                std::shuffle(keys.begin(), keys.end(), rng);
+                break;
+
+            case Pattern::ZIPFIAN:
+            {
+                std::vector<Key> hot(n);
+
+                for(std::size_t i = 0; i < n; ++i)
+                    hot[i] = i;
+                std::shuffle(hot.begin(), hot.end(), rng);
+
+                ZipfGenerator zipf(n, ZIPF_THETA);
+
+                for(std::size_t i = 0; i < n; ++i)
+                    keys[i] = hot[zipf(rng)];
+                break;
+            }
+
+            case Pattern::ADVERSARIAL:
+                for(std::size_t i = 0; i < n; ++i)
+                    keys[i] = (i % 2 == 0) ? i / 2 : n - 1 - i / 2;
+                break;
+        }
+
+        return keys;
+    }
+
+    /**
+     * @brief Builds a container holding the keys 0..n-1, inserting the keys of order first and the rest in random order.
+     *        The insertion order decides where the nodes land in memory, which is what iterations and copies pay for.
+     */
+    template< typename ADAPTER >
+    void Fill(typename ADAPTER::Container& container, std::vector<Key> const& order, std::vector<Key> const& randomKeys)
+    {
+        if constexpr(ADAPTER::EDITS_IN_LINEAR_TIME)
+        {
+            container.reserve(randomKeys.size());
+
+            for(std::size_t i = 0; i < randomKeys.size(); ++i)
+                container.emplace_back(i, i);
+        }
+        else
+        {
+            for(Key key : order)
+                ADAPTER::Insert(container, key, key);
+
+            // Zipfian keys repeat, so some keys are still missing
+            if(ADAPTER::Size(container) < randomKeys.size())
+            {
+                for(Key key : randomKeys)
+                    ADAPTER::Insert(container, key, key);
+            }
+        }
+    }
+
+    /**
+     * @brief Runs an operation over every key of the pattern, repeating small sizes so the run is long enough to time.
+     *        Containers are built before the clock starts and destroyed after it stops.
+     */
+    template< typename ADAPTER >
+    Result Measure(Operation operation, std::vector<Key> const& keys, std::vector<Key> const& randomKeys, double bytesPerEntry)
+    {
+        typedef typename ADAPTER::Container Container;
+
+        std::size_t n = keys.size();
+        Result result;
+        result.bytesPerEntry = bytesPerEntry;
+
+        // operator[] only finds here, every key is already in the container
+        bool edits = operation == Operation::INSERT || operation == Operation::ERASE;
+
+        if(ADAPTER::EDITS_IN_LINEAR_TIME && edits && n > VECTOR_EDIT_LIMIT)
+        {
+            result.skipped = true;
+            return result;
+        }
+
+        std::size_t budget = (ADAPTER::EDITS_IN_LINEAR_TIME && edits) ? LINEAR_OPERATIONS_PER_MEASUREMENT : OPERATIONS_PER_MEASUREMENT;
+        std::size_t repeats = std::max<std::size_t>(1, budget / n);
+        double nanoseconds = 0;
+        std::size_t allocations = 0;
+        std::size_t operations = 0;
+        Value sum = 0;
+
+        for(std::size_t repeat = 0; repeat < repeats; ++repeat)
+        {
+            Container container;
+            std::optional<Container> copy; // destroyed after the clock stops
+
+            // A map that grew over time for the lookups, one built in the pattern's order for the full walks
+            if(operation == Operation::ITERATE || operation == Operation::COPY)
+                Fill<ADAPTER>(container, keys, randomKeys);
+            else if(operation != Operation::INSERT)
+                Fill<ADAPTER>(container, randomKeys, randomKeys);
+
+            std::size_t allocationsBefore = gCounters.allocations;
+            auto start = std::chrono::steady_clock::now();
+
+            switch(operation)
+            {
+                case Operation::INSERT:
+                    for(Key key : keys)
+                        ADAPTER::Insert(container, key, key);
+                    operations += n;
+                    break;
+
+                case Operation::FIND:
+                    for(Key key : keys)
+                        sum += ADAPTER::Find(container, key);
+                    operations += n;
+                    break;
+
+                case Operation::ERASE:
+                    for(Key key : keys)
+                        ADAPTER::Erase(container, key);
+                    operations += n;
+                    break;
+
+                case Operation::ITERATE:
+                    sum += ADAPTER::Iterate(container);
+                    operations += n;
+                    break;
+
+                case Operation::COPY:
+                    copy.emplace(container);
+                    sum += ADAPTER::Size(*copy);
+                    operations += n;
+                    break;
+
+                case Operation::INDEX:
+                    for(Key key : keys)
+                        ++ADAPTER::Index(container, key);
+                    operations += n;
+                    break;
+            }
+
+            auto stop = std::chrono::steady_clock::now();
+            allocations += gCounters.allocations - allocationsBefore;
+            nanoseconds += std::chrono::duration<double, std::nano>(stop - start).count();
+        }
+
+        gSink = gSink + sum;
+
+        result.nsPerOperation = nanoseconds / static_cast<double>(operations);
+        result.allocationsPerOperation = static_cast<double>(allocations) / static_cast<double>(operations);
+
+        return result;
+    }
+
+    /**
+     * @brief Returns the heap bytes per entry of a container holding the keys 0..n-1
+     */
+    template< typename ADAPTER >
+    double BytesPerEntry(std::vector<Key> const& randomKeys)
+    {
+        std::size_t before = gCounters.liveBytes;
+        typename ADAPTER::Container container;
+
+        Fill<ADAPTER>(container, randomKeys, randomKeys);
+
+        return static_cast<double>(gCounters.liveBytes - before) / static_cast<double>(randomKeys.size());
+    }
+
+    void PrintHeader(Options const& options)
+    {
+        if(options.csv)
+            std::printf("operation,pattern,size,container,ns_per_op,allocs_per_op,bytes_per_entry\n");
+        else
+            std::printf("%-11s %-12s %10s  %-14s %12s %10s %12s\n", "operation", "pattern", "size", "container", "ns/op", "allocs/op", "bytes/entry");
+    }
+
+    void PrintRow(Options const& options, Operation operation, Pattern pattern, std::size_t n, char const* container, Result const& result)
+    {
+        char const* op = OPERATION_NAMES[static_cast<int>(operation)];
+        char const* pat = PATTERN_NAMES[static_cast<int>(pattern)];
+
+        if(options.csv)
+        {
+            if(result.skipped)
+                std::printf("%s,%s,%zu,%s,,,%.1f\n", op, pat, n, container, result.bytesPerEntry);
+            else
+                std::printf("%s,%s,%zu,%s,%.2f,%.3f,%.1f\n", op, pat, n, container, result.nsPerOperation, result.allocationsPerOperation, result.bytesPerEntry);
+        }
+        else
+        {
+            if(result.skipped)
+                std::printf("%-11s %-12s %10zu  %-14s %12s %10s %12.1f\n", op, pat, n, container, "skipped", "-", result.bytesPerEntry);
+            else
+                std::printf("%-11s %-12s %10zu  %-14s %12.1f %10.3f %12.1f\n", op, pat, n, container, result.nsPerOperation, result.allocationsPerOperation, result.bytesPerEntry);
+        }
+
+        std::fflush(stdout);
+    }
+
+    /**
+     * @brief Parses a comma separated list of names into flags, one per entry of names
+     */
+    bool ParseNames(std::string const& list, char const* const* names, std::size_t count, std::vector<bool>& enabled)
+    {
+        enabled.assign(count, false);
+        std::size_t start = 0;
+
+        while(start <= list.size())
+        {
+            std::size_t end = list.find(',', start);
+            std::string name = list.substr(start, end == std::string::npos ? std::string::npos : end - start);
+            std::size_t i = 0;
+
+            while(i < count && name != names[i])
+                ++i;
+
+            if(i == count)
+            {
+                std::fprintf(stderr, "unknown name '%s'\n", name.c_str());
+                return false;
+            }
+
+            enabled[i] = true;
+
+            if(end == std::string::npos)
+                break;
+
+            start = end + 1;
+        }
+
+        return true;
+    }
+
+    bool ParseOptions(int argc, char** argv, Options& options)
+    {
+        for(int i = 1; i < argc; ++i)
+        {
+            std::string arg = argv[i];
+
+            if(arg == "--quick")
+            {
+                options.sizes = { 1000, 10000, 100000 };
+            }
+            else if(arg == "--csv")
+            {
+                options.csv = true;
+            }
+            else if(arg.compare(0, 8, "--sizes=") == 0)
+            {
+                options.sizes.clear();
+                std::string list = arg.substr(8);
+
+                for(std::size_t start = 0; start < list.size(); )
+                {
+                    std::size_t end = list.find(',', start);
+                    std::size_t n = std::strtoull(list.substr(start, end - start).c_str(), nullptr, 10);
+
+                    if(n == 0)
+                    {
+                        std::fprintf(stderr, "bad size in '%s'\n", arg.c_str());
+                        return false;
+                    }
+
+                    options.sizes.push_back(n);
+                    start = (end == std::string::npos) ? list.size() : end + 1;
+                }
+            }
+            else if(arg.compare(0, 6, "--ops=") == 0)
+            {
+                if(!ParseNames(arg.substr(6), OPERATION_NAMES, 6, options.operations))
+                    return false;
+            }
+            else if(arg.compare(0, 11, "--patterns=") == 0)
+            {
+                if(!ParseNames(arg.substr(11), PATTERN_NAMES, 4, options.patterns))
+                    return false;
+            }
+            else if(arg.compare(0, 13, "--containers=") == 0)
+            {
+                if(!ParseNames(arg.substr(13), CONTAINER_NAMES, 3, options.containers))
+                    return false;
+            }
+            else
+            {
+                std::fprintf(stderr, "usage: %s [--quick] [--csv] [--sizes=N,...] [--ops=insert,find,erase,iterate,copy,operator[]]\n"
+                                     "       [--patterns=sequential,random,zipfian,adversarial] [--containers=avl,map,vector]\n", argv[0]);
+                return false;
+            }
+        }
+
+        return !options.sizes.empty();
+    }
+
+    template< typename ADAPTER >
+    void RunContainer(Options const& options, Operation operation, Pattern pattern, std::vector<Key> const& keys,
+                      std::vector<Key> const& randomKeys, double bytesPerEntry)
+    {
+        Result result = Measure<ADAPTER>(operation, keys, randomKeys, bytesPerEntry);
+        PrintRow(options, operation, pattern, keys.size(), ADAPTER::NAME, result);
+    }
+}
+
+int main(int argc, char** argv)
+{
+    Options options;
+
+    if(!ParseOptions(argc, argv, options))
+        return 1;
+
+    PrintHeader(options);
+
+    for(std::size_t n : options.sizes)
+    {
+        std::vector<Key> randomKeys = MakeKeys(Pattern::RANDOM, n);
+
+        double avlBytes = options.containers[0] ? BytesPerEntry<AVLmapAdapter>(randomKeys) : 0;
+        double mapBytes = options.containers[1] ? BytesPerEntry<StdMapAdapter>(randomKeys) : 0;
+        double vectorBytes = options.containers[2] ? BytesPerEntry<SortedVectorAdapter>(randomKeys) : 0;
+
+        for(int op = 0; op < 6; ++op)
+        {
+            if(!options.operations[op])
+                continue;
+
+            Operation operation = static_cast<Operation>(op);
+
+            for(int pat = 0; pat < 4; ++pat)
+            {
+                if(!options.patterns[pat])
+                    continue;
+
+                Pattern pattern = static_cast<Pattern>(pat);
+                std::vector<Key> keys = MakeKeys(pattern, n);
+
+                if(options.containers[0])
+                    RunContainer<AVLmapAdapter>(options, operation, pattern, keys, randomKeys, avlBytes);
+                if(options.containers[1])
+                    RunContainer<StdMapAdapter>(options, operation, pattern, keys, randomKeys, mapBytes);
+                if(options.containers[2])
+                    RunContainer<SortedVectorAdapter>(options, operation, pattern, keys, randomKeys, vectorBytes);
+            }
+        }
+    }
+
+    return 0;
+}
@@ -0,0 +1,1551 @@
+/**
+ * @file compact-avl-map.cpp
+ * @brief This implements the compact AVL map: the same balanced search tree as AVLmap, with the nodes kept
+ *        in a contiguous array, 32 bit links and a 2 bit balance factor instead of a cached height.
+ *        Rebalancing works on balance factors alone, with the classic AVL update rules.
+ */
+
+#include "compact-avl-map.h"
+
+/**
+ * @brief Construct the map, it starts without a node array
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename COMPARE, typename ALLOCATOR >
+CS280::CompactAVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR>::CompactAVLmap()
+{
+
+}
+
+/**
+ * @brief Construct the map with the allocator that supplies the node array
+ *
+ * @param alloc - allocator for the node array
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename COMPARE, typename ALLOCATOR >
+CS280::CompactAVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR>::CompactAVLmap(ALLOCATOR const& alloc) : mAlloc(alloc)
+{
+
+}
+
+/**
+ * @brief Construct the map that orders its keys with the given comparator
+ *
+ * @param comp - key comparator
+ * @param alloc - allocator for the node array
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename COMPARE, typename ALLOCATOR >
+CS280::CompactAVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR>::CompactAVLmap(COMPARE const& comp, ALLOCATOR const& alloc) : mCompare(comp), mAlloc(alloc)
+{
+
+}
+
+/**
+ * @brief Copy constructor. The node array is copied slot for slot, so the copy has the same shape
+ *        and no comparison or rotation is done.
+ *
+ * @param rhs - map to copy
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename COMPARE, typename ALLOCATOR >
+CS280::CompactAVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR>::CompactAVLmap(const CompactAVLmap& rhs)
+    : mCompare(rhs.mCompare), mAlloc(std::allocator_traits<NodeAllocator>::select_on_container_copy_construction(rhs.mAlloc))
+{
+    CopyNodes(rhs);
+}
+
+/**
+ * @brief Move constructor. Takes rhs's node array.
+ *
+ * @param rhs - map to move
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename COMPARE, typename ALLOCATOR >
+CS280::CompactAVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR>::CompactAVLmap(CompactAVLmap&& rhs)
+    : mNodes(rhs.mNodes), mCapacity(rhs.mCapacity), mUsed(rhs.mUsed), mFree(rhs.mFree), mRoot(rhs.mRoot), size_(rhs.size_),
+      mCompare(rhs.mCompare), mAlloc(rhs.mAlloc)
+{
+    rhs.mNodes = nullptr;
+    rhs.mCapacity = 0;
+    rhs.mUsed = 0;
+    rhs.mFree = NIL;
+    rhs.mRoot = NIL;
+    rhs.size_ = 0;
+}
+
+/**
+ * @brief Assignment operator. Copies rhs first, so this map is unchanged if a copy throws.
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename COMPARE, typename ALLOCATOR >
+typename CS280::CompactAVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR>::CompactAVLmap& CS280::CompactAVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR>::operator=(const CompactAVLmap& rhs)
+{
+    if(this != &rhs)
+    {
+        CompactAVLmap copy(rhs);
+        *this = std::move(copy);
+    }
+
+    return *this;
+}
+
+/**
+ * @brief Move assignment operator. Swaps the node arrays with rhs.
+ *
+ * @param rhs - map to move into this map
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename COMPARE, typename ALLOCATOR >
+typename CS280::CompactAVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR>::CompactAVLmap& CS280::CompactAVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR>::operator=(CompactAVLmap&& rhs)
+{
+    std::swap(mNodes, rhs.mNodes);
+    std::swap(mCapacity, rhs.mCapacity);
+    std::swap(mUsed, rhs.mUsed);
+    std::swap(mFree, rhs.mFree);
+    std::swap(mRoot, rhs.mRoot);
+    std::swap(size_, rhs.size_);
+    std::swap(mCompare, rhs.mCompare);
+    std::swap(mAlloc, rhs.mAlloc);
+
+    return *this;
+}
+
+/**
+ * @brief Destructor. Destroys the nodes and gives the array back.
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename COMPARE, typename ALLOCATOR >
+CS280::CompactAVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR>::~CompactAVLmap()
+{
+    if(mNodes != nullptr)
+    {
+        DestroyNodes(mNodes, mUsed);
+        std::allocator_traits<NodeAllocator>::deallocate(mAlloc, mNodes, mCapacity);
+    }
+}
+
+/**
+ * @brief Returns the size (number of nodes) in the map
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename COMPARE, typename ALLOCATOR >
+unsigned int CS280::CompactAVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR>::size()
+{
+    return size_;
+}
+
+/**
+ * @brief Returns the comparator that orders the keys
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename COMPARE, typename ALLOCATOR >
+COMPARE CS280::CompactAVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR>::key_comp() const
+{
+    return mCompare;
+}
+
+/**
+ * @brief Returns the allocator the node array comes from
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename COMPARE, typename ALLOCATOR >
+ALLOCATOR CS280::CompactAVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR>::get_allocator() const
+{
+    return ALLOCATOR(mAlloc);
+}
+
+/**
+ * @brief Makes room for at least count nodes, so the next inserts don't grow (and move) the node array.
+ *
+ * @param count - number of nodes to make room for
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename COMPARE, typename ALLOCATOR >
+void CS280::CompactAVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR>::reserve(unsigned int count)
+{
+    if(count >= NIL)
+        throw std::length_error("CompactAVLmap can't hold that many nodes");
+
+    if(count > mCapacity)
+        Reallocate(static_cast<std::uint32_t>(count));
+}
+
+/**
+ * @brief Erases every node. The node array is kept for the next inserts.
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename COMPARE, typename ALLOCATOR >
+void CS280::CompactAVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR>::clear()
+{
+    if(mNodes != nullptr)
+        DestroyNodes(mNodes, mUsed);
+
+    mUsed = 0;
+    mFree = NIL;
+    mRoot = NIL;
+    size_ = 0;
+}
+
+/**
+ * @brief Finds the value of the key, inserting a default value if the key is missing
+ *
+ * @param key - key to find
+ * @return the value of the key
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename COMPARE, typename ALLOCATOR >
+VALUE_TYPE& CS280::CompactAVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR>::operator[](KEY_TYPE const& key)
+{
+    // Find the node or insert a default value in the same descent
+    return TryEmplace(key).first->Value();
+}
+
+/**
+ * @brief Returns the begin iterator of the map
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename COMPARE, typename ALLOCATOR >
+typename CS280::CompactAVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR>::CompactAVLmap_iterator CS280::CompactAVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR>::begin()
+{
+    return CompactAVLmap_iterator(this, First(mRoot));
+}
+
+/**
+ * @brief Returns the end iterator
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename COMPARE, typename ALLOCATOR >
+typename CS280::CompactAVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR>::CompactAVLmap_iterator CS280::CompactAVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR>::end()
+{
+    return CompactAVLmap_iterator(this, NIL);
+}
+
+/**
+ * @brief Returns the reverse begin iterator (the last node)
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename COMPARE, typename ALLOCATOR >
+typename CS280::CompactAVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR>::reverse_iterator CS280::CompactAVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR>::rbegin()
+{
+    return reverse_iterator(end());
+}
+
+/**
+ * @brief Returns the reverse end iterator (before the first node)
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename COMPARE, typename ALLOCATOR >
+typename CS280::CompactAVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR>::reverse_iterator CS280::CompactAVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR>::rend()
+{
+    return reverse_iterator(begin());
+}
+
+/**
+ * @brief Finds the node of given key and returns as an iterator
+ *
+ * @param key - key to find
+ * @return the node, or end if the key is missing
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename COMPARE, typename ALLOCATOR >
+typename CS280::CompactAVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR>::CompactAVLmap_iterator CS280::CompactAVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR>::find(KEY_TYPE const& key)
+{
+    return CompactAVLmap_iterator(this, FindNode(key));
+}
+
+/**
+ * @brief Erase a node from the map based off the given iterator. Other iterators stay valid,
+ *        so the following node is found before the erase and stays where it is.
+ *
+ * @param it - node to erase
+ * @return iterator to the node after the erased one, or end
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename COMPARE, typename ALLOCATOR >
+typename CS280::CompactAVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR>::CompactAVLmap_iterator CS280::CompactAVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR>::erase(CompactAVLmap_iterator it)
+{
+    if(it.mIndex == NIL)
+        return end();
+
+    std::uint32_t next = Next(it.mIndex);
+
+    DeleteItem(it.mIndex);
+    return CompactAVLmap_iterator(this, next);
+}
+
+/**
+ * @brief Erases the node with the given key, if there is one.
+ *
+ * @param key - key to erase
+ * @return the number of nodes erased (0 or 1)
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename COMPARE, typename ALLOCATOR >
+unsigned int CS280::CompactAVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR>::erase(KEY_TYPE const& key)
+{
+    std::uint32_t node = FindNode(key);
+
+    if(node == NIL)
+        return 0;
+
+    DeleteItem(node);
+    return 1;
+}
+
+/**
+ * @brief Returns the first node with a key not less than the given key
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename COMPARE, typename ALLOCATOR >
+typename CS280::CompactAVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR>::CompactAVLmap_iterator CS280::CompactAVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR>::lower_bound(KEY_TYPE const& key)
+{
+    return CompactAVLmap_iterator(this, LowerBound(key));
+}
+
+/**
+ * @brief Returns the first node with a key greater than the given key
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename COMPARE, typename ALLOCATOR >
+typename CS280::CompactAVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR>::CompactAVLmap_iterator CS280::CompactAVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR>::upper_bound(KEY_TYPE const& key)
+{
+    return CompactAVLmap_iterator(this, UpperBound(key));
+}
+
+/**
+ * @brief Inserts a copy of the pair if its key is not in the map yet.
+ *
+ * @param item - key and value to insert
+ * @return the node with the key, and whether it was inserted
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename COMPARE, typename ALLOCATOR >
+std::pair<typename CS280::CompactAVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR>::CompactAVLmap_iterator, bool> CS280::CompactAVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR>::insert(value_type const& item)
+{
+    return TryEmplace(item.first, item.second);
+}
+
+/**
+ * @brief Inserts the pair, moving the key and value into the node, if its key is not in the map yet.
+ *
+ * @param item - key and value to insert
+ * @return the node with the key, and whether it was inserted
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename COMPARE, typename ALLOCATOR >
+std::pair<typename CS280::CompactAVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR>::CompactAVLmap_iterator, bool> CS280::CompactAVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR>::insert(value_type&& item)
+{
+    return TryEmplace(std::move(item.first), std::move(item.second));
+}
+
+/**
+ * @brief Builds the value from args only if the key is missing.
+ *
+ * @param key - key to insert
+ * @param args - value constructor arguments
+ * @return the node with the key, and whether it was inserted
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename COMPARE, typename ALLOCATOR >
+template< typename... ARGS >
+std::pair<typename CS280::CompactAVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR>::CompactAVLmap_iterator, bool> CS280::CompactAVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR>::try_emplace(KEY_TYPE const& key, ARGS&&... args)
+{
+    return TryEmplace(key, std::forward<ARGS>(args)...);
+}
+
+/**
+ * @brief Builds the value from args only if the key is missing, the key is moved into the node.
+ *
+ * @param key - key to insert
+ * @param args - value constructor arguments
+ * @return the node with the key, and whether it was inserted
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename COMPARE, typename ALLOCATOR >
+template< typename... ARGS >
+std::pair<typename CS280::CompactAVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR>::CompactAVLmap_iterator, bool> CS280::CompactAVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR>::try_emplace(KEY_TYPE&& key, ARGS&&... args)
+{
+    return TryEmplace(std::move(key), std::forward<ARGS>(args)...);
+}
+
+/**
+ * @brief Returns the const begin iterator of the map
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename COMPARE, typename ALLOCATOR >
+typename CS280::CompactAVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR>::CompactAVLmap_iterator_const CS280::CompactAVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR>::begin() const
+{
+    return CompactAVLmap_iterator_const(this, First(mRoot));
+}
+
+/**
+ * @brief Returns the const end iterator
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename COMPARE, typename ALLOCATOR >
+typename CS280::CompactAVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR>::CompactAVLmap_iterator_const CS280::CompactAVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR>::end() const
+{
+    return CompactAVLmap_iterator_const(this, NIL);
+}
+
+/**
+ * @brief Returns the const reverse begin iterator (the last node)
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename COMPARE, typename ALLOCATOR >
+typename CS280::CompactAVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR>::const_reverse_iterator CS280::CompactAVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR>::rbegin() const
+{
+    return const_reverse_iterator(end());
+}
+
+/**
+ * @brief Returns the const reverse end iterator (before the first node)
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename COMPARE, typename ALLOCATOR >
+typename CS280::CompactAVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR>::const_reverse_iterator CS280::CompactAVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR>::rend() const
+{
+    return const_reverse_iterator(begin());
+}
+
+/**
+ * @brief Finds the node of given key and returns as a const iterator
+ *
+ * @param key - key to find
+ * @return the node, or end if the key is missing
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename COMPARE, typename ALLOCATOR >
+typename CS280::CompactAVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR>::CompactAVLmap_iterator_const CS280::CompactAVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR>::find(KEY_TYPE const& key) const
+{
+    return CompactAVLmap_iterator_const(this, FindNode(key));
+}
+
+/**
+ * @brief Returns the first node with a key not less than the given key
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename COMPARE, typename ALLOCATOR >
+typename CS280::CompactAVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR>::CompactAVLmap_iterator_const CS280::CompactAVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR>::lower_bound(KEY_TYPE const& key) const
+{
+    return CompactAVLmap_iterator_const(this, LowerBound(key));
+}
+
+/**
+ * @brief Returns the first node with a key greater than the given key
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename COMPARE, typename ALLOCATOR >
+typename CS280::CompactAVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR>::CompactAVLmap_iterator_const CS280::CompactAVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR>::upper_bound(KEY_TYPE const& key) const
+{
+    return CompactAVLmap_iterator_const(this, UpperBound(key));
+}
+
+/**
+ * @brief Checks every link, the key order and every balance factor against the real subtree heights. O(n).
+ *
+ * @return whether the tree is a valid AVL tree holding size() nodes
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename COMPARE, typename ALLOCATOR >
+bool CS280::CompactAVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR>::sanityCheck() const
+{
+    unsigned int count = 0;
+
+    if(CheckSubtree(mRoot, NIL, count) < -1)
+        return false;
+
+    return count == size_;
+}
+
+/**
+ * @brief Finds the node with the given key with one comparison per level.
+ *
+ * @param key - key to find
+ * @return the node index, or NIL if the key is missing
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename COMPARE, typename ALLOCATOR >
+std::uint32_t CS280::CompactAVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR>::FindNode(KEY_TYPE const& key) const
+{
+    std::uint32_t bound = LowerBound(key);
+
+    // The bound is not less than the key, so it is the key if the key is not less either
+    if(bound != NIL && !mCompare(key, KeyOf(mNodes[bound])))
+        return bound;
+
+    return NIL;
+}
+
+/**
+ * @brief Finds the node with the given key, or the spot where it would be linked if it is missing.
+ *        Equal keys go right so the last node we went right at is the only possible match.
+ *
+ * @param key - key to find
+ * @param parent - set to the node the key would be linked under (NIL if the tree is empty)
+ * @param left - set to whether the key would be the parent's left child
+ * @return the node with the key, or NIL if it is missing
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename COMPARE, typename ALLOCATOR >
+std::uint32_t CS280::CompactAVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR>::FindSlot(KEY_TYPE const& key, std::uint32_t& parent, bool& left) const
+{
+    std::uint32_t walker = mRoot;
+    std::uint32_t candidate = NIL;
+
+    parent = NIL;
+    left = false;
+
+    while(walker != NIL)
+    {
+        parent = walker;
+
+        if(mCompare(key, KeyOf(mNodes[walker])))
+        {
+            left = true;
+            walker = mNodes[walker].left;
+        }
+        else
+        {
+            left = false;
+            candidate = walker;
+            walker = mNodes[walker].right;
+        }
+    }
+
+    if(candidate != NIL && !mCompare(KeyOf(mNodes[candidate]), key))
+        return candidate;
+
+    return NIL;
+}
+
+/**
+ * @brief Finds the first node with a key not less than the given key in a single descent.
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename COMPARE, typename ALLOCATOR >
+std::uint32_t CS280::CompactAVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR>::LowerBound(KEY_TYPE const& key) const
+{
+    std::uint32_t walker = mRoot;
+    std::uint32_t bound = NIL;
+
+    while(walker != NIL)
+    {
+        if(mCompare(KeyOf(mNodes[walker]), key))
+        {
+            walker = mNodes[walker].right;
+        }
+        else
+        {
+            bound = walker;
+            walker = mNodes[walker].left;
+        }
+    }
+
+    return bound;
+}
+
+/**
+ * @brief Finds the first node with a key greater than the given key in a single descent.
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename COMPARE, typename ALLOCATOR >
+std::uint32_t CS280::CompactAVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR>::UpperBound(KEY_TYPE const& key) const
+{
+    std::uint32_t walker = mRoot;
+    std::uint32_t bound = NIL;
+
+    while(walker != NIL)
+    {
+        if(mCompare(key, KeyOf(mNodes[walker])))
+        {
+            bound = walker;
+            walker = mNodes[walker].left;
+        }
+        else
+        {
+            walker = mNodes[walker].right;
+        }
+    }
+
+    return bound;
+}
+
+/**
+ * @brief Looks the key up and builds a node from the key and args only if it is missing.
+ *
+ * @param key - key to insert
+ * @param args - value constructor arguments
+ * @return the node with the key, and whether it was inserted
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename COMPARE, typename ALLOCATOR >
+template< typename KEY_ARG, typename... ARGS >
+std::pair<typename CS280::CompactAVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR>::CompactAVLmap_iterator, bool> CS280::CompactAVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR>::TryEmplace(KEY_ARG&& key, ARGS&&... args)
+{
+    std::uint32_t parent;
+    bool left;
+
+    std::uint32_t found = FindSlot(key, parent, left);
+
+    if(found != NIL)
+        return std::pair<CompactAVLmap_iterator, bool>(CompactAVLmap_iterator(this, found), false);
+
+    // Indices survive the array growing, so the slot found above is still right
+    std::uint32_t node = CreateNode(std::forward<KEY_ARG>(key), std::forward<ARGS>(args)...);
+    InsertItem(node, parent, left);
+
+    return std::pair<CompactAVLmap_iterator, bool>(CompactAVLmap_iterator(this, node), true);
+}
+
+/**
+ * @brief Links a new node into the spot found by FindSlot and rebalances the tree.
+ *
+ * @param node - node to link
+ * @param parent - node to link it under (NIL if the tree is empty)
+ * @param left - whether the node becomes the parent's left child
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename COMPARE, typename ALLOCATOR >
+void CS280::CompactAVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR>::InsertItem(std::uint32_t node, std::uint32_t parent, bool left)
+{
+    SetParent(node, parent);
+
+    ++size_;
+
+    if(parent == NIL)
+    {
+        mRoot = node;
+        return;
+    }
+
+    if(left)
+    {
+        mNodes[parent].left = node;
+    }
+    else
+    {
+        mNodes[parent].right = node;
+    }
+
+    RebalanceAfterInsert(node);
+}
+
+/**
+ * @brief Unlinks a node and frees it. A node with two children is replaced by its predecessor,
+ *        which is relinked into its place (no key or value is copied, so iterators to other nodes stay valid).
+ *
+ * @param node - node to delete
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename COMPARE, typename ALLOCATOR >
+void CS280::CompactAVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR>::DeleteItem(std::uint32_t node)
+{
+    Node& doomed = mNodes[node];
+    std::uint32_t parent = Parent(node);
+
+    if(doomed.left != NIL && doomed.right != NIL)
+    {
+        std::uint32_t pred = Last(doomed.left);
+        std::uint32_t retrace;
+        bool leftShrank;
+
+        if(pred == doomed.left)
+        {
+            // The predecessor moves up and keeps its left subtree, which is one shorter than the old left subtree
+            retrace = pred;
+            leftShrank = true;
+        }
+        else
+        {
+            // The predecessor's left subtree takes its spot, then it takes both of the node's subtrees
+            retrace = Parent(pred);
+            leftShrank = false;
+
+            mNodes[retrace].right = mNodes[pred].left;
+
+            if(mNodes[pred].left != NIL)
+                SetParent(mNodes[pred].left, retrace);
+
+            mNodes[pred].left = doomed.left;
+            SetParent(doomed.left, pred);
+        }
+
+        mNodes[pred].right = doomed.right;
+        SetParent(doomed.right, pred);
+
+        ReplaceChild(parent, node, pred);
+        SetParent(pred, parent);
+        SetBalance(pred, Balance(node));
+
+        FreeNode(node);
+        RebalanceAfterErase(retrace, leftShrank);
+        return;
+    }
+
+    // At most one child, it takes the node's place
+    std::uint32_t child = doomed.left != NIL ? doomed.left : doomed.right;
+    bool leftShrank = parent != NIL && mNodes[parent].left == node;
+
+    ReplaceChild(parent, node, child);
+
+    if(child != NIL)
+        SetParent(child, parent);
+
+    FreeNode(node);
+    RebalanceAfterErase(parent, leftShrank);
+}
+
+/**
+ * @brief Walks up from a new leaf updating the balance factors until a subtree kept its height,
+ *        or one rotation restores it.
+ *
+ * @param node - new leaf
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename COMPARE, typename ALLOCATOR >
+void CS280::CompactAVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR>::RebalanceAfterInsert(std::uint32_t node)
+{
+    std::uint32_t child = node;
+    std::uint32_t parent = Parent(node);
+
+    while(parent != NIL)
+    {
+        int balance = Balance(parent) + (mNodes[parent].left == child ? 1 : -1);
+
+        if(balance == 0)
+        {
+            // The shorter side caught up, the height didn't change
+            SetBalance(parent, 0);
+            return;
+        }
+
+        if(balance == 1 || balance == -1)
+        {
+            // The subtree grew, keep going up
+            SetBalance(parent, balance);
+            child = parent;
+            parent = Parent(parent);
+            continue;
+        }
+
+        // A rotation after an insert always restores the subtree's old height
+        Rebalance(parent, balance);
+        return;
+    }
+}
+
+/**
+ * @brief Walks up from where a node was unlinked updating the balance factors, until a subtree kept its height.
+ *
+ * @param parent - node one of whose subtrees got one shorter
+ * @param leftShrank - whether it was the left subtree
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename COMPARE, typename ALLOCATOR >
+void CS280::CompactAVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR>::RebalanceAfterErase(std::uint32_t parent, bool leftShrank)
+{
+    while(parent != NIL)
+    {
+        int balance = Balance(parent) + (leftShrank ? -1 : 1);
+
+        std::uint32_t up = Parent(parent);
+        bool upLeft = up != NIL && mNodes[up].left == parent;
+
+        if(balance == 1 || balance == -1)
+        {
+            // It was even, one side is still as tall as before
+            SetBalance(parent, balance);
+            return;
+        }
+
+        if(balance == 0)
+        {
+            SetBalance(parent, 0);
+        }
+        else if(Balance(Rebalance(parent, balance)) != 0)
+        {
+            // A single rotation over an even child keeps the height
+            return;
+        }
+
+        // This subtree got one shorter
+        parent = up;
+        leftShrank = upLeft;
+    }
+}
+
+/**
+ * @brief Builds a node from the key and value arguments in a free slot, or past the used slots.
+ *        When the array is full a bigger one is allocated and the node is built there before the old
+ *        nodes move, so arguments that refer to keys or values in the map stay valid.
+ *
+ * @param key - key constructor argument
+ * @param args - value constructor arguments
+ * @return index of the new node, a leaf without parent and with balance 0
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename COMPARE, typename ALLOCATOR >
+template< typename KEY_ARG, typename... VALUE_ARGS >
+std::uint32_t CS280::CompactAVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR>::CreateNode(KEY_ARG&& key, VALUE_ARGS&&... args)
+{
+    std::uint32_t node;
+
+    if(mFree != NIL)
+    {
+        node = mFree;
+        Construct(mNodes[node], std::forward<KEY_ARG>(key), std::forward<VALUE_ARGS>(args)...);
+        mFree = mNodes[node].left;
+    }
+    else if(mUsed < mCapacity)
+    {
+        node = mUsed;
+        Construct(mNodes[node], std::forward<KEY_ARG>(key), std::forward<VALUE_ARGS>(args)...);
+        ++mUsed;
+    }
+    else
+    {
+        std::uint32_t capacity = GrownCapacity();
+        Node* nodes = AllocateNodes(capacity);
+
+        node = mUsed;
+
+        try
+        {
+            Construct(nodes[node], std::forward<KEY_ARG>(key), std::forward<VALUE_ARGS>(args)...);
+        }
+        catch(...)
+        {
+            std::allocator_traits<NodeAllocator>::deallocate(mAlloc, nodes, capacity);
+            throw;
+        }
+
+        try
+        {
+            MoveNodesTo(nodes);
+        }
+        catch(...)
+        {
+            DestroyNodes(nodes + node, 1);
+            std::allocator_traits<NodeAllocator>::deallocate(mAlloc, nodes, capacity);
+            throw;
+        }
+
+        if(mNodes != nullptr)
+        {
+            DestroyNodes(mNodes, mUsed);
+            std::allocator_traits<NodeAllocator>::deallocate(mAlloc, mNodes, mCapacity);
+        }
+
+        mNodes = nodes;
+        mCapacity = capacity;
+        ++mUsed;
+    }
+
+    Node& created = mNodes[node];
+    created.left = NIL;
+    created.right = NIL;
+    created.parentAndBalance = NIL | (1u << 30);
+
+    return node;
+}
+
+/**
+ * @brief Builds a key and a value in a slot's raw storage. If the value throws, the key is destroyed again.
+ *
+ * @param node - slot to build in
+ * @param key - key constructor argument
+ * @param args - value constructor arguments
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename COMPARE, typename ALLOCATOR >
+template< typename KEY_ARG, typename... VALUE_ARGS >
+void CS280::CompactAVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR>::Construct(Node& node, KEY_ARG&& key, VALUE_ARGS&&... args)
+{
+    ::new (static_cast<void*>(node.key)) KEY_TYPE(std::forward<KEY_ARG>(key));
+
+    try
+    {
+        ::new (static_cast<void*>(node.value)) VALUE_TYPE(std::forward<VALUE_ARGS>(args)...);
+    }
+    catch(...)
+    {
+        KeyOf(node).~KEY_TYPE();
+        throw;
+    }
+}
+
+/**
+ * @brief Destroys a node's key and value and puts its slot on the free list
+ *
+ * @param node - node to free
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename COMPARE, typename ALLOCATOR >
+void CS280::CompactAVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR>::FreeNode(std::uint32_t node)
+{
+    DestroyNodes(mNodes + node, 1);
+
+    mNodes[node].left = mFree;
+    mNodes[node].parentAndBalance = FREE_SLOT;
+    mFree = node;
+
+    --size_;
+}
+
+/**
+ * @brief Allocates a node array. The slots are plain storage until a key and value are built in them.
+ *
+ * @param capacity - number of slots
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename COMPARE, typename ALLOCATOR >
+typename CS280::CompactAVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR>::Node* CS280::CompactAVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR>::AllocateNodes(std::uint32_t capacity)
+{
+    return std::allocator_traits<NodeAllocator>::allocate(mAlloc, capacity);
+}
+
+/**
+ * @brief Moves every used slot into another array at the same index (the keys and values are only copied
+ *        when moving them could throw). If a copy throws, what was built in the new array is destroyed
+ *        and this array is unchanged.
+ *
+ * @param nodes - array with room for every used slot
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename COMPARE, typename ALLOCATOR >
+void CS280::CompactAVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR>::MoveNodesTo(Node* nodes)
+{
+    std::uint32_t index = 0;
+
+    try
+    {
+        for(; index < mUsed; ++index)
+        {
+            Node& source = mNodes[index];
+            Node& target = nodes[index];
+
+            target.left = source.left;
+            target.right = source.right;
+            target.parentAndBalance = FREE_SLOT;
+
+            if(source.parentAndBalance != FREE_SLOT)
+            {
+                Construct(target, std::move_if_noexcept(KeyOf(source)), std::move_if_noexcept(ValueOf(source)));
+                target.parentAndBalance = source.parentAndBalance;
+            }
+        }
+    }
+    catch(...)
+    {
+        DestroyNodes(nodes, index);
+        throw;
+    }
+}
+
+/**
+ * @brief Moves the nodes into a new array with the given capacity (at least the number of used slots).
+ *
+ * @param capacity - number of slots of the new array
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename COMPARE, typename ALLOCATOR >
+void CS280::CompactAVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR>::Reallocate(std::uint32_t capacity)
+{
+    Node* nodes = AllocateNodes(capacity);
+
+    try
+    {
+        MoveNodesTo(nodes);
+    }
+    catch(...)
+    {
+        std::allocator_traits<NodeAllocator>::deallocate(mAlloc, nodes, capacity);
+        throw;
+    }
+
+    if(mNodes != nullptr)
+    {
+        DestroyNodes(mNodes, mUsed);
+        std::allocator_traits<NodeAllocator>::deallocate(mAlloc, mNodes, mCapacity);
+    }
+
+    mNodes = nodes;
+    mCapacity = capacity;
+}
+
+/**
+ * @brief Returns the capacity to grow a full array to: twice as big, up to the largest index.
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename COMPARE, typename ALLOCATOR >
+std::uint32_t CS280::CompactAVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR>::GrownCapacity() const
+{
+    if(mCapacity == 0)
+        return FIRST_CAPACITY;
+
+    if(mCapacity >= NIL)
+        throw std::length_error("CompactAVLmap can't hold more nodes");
+
+    return mCapacity > NIL / 2 ? NIL : mCapacity * 2;
+}
+
+/**
+ * @brief Destroys the keys and values of the live nodes among some slots (nothing to do when they are
+ *        trivially destructible). Free slots are skipped.
+ *
+ * @param nodes - first slot
+ * @param count - number of slots
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename COMPARE, typename ALLOCATOR >
+void CS280::CompactAVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR>::DestroyNodes(Node* nodes, std::uint32_t count)
+{
+    if(std::is_trivially_destructible<KEY_TYPE>::value && std::is_trivially_destructible<VALUE_TYPE>::value)
+        return;
+
+    for(std::uint32_t index = 0; index < count; ++index)
+    {
+        if(nodes[index].parentAndBalance != FREE_SLOT)
+        {
+            KeyOf(nodes[index]).~KEY_TYPE();
+            ValueOf(nodes[index]).~VALUE_TYPE();
+        }
+    }
+}
+
+/**
+ * @brief Copies rhs's node array slot for slot into this empty map. If a copy throws,
+ *        the nodes copied so far are destroyed and this map stays empty.
+ *
+ * @param rhs - map to copy
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename COMPARE, typename ALLOCATOR >
+void CS280::CompactAVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR>::CopyNodes(const CompactAVLmap& rhs)
+{
+    if(rhs.mUsed == 0)
+        return;
+
+    Node* nodes = AllocateNodes(rhs.mUsed);
+    std::uint32_t index = 0;
+
+    try
+    {
+        for(; index < rhs.mUsed; ++index)
+        {
+            Node const& source = rhs.mNodes[index];
+            Node& target = nodes[index];
+
+            target.left = source.left;
+            target.right = source.right;
+            target.parentAndBalance = FREE_SLOT;
+
+            if(source.parentAndBalance != FREE_SLOT)
+            {
+                Construct(target, KeyOf(source), rhs.mNodes[index].Value());
+                target.parentAndBalance = source.parentAndBalance;
+            }
+        }
+    }
+    catch(...)
+    {
+        DestroyNodes(nodes, index);
+        std::allocator_traits<NodeAllocator>::deallocate(mAlloc, nodes, rhs.mUsed);
+        throw;
+    }
+
+    mNodes = nodes;
+    mCapacity = rhs.mUsed;
+    mUsed = rhs.mUsed;
+    mFree = rhs.mFree;
+    mRoot = rhs.mRoot;
+    size_ = rhs.size_;
+}
+
+/**
+ * @brief Rotates a node left, only the links change.
+ *
+ * @param node - node to rotate
+ * @return the node promoted in its place
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename COMPARE, typename ALLOCATOR >
+std::uint32_t CS280::CompactAVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR>::RotateLeft(std::uint32_t node)
+{
+    std::uint32_t promoted = mNodes[node].right;
+    std::uint32_t parent = Parent(node);
+    std::uint32_t inner = mNodes[promoted].left;
+
+    mNodes[node].right = inner;
+
+    if(inner != NIL)
+        SetParent(inner, node);
+
+    mNodes[promoted].left = node;
+    SetParent(node, promoted);
+
+    ReplaceChild(parent, node, promoted);
+    SetParent(promoted, parent);
+
+    return promoted;
+}
+
+/**
+ * @brief Rotates a node right, only the links change.
+ *
+ * @param node - node to rotate
+ * @return the node promoted in its place
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename COMPARE, typename ALLOCATOR >
+std::uint32_t CS280::CompactAVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR>::RotateRight(std::uint32_t node)
+{
+    std::uint32_t promoted = mNodes[node].left;
+    std::uint32_t parent = Parent(node);
+    std::uint32_t inner = mNodes[promoted].right;
+
+    mNodes[node].left = inner;
+
+    if(inner != NIL)
+        SetParent(inner, node);
+
+    mNodes[promoted].right = node;
+    SetParent(node, promoted);
+
+    ReplaceChild(parent, node, promoted);
+    SetParent(promoted, parent);
+
+    return promoted;
+}
+
+/**
+ * @brief Rotates a node whose balance went out of range back into balance (single or double rotation)
+ *        and sets the balance factors of the rotated nodes.
+ *
+ * @param node - node to rebalance
+ * @param balance - its balance factor, 2 or -2 (it can't be stored in the node)
+ * @return the root of the rebalanced subtree
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename COMPARE, typename ALLOCATOR >
+std::uint32_t CS280::CompactAVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR>::Rebalance(std::uint32_t node, int balance)
+{
+    if(balance > 1)
+    {
+        std::uint32_t child = mNodes[node].left;
+        int childBalance = Balance(child);
+
+        if(childBalance >= 0)
+        {
+            std::uint32_t top = RotateRight(node);
+
+            int nodeBalance = balance - 1 - std::max(childBalance, 0);
+            SetBalance(node, nodeBalance);
+            SetBalance(top, childBalance - 1 + std::min(nodeBalance, 0));
+
+            return top;
+        }
+
+        // The child leans right, its right child comes up two levels
+        int grandchildBalance = Balance(mNodes[child].right);
+
+        RotateLeft(child);
+        std::uint32_t top = RotateRight(node);
+
+        SetBalance(node, grandchildBalance > 0 ? -1 : 0);
+        SetBalance(child, grandchildBalance < 0 ? 1 : 0);
+        SetBalance(top, 0);
+
+        return top;
+    }
+    else
+    {
+        std::uint32_t child = mNodes[node].right;
+        int childBalance = Balance(child);
+
+        if(childBalance <= 0)
+        {
+            std::uint32_t top = RotateLeft(node);
+
+            int nodeBalance = balance + 1 - std::min(childBalance, 0);
+            SetBalance(node, nodeBalance);
+            SetBalance(top, childBalance + 1 + std::max(nodeBalance, 0));
+
+            return top;
+        }
+
+        // The child leans left, its left child comes up two levels
+        int grandchildBalance = Balance(mNodes[child].left);
+
+        RotateRight(child);
+        std::uint32_t top = RotateLeft(node);
+
+        SetBalance(node, grandchildBalance < 0 ? 1 : 0);
+        SetBalance(child, grandchildBalance > 0 ? -1 : 0);
+        SetBalance(top, 0);
+
+        return top;
+    }
+}
+
+/**
+ * @brief Points the parent's link that pointed at the old child at the new one (the root if there is no parent)
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename COMPARE, typename ALLOCATOR >
+void CS280::CompactAVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR>::ReplaceChild(std::uint32_t parent, std::uint32_t oldChild, std::uint32_t newChild)
+{
+    if(parent == NIL)
+    {
+        mRoot = newChild;
+    }
+    else if(mNodes[parent].left == oldChild)
+    {
+        mNodes[parent].left = newChild;
+    }
+    else
+    {
+        mNodes[parent].right = newChild;
+    }
+}
+
+/**
+ * @brief Returns the minimum of a subtree (NIL for an empty one)
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename COMPARE, typename ALLOCATOR >
+std::uint32_t CS280::CompactAVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR>::First(std::uint32_t node) const
+{
+    if(node == NIL)
+        return NIL;
+
+    while(mNodes[node].left != NIL)
+    {
+        node = mNodes[node].left;
+    }
+
+    return node;
+}
+
+/**
+ * @brief Returns the maximum of a subtree (NIL for an empty one)
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename COMPARE, typename ALLOCATOR >
+std::uint32_t CS280::CompactAVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR>::Last(std::uint32_t node) const
+{
+    if(node == NIL)
+        return NIL;
+
+    while(mNodes[node].right != NIL)
+    {
+        node = mNodes[node].right;
+    }
+
+    return node;
+}
+
+/**
+ * @brief Returns the in-order successor of a node (NIL after the last one)
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename COMPARE, typename ALLOCATOR >
+std::uint32_t CS280::CompactAVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR>::Next(std::uint32_t node) const
+{
+    if(mNodes[node].right != NIL)
+        return First(mNodes[node].right);
+
+    std::uint32_t parent = Parent(node);
+
+    while(parent != NIL && mNodes[parent].right == node)
+    {
+        node = parent;
+        parent = Parent(parent);
+    }
+
+    return parent;
+}
+
+/**
+ * @brief Returns the in-order predecessor of a node (NIL before the first one)
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename COMPARE, typename ALLOCATOR >
+std::uint32_t CS280::CompactAVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR>::Previous(std::uint32_t node) const
+{
+    if(mNodes[node].left != NIL)
+        return Last(mNodes[node].left);
+
+    std::uint32_t parent = Parent(node);
+
+    while(parent != NIL && mNodes[parent].left == node)
+    {
+        node = parent;
+        parent = Parent(parent);
+    }
+
+    return parent;
+}
+
+/**
+ * @brief Checks a subtree for sanityCheck. The recursion is as deep as the tree, O(log n) for a valid one.
+ *
+ * @param node - subtree root
+ * @param parent - expected parent
+ * @param count - incremented for every node
+ * @return height of the subtree (-1 when empty), or -2 if something is wrong
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename COMPARE, typename ALLOCATOR >
+int CS280::CompactAVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR>::CheckSubtree(std::uint32_t node, std::uint32_t parent, unsigned int& count) const
+{
+    if(node == NIL)
+        return -1;
+
+    Node const& current = mNodes[node];
+
+    if(node >= mUsed || current.parentAndBalance == FREE_SLOT || Parent(node) != parent || ++count > size_)
+        return -2;
+
+    if(current.left != NIL && !mCompare(KeyOf(mNodes[current.left]), KeyOf(current)))
+        return -2;
+
+    if(current.right != NIL && !mCompare(KeyOf(current), KeyOf(mNodes[current.right])))
+        return -2;
+
+    int leftHeight = CheckSubtree(current.left, node, count);
+    int rightHeight = CheckSubtree(current.right, node, count);
+
+    if(leftHeight < -1 || rightHeight < -1 || leftHeight - rightHeight != Balance(node))
+        return -2;
+
+    return 1 + std::max(leftHeight, rightHeight);
+}
+
+/**
+ * @brief Returns a node's parent index
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename COMPARE, typename ALLOCATOR >
+std::uint32_t CS280::CompactAVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR>::Parent(std::uint32_t node) const
+{
+    return mNodes[node].parentAndBalance & PARENT_MASK;
+}
+
+/**
+ * @brief Returns a node's balance factor (left height - right height, -1 to 1)
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename COMPARE, typename ALLOCATOR >
+int CS280::CompactAVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR>::Balance(std::uint32_t node) const
+{
+    return static_cast<int>(mNodes[node].parentAndBalance >> 30) - 1;
+}
+
+/**
+ * @brief Sets a node's parent index, keeping its balance factor
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename COMPARE, typename ALLOCATOR >
+void CS280::CompactAVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR>::SetParent(std::uint32_t node, std::uint32_t parent)
+{
+    std::uint32_t& packed = mNodes[node].parentAndBalance;
+    packed = (packed & ~PARENT_MASK) | parent;
+}
+
+/**
+ * @brief Sets a node's balance factor (-1 to 1), keeping its parent index
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename COMPARE, typename ALLOCATOR >
+void CS280::CompactAVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR>::SetBalance(std::uint32_t node, int balance)
+{
+    std::uint32_t& packed = mNodes[node].parentAndBalance;
+    packed = (packed & PARENT_MASK) | (static_cast<std::uint32_t>(balance + 1) << 30);
+}
+
+/**
+ * @brief Returns the key built in a node's raw storage
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename COMPARE, typename ALLOCATOR >
+KEY_TYPE& CS280::CompactAVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR>::KeyOf(Node& node)
+{
+    return *std::launder(reinterpret_cast<KEY_TYPE*>(node.key));
+}
+
+/**
+ * @brief Returns the key built in a node's raw storage
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename COMPARE, typename ALLOCATOR >
+KEY_TYPE const& CS280::CompactAVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR>::KeyOf(Node const& node)
+{
+    return *std::launder(reinterpret_cast<KEY_TYPE const*>(node.key));
+}
+
+/**
+ * @brief Returns the value built in a node's raw storage
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename COMPARE, typename ALLOCATOR >
+VALUE_TYPE& CS280::CompactAVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR>::ValueOf(Node& node)
+{
+    return *std::launder(reinterpret_cast<VALUE_TYPE*>(node.value));
+}
+
+/**
+ * @brief Returns the key of the node
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename COMPARE, typename ALLOCATOR >
+KEY_TYPE const& CS280::CompactAVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR>::Node::Key() const
+{
+    return KeyOf(*this);
+}
+
+/**
+ * @brief Returns the value of the node
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename COMPARE, typename ALLOCATOR >
+VALUE_TYPE& CS280::CompactAVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR>::Node::Value()
+{
+    return ValueOf(*this);
+}
+
+/**
+ * @brief Returns the value of the node
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename COMPARE, typename ALLOCATOR >
+VALUE_TYPE const& CS280::CompactAVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR>::Node::Value() const
+{
+    return *std::launder(reinterpret_cast<VALUE_TYPE const*>(value));
+}
+
+/**
+ * @brief Constructor for iterator
+ *
+ * @param map - map the node is in
+ * @param index - node index, NIL for end
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename COMPARE, typename ALLOCATOR >
+CS280::CompactAVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR>::CompactAVLmap_iterator::CompactAVLmap_iterator(CompactAVLmap* map, std::uint32_t index) : mMap(map), mIndex(index)
+{
+
+}
+
+/**
+ * @brief Prefix increment operator for iterators
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename COMPARE, typename ALLOCATOR >
+typename CS280::CompactAVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR>::CompactAVLmap_iterator& CS280::CompactAVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR>::CompactAVLmap_iterator::operator++()
+{
+    mIndex = mMap->Next(mIndex);
+    return *this;
+}
+
+/**
+ * @brief Postfix increment operator for iterators
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename COMPARE, typename ALLOCATOR >
+typename CS280::CompactAVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR>::CompactAVLmap_iterator CS280::CompactAVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR>::CompactAVLmap_iterator::operator++(int)
+{
+    CompactAVLmap_iterator temp = *this;
+    ++*this;
+    return temp;
+}
+
+/**
+ * @brief Prefix decrement operator for iterators. Decrementing end gives the last node.
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename COMPARE, typename ALLOCATOR >
+typename CS280::CompactAVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR>::CompactAVLmap_iterator& CS280::CompactAVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR>::CompactAVLmap_iterator::operator--()
+{
+    mIndex = mIndex == NIL ? mMap->Last(mMap->mRoot) : mMap->Previous(mIndex);
+    return *this;
+}
+
+/**
+ * @brief Postfix decrement operator for iterators
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename COMPARE, typename ALLOCATOR >
+typename CS280::CompactAVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR>::CompactAVLmap_iterator CS280::CompactAVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR>::CompactAVLmap_iterator::operator--(int)
+{
+    CompactAVLmap_iterator temp = *this;
+    --*this;
+    return temp;
+}
+
+/**
+ * @brief Dereference operator for iterator
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename COMPARE, typename ALLOCATOR >
+typename CS280::CompactAVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR>::Node& CS280::CompactAVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR>::CompactAVLmap_iterator::operator*() const
+{
+    return mMap->mNodes[mIndex];
+}
+
+/**
+ * @brief Arrow operator for iterator
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename COMPARE, typename ALLOCATOR >
+typename CS280::CompactAVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR>::Node* CS280::CompactAVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR>::CompactAVLmap_iterator::operator->() const
+{
+    return mMap->mNodes + mIndex;
+}
+
+/**
+ * @brief Not equal operator for iterator.
+ * @param rhs - check value against
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename COMPARE, typename ALLOCATOR >
+bool CS280::CompactAVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR>::CompactAVLmap_iterator::operator!=(const CompactAVLmap_iterator& rhs) const
+{
+    return mIndex != rhs.mIndex;
+}
+
+/**
+ * @brief Equal operator for iterator.
+ * @param rhs - check value against
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename COMPARE, typename ALLOCATOR >
+bool CS280::CompactAVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR>::CompactAVLmap_iterator::operator==(const CompactAVLmap_iterator& rhs) const
+{
+    return mIndex == rhs.mIndex;
+}
+
+/**
+ * @brief Constructor for const iterator
+ *
+ * @param map - map the node is in
+ * @param index - node index, NIL for end
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename COMPARE, typename ALLOCATOR >
+CS280::CompactAVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR>::CompactAVLmap_iterator_const::CompactAVLmap_iterator_const(CompactAVLmap const* map, std::uint32_t index) : mMap(map), mIndex(index)
+{
+
+}
+
+/**
+ * @brief Converts an iterator to a const iterator
+ *
+ * @param rhs - iterator to convert
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename COMPARE, typename ALLOCATOR >
+CS280::CompactAVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR>::CompactAVLmap_iterator_const::CompactAVLmap_iterator_const(const CompactAVLmap_iterator& rhs) : mMap(rhs.mMap), mIndex(rhs.mIndex)
+{
+
+}
+
+/**
+ * @brief Prefix increment operator for const iterators
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename COMPARE, typename ALLOCATOR >
+typename CS280::CompactAVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR>::CompactAVLmap_iterator_const& CS280::CompactAVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR>::CompactAVLmap_iterator_const::operator++()
+{
+    mIndex = mMap->Next(mIndex);
+    return *this;
+}
+
+/**
+ * @brief Postfix increment operator for const iterators
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename COMPARE, typename ALLOCATOR >
+typename CS280::CompactAVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR>::CompactAVLmap_iterator_const CS280::CompactAVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR>::CompactAVLmap_iterator_const::operator++(int)
+{
+    CompactAVLmap_iterator_const temp = *this;
+    ++*this;
+    return temp;
+}
+
+/**
+ * @brief Prefix decrement operator for const iterators. Decrementing end gives the last node.
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename COMPARE, typename ALLOCATOR >
+typename CS280::CompactAVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR>::CompactAVLmap_iterator_const& CS280::CompactAVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR>::CompactAVLmap_iterator_const::operator--()
+{
+    mIndex = mIndex == NIL ? mMap->Last(mMap->mRoot) : mMap->Previous(mIndex);
+    return *this;
+}
+
+/**
+ * @brief Postfix decrement operator for const iterators
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename COMPARE, typename ALLOCATOR >
+typename CS280::CompactAVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR>::CompactAVLmap_iterator_const CS280::CompactAVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR>::CompactAVLmap_iterator_const::operator--(int)
+{
+    CompactAVLmap_iterator_const temp = *this;
+    --*this;
+    return temp;
+}
+
+/**
+ * @brief Dereference operator for const iterator
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename COMPARE, typename ALLOCATOR >
+typename CS280::CompactAVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR>::Node const& CS280::CompactAVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR>::CompactAVLmap_iterator_const::operator*() const
+{
+    return mMap->mNodes[mIndex];
+}
+
+/**
+ * @brief Arrow operator for const iterator
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename COMPARE, typename ALLOCATOR >
+typename CS280::CompactAVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR>::Node const* CS280::CompactAVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR>::CompactAVLmap_iterator_const::operator->() const
+{
+    return mMap->mNodes + mIndex;
+}
+
+/**
+ * @brief Not equal operator for const iterator.
+ * @param rhs - check value against
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename COMPARE, typename ALLOCATOR >
+bool CS280::CompactAVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR>::CompactAVLmap_iterator_const::operator!=(const CompactAVLmap_iterator_const& rhs) const
+{
+    return mIndex != rhs.mIndex;
+}
+
+/**
+ * @brief Equal operator for const iterator.
+ * @param rhs - check value against
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename COMPARE, typename ALLOCATOR >
+bool CS280::CompactAVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR>::CompactAVLmap_iterator_const::operator==(const CompactAVLmap_iterator_const& rhs) const
+{
+    return mIndex == rhs.mIndex;
+}
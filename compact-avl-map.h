@@ -0,0 +1,219 @@
+/**
+ * @file compact-avl-map.h
+ * @brief A compact variant of AVLmap. The nodes live in one contiguous array and link to each other with
+ *        32 bit indices, and each node keeps only its balance factor, packed into the top bits of its parent index.
+ *        Iterators, find and erase behave like AVLmap's. Iterators stay valid until their node is erased,
+ *        but references to keys and values are invalidated when the array grows (see reserve).
+ */
+
+#ifndef COMPACT_AVLMAP_H
+#define COMPACT_AVLMAP_H
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <iterator>
+#include <memory>
+#include <new>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+
+namespace CS280 {
+
+    // COMPARE orders the keys, ALLOCATOR supplies the memory for the node array (it is rebound internally)
+    template< typename KEY_TYPE, typename VALUE_TYPE, typename COMPARE = std::less<KEY_TYPE>,
+              typename ALLOCATOR = std::allocator< std::pair<const KEY_TYPE, VALUE_TYPE> > >
+    class CompactAVLmap {
+		public:
+
+			class Node
+			{
+				public:
+					KEY_TYPE const & Key() const;   // return a const reference
+					VALUE_TYPE  &    Value();       // return a reference
+					VALUE_TYPE const & Value() const; // return a const reference
+				private:
+					// raw storage, so free slots don't hold live keys and values
+					alignas(KEY_TYPE)   unsigned char key[sizeof(KEY_TYPE)];
+					alignas(VALUE_TYPE) unsigned char value[sizeof(VALUE_TYPE)];
+					std::uint32_t left; // child indices, NIL when empty (a free slot chains the free list here)
+					std::uint32_t right;
+					std::uint32_t parentAndBalance; // parent index in the low 30 bits, balance factor + 1 in the top 2
+
+					friend class CompactAVLmap;
+			};
+
+		private:
+
+			typedef typename std::allocator_traits<ALLOCATOR>::template rebind_alloc<Node> NodeAllocator;
+
+			static constexpr std::uint32_t NIL = 0x3FFFFFFF; // no node, also one past the largest index
+			static constexpr std::uint32_t PARENT_MASK = 0x3FFFFFFF;
+			static constexpr std::uint32_t FREE_SLOT = 0xFFFFFFFF; // balance bits of 3 mark a free slot
+			static constexpr std::uint32_t FIRST_CAPACITY = 8;
+
+			struct CompactAVLmap_iterator
+			{
+				private:
+					CompactAVLmap* mMap;
+					std::uint32_t mIndex;
+				public:
+					typedef std::bidirectional_iterator_tag iterator_category;
+					typedef Node                      value_type;
+					typedef std::ptrdiff_t            difference_type;
+					typedef Node*                     pointer;
+					typedef Node&                     reference;
+
+					CompactAVLmap_iterator(CompactAVLmap* map=nullptr, std::uint32_t index=NIL);
+					CompactAVLmap_iterator& operator++();
+					CompactAVLmap_iterator operator++(int);
+					CompactAVLmap_iterator& operator--();
+					CompactAVLmap_iterator operator--(int);
+					Node & operator*() const;
+					Node * operator->() const;
+					bool operator!=(const CompactAVLmap_iterator& rhs) const;
+					bool operator==(const CompactAVLmap_iterator& rhs) const;
+					friend class CompactAVLmap;
+			};
+
+			struct CompactAVLmap_iterator_const
+			{
+				private:
+					CompactAVLmap const* mMap;
+					std::uint32_t mIndex;
+				public:
+					typedef std::bidirectional_iterator_tag iterator_category;
+					typedef Node                      value_type;
+					typedef std::ptrdiff_t            difference_type;
+					typedef Node const*               pointer;
+					typedef Node const&               reference;
+
+					CompactAVLmap_iterator_const(CompactAVLmap const* map=nullptr, std::uint32_t index=NIL);
+					CompactAVLmap_iterator_const(const CompactAVLmap_iterator& rhs);
+					CompactAVLmap_iterator_const& operator++();
+					CompactAVLmap_iterator_const operator++(int);
+					CompactAVLmap_iterator_const& operator--();
+					CompactAVLmap_iterator_const operator--(int);
+					Node const& operator*() const;
+					Node const* operator->() const;
+					bool operator!=(const CompactAVLmap_iterator_const& rhs) const;
+					bool operator==(const CompactAVLmap_iterator_const& rhs) const;
+					friend class CompactAVLmap;
+			};
+
+			// CompactAVLmap implementation
+			Node*         mNodes = nullptr;
+			std::uint32_t mCapacity = 0;
+			std::uint32_t mUsed = 0; // slots ever handed out, the ones below that are live or on the free list
+			std::uint32_t mFree = NIL; // free list head
+			std::uint32_t mRoot = NIL;
+			unsigned int  size_ = 0;
+			COMPARE       mCompare;
+			NodeAllocator mAlloc;
+
+		public:
+			CompactAVLmap();
+			explicit CompactAVLmap(ALLOCATOR const& alloc);
+			explicit CompactAVLmap(COMPARE const& comp, ALLOCATOR const& alloc = ALLOCATOR());
+			CompactAVLmap(const CompactAVLmap& rhs);
+			CompactAVLmap(CompactAVLmap&& rhs);
+			CompactAVLmap& operator=(const CompactAVLmap& rhs);
+			CompactAVLmap& operator=(CompactAVLmap&& rhs);
+			~CompactAVLmap();
+
+			unsigned int size();
+			COMPARE key_comp() const;
+			ALLOCATOR get_allocator() const;
+			void reserve(unsigned int count); // grows the node array up front so inserts don't move the nodes
+			void clear();
+
+			//value setter and getter
+			VALUE_TYPE& operator[](KEY_TYPE const& key);
+
+			//standard names for iterator types
+			typedef CompactAVLmap_iterator       iterator;
+			typedef CompactAVLmap_iterator_const const_iterator;
+			typedef std::pair<KEY_TYPE, VALUE_TYPE> value_type;
+			typedef std::reverse_iterator<CompactAVLmap_iterator>       reverse_iterator;
+			typedef std::reverse_iterator<CompactAVLmap_iterator_const> const_reverse_iterator;
+
+			CompactAVLmap_iterator begin();
+			CompactAVLmap_iterator end();
+			reverse_iterator rbegin();
+			reverse_iterator rend();
+			CompactAVLmap_iterator find(KEY_TYPE const& key);
+			CompactAVLmap_iterator erase(CompactAVLmap_iterator it); // returns the node after the erased one
+			unsigned int erase(KEY_TYPE const& key); // returns the number of nodes erased
+			CompactAVLmap_iterator lower_bound(KEY_TYPE const& key); // first node with key >= given key
+			CompactAVLmap_iterator upper_bound(KEY_TYPE const& key); // first node with key > given key
+
+			//insertion in a single descent, returns the node with the key and whether it was inserted
+			std::pair<CompactAVLmap_iterator, bool> insert(value_type const& item);
+			std::pair<CompactAVLmap_iterator, bool> insert(value_type&& item);
+			template< typename... ARGS >
+			std::pair<CompactAVLmap_iterator, bool> try_emplace(KEY_TYPE const& key, ARGS&&... args);
+			template< typename... ARGS >
+			std::pair<CompactAVLmap_iterator, bool> try_emplace(KEY_TYPE&& key, ARGS&&... args);
+
+			CompactAVLmap_iterator_const begin() const;
+			CompactAVLmap_iterator_const end() const;
+			const_reverse_iterator rbegin() const;
+			const_reverse_iterator rend() const;
+			CompactAVLmap_iterator_const find(KEY_TYPE const& key) const;
+			CompactAVLmap_iterator_const lower_bound(KEY_TYPE const& key) const;
+			CompactAVLmap_iterator_const upper_bound(KEY_TYPE const& key) const;
+
+			bool sanityCheck() const;
+
+			friend struct CompactAVLmap_iterator;
+			friend struct CompactAVLmap_iterator_const;
+		private:
+			std::uint32_t FindNode(KEY_TYPE const& key) const;
+			std::uint32_t FindSlot(KEY_TYPE const& key, std::uint32_t& parent, bool& left) const;
+			std::uint32_t LowerBound(KEY_TYPE const& key) const;
+			std::uint32_t UpperBound(KEY_TYPE const& key) const;
+
+			template< typename KEY_ARG, typename... ARGS >
+			std::pair<CompactAVLmap_iterator, bool> TryEmplace(KEY_ARG&& key, ARGS&&... args);
+			void InsertItem(std::uint32_t node, std::uint32_t parent, bool left);
+			void DeleteItem(std::uint32_t node);
+			void RebalanceAfterInsert(std::uint32_t node);
+			void RebalanceAfterErase(std::uint32_t parent, bool leftShrank);
+
+			template< typename KEY_ARG, typename... VALUE_ARGS >
+			std::uint32_t CreateNode(KEY_ARG&& key, VALUE_ARGS&&... args);
+			template< typename KEY_ARG, typename... VALUE_ARGS >
+			static void Construct(Node& node, KEY_ARG&& key, VALUE_ARGS&&... args);
+			void FreeNode(std::uint32_t node);
+			Node* AllocateNodes(std::uint32_t capacity);
+			void MoveNodesTo(Node* nodes);
+			void Reallocate(std::uint32_t capacity);
+			std::uint32_t GrownCapacity() const;
+			void DestroyNodes(Node* nodes, std::uint32_t count);
+			void CopyNodes(const CompactAVLmap& rhs);
+
+			std::uint32_t RotateLeft(std::uint32_t node);
+			std::uint32_t RotateRight(std::uint32_t node);
+			std::uint32_t Rebalance(std::uint32_t node, int balance);
+			void ReplaceChild(std::uint32_t parent, std::uint32_t oldChild, std::uint32_t newChild);
+
+			std::uint32_t First(std::uint32_t node) const;
+			std::uint32_t Last(std::uint32_t node) const;
+			std::uint32_t Next(std::uint32_t node) const;
+			std::uint32_t Previous(std::uint32_t node) const;
+			int CheckSubtree(std::uint32_t node, std::uint32_t parent, unsigned int& count) const;
+
+			std::uint32_t Parent(std::uint32_t node) const;
+			int Balance(std::uint32_t node) const;
+			void SetParent(std::uint32_t node, std::uint32_t parent);
+			void SetBalance(std::uint32_t node, int balance);
+			static KEY_TYPE& KeyOf(Node& node);
+			static KEY_TYPE const& KeyOf(Node const& node);
+			static VALUE_TYPE& ValueOf(Node& node);
+	};
+}
+
+#include "compact-avl-map.cpp"
+#endif
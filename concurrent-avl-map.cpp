@@ -0,0 +1,806 @@
+/**
+ * @file concurrent-avl-map.cpp
+ * @brief This implements the concurrent AVL map. A write rebuilds the path from the root to the change out of
+ *        new nodes (rotations included) and publishes it by storing the new root, the nodes it replaced are retired.
+ *        A reader counts itself in the epoch it enters in, and retired nodes are freed one epoch change later,
+ *        once the count of the old epoch is back to zero.
+ */
+
+#include "concurrent-avl-map.h"
+
+/**
+ * @brief Construct an empty map
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename COMPARE, typename ALLOCATOR >
+CS280::ConcurrentAVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR>::ConcurrentAVLmap() : ConcurrentAVLmap(COMPARE(), ALLOCATOR())
+{
+
+}
+
+/**
+ * @brief Construct an empty map with the allocator that supplies the nodes
+ *
+ * @param alloc - allocator for the nodes
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename COMPARE, typename ALLOCATOR >
+CS280::ConcurrentAVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR>::ConcurrentAVLmap(ALLOCATOR const& alloc) : ConcurrentAVLmap(COMPARE(), alloc)
+{
+
+}
+
+/**
+ * @brief Construct an empty map that orders its keys with the given comparator
+ *
+ * @param comp - key comparator
+ * @param alloc - allocator for the nodes
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename COMPARE, typename ALLOCATOR >
+CS280::ConcurrentAVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR>::ConcurrentAVLmap(COMPARE const& comp, ALLOCATOR const& alloc)
+    : mRoot(nullptr), mSize(0), mEpoch(0), mCompare(comp), mAlloc(alloc)
+{
+    for(ReaderStripe& stripe : mStripes)
+    {
+        stripe.readers[0].store(0);
+        stripe.readers[1].store(0);
+    }
+}
+
+/**
+ * @brief Destructor. Frees the tree and every retired node.
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename COMPARE, typename ALLOCATOR >
+CS280::ConcurrentAVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR>::~ConcurrentAVLmap()
+{
+    std::vector<Node*> nodes;
+
+    CollectTree(mRoot.load(), nodes);
+    DestroyNodes(nodes);
+    DestroyNodes(mRetired);
+    DestroyNodes(mDraining);
+}
+
+/**
+ * @brief Returns the size (number of nodes) of the latest version of the map
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename COMPARE, typename ALLOCATOR >
+unsigned int CS280::ConcurrentAVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR>::size() const
+{
+    return mSize.load(std::memory_order_relaxed);
+}
+
+/**
+ * @brief Returns the comparator that orders the keys
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename COMPARE, typename ALLOCATOR >
+COMPARE CS280::ConcurrentAVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR>::key_comp() const
+{
+    return mCompare;
+}
+
+/**
+ * @brief Checks whether the key is in the map
+ *
+ * @param key - key to find
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename COMPARE, typename ALLOCATOR >
+bool CS280::ConcurrentAVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR>::contains(KEY_TYPE const& key) const
+{
+    ReadGuard guard(*this);
+
+    return FindNode(mRoot.load(), key) != nullptr;
+}
+
+/**
+ * @brief Copies the value of the key out of the map
+ *
+ * @param key - key to find
+ * @param value - set to the value of the key, unchanged if the key is missing
+ * @return whether the key was found
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename COMPARE, typename ALLOCATOR >
+bool CS280::ConcurrentAVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR>::get(KEY_TYPE const& key, VALUE_TYPE& value) const
+{
+    ReadGuard guard(*this);
+
+    Node* node = FindNode(mRoot.load(), key);
+
+    if(node == nullptr)
+        return false;
+
+    value = node->value;
+    return true;
+}
+
+/**
+ * @brief Calls a function with the value of the key. The node stays alive until the function returns,
+ *        so it can look at the value without copying it (it must not keep a reference to it).
+ *
+ * @param key - key to find
+ * @param f - called as f(value)
+ * @return whether the key was found
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename COMPARE, typename ALLOCATOR >
+template< typename FUNC >
+bool CS280::ConcurrentAVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR>::visit(KEY_TYPE const& key, FUNC&& f) const
+{
+    ReadGuard guard(*this);
+
+    Node* node = FindNode(mRoot.load(), key);
+
+    if(node == nullptr)
+        return false;
+
+    f(static_cast<VALUE_TYPE const&>(node->value));
+    return true;
+}
+
+/**
+ * @brief Calls a function for every node in key order. Writes that land in the meantime are not seen,
+ *        the whole walk is over the version that was current when it started.
+ *
+ * @param f - called as f(key, value)
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename COMPARE, typename ALLOCATOR >
+template< typename FUNC >
+void CS280::ConcurrentAVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR>::for_each(FUNC&& f) const
+{
+    ReadGuard guard(*this);
+
+    ForEach(mRoot.load(), f);
+}
+
+/**
+ * @brief Inserts a copy of the pair if its key is not in the map yet.
+ *
+ * @param item - key and value to insert
+ * @return whether it was inserted
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename COMPARE, typename ALLOCATOR >
+bool CS280::ConcurrentAVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR>::insert(value_type const& item)
+{
+    return try_emplace(item.first, item.second);
+}
+
+/**
+ * @brief Builds the value from args only if the key is missing.
+ *
+ * @param key - key to insert
+ * @param args - value constructor arguments
+ * @return whether it was inserted
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename COMPARE, typename ALLOCATOR >
+template< typename... ARGS >
+bool CS280::ConcurrentAVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR>::try_emplace(KEY_TYPE const& key, ARGS&&... args)
+{
+    std::lock_guard<std::mutex> lock(mWriter);
+
+    bool inserted = false;
+
+    try
+    {
+        Node* root = mRoot.load(std::memory_order_relaxed);
+        Node* updated = InsertNode(root, key, false, inserted, std::forward<ARGS>(args)...);
+
+        if(inserted)
+            Publish(updated, mSize.load(std::memory_order_relaxed) + 1);
+    }
+    catch(...)
+    {
+        Abandon();
+        throw;
+    }
+
+    return inserted;
+}
+
+/**
+ * @brief Inserts the key with the value, or gives the key the value if it is already there
+ *        (its node is replaced by a copy holding the new value).
+ *
+ * @param key - key to insert or assign
+ * @param obj - value
+ * @return true if the key was inserted, false if it was assigned
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename COMPARE, typename ALLOCATOR >
+template< typename M >
+bool CS280::ConcurrentAVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR>::insert_or_assign(KEY_TYPE const& key, M&& obj)
+{
+    std::lock_guard<std::mutex> lock(mWriter);
+
+    bool inserted = false;
+
+    try
+    {
+        Node* root = mRoot.load(std::memory_order_relaxed);
+        Node* updated = InsertNode(root, key, true, inserted, std::forward<M>(obj));
+
+        Publish(updated, mSize.load(std::memory_order_relaxed) + (inserted ? 1 : 0));
+    }
+    catch(...)
+    {
+        Abandon();
+        throw;
+    }
+
+    return inserted;
+}
+
+/**
+ * @brief Erases the node with the given key, if there is one.
+ *
+ * @param key - key to erase
+ * @return the number of nodes erased (0 or 1)
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename COMPARE, typename ALLOCATOR >
+unsigned int CS280::ConcurrentAVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR>::erase(KEY_TYPE const& key)
+{
+    std::lock_guard<std::mutex> lock(mWriter);
+
+    bool erased = false;
+
+    try
+    {
+        Node* root = mRoot.load(std::memory_order_relaxed);
+        Node* updated = EraseNode(root, key, erased);
+
+        if(erased)
+            Publish(updated, mSize.load(std::memory_order_relaxed) - 1);
+    }
+    catch(...)
+    {
+        Abandon();
+        throw;
+    }
+
+    return erased ? 1 : 0;
+}
+
+/**
+ * @brief Erases every node. Readers still walking the old version keep seeing it until they are done.
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename COMPARE, typename ALLOCATOR >
+void CS280::ConcurrentAVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR>::clear()
+{
+    std::lock_guard<std::mutex> lock(mWriter);
+
+    Node* root = mRoot.load(std::memory_order_relaxed);
+
+    if(root == nullptr)
+        return;
+
+    try
+    {
+        CollectTree(root, mReplaced);
+        Publish(nullptr, 0);
+    }
+    catch(...)
+    {
+        Abandon();
+        throw;
+    }
+}
+
+/**
+ * @brief Checks the key order, the heights and the balance of the latest version, and that nothing
+ *        reachable is still marked fresh. Takes the writer lock.
+ *
+ * @return whether the tree is a valid AVL tree holding size() nodes
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename COMPARE, typename ALLOCATOR >
+bool CS280::ConcurrentAVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR>::sanityCheck() const
+{
+    std::lock_guard<std::mutex> lock(mWriter);
+
+    unsigned int count = 0;
+
+    if(CheckSubtree(mRoot.load(), count) < -1)
+        return false;
+
+    return count == mSize.load();
+}
+
+/**
+ * @brief Finds the node with the given key in a subtree
+ *
+ * @param tree - subtree to search
+ * @param key - key to find
+ * @return the node, or null if the key is missing
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename COMPARE, typename ALLOCATOR >
+typename CS280::ConcurrentAVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR>::Node* CS280::ConcurrentAVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR>::FindNode(Node* tree, KEY_TYPE const& key) const
+{
+    while(tree != nullptr)
+    {
+        if(mCompare(key, tree->key))
+        {
+            tree = tree->left;
+        }
+        else if(mCompare(tree->key, key))
+        {
+            tree = tree->right;
+        }
+        else
+        {
+            return tree;
+        }
+    }
+
+    return nullptr;
+}
+
+/**
+ * @brief Calls a function for every node of a subtree in key order
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename COMPARE, typename ALLOCATOR >
+template< typename FUNC >
+void CS280::ConcurrentAVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR>::ForEach(Node* tree, FUNC& f)
+{
+    if(tree == nullptr)
+        return;
+
+    ForEach(tree->left, f);
+    f(static_cast<KEY_TYPE const&>(tree->key), static_cast<VALUE_TYPE const&>(tree->value));
+    ForEach(tree->right, f);
+}
+
+/**
+ * @brief Inserts the key into a copy of a subtree. Only the nodes on the path to the key are copied,
+ *        a subtree that doesn't change is returned as it is.
+ *
+ * @param tree - subtree to insert into
+ * @param key - key to insert
+ * @param assign - whether a node already holding the key gets a copy with the new value
+ * @param inserted - set to true when a node was added
+ * @param args - value constructor arguments
+ * @return the new (or unchanged) subtree
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename COMPARE, typename ALLOCATOR >
+template< typename... ARGS >
+typename CS280::ConcurrentAVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR>::Node* CS280::ConcurrentAVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR>::InsertNode(Node* tree, KEY_TYPE const& key, bool assign, bool& inserted, ARGS&&... args)
+{
+    if(tree == nullptr)
+    {
+        inserted = true;
+        return CreateNode(key, std::forward<ARGS>(args)...);
+    }
+
+    if(mCompare(key, tree->key))
+    {
+        Node* left = InsertNode(tree->left, key, assign, inserted, std::forward<ARGS>(args)...);
+
+        if(left == tree->left)
+            return tree;
+
+        return Rebalance(Rebuild(tree, left, tree->right));
+    }
+
+    if(mCompare(tree->key, key))
+    {
+        Node* right = InsertNode(tree->right, key, assign, inserted, std::forward<ARGS>(args)...);
+
+        if(right == tree->right)
+            return tree;
+
+        return Rebalance(Rebuild(tree, tree->left, right));
+    }
+
+    if(!assign)
+        return tree;
+
+    // Same shape, new value
+    Node* node = CreateNode(tree->key, std::forward<ARGS>(args)...);
+    node->left = tree->left;
+    node->right = tree->right;
+    node->height = tree->height;
+
+    mReplaced.push_back(tree);
+    return node;
+}
+
+/**
+ * @brief Erases the key from a copy of a subtree. A node with two children is replaced by a copy of its successor.
+ *
+ * @param tree - subtree to erase from
+ * @param key - key to erase
+ * @param erased - set to true when a node was removed
+ * @return the new (or unchanged) subtree
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename COMPARE, typename ALLOCATOR >
+typename CS280::ConcurrentAVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR>::Node* CS280::ConcurrentAVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR>::EraseNode(Node* tree, KEY_TYPE const& key, bool& erased)
+{
+    if(tree == nullptr)
+        return nullptr;
+
+    if(mCompare(key, tree->key))
+    {
+        Node* left = EraseNode(tree->left, key, erased);
+
+        if(left == tree->left)
+            return tree;
+
+        return Rebalance(Rebuild(tree, left, tree->right));
+    }
+
+    if(mCompare(tree->key, key))
+    {
+        Node* right = EraseNode(tree->right, key, erased);
+
+        if(right == tree->right)
+            return tree;
+
+        return Rebalance(Rebuild(tree, tree->left, right));
+    }
+
+    erased = true;
+    mReplaced.push_back(tree);
+
+    if(tree->left == nullptr)
+        return tree->right;
+
+    if(tree->right == nullptr)
+        return tree->left;
+
+    Node* first;
+    Node* right = RemoveFirst(tree->right, first);
+
+    return Rebalance(Rebuild(first, tree->left, right));
+}
+
+/**
+ * @brief Unlinks the minimum from a copy of a subtree
+ *
+ * @param tree - subtree, not empty
+ * @param first - set to the minimum (still published, the caller rebuilds it)
+ * @return the new subtree
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename COMPARE, typename ALLOCATOR >
+typename CS280::ConcurrentAVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR>::Node* CS280::ConcurrentAVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR>::RemoveFirst(Node* tree, Node*& first)
+{
+    if(tree->left == nullptr)
+    {
+        first = tree;
+        return tree->right;
+    }
+
+    Node* left = RemoveFirst(tree->left, first);
+
+    return Rebalance(Rebuild(tree, left, tree->right));
+}
+
+/**
+ * @brief Restores the balance of a fresh node whose subtrees differ in height by at most 2,
+ *        rebuilding the nodes the rotation moves.
+ *
+ * @param node - fresh node
+ * @return root of the balanced subtree
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename COMPARE, typename ALLOCATOR >
+typename CS280::ConcurrentAVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR>::Node* CS280::ConcurrentAVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR>::Rebalance(Node* node)
+{
+    int balance = Height(node->left) - Height(node->right);
+
+    if(balance > 1)
+    {
+        Node* child = node->left;
+
+        if(Height(child->left) >= Height(child->right))
+        {
+            // Single right rotation
+            Node* lower = Rebuild(node, child->right, node->right);
+            return Rebuild(child, child->left, lower);
+        }
+
+        // Left-right, the child's right child comes up two levels
+        Node* grandchild = child->right;
+        Node* left = Rebuild(child, child->left, grandchild->left);
+        Node* right = Rebuild(node, grandchild->right, node->right);
+
+        return Rebuild(grandchild, left, right);
+    }
+
+    if(balance < -1)
+    {
+        Node* child = node->right;
+
+        if(Height(child->right) >= Height(child->left))
+        {
+            // Single left rotation
+            Node* lower = Rebuild(node, node->left, child->left);
+            return Rebuild(child, lower, child->right);
+        }
+
+        // Right-left, the child's left child comes up two levels
+        Node* grandchild = child->left;
+        Node* left = Rebuild(node, node->left, grandchild->left);
+        Node* right = Rebuild(child, grandchild->right, child->right);
+
+        return Rebuild(grandchild, left, right);
+    }
+
+    return node;
+}
+
+/**
+ * @brief Gives a node new children. A fresh node is changed in place, a published one is copied
+ *        (and the original retired once the write is published).
+ *
+ * @param node - node to rebuild
+ * @param left - new left subtree
+ * @param right - new right subtree
+ * @return the fresh node with the new children and height
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename COMPARE, typename ALLOCATOR >
+typename CS280::ConcurrentAVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR>::Node* CS280::ConcurrentAVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR>::Rebuild(Node* node, Node* left, Node* right)
+{
+    if(!node->fresh)
+    {
+        Node* copy = CreateNode(node->key, node->value);
+        mReplaced.push_back(node);
+        node = copy;
+    }
+
+    node->left = left;
+    node->right = right;
+    node->height = 1 + std::max(Height(left), Height(right));
+
+    return node;
+}
+
+/**
+ * @brief Builds a fresh leaf and tracks it, so it is freed if the write fails
+ *
+ * @param args - key and value constructor arguments
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename COMPARE, typename ALLOCATOR >
+template< typename... ARGS >
+typename CS280::ConcurrentAVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR>::Node* CS280::ConcurrentAVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR>::CreateNode(ARGS&&... args)
+{
+    // Room first, so a built node is never left untracked
+    mFresh.push_back(nullptr);
+
+    Node* node = std::allocator_traits<NodeAllocator>::allocate(mAlloc, 1);
+
+    try
+    {
+        std::allocator_traits<NodeAllocator>::construct(mAlloc, node, std::forward<ARGS>(args)...);
+    }
+    catch(...)
+    {
+        std::allocator_traits<NodeAllocator>::deallocate(mAlloc, node, 1);
+        mFresh.pop_back();
+        throw;
+    }
+
+    mFresh.back() = node;
+    return node;
+}
+
+/**
+ * @brief Makes the write visible: the fresh nodes become read-only, the new root is stored
+ *        and the nodes the write replaced are retired.
+ *
+ * @param root - new root
+ * @param size - new number of nodes
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename COMPARE, typename ALLOCATOR >
+void CS280::ConcurrentAVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR>::Publish(Node* root, unsigned int size)
+{
+    // The only step that can throw, done while the write can still be abandoned
+    mRetired.reserve(mRetired.size() + mReplaced.size());
+
+    for(Node* node : mFresh)
+    {
+        node->fresh = false;
+    }
+
+    mFresh.clear();
+
+    mRoot.store(root);
+    mSize.store(size, std::memory_order_relaxed);
+
+    Retire(mReplaced);
+    TryReclaim();
+}
+
+/**
+ * @brief Throws away a write that failed part way: its fresh nodes are freed, the published tree was never touched.
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename COMPARE, typename ALLOCATOR >
+void CS280::ConcurrentAVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR>::Abandon()
+{
+    DestroyNodes(mFresh);
+    mReplaced.clear();
+}
+
+/**
+ * @brief Moves unlinked nodes to the retired list of the current epoch (the list has room for them)
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename COMPARE, typename ALLOCATOR >
+void CS280::ConcurrentAVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR>::Retire(std::vector<Node*>& nodes)
+{
+    mRetired.insert(mRetired.end(), nodes.begin(), nodes.end());
+    nodes.clear();
+}
+
+/**
+ * @brief Frees retired nodes that no reader can reach any more. Once a batch has been retired, the nodes of
+ *        the previous epoch are freed if its readers are gone, and the epoch is changed, so the new batch
+ *        is freed once the readers that entered before the change are gone. Never waits for readers.
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename COMPARE, typename ALLOCATOR >
+void CS280::ConcurrentAVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR>::TryReclaim()
+{
+    if(mRetired.size() < mNextReclaim)
+        return;
+
+    if(!mDraining.empty())
+    {
+        if(Readers(mDrainParity) != 0)
+        {
+            // A reader is still in the old epoch, wait for another batch before looking again
+            mNextReclaim = mRetired.size() + RECLAIM_BATCH;
+            return;
+        }
+
+        DestroyNodes(mDraining);
+    }
+
+    mDraining.swap(mRetired);
+    mDrainParity = mEpoch.fetch_add(1) & 1;
+    mNextReclaim = RECLAIM_BATCH;
+
+    // Short reads are usually over already
+    if(Readers(mDrainParity) == 0)
+        DestroyNodes(mDraining);
+}
+
+/**
+ * @brief Returns the number of readers inside the epochs of the given parity
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename COMPARE, typename ALLOCATOR >
+unsigned long CS280::ConcurrentAVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR>::Readers(unsigned long parity) const
+{
+    unsigned long readers = 0;
+
+    for(ReaderStripe const& stripe : mStripes)
+    {
+        readers += stripe.readers[parity].load();
+    }
+
+    return readers;
+}
+
+/**
+ * @brief Destroys a node and gives its memory back
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename COMPARE, typename ALLOCATOR >
+void CS280::ConcurrentAVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR>::DestroyNode(Node* node)
+{
+    std::allocator_traits<NodeAllocator>::destroy(mAlloc, node);
+    std::allocator_traits<NodeAllocator>::deallocate(mAlloc, node, 1);
+}
+
+/**
+ * @brief Destroys every node of a list and empties it
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename COMPARE, typename ALLOCATOR >
+void CS280::ConcurrentAVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR>::DestroyNodes(std::vector<Node*>& nodes)
+{
+    for(Node* node : nodes)
+    {
+        DestroyNode(node);
+    }
+
+    nodes.clear();
+}
+
+/**
+ * @brief Adds every node of a subtree to a list
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename COMPARE, typename ALLOCATOR >
+void CS280::ConcurrentAVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR>::CollectTree(Node* tree, std::vector<Node*>& nodes)
+{
+    if(tree == nullptr)
+        return;
+
+    nodes.push_back(tree);
+    CollectTree(tree->left, nodes);
+    CollectTree(tree->right, nodes);
+}
+
+/**
+ * @brief Returns the height of a subtree (-1 when empty)
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename COMPARE, typename ALLOCATOR >
+int CS280::ConcurrentAVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR>::Height(Node* node)
+{
+    return node == nullptr ? -1 : node->height;
+}
+
+/**
+ * @brief Checks a subtree for sanityCheck
+ *
+ * @param node - subtree root
+ * @param count - incremented for every node
+ * @return height of the subtree (-1 when empty), or -2 if something is wrong
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename COMPARE, typename ALLOCATOR >
+int CS280::ConcurrentAVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR>::CheckSubtree(Node* node, unsigned int& count) const
+{
+    if(node == nullptr)
+        return -1;
+
+    if(node->fresh || ++count > mSize.load())
+        return -2;
+
+    if(node->left != nullptr && !mCompare(node->left->key, node->key))
+        return -2;
+
+    if(node->right != nullptr && !mCompare(node->key, node->right->key))
+        return -2;
+
+    int leftHeight = CheckSubtree(node->left, count);
+    int rightHeight = CheckSubtree(node->right, count);
+
+    if(leftHeight < -1 || rightHeight < -1 || std::abs(leftHeight - rightHeight) > 1 || node->height != 1 + std::max(leftHeight, rightHeight))
+        return -2;
+
+    return node->height;
+}
+
+/**
+ * @brief Returns the reader stripe of the calling thread. Threads are spread over the stripes in the order they first read.
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename COMPARE, typename ALLOCATOR >
+unsigned int CS280::ConcurrentAVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR>::ThreadStripe()
+{
+    static std::atomic<unsigned int> next(0);
+    thread_local unsigned int stripe = next.fetch_add(1, std::memory_order_relaxed) % READER_STRIPES;
+
+    return stripe;
+}
+
+/**
+ * @brief Builds a fresh leaf: the key from k, the value from val
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename COMPARE, typename ALLOCATOR >
+template< typename KEY_ARG, typename... VALUE_ARGS >
+CS280::ConcurrentAVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR>::Node::Node(KEY_ARG&& k, VALUE_ARGS&&... val)
+    : key(std::forward<KEY_ARG>(k)), value(std::forward<VALUE_ARGS>(val)...), height(0), left(nullptr), right(nullptr), fresh(true)
+{
+
+}
+
+/**
+ * @brief Enters the current epoch. If the epoch changes while entering, the reader might have been counted
+ *        too late for the writer to see it, so it enters again.
+ *
+ * @param map - map about to be read
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename COMPARE, typename ALLOCATOR >
+CS280::ConcurrentAVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR>::ReadGuard::ReadGuard(ConcurrentAVLmap const& map)
+{
+    ReaderStripe& stripe = map.mStripes[ThreadStripe()];
+
+    for(;;)
+    {
+        unsigned long epoch = map.mEpoch.load();
+
+        counter = &stripe.readers[epoch & 1];
+        counter->fetch_add(1);
+
+        if(map.mEpoch.load() == epoch)
+            break;
+
+        counter->fetch_sub(1);
+    }
+}
+
+/**
+ * @brief Leaves the epoch, the nodes the reader saw may be freed after this
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename COMPARE, typename ALLOCATOR >
+CS280::ConcurrentAVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR>::ReadGuard::~ReadGuard()
+{
+    counter->fetch_sub(1, std::memory_order_release);
+}
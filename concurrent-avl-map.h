@@ -0,0 +1,149 @@
+/**
+ * @file concurrent-avl-map.h
+ * @brief An AVL map that many threads can read while one thread writes. Published nodes are never changed:
+ *        a write copies the nodes on its root path (and the ones its rotations touch) and then swaps in the
+ *        new root, so a reader always walks one consistent version without taking a lock.
+ *        Replaced nodes are freed once every reader that could still see them has left (epoch based reclamation).
+ */
+
+#ifndef CONCURRENT_AVLMAP_H
+#define CONCURRENT_AVLMAP_H
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdlib>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+namespace CS280 {
+
+    // COMPARE orders the keys, ALLOCATOR supplies the memory for the nodes (it is rebound internally)
+    // Writes copy nodes, so keys and values must be copy constructible
+    template< typename KEY_TYPE, typename VALUE_TYPE, typename COMPARE = std::less<KEY_TYPE>,
+              typename ALLOCATOR = std::allocator< std::pair<const KEY_TYPE, VALUE_TYPE> > >
+    class ConcurrentAVLmap {
+		private:
+
+			struct Node
+			{
+				template< typename KEY_ARG, typename... VALUE_ARGS >
+				Node( KEY_ARG&& k, VALUE_ARGS&&... val );
+
+				KEY_TYPE    key;
+				VALUE_TYPE  value;
+				int         height; // subtree height (leaf is 0)
+				Node        *left;
+				Node        *right;
+				bool        fresh; // built by the write in progress, not reachable by readers yet so it can still change
+			};
+
+			typedef typename std::allocator_traits<ALLOCATOR>::template rebind_alloc<Node> NodeAllocator;
+
+			// readers count themselves in one of two counters of their stripe, picked by the parity of the epoch
+			// they entered in. Stripes keep readers on different cores from fighting over one cache line.
+			struct alignas(64) ReaderStripe
+			{
+				std::atomic<unsigned long> readers[2];
+			};
+
+			// pins the current epoch for as long as a reader walks the tree
+			class ReadGuard
+			{
+				public:
+					explicit ReadGuard(ConcurrentAVLmap const& map);
+					~ReadGuard();
+
+					ReadGuard(const ReadGuard&)               = delete;
+					ReadGuard& operator=(const ReadGuard&)    = delete;
+				private:
+					std::atomic<unsigned long>* counter;
+			};
+
+			static constexpr unsigned int READER_STRIPES = 64;
+			static constexpr std::size_t RECLAIM_BATCH = 256; // retired nodes to collect before trying to free them
+
+			// ConcurrentAVLmap implementation, shared with readers
+			std::atomic<Node*>          mRoot;
+			std::atomic<unsigned int>   mSize;
+			std::atomic<unsigned long>  mEpoch;
+			mutable ReaderStripe        mStripes[READER_STRIPES];
+			COMPARE                     mCompare;
+
+			// only touched by the writer holding mWriter
+			mutable std::mutex          mWriter;
+			NodeAllocator               mAlloc;
+			std::vector<Node*>          mFresh; // nodes built by the write in progress
+			std::vector<Node*>          mReplaced; // published nodes the write in progress copied or unlinked
+			std::vector<Node*>          mRetired; // unlinked in the current epoch
+			std::vector<Node*>          mDraining; // unlinked before the last epoch change, freed when its readers are gone
+			unsigned long               mDrainParity = 0;
+			std::size_t                 mNextReclaim = RECLAIM_BATCH;
+
+		public:
+			ConcurrentAVLmap();
+			explicit ConcurrentAVLmap(ALLOCATOR const& alloc);
+			explicit ConcurrentAVLmap(COMPARE const& comp, ALLOCATOR const& alloc = ALLOCATOR());
+			ConcurrentAVLmap(const ConcurrentAVLmap&)               = delete;
+			ConcurrentAVLmap& operator=(const ConcurrentAVLmap&)    = delete;
+			~ConcurrentAVLmap(); // no reader or writer may still be using the map
+
+			typedef std::pair<KEY_TYPE, VALUE_TYPE> value_type;
+
+			unsigned int size() const;
+			COMPARE key_comp() const;
+
+			//readers, lock free and safe to call from any number of threads at once
+			bool contains(KEY_TYPE const& key) const;
+			bool get(KEY_TYPE const& key, VALUE_TYPE& value) const; // copies the value out, false if the key is missing
+			//calls f(value) while the node can't be freed, false if the key is missing
+			template< typename FUNC >
+			bool visit(KEY_TYPE const& key, FUNC&& f) const;
+			//calls f(key, value) for every node in key order, all from the same version of the map
+			template< typename FUNC >
+			void for_each(FUNC&& f) const;
+
+			//writers, serialized with each other, never block readers
+			bool insert(value_type const& item); // false if the key is already there
+			template< typename... ARGS >
+			bool try_emplace(KEY_TYPE const& key, ARGS&&... args); // value is only built if the key is missing
+			template< typename M >
+			bool insert_or_assign(KEY_TYPE const& key, M&& obj); // true if the key was inserted, false if assigned
+			unsigned int erase(KEY_TYPE const& key); // returns the number of nodes erased
+			void clear();
+
+			bool sanityCheck() const;
+		private:
+			Node* FindNode(Node* tree, KEY_TYPE const& key) const;
+			template< typename FUNC >
+			static void ForEach(Node* tree, FUNC& f);
+
+			template< typename... ARGS >
+			Node* InsertNode(Node* tree, KEY_TYPE const& key, bool assign, bool& inserted, ARGS&&... args);
+			Node* EraseNode(Node* tree, KEY_TYPE const& key, bool& erased);
+			Node* RemoveFirst(Node* tree, Node*& first);
+			Node* Rebalance(Node* node);
+			Node* Rebuild(Node* node, Node* left, Node* right);
+
+			template< typename... ARGS >
+			Node* CreateNode(ARGS&&... args);
+			void Publish(Node* root, unsigned int size);
+			void Abandon();
+			void Retire(std::vector<Node*>& nodes);
+			void TryReclaim();
+			unsigned long Readers(unsigned long parity) const;
+			void DestroyNode(Node* node);
+			void DestroyNodes(std::vector<Node*>& nodes);
+			void CollectTree(Node* tree, std::vector<Node*>& nodes);
+
+			static int Height(Node* node);
+			int CheckSubtree(Node* node, unsigned int& count) const;
+			static unsigned int ThreadStripe();
+	};
+}
+
+#include "concurrent-avl-map.cpp"
+#endif
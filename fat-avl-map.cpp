@@ -0,0 +1,1558 @@
+/**
+ * @file fat-avl-map.cpp
+ * @brief This implements the fat node map. A lookup walks down the inner nodes, taking the child after the last
+ *        key not greater than the key, and finds the key's slot in the leaf by counting the keys less than it.
+ *        Both counts compare the key with a node's whole key line at once. A full node splits in half and hands
+ *        a key to its parent, a node that drops below half borrows from a sibling or merges with it, so the tree
+ *        only grows or shrinks at the root and every leaf stays at the same depth.
+ */
+
+#include "fat-avl-map.h"
+
+/**
+ * @brief Construct the map, it starts without a node
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename ALLOCATOR >
+CS280::FatAVLmap<KEY_TYPE,VALUE_TYPE,ALLOCATOR>::FatAVLmap()
+{
+
+}
+
+/**
+ * @brief Construct the map with the allocator that supplies the nodes
+ *
+ * @param alloc - allocator for the nodes
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename ALLOCATOR >
+CS280::FatAVLmap<KEY_TYPE,VALUE_TYPE,ALLOCATOR>::FatAVLmap(ALLOCATOR const& alloc) : mLeafAlloc(alloc), mInnerAlloc(alloc)
+{
+
+}
+
+/**
+ * @brief Copy constructor. The nodes are copied one for one, so the copy has the same shape
+ *        and no key is searched for.
+ *
+ * @param rhs - map to copy
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename ALLOCATOR >
+CS280::FatAVLmap<KEY_TYPE,VALUE_TYPE,ALLOCATOR>::FatAVLmap(const FatAVLmap& rhs)
+    : mLeafAlloc(std::allocator_traits<LeafAllocator>::select_on_container_copy_construction(rhs.mLeafAlloc)),
+      mInnerAlloc(std::allocator_traits<InnerAllocator>::select_on_container_copy_construction(rhs.mInnerAlloc))
+{
+    if(rhs.mRoot == nullptr)
+        return;
+
+    Leaf* last = nullptr;
+
+    mRoot = CopyTree(rhs.mRoot, rhs.mLevels, nullptr, last);
+    mLevels = rhs.mLevels;
+    size_ = rhs.size_;
+}
+
+/**
+ * @brief Move constructor. Takes rhs's nodes.
+ *
+ * @param rhs - map to move
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename ALLOCATOR >
+CS280::FatAVLmap<KEY_TYPE,VALUE_TYPE,ALLOCATOR>::FatAVLmap(FatAVLmap&& rhs)
+    : mRoot(rhs.mRoot), mLevels(rhs.mLevels), size_(rhs.size_), mLeafAlloc(rhs.mLeafAlloc), mInnerAlloc(rhs.mInnerAlloc)
+{
+    rhs.mRoot = nullptr;
+    rhs.mLevels = 0;
+    rhs.size_ = 0;
+}
+
+/**
+ * @brief Assignment operator. Copies rhs first, so this map is unchanged if a copy throws.
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename ALLOCATOR >
+typename CS280::FatAVLmap<KEY_TYPE,VALUE_TYPE,ALLOCATOR>::FatAVLmap& CS280::FatAVLmap<KEY_TYPE,VALUE_TYPE,ALLOCATOR>::operator=(const FatAVLmap& rhs)
+{
+    if(this != &rhs)
+    {
+        FatAVLmap copy(rhs);
+        *this = std::move(copy);
+    }
+
+    return *this;
+}
+
+/**
+ * @brief Move assignment operator. Swaps the trees with rhs.
+ *
+ * @param rhs - map to move into this map
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename ALLOCATOR >
+typename CS280::FatAVLmap<KEY_TYPE,VALUE_TYPE,ALLOCATOR>::FatAVLmap& CS280::FatAVLmap<KEY_TYPE,VALUE_TYPE,ALLOCATOR>::operator=(FatAVLmap&& rhs)
+{
+    std::swap(mRoot, rhs.mRoot);
+    std::swap(mLevels, rhs.mLevels);
+    std::swap(size_, rhs.size_);
+    std::swap(mLeafAlloc, rhs.mLeafAlloc);
+    std::swap(mInnerAlloc, rhs.mInnerAlloc);
+
+    return *this;
+}
+
+/**
+ * @brief Destructor. Destroys the entries and frees the nodes.
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename ALLOCATOR >
+CS280::FatAVLmap<KEY_TYPE,VALUE_TYPE,ALLOCATOR>::~FatAVLmap()
+{
+    clear();
+}
+
+/**
+ * @brief Returns the size (number of entries) in the map
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename ALLOCATOR >
+unsigned int CS280::FatAVLmap<KEY_TYPE,VALUE_TYPE,ALLOCATOR>::size() const
+{
+    return size_;
+}
+
+/**
+ * @brief Returns the allocator the nodes come from
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename ALLOCATOR >
+ALLOCATOR CS280::FatAVLmap<KEY_TYPE,VALUE_TYPE,ALLOCATOR>::get_allocator() const
+{
+    return ALLOCATOR(mLeafAlloc);
+}
+
+/**
+ * @brief Erases every entry and frees every node
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename ALLOCATOR >
+void CS280::FatAVLmap<KEY_TYPE,VALUE_TYPE,ALLOCATOR>::clear()
+{
+    if(mRoot != nullptr)
+        DestroyTree(mRoot, mLevels);
+
+    mRoot = nullptr;
+    mLevels = 0;
+    size_ = 0;
+}
+
+/**
+ * @brief Finds the value of the key, inserting a default value if the key is missing
+ *
+ * @param key - key to find
+ * @return the value of the key
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename ALLOCATOR >
+VALUE_TYPE& CS280::FatAVLmap<KEY_TYPE,VALUE_TYPE,ALLOCATOR>::operator[](KEY_TYPE const& key)
+{
+    // Find the entry or insert a default value in the same descent
+    return TryEmplace(key).first->Value();
+}
+
+/**
+ * @brief Returns the begin iterator of the map
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename ALLOCATOR >
+typename CS280::FatAVLmap<KEY_TYPE,VALUE_TYPE,ALLOCATOR>::FatAVLmap_iterator CS280::FatAVLmap<KEY_TYPE,VALUE_TYPE,ALLOCATOR>::begin()
+{
+    return FatAVLmap_iterator(this, FirstLeaf(), 0);
+}
+
+/**
+ * @brief Returns the end iterator
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename ALLOCATOR >
+typename CS280::FatAVLmap<KEY_TYPE,VALUE_TYPE,ALLOCATOR>::FatAVLmap_iterator CS280::FatAVLmap<KEY_TYPE,VALUE_TYPE,ALLOCATOR>::end()
+{
+    return FatAVLmap_iterator(this, nullptr, 0);
+}
+
+/**
+ * @brief Returns the reverse begin iterator (the last entry)
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename ALLOCATOR >
+typename CS280::FatAVLmap<KEY_TYPE,VALUE_TYPE,ALLOCATOR>::reverse_iterator CS280::FatAVLmap<KEY_TYPE,VALUE_TYPE,ALLOCATOR>::rbegin()
+{
+    return reverse_iterator(end());
+}
+
+/**
+ * @brief Returns the reverse end iterator (before the first entry)
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename ALLOCATOR >
+typename CS280::FatAVLmap<KEY_TYPE,VALUE_TYPE,ALLOCATOR>::reverse_iterator CS280::FatAVLmap<KEY_TYPE,VALUE_TYPE,ALLOCATOR>::rend()
+{
+    return reverse_iterator(begin());
+}
+
+/**
+ * @brief Finds the entry of given key and returns as an iterator
+ *
+ * @param key - key to find
+ * @return the entry, or end if the key is missing
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename ALLOCATOR >
+typename CS280::FatAVLmap<KEY_TYPE,VALUE_TYPE,ALLOCATOR>::FatAVLmap_iterator CS280::FatAVLmap<KEY_TYPE,VALUE_TYPE,ALLOCATOR>::find(KEY_TYPE const& key)
+{
+    unsigned int slot = 0;
+    Leaf* leaf = FindEntry(key, slot);
+
+    return FatAVLmap_iterator(this, leaf, slot);
+}
+
+/**
+ * @brief Erase an entry from the map based off the given iterator. Every other iterator is invalidated.
+ *        When the leaf stays at least half full the following entry only shifts down a slot, otherwise
+ *        the leaf borrowed or merged and the following entry is found again by its key.
+ *
+ * @param it - entry to erase
+ * @return iterator to the entry after the erased one, or end
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename ALLOCATOR >
+typename CS280::FatAVLmap<KEY_TYPE,VALUE_TYPE,ALLOCATOR>::FatAVLmap_iterator CS280::FatAVLmap<KEY_TYPE,VALUE_TYPE,ALLOCATOR>::erase(FatAVLmap_iterator it)
+{
+    Leaf* leaf = it.mLeaf;
+    unsigned int slot = it.mSlot;
+
+    if(leaf == nullptr)
+        return end();
+
+    bool last = slot + 1 == leaf->count && leaf->next == nullptr;
+    KEY_TYPE next = last ? KEY_TYPE() : slot + 1 < leaf->count ? leaf->keys[slot + 1] : leaf->next->keys[0];
+    bool stays = leaf->parent == nullptr || leaf->count > MIN_LEAF_KEYS;
+
+    EraseEntry(leaf, slot);
+
+    if(last)
+        return end();
+
+    if(!stays)
+        return lower_bound(next);
+
+    return slot < leaf->count ? FatAVLmap_iterator(this, leaf, slot) : FatAVLmap_iterator(this, leaf->next, 0);
+}
+
+/**
+ * @brief Erases the entry with the given key, if there is one.
+ *
+ * @param key - key to erase
+ * @return the number of entries erased (0 or 1)
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename ALLOCATOR >
+unsigned int CS280::FatAVLmap<KEY_TYPE,VALUE_TYPE,ALLOCATOR>::erase(KEY_TYPE const& key)
+{
+    unsigned int slot = 0;
+    Leaf* leaf = FindEntry(key, slot);
+
+    if(leaf == nullptr)
+        return 0;
+
+    EraseEntry(leaf, slot);
+    return 1;
+}
+
+/**
+ * @brief Returns the first entry with a key not less than the given key
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename ALLOCATOR >
+typename CS280::FatAVLmap<KEY_TYPE,VALUE_TYPE,ALLOCATOR>::FatAVLmap_iterator CS280::FatAVLmap<KEY_TYPE,VALUE_TYPE,ALLOCATOR>::lower_bound(KEY_TYPE const& key)
+{
+    unsigned int slot = 0;
+    Leaf* leaf = LowerBound(key, slot);
+
+    return FatAVLmap_iterator(this, leaf, slot);
+}
+
+/**
+ * @brief Returns the first entry with a key greater than the given key
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename ALLOCATOR >
+typename CS280::FatAVLmap<KEY_TYPE,VALUE_TYPE,ALLOCATOR>::FatAVLmap_iterator CS280::FatAVLmap<KEY_TYPE,VALUE_TYPE,ALLOCATOR>::upper_bound(KEY_TYPE const& key)
+{
+    unsigned int slot = 0;
+    Leaf* leaf = UpperBound(key, slot);
+
+    return FatAVLmap_iterator(this, leaf, slot);
+}
+
+/**
+ * @brief Inserts a copy of the pair if its key is not in the map yet.
+ *
+ * @param item - key and value to insert
+ * @return the entry with the key, and whether it was inserted
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename ALLOCATOR >
+std::pair<typename CS280::FatAVLmap<KEY_TYPE,VALUE_TYPE,ALLOCATOR>::FatAVLmap_iterator, bool> CS280::FatAVLmap<KEY_TYPE,VALUE_TYPE,ALLOCATOR>::insert(value_type const& item)
+{
+    return TryEmplace(item.first, item.second);
+}
+
+/**
+ * @brief Inserts the pair, moving the value into the entry, if its key is not in the map yet.
+ *
+ * @param item - key and value to insert
+ * @return the entry with the key, and whether it was inserted
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename ALLOCATOR >
+std::pair<typename CS280::FatAVLmap<KEY_TYPE,VALUE_TYPE,ALLOCATOR>::FatAVLmap_iterator, bool> CS280::FatAVLmap<KEY_TYPE,VALUE_TYPE,ALLOCATOR>::insert(value_type&& item)
+{
+    return TryEmplace(item.first, std::move(item.second));
+}
+
+/**
+ * @brief Builds the value from args only if the key is missing.
+ *
+ * @param key - key to insert
+ * @param args - value constructor arguments
+ * @return the entry with the key, and whether it was inserted
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename ALLOCATOR >
+template< typename... ARGS >
+std::pair<typename CS280::FatAVLmap<KEY_TYPE,VALUE_TYPE,ALLOCATOR>::FatAVLmap_iterator, bool> CS280::FatAVLmap<KEY_TYPE,VALUE_TYPE,ALLOCATOR>::try_emplace(KEY_TYPE const& key, ARGS&&... args)
+{
+    return TryEmplace(key, std::forward<ARGS>(args)...);
+}
+
+/**
+ * @brief Returns the begin iterator of the map
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename ALLOCATOR >
+typename CS280::FatAVLmap<KEY_TYPE,VALUE_TYPE,ALLOCATOR>::FatAVLmap_iterator_const CS280::FatAVLmap<KEY_TYPE,VALUE_TYPE,ALLOCATOR>::begin() const
+{
+    return FatAVLmap_iterator_const(this, FirstLeaf(), 0);
+}
+
+/**
+ * @brief Returns the end iterator
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename ALLOCATOR >
+typename CS280::FatAVLmap<KEY_TYPE,VALUE_TYPE,ALLOCATOR>::FatAVLmap_iterator_const CS280::FatAVLmap<KEY_TYPE,VALUE_TYPE,ALLOCATOR>::end() const
+{
+    return FatAVLmap_iterator_const(this, nullptr, 0);
+}
+
+/**
+ * @brief Returns the reverse begin iterator (the last entry)
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename ALLOCATOR >
+typename CS280::FatAVLmap<KEY_TYPE,VALUE_TYPE,ALLOCATOR>::const_reverse_iterator CS280::FatAVLmap<KEY_TYPE,VALUE_TYPE,ALLOCATOR>::rbegin() const
+{
+    return const_reverse_iterator(end());
+}
+
+/**
+ * @brief Returns the reverse end iterator (before the first entry)
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename ALLOCATOR >
+typename CS280::FatAVLmap<KEY_TYPE,VALUE_TYPE,ALLOCATOR>::const_reverse_iterator CS280::FatAVLmap<KEY_TYPE,VALUE_TYPE,ALLOCATOR>::rend() const
+{
+    return const_reverse_iterator(begin());
+}
+
+/**
+ * @brief Finds the entry of given key and returns as a const iterator
+ *
+ * @param key - key to find
+ * @return the entry, or end if the key is missing
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename ALLOCATOR >
+typename CS280::FatAVLmap<KEY_TYPE,VALUE_TYPE,ALLOCATOR>::FatAVLmap_iterator_const CS280::FatAVLmap<KEY_TYPE,VALUE_TYPE,ALLOCATOR>::find(KEY_TYPE const& key) const
+{
+    unsigned int slot = 0;
+    Leaf const* leaf = FindEntry(key, slot);
+
+    return FatAVLmap_iterator_const(this, leaf, slot);
+}
+
+/**
+ * @brief Returns the first entry with a key not less than the given key
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename ALLOCATOR >
+typename CS280::FatAVLmap<KEY_TYPE,VALUE_TYPE,ALLOCATOR>::FatAVLmap_iterator_const CS280::FatAVLmap<KEY_TYPE,VALUE_TYPE,ALLOCATOR>::lower_bound(KEY_TYPE const& key) const
+{
+    unsigned int slot = 0;
+    Leaf const* leaf = LowerBound(key, slot);
+
+    return FatAVLmap_iterator_const(this, leaf, slot);
+}
+
+/**
+ * @brief Returns the first entry with a key greater than the given key
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename ALLOCATOR >
+typename CS280::FatAVLmap<KEY_TYPE,VALUE_TYPE,ALLOCATOR>::FatAVLmap_iterator_const CS280::FatAVLmap<KEY_TYPE,VALUE_TYPE,ALLOCATOR>::upper_bound(KEY_TYPE const& key) const
+{
+    unsigned int slot = 0;
+    Leaf const* leaf = UpperBound(key, slot);
+
+    return FatAVLmap_iterator_const(this, leaf, slot);
+}
+
+/**
+ * @brief Checks the whole tree: the key order and the bounds the inner keys set, the fill of every node,
+ *        the parent links, the leaf list, the keys copied into the entries and the size. The leaves being
+ *        at the same depth follows from the walk reaching them with the level count. O(n).
+ *
+ * @return whether the tree is valid
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename ALLOCATOR >
+bool CS280::FatAVLmap<KEY_TYPE,VALUE_TYPE,ALLOCATOR>::sanityCheck() const
+{
+    if(mRoot == nullptr)
+        return mLevels == 0 && size_ == 0;
+
+    if(mRoot->parent != nullptr)
+        return false;
+
+    Leaf const* previous = nullptr;
+    unsigned int count = 0;
+
+    if(!CheckBlock(mRoot, mLevels, nullptr, nullptr, previous, count))
+        return false;
+
+    return previous->next == nullptr && count == size_;
+}
+
+/**
+ * @brief Walks down to the leaf where the key is, or would be.
+ *
+ * @param key - key to find
+ * @return the leaf, or nullptr if the map is empty
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename ALLOCATOR >
+typename CS280::FatAVLmap<KEY_TYPE,VALUE_TYPE,ALLOCATOR>::Leaf* CS280::FatAVLmap<KEY_TYPE,VALUE_TYPE,ALLOCATOR>::FindLeaf(KEY_TYPE key) const
+{
+    Block* block = mRoot;
+
+    // Keys equal to an inner key are in the child after it
+    for(unsigned int level = mLevels; level > 0; --level)
+    {
+        Inner* inner = static_cast<Inner*>(block);
+        block = inner->children[KeyLine<KEY_TYPE>::template CountBelow<true>(inner->keys, inner->count, key)];
+    }
+
+    return static_cast<Leaf*>(block);
+}
+
+/**
+ * @brief Finds the entry with the given key.
+ *
+ * @param key - key to find
+ * @param slot - set to the entry's position in its leaf
+ * @return the entry's leaf, or nullptr if the key is missing
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename ALLOCATOR >
+typename CS280::FatAVLmap<KEY_TYPE,VALUE_TYPE,ALLOCATOR>::Leaf* CS280::FatAVLmap<KEY_TYPE,VALUE_TYPE,ALLOCATOR>::FindEntry(KEY_TYPE key, unsigned int& slot) const
+{
+    Leaf* leaf = FindLeaf(key);
+
+    if(leaf == nullptr)
+        return nullptr;
+
+    slot = KeyLine<KEY_TYPE>::template CountBelow<false>(leaf->keys, leaf->count, key);
+
+    if(slot < leaf->count && leaf->keys[slot] == key)
+        return leaf;
+
+    slot = 0;
+    return nullptr;
+}
+
+/**
+ * @brief Finds the first entry with a key not less than the given key.
+ *
+ * @param key - key to compare with
+ * @param slot - set to the entry's position in its leaf
+ * @return the entry's leaf, or nullptr if every key is less
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename ALLOCATOR >
+typename CS280::FatAVLmap<KEY_TYPE,VALUE_TYPE,ALLOCATOR>::Leaf* CS280::FatAVLmap<KEY_TYPE,VALUE_TYPE,ALLOCATOR>::LowerBound(KEY_TYPE key, unsigned int& slot) const
+{
+    Leaf* leaf = FindLeaf(key);
+
+    if(leaf == nullptr)
+        return nullptr;
+
+    slot = KeyLine<KEY_TYPE>::template CountBelow<false>(leaf->keys, leaf->count, key);
+
+    // Every key of the leaf is less, the bound is the first entry of the next one
+    if(slot == leaf->count)
+    {
+        leaf = leaf->next;
+        slot = 0;
+    }
+
+    return leaf;
+}
+
+/**
+ * @brief Finds the first entry with a key greater than the given key.
+ *
+ * @param key - key to compare with
+ * @param slot - set to the entry's position in its leaf
+ * @return the entry's leaf, or nullptr if no key is greater
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename ALLOCATOR >
+typename CS280::FatAVLmap<KEY_TYPE,VALUE_TYPE,ALLOCATOR>::Leaf* CS280::FatAVLmap<KEY_TYPE,VALUE_TYPE,ALLOCATOR>::UpperBound(KEY_TYPE key, unsigned int& slot) const
+{
+    Leaf* leaf = FindLeaf(key);
+
+    if(leaf == nullptr)
+        return nullptr;
+
+    slot = KeyLine<KEY_TYPE>::template CountBelow<true>(leaf->keys, leaf->count, key);
+
+    if(slot == leaf->count)
+    {
+        leaf = leaf->next;
+        slot = 0;
+    }
+
+    return leaf;
+}
+
+/**
+ * @brief Returns the leaf with the smallest keys, nullptr if the map is empty
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename ALLOCATOR >
+typename CS280::FatAVLmap<KEY_TYPE,VALUE_TYPE,ALLOCATOR>::Leaf* CS280::FatAVLmap<KEY_TYPE,VALUE_TYPE,ALLOCATOR>::FirstLeaf() const
+{
+    Block* block = mRoot;
+
+    for(unsigned int level = mLevels; level > 0; --level)
+        block = static_cast<Inner*>(block)->children[0];
+
+    return static_cast<Leaf*>(block);
+}
+
+/**
+ * @brief Returns the leaf with the largest keys, nullptr if the map is empty
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename ALLOCATOR >
+typename CS280::FatAVLmap<KEY_TYPE,VALUE_TYPE,ALLOCATOR>::Leaf* CS280::FatAVLmap<KEY_TYPE,VALUE_TYPE,ALLOCATOR>::LastLeaf() const
+{
+    Block* block = mRoot;
+
+    for(unsigned int level = mLevels; level > 0; --level)
+        block = static_cast<Inner*>(block)->children[block->count];
+
+    return static_cast<Leaf*>(block);
+}
+
+/**
+ * @brief Finds the entry of the key or builds it in its leaf. A full leaf is split first, and so is every
+ *        full ancestor the split reaches. The value is built in place after the entries above it move up,
+ *        if it throws they move back (the split, if there was one, stays).
+ *
+ * @param key - key to insert
+ * @param args - value constructor arguments
+ * @return the entry with the key, and whether it was inserted
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename ALLOCATOR >
+template< typename... ARGS >
+std::pair<typename CS280::FatAVLmap<KEY_TYPE,VALUE_TYPE,ALLOCATOR>::FatAVLmap_iterator, bool> CS280::FatAVLmap<KEY_TYPE,VALUE_TYPE,ALLOCATOR>::TryEmplace(KEY_TYPE key, ARGS&&... args)
+{
+    if(mRoot == nullptr)
+        mRoot = CreateLeaf();
+
+    Leaf* leaf = FindLeaf(key);
+    unsigned int slot = KeyLine<KEY_TYPE>::template CountBelow<false>(leaf->keys, leaf->count, key);
+
+    if(slot < leaf->count && leaf->keys[slot] == key)
+        return std::make_pair(FatAVLmap_iterator(this, leaf, slot), false);
+
+    if(leaf->count == NODE_KEYS)
+    {
+        Leaf* right = SplitLeaf(leaf);
+
+        // A key between the halves stays left, the right half's first key is its parent's key now
+        if(slot > leaf->count)
+        {
+            slot -= leaf->count;
+            leaf = right;
+        }
+    }
+
+    MoveEntries(leaf, slot, leaf->count - slot, leaf, slot + 1);
+
+    try
+    {
+        ::new (static_cast<void*>(leaf->Entries() + slot)) Node(key, std::forward<ARGS>(args)...);
+    }
+    catch(...)
+    {
+        MoveEntries(leaf, slot + 1, leaf->count - slot, leaf, slot);
+
+        // Only the root leaf of a map that was empty can be left without an entry
+        if(leaf->count == 0)
+        {
+            FreeLeaf(leaf);
+            mRoot = nullptr;
+        }
+
+        throw;
+    }
+
+    leaf->keys[slot] = key;
+    ++leaf->count;
+    ++size_;
+
+    return std::make_pair(FatAVLmap_iterator(this, leaf, slot), true);
+}
+
+/**
+ * @brief Splits a full leaf, the upper half moves to a new leaf to its right, and hands the new leaf's
+ *        first key to the parent. The nodes for every full ancestor that splits as well (and for a new root)
+ *        are allocated before anything moves, so a bad_alloc leaves the map as it was.
+ *
+ * @param leaf - full leaf to split
+ * @return the new leaf
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename ALLOCATOR >
+typename CS280::FatAVLmap<KEY_TYPE,VALUE_TYPE,ALLOCATOR>::Leaf* CS280::FatAVLmap<KEY_TYPE,VALUE_TYPE,ALLOCATOR>::SplitLeaf(Leaf* leaf)
+{
+    unsigned int splits = 0;
+    Inner* ancestor = leaf->parent;
+
+    while(ancestor != nullptr && ancestor->count == NODE_KEYS)
+    {
+        ++splits;
+        ancestor = ancestor->parent;
+    }
+
+    // The root splits too, a new root goes on top
+    if(ancestor == nullptr)
+        ++splits;
+
+    Inner* spares = nullptr;
+    Leaf* right = nullptr;
+
+    try
+    {
+        for(; splits > 0; --splits)
+        {
+            Inner* spare = CreateInner();
+            spare->parent = spares;
+            spares = spare;
+        }
+
+        right = CreateLeaf();
+    }
+    catch(...)
+    {
+        FreeSpares(spares);
+        throw;
+    }
+
+    unsigned int keep = leaf->count / 2;
+
+    MoveEntries(leaf, keep, leaf->count - keep, right, 0);
+    right->count = leaf->count - keep;
+    leaf->count = keep;
+
+    right->previous = leaf;
+    right->next = leaf->next;
+
+    if(leaf->next != nullptr)
+        leaf->next->previous = right;
+
+    leaf->next = right;
+
+    InsertIntoParent(leaf, right->keys[0], right, spares);
+    return right;
+}
+
+/**
+ * @brief Links a node that was split off to the right of left into left's parent, under the given key.
+ *        A full parent splits around its middle key, which goes up to the grandparent the same way,
+ *        and a split root gets a new root above it. The new nodes come from spares.
+ *
+ * @param left - node that was split
+ * @param separator - smallest key that can be under right
+ * @param right - node split off
+ * @param spares - preallocated inner nodes, chained through their parent links
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename ALLOCATOR >
+void CS280::FatAVLmap<KEY_TYPE,VALUE_TYPE,ALLOCATOR>::InsertIntoParent(Block* left, KEY_TYPE separator, Block* right, Inner*& spares)
+{
+    while(true)
+    {
+        Inner* parent = left->parent;
+
+        if(parent == nullptr)
+        {
+            Inner* root = TakeSpare(spares);
+
+            root->keys[0] = separator;
+            root->children[0] = left;
+            root->children[1] = right;
+            root->count = 1;
+            left->parent = root;
+            right->parent = root;
+
+            mRoot = root;
+            ++mLevels;
+            return;
+        }
+
+        unsigned int index = ChildIndex(parent, left);
+
+        if(parent->count < NODE_KEYS)
+        {
+            InsertChild(parent, index, separator, right);
+            return;
+        }
+
+        // The middle key goes up, the keys and children after it move to the sibling
+        Inner* sibling = TakeSpare(spares);
+        unsigned int middle = NODE_KEYS / 2;
+        KEY_TYPE up = parent->keys[middle];
+
+        sibling->count = NODE_KEYS - middle - 1;
+
+        for(unsigned int i = 0; i < sibling->count; ++i)
+            sibling->keys[i] = parent->keys[middle + 1 + i];
+
+        for(unsigned int i = 0; i <= sibling->count; ++i)
+        {
+            sibling->children[i] = parent->children[middle + 1 + i];
+            sibling->children[i]->parent = sibling;
+        }
+
+        parent->count = middle;
+
+        if(index <= middle)
+        {
+            InsertChild(parent, index, separator, right);
+        }
+        else
+        {
+            InsertChild(sibling, index - middle - 1, separator, right);
+        }
+
+        left = parent;
+        separator = up;
+        right = sibling;
+    }
+}
+
+/**
+ * @brief Inserts a key at the given position of an inner node that has room, with the child after it
+ *
+ * @param inner - node to insert into
+ * @param index - position of the key, the child goes at index + 1
+ * @param separator - smallest key that can be under the child
+ * @param child - child to link
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename ALLOCATOR >
+void CS280::FatAVLmap<KEY_TYPE,VALUE_TYPE,ALLOCATOR>::InsertChild(Inner* inner, unsigned int index, KEY_TYPE separator, Block* child)
+{
+    for(unsigned int i = inner->count; i > index; --i)
+    {
+        inner->keys[i] = inner->keys[i - 1];
+        inner->children[i + 1] = inner->children[i];
+    }
+
+    inner->keys[index] = separator;
+    inner->children[index + 1] = child;
+    child->parent = inner;
+    ++inner->count;
+}
+
+/**
+ * @brief Removes the key at the given position of an inner node, with the child after it
+ *
+ * @param inner - node to remove from
+ * @param index - position of the key, the child at index + 1 goes too
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename ALLOCATOR >
+void CS280::FatAVLmap<KEY_TYPE,VALUE_TYPE,ALLOCATOR>::RemoveChild(Inner* inner, unsigned int index)
+{
+    for(unsigned int i = index + 1; i < inner->count; ++i)
+    {
+        inner->keys[i - 1] = inner->keys[i];
+        inner->children[i] = inner->children[i + 1];
+    }
+
+    --inner->count;
+}
+
+/**
+ * @brief Returns a child's position among its parent's children
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename ALLOCATOR >
+unsigned int CS280::FatAVLmap<KEY_TYPE,VALUE_TYPE,ALLOCATOR>::ChildIndex(Inner const* parent, Block const* child)
+{
+    unsigned int index = 0;
+
+    while(index < parent->count && parent->children[index] != child)
+        ++index;
+
+    return index;
+}
+
+/**
+ * @brief Destroys an entry and closes the gap. A leaf left under half full is refilled from a sibling
+ *        or merged with it, an empty root leaf is freed.
+ *
+ * @param leaf - leaf of the entry
+ * @param slot - position of the entry
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename ALLOCATOR >
+void CS280::FatAVLmap<KEY_TYPE,VALUE_TYPE,ALLOCATOR>::EraseEntry(Leaf* leaf, unsigned int slot)
+{
+    leaf->Entries()[slot].~Node();
+    MoveEntries(leaf, slot + 1, leaf->count - slot - 1, leaf, slot);
+    --leaf->count;
+    --size_;
+
+    if(leaf->parent == nullptr)
+    {
+        if(leaf->count == 0)
+        {
+            FreeLeaf(leaf);
+            mRoot = nullptr;
+        }
+
+        return;
+    }
+
+    if(leaf->count < MIN_LEAF_KEYS)
+        FixLeaf(leaf);
+}
+
+/**
+ * @brief Refills a leaf that is under half full. It borrows an entry from a sibling that can spare one
+ *        (the parent's key between them becomes the new first key of the right one), otherwise it merges
+ *        with the sibling and the parent is fixed in turn.
+ *
+ * @param leaf - leaf under half full, not the root
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename ALLOCATOR >
+void CS280::FatAVLmap<KEY_TYPE,VALUE_TYPE,ALLOCATOR>::FixLeaf(Leaf* leaf)
+{
+    Inner* parent = leaf->parent;
+    unsigned int index = ChildIndex(parent, leaf);
+
+    if(index > 0)
+    {
+        Leaf* left = static_cast<Leaf*>(parent->children[index - 1]);
+
+        if(left->count > MIN_LEAF_KEYS)
+        {
+            MoveEntries(leaf, 0, leaf->count, leaf, 1);
+            MoveEntries(left, left->count - 1, 1, leaf, 0);
+            --left->count;
+            ++leaf->count;
+            parent->keys[index - 1] = leaf->keys[0];
+            return;
+        }
+
+        MergeLeaves(left, leaf, index - 1);
+    }
+    else
+    {
+        Leaf* right = static_cast<Leaf*>(parent->children[1]);
+
+        if(right->count > MIN_LEAF_KEYS)
+        {
+            MoveEntries(right, 0, 1, leaf, leaf->count);
+            ++leaf->count;
+            MoveEntries(right, 1, right->count - 1, right, 0);
+            --right->count;
+            parent->keys[0] = right->keys[0];
+            return;
+        }
+
+        MergeLeaves(leaf, right, 0);
+    }
+
+    FixInner(parent);
+}
+
+/**
+ * @brief Moves every entry of a leaf into its left sibling and frees it
+ *
+ * @param left - leaf that keeps the entries
+ * @param right - leaf after it, freed
+ * @param separator - position of the parent's key between them
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename ALLOCATOR >
+void CS280::FatAVLmap<KEY_TYPE,VALUE_TYPE,ALLOCATOR>::MergeLeaves(Leaf* left, Leaf* right, unsigned int separator)
+{
+    MoveEntries(right, 0, right->count, left, left->count);
+    left->count += right->count;
+    right->count = 0;
+
+    left->next = right->next;
+
+    if(right->next != nullptr)
+        right->next->previous = left;
+
+    RemoveChild(left->parent, separator);
+    FreeLeaf(right);
+}
+
+/**
+ * @brief Walks up from an inner node that lost a child, refilling the nodes that are under half full
+ *        the same way as the leaves: the parent's key between two siblings rotates through to borrow a child,
+ *        or comes down into the merged node. A root left with a single child is replaced by it.
+ *
+ * @param inner - node that lost a child
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename ALLOCATOR >
+void CS280::FatAVLmap<KEY_TYPE,VALUE_TYPE,ALLOCATOR>::FixInner(Inner* inner)
+{
+    while(true)
+    {
+        Inner* parent = inner->parent;
+
+        if(parent == nullptr)
+        {
+            if(inner->count == 0)
+            {
+                mRoot = inner->children[0];
+                mRoot->parent = nullptr;
+                --mLevels;
+                FreeInner(inner);
+            }
+
+            return;
+        }
+
+        if(inner->count >= MIN_INNER_KEYS)
+            return;
+
+        unsigned int index = ChildIndex(parent, inner);
+
+        if(index > 0)
+        {
+            Inner* left = static_cast<Inner*>(parent->children[index - 1]);
+
+            if(left->count > MIN_INNER_KEYS)
+            {
+                // Left's last child comes over, the keys rotate through the parent
+                for(unsigned int i = inner->count; i > 0; --i)
+                    inner->keys[i] = inner->keys[i - 1];
+
+                for(unsigned int i = inner->count + 1; i > 0; --i)
+                    inner->children[i] = inner->children[i - 1];
+
+                inner->keys[0] = parent->keys[index - 1];
+                inner->children[0] = left->children[left->count];
+                inner->children[0]->parent = inner;
+                ++inner->count;
+
+                parent->keys[index - 1] = left->keys[left->count - 1];
+                --left->count;
+                return;
+            }
+
+            MergeInners(left, inner, index - 1);
+        }
+        else
+        {
+            Inner* right = static_cast<Inner*>(parent->children[1]);
+
+            if(right->count > MIN_INNER_KEYS)
+            {
+                // Right's first child comes over
+                inner->keys[inner->count] = parent->keys[0];
+                inner->children[inner->count + 1] = right->children[0];
+                inner->children[inner->count + 1]->parent = inner;
+                ++inner->count;
+
+                parent->keys[0] = right->keys[0];
+
+                for(unsigned int i = 1; i < right->count; ++i)
+                    right->keys[i - 1] = right->keys[i];
+
+                for(unsigned int i = 1; i <= right->count; ++i)
+                    right->children[i - 1] = right->children[i];
+
+                --right->count;
+                return;
+            }
+
+            MergeInners(inner, right, 0);
+        }
+
+        inner = parent;
+    }
+}
+
+/**
+ * @brief Moves the parent's key between two inner siblings and everything in the right one into the left one,
+ *        and frees the right one
+ *
+ * @param left - node that keeps the children
+ * @param right - node after it, freed
+ * @param separator - position of the parent's key between them
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename ALLOCATOR >
+void CS280::FatAVLmap<KEY_TYPE,VALUE_TYPE,ALLOCATOR>::MergeInners(Inner* left, Inner* right, unsigned int separator)
+{
+    Inner* parent = left->parent;
+
+    left->keys[left->count] = parent->keys[separator];
+
+    for(unsigned int i = 0; i < right->count; ++i)
+        left->keys[left->count + 1 + i] = right->keys[i];
+
+    for(unsigned int i = 0; i <= right->count; ++i)
+    {
+        left->children[left->count + 1 + i] = right->children[i];
+        right->children[i]->parent = left;
+    }
+
+    left->count += 1 + right->count;
+
+    RemoveChild(parent, separator);
+    FreeInner(right);
+}
+
+/**
+ * @brief Moves a run of entries, with their keys, to another position of the same leaf or to another leaf.
+ *        Runs that overlap are moved from the far end first, the slots moved out of are left raw.
+ *
+ * @param from - leaf the entries are in
+ * @param first - position of the first entry
+ * @param count - number of entries
+ * @param to - leaf to move them to
+ * @param destination - position of the first entry in to
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename ALLOCATOR >
+void CS280::FatAVLmap<KEY_TYPE,VALUE_TYPE,ALLOCATOR>::MoveEntries(Leaf* from, unsigned int first, unsigned int count, Leaf* to, unsigned int destination)
+{
+    Node* source = from->Entries();
+    Node* target = to->Entries();
+    bool backwards = from == to && destination > first;
+
+    for(unsigned int i = 0; i < count; ++i)
+    {
+        unsigned int offset = backwards ? count - 1 - i : i;
+
+        to->keys[destination + offset] = from->keys[first + offset];
+        ::new (static_cast<void*>(target + destination + offset)) Node(std::move(source[first + offset]));
+        source[first + offset].~Node();
+    }
+}
+
+/**
+ * @brief Allocates an empty leaf
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename ALLOCATOR >
+typename CS280::FatAVLmap<KEY_TYPE,VALUE_TYPE,ALLOCATOR>::Leaf* CS280::FatAVLmap<KEY_TYPE,VALUE_TYPE,ALLOCATOR>::CreateLeaf()
+{
+    Leaf* leaf = std::allocator_traits<LeafAllocator>::allocate(mLeafAlloc, 1);
+
+    // Default initialized, so the entries stay raw
+    return ::new (static_cast<void*>(leaf)) Leaf;
+}
+
+/**
+ * @brief Allocates an empty inner node
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename ALLOCATOR >
+typename CS280::FatAVLmap<KEY_TYPE,VALUE_TYPE,ALLOCATOR>::Inner* CS280::FatAVLmap<KEY_TYPE,VALUE_TYPE,ALLOCATOR>::CreateInner()
+{
+    Inner* inner = std::allocator_traits<InnerAllocator>::allocate(mInnerAlloc, 1);
+
+    return ::new (static_cast<void*>(inner)) Inner;
+}
+
+/**
+ * @brief Takes the first node off a chain of spare inner nodes
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename ALLOCATOR >
+typename CS280::FatAVLmap<KEY_TYPE,VALUE_TYPE,ALLOCATOR>::Inner* CS280::FatAVLmap<KEY_TYPE,VALUE_TYPE,ALLOCATOR>::TakeSpare(Inner*& spares)
+{
+    Inner* spare = spares;
+
+    spares = spare->parent;
+    spare->parent = nullptr;
+
+    return spare;
+}
+
+/**
+ * @brief Frees a chain of spare inner nodes
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename ALLOCATOR >
+void CS280::FatAVLmap<KEY_TYPE,VALUE_TYPE,ALLOCATOR>::FreeSpares(Inner* spares)
+{
+    while(spares != nullptr)
+        FreeInner(TakeSpare(spares));
+}
+
+/**
+ * @brief Frees a leaf, its entries must be destroyed or moved out already
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename ALLOCATOR >
+void CS280::FatAVLmap<KEY_TYPE,VALUE_TYPE,ALLOCATOR>::FreeLeaf(Leaf* leaf)
+{
+    leaf->~Leaf();
+    std::allocator_traits<LeafAllocator>::deallocate(mLeafAlloc, leaf, 1);
+}
+
+/**
+ * @brief Frees an inner node, not its children
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename ALLOCATOR >
+void CS280::FatAVLmap<KEY_TYPE,VALUE_TYPE,ALLOCATOR>::FreeInner(Inner* inner)
+{
+    inner->~Inner();
+    std::allocator_traits<InnerAllocator>::deallocate(mInnerAlloc, inner, 1);
+}
+
+/**
+ * @brief Destroys the entries of a subtree and frees its nodes. The recursion is as deep as the tree.
+ *
+ * @param block - subtree root
+ * @param level - its level, 0 for a leaf
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename ALLOCATOR >
+void CS280::FatAVLmap<KEY_TYPE,VALUE_TYPE,ALLOCATOR>::DestroyTree(Block* block, unsigned int level)
+{
+    if(level == 0)
+    {
+        Leaf* leaf = static_cast<Leaf*>(block);
+
+        for(unsigned int i = 0; i < leaf->count; ++i)
+            leaf->Entries()[i].~Node();
+
+        FreeLeaf(leaf);
+        return;
+    }
+
+    Inner* inner = static_cast<Inner*>(block);
+
+    for(unsigned int i = 0; i <= inner->count; ++i)
+        DestroyTree(inner->children[i], level - 1);
+
+    FreeInner(inner);
+}
+
+/**
+ * @brief Copies a subtree node for node, linking the copied leaves in order after last.
+ *        If a copy throws, what was copied of the subtree is destroyed.
+ *
+ * @param block - subtree root to copy
+ * @param level - its level, 0 for a leaf
+ * @param parent - parent of the copy
+ * @param last - last leaf copied so far, updated
+ * @return the copy
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename ALLOCATOR >
+typename CS280::FatAVLmap<KEY_TYPE,VALUE_TYPE,ALLOCATOR>::Block* CS280::FatAVLmap<KEY_TYPE,VALUE_TYPE,ALLOCATOR>::CopyTree(Block const* block, unsigned int level, Inner* parent, Leaf*& last)
+{
+    if(level == 0)
+    {
+        Leaf const* source = static_cast<Leaf const*>(block);
+        Leaf* leaf = CreateLeaf();
+
+        try
+        {
+            for(; leaf->count < source->count; ++leaf->count)
+            {
+                ::new (static_cast<void*>(leaf->Entries() + leaf->count)) Node(source->Entries()[leaf->count]);
+                leaf->keys[leaf->count] = source->keys[leaf->count];
+            }
+        }
+        catch(...)
+        {
+            DestroyTree(leaf, 0);
+            throw;
+        }
+
+        leaf->parent = parent;
+        leaf->previous = last;
+
+        if(last != nullptr)
+            last->next = leaf;
+
+        last = leaf;
+        return leaf;
+    }
+
+    Inner const* source = static_cast<Inner const*>(block);
+    Inner* inner = CreateInner();
+
+    inner->parent = parent;
+
+    for(unsigned int i = 0; i < source->count; ++i)
+        inner->keys[i] = source->keys[i];
+
+    unsigned int copied = 0;
+
+    try
+    {
+        for(; copied <= source->count; ++copied)
+            inner->children[copied] = CopyTree(source->children[copied], level - 1, inner, last);
+    }
+    catch(...)
+    {
+        for(unsigned int i = 0; i < copied; ++i)
+            DestroyTree(inner->children[i], level - 1);
+
+        FreeInner(inner);
+        throw;
+    }
+
+    inner->count = source->count;
+    return inner;
+}
+
+/**
+ * @brief Checks a subtree for sanityCheck. The recursion is as deep as the tree.
+ *
+ * @param block - subtree root
+ * @param level - the level it should be at, 0 for a leaf
+ * @param low - every key of the subtree is at least this, nullptr for no bound
+ * @param high - every key of the subtree is less than this, nullptr for no bound
+ * @param previous - the leaf before the subtree's first leaf, updated to its last leaf
+ * @param count - incremented for every entry
+ * @return whether the subtree is valid
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename ALLOCATOR >
+bool CS280::FatAVLmap<KEY_TYPE,VALUE_TYPE,ALLOCATOR>::CheckBlock(Block const* block, unsigned int level, KEY_TYPE const* low, KEY_TYPE const* high,
+                                                               Leaf const*& previous, unsigned int& count) const
+{
+    unsigned int fewest = block == mRoot ? 1 : level == 0 ? MIN_LEAF_KEYS : MIN_INNER_KEYS;
+
+    if(block->count < fewest || block->count > NODE_KEYS)
+        return false;
+
+    for(unsigned int i = 0; i < block->count; ++i)
+    {
+        if(i > 0 && !(block->keys[i - 1] < block->keys[i]))
+            return false;
+
+        if((low != nullptr && block->keys[i] < *low) || (high != nullptr && !(block->keys[i] < *high)))
+            return false;
+    }
+
+    if(level == 0)
+    {
+        Leaf const* leaf = static_cast<Leaf const*>(block);
+
+        if(leaf->previous != previous || (previous != nullptr && previous->next != leaf))
+            return false;
+
+        for(unsigned int i = 0; i < leaf->count; ++i)
+        {
+            if(leaf->Entries()[i].key != leaf->keys[i])
+                return false;
+        }
+
+        previous = leaf;
+        count += leaf->count;
+        return true;
+    }
+
+    Inner const* inner = static_cast<Inner const*>(block);
+
+    for(unsigned int i = 0; i <= inner->count; ++i)
+    {
+        Block const* child = inner->children[i];
+
+        if(child == nullptr || child->parent != inner)
+            return false;
+
+        KEY_TYPE const* childLow = i == 0 ? low : &inner->keys[i - 1];
+        KEY_TYPE const* childHigh = i == inner->count ? high : &inner->keys[i];
+
+        if(!CheckBlock(child, level - 1, childLow, childHigh, previous, count))
+            return false;
+    }
+
+    return true;
+}
+
+/**
+ * @brief Returns the entries of a leaf
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename ALLOCATOR >
+typename CS280::FatAVLmap<KEY_TYPE,VALUE_TYPE,ALLOCATOR>::Node* CS280::FatAVLmap<KEY_TYPE,VALUE_TYPE,ALLOCATOR>::Leaf::Entries()
+{
+    return std::launder(reinterpret_cast<Node*>(entries));
+}
+
+/**
+ * @brief Returns the entries of a leaf
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename ALLOCATOR >
+typename CS280::FatAVLmap<KEY_TYPE,VALUE_TYPE,ALLOCATOR>::Node const* CS280::FatAVLmap<KEY_TYPE,VALUE_TYPE,ALLOCATOR>::Leaf::Entries() const
+{
+    return std::launder(reinterpret_cast<Node const*>(entries));
+}
+
+/**
+ * @brief Builds an entry
+ *
+ * @param k - key
+ * @param args - value constructor arguments
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename ALLOCATOR >
+template< typename... ARGS >
+CS280::FatAVLmap<KEY_TYPE,VALUE_TYPE,ALLOCATOR>::Node::Node( KEY_TYPE k, ARGS&&... args ) : key(k), value(std::forward<ARGS>(args)...)
+{
+
+}
+
+/**
+ * @brief Returns the key of the entry
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename ALLOCATOR >
+KEY_TYPE const& CS280::FatAVLmap<KEY_TYPE,VALUE_TYPE,ALLOCATOR>::Node::Key() const
+{
+    return key;
+}
+
+/**
+ * @brief Returns the value of the entry
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename ALLOCATOR >
+VALUE_TYPE& CS280::FatAVLmap<KEY_TYPE,VALUE_TYPE,ALLOCATOR>::Node::Value()
+{
+    return value;
+}
+
+/**
+ * @brief Returns the value of the entry
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename ALLOCATOR >
+VALUE_TYPE const& CS280::FatAVLmap<KEY_TYPE,VALUE_TYPE,ALLOCATOR>::Node::Value() const
+{
+    return value;
+}
+
+/**
+ * @brief Iterator constructor
+ *
+ * @param map - map iterated over
+ * @param leaf - leaf of the entry (nullptr for end)
+ * @param slot - position of the entry in the leaf
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename ALLOCATOR >
+CS280::FatAVLmap<KEY_TYPE,VALUE_TYPE,ALLOCATOR>::FatAVLmap_iterator::FatAVLmap_iterator(FatAVLmap* map, Leaf* leaf, unsigned int slot) : mMap(map), mLeaf(leaf), mSlot(slot)
+{
+
+}
+
+/**
+ * @brief Pre-increment operator for iterator, moves to the next leaf at the end of one
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename ALLOCATOR >
+typename CS280::FatAVLmap<KEY_TYPE,VALUE_TYPE,ALLOCATOR>::FatAVLmap_iterator& CS280::FatAVLmap<KEY_TYPE,VALUE_TYPE,ALLOCATOR>::FatAVLmap_iterator::operator++()
+{
+    if(++mSlot == mLeaf->count)
+    {
+        mLeaf = mLeaf->next;
+        mSlot = 0;
+    }
+
+    return *this;
+}
+
+/**
+ * @brief Post-increment operator for iterator
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename ALLOCATOR >
+typename CS280::FatAVLmap<KEY_TYPE,VALUE_TYPE,ALLOCATOR>::FatAVLmap_iterator CS280::FatAVLmap<KEY_TYPE,VALUE_TYPE,ALLOCATOR>::FatAVLmap_iterator::operator++(int)
+{
+    FatAVLmap_iterator old = *this;
+    ++*this;
+    return old;
+}
+
+/**
+ * @brief Pre-decrement operator for iterator, end goes back to the last entry
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename ALLOCATOR >
+typename CS280::FatAVLmap<KEY_TYPE,VALUE_TYPE,ALLOCATOR>::FatAVLmap_iterator& CS280::FatAVLmap<KEY_TYPE,VALUE_TYPE,ALLOCATOR>::FatAVLmap_iterator::operator--()
+{
+    if(mLeaf == nullptr)
+    {
+        mLeaf = mMap->LastLeaf();
+        mSlot = mLeaf->count - 1;
+    }
+    else if(mSlot > 0)
+    {
+        --mSlot;
+    }
+    else
+    {
+        mLeaf = mLeaf->previous;
+        mSlot = mLeaf->count - 1;
+    }
+
+    return *this;
+}
+
+/**
+ * @brief Post-decrement operator for iterator
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename ALLOCATOR >
+typename CS280::FatAVLmap<KEY_TYPE,VALUE_TYPE,ALLOCATOR>::FatAVLmap_iterator CS280::FatAVLmap<KEY_TYPE,VALUE_TYPE,ALLOCATOR>::FatAVLmap_iterator::operator--(int)
+{
+    FatAVLmap_iterator old = *this;
+    --*this;
+    return old;
+}
+
+/**
+ * @brief Dereference operator for iterator
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename ALLOCATOR >
+typename CS280::FatAVLmap<KEY_TYPE,VALUE_TYPE,ALLOCATOR>::Node& CS280::FatAVLmap<KEY_TYPE,VALUE_TYPE,ALLOCATOR>::FatAVLmap_iterator::operator*() const
+{
+    return mLeaf->Entries()[mSlot];
+}
+
+/**
+ * @brief Arrow operator for iterator
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename ALLOCATOR >
+typename CS280::FatAVLmap<KEY_TYPE,VALUE_TYPE,ALLOCATOR>::Node* CS280::FatAVLmap<KEY_TYPE,VALUE_TYPE,ALLOCATOR>::FatAVLmap_iterator::operator->() const
+{
+    return mLeaf->Entries() + mSlot;
+}
+
+/**
+ * @brief Not equal operator for iterator
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename ALLOCATOR >
+bool CS280::FatAVLmap<KEY_TYPE,VALUE_TYPE,ALLOCATOR>::FatAVLmap_iterator::operator!=(const FatAVLmap_iterator& rhs) const
+{
+    return !(*this == rhs);
+}
+
+/**
+ * @brief Equal operator for iterator
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename ALLOCATOR >
+bool CS280::FatAVLmap<KEY_TYPE,VALUE_TYPE,ALLOCATOR>::FatAVLmap_iterator::operator==(const FatAVLmap_iterator& rhs) const
+{
+    return mLeaf == rhs.mLeaf && mSlot == rhs.mSlot;
+}
+
+/**
+ * @brief Const iterator constructor
+ *
+ * @param map - map iterated over
+ * @param leaf - leaf of the entry (nullptr for end)
+ * @param slot - position of the entry in the leaf
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename ALLOCATOR >
+CS280::FatAVLmap<KEY_TYPE,VALUE_TYPE,ALLOCATOR>::FatAVLmap_iterator_const::FatAVLmap_iterator_const(FatAVLmap const* map, Leaf const* leaf, unsigned int slot) : mMap(map), mLeaf(leaf), mSlot(slot)
+{
+
+}
+
+/**
+ * @brief Converts an iterator to a const iterator
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename ALLOCATOR >
+CS280::FatAVLmap<KEY_TYPE,VALUE_TYPE,ALLOCATOR>::FatAVLmap_iterator_const::FatAVLmap_iterator_const(const FatAVLmap_iterator& rhs) : mMap(rhs.mMap), mLeaf(rhs.mLeaf), mSlot(rhs.mSlot)
+{
+
+}
+
+/**
+ * @brief Pre-increment operator for const iterator, moves to the next leaf at the end of one
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename ALLOCATOR >
+typename CS280::FatAVLmap<KEY_TYPE,VALUE_TYPE,ALLOCATOR>::FatAVLmap_iterator_const& CS280::FatAVLmap<KEY_TYPE,VALUE_TYPE,ALLOCATOR>::FatAVLmap_iterator_const::operator++()
+{
+    if(++mSlot == mLeaf->count)
+    {
+        mLeaf = mLeaf->next;
+        mSlot = 0;
+    }
+
+    return *this;
+}
+
+/**
+ * @brief Post-increment operator for const iterator
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename ALLOCATOR >
+typename CS280::FatAVLmap<KEY_TYPE,VALUE_TYPE,ALLOCATOR>::FatAVLmap_iterator_const CS280::FatAVLmap<KEY_TYPE,VALUE_TYPE,ALLOCATOR>::FatAVLmap_iterator_const::operator++(int)
+{
+    FatAVLmap_iterator_const old = *this;
+    ++*this;
+    return old;
+}
+
+/**
+ * @brief Pre-decrement operator for const iterator, end goes back to the last entry
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename ALLOCATOR >
+typename CS280::FatAVLmap<KEY_TYPE,VALUE_TYPE,ALLOCATOR>::FatAVLmap_iterator_const& CS280::FatAVLmap<KEY_TYPE,VALUE_TYPE,ALLOCATOR>::FatAVLmap_iterator_const::operator--()
+{
+    if(mLeaf == nullptr)
+    {
+        mLeaf = mMap->LastLeaf();
+        mSlot = mLeaf->count - 1;
+    }
+    else if(mSlot > 0)
+    {
+        --mSlot;
+    }
+    else
+    {
+        mLeaf = mLeaf->previous;
+        mSlot = mLeaf->count - 1;
+    }
+
+    return *this;
+}
+
+/**
+ * @brief Post-decrement operator for const iterator
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename ALLOCATOR >
+typename CS280::FatAVLmap<KEY_TYPE,VALUE_TYPE,ALLOCATOR>::FatAVLmap_iterator_const CS280::FatAVLmap<KEY_TYPE,VALUE_TYPE,ALLOCATOR>::FatAVLmap_iterator_const::operator--(int)
+{
+    FatAVLmap_iterator_const old = *this;
+    --*this;
+    return old;
+}
+
+/**
+ * @brief Dereference operator for const iterator
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename ALLOCATOR >
+typename CS280::FatAVLmap<KEY_TYPE,VALUE_TYPE,ALLOCATOR>::Node const& CS280::FatAVLmap<KEY_TYPE,VALUE_TYPE,ALLOCATOR>::FatAVLmap_iterator_const::operator*() const
+{
+    return mLeaf->Entries()[mSlot];
+}
+
+/**
+ * @brief Arrow operator for const iterator
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename ALLOCATOR >
+typename CS280::FatAVLmap<KEY_TYPE,VALUE_TYPE,ALLOCATOR>::Node const* CS280::FatAVLmap<KEY_TYPE,VALUE_TYPE,ALLOCATOR>::FatAVLmap_iterator_const::operator->() const
+{
+    return mLeaf->Entries() + mSlot;
+}
+
+/**
+ * @brief Not equal operator for const iterator
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename ALLOCATOR >
+bool CS280::FatAVLmap<KEY_TYPE,VALUE_TYPE,ALLOCATOR>::FatAVLmap_iterator_const::operator!=(const FatAVLmap_iterator_const& rhs) const
+{
+    return !(*this == rhs);
+}
+
+/**
+ * @brief Equal operator for const iterator
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename ALLOCATOR >
+bool CS280::FatAVLmap<KEY_TYPE,VALUE_TYPE,ALLOCATOR>::FatAVLmap_iterator_const::operator==(const FatAVLmap_iterator_const& rhs) const
+{
+    return mLeaf == rhs.mLeaf && mSlot == rhs.mSlot;
+}
@@ -0,0 +1,237 @@
+/**
+ * @file fat-avl-map.h
+ * @brief A cache conscious variant of AVLmap for integral keys. The keys live in fat, cache line aligned nodes
+ *        of 8 to 32 sorted keys (one cache line of keys), laid out like a B+ tree: every entry is in a leaf,
+ *        every leaf is at the same depth and the inner nodes only route the lookups. A lookup misses the cache
+ *        about once per level of a tree that is log(n) / log(8 to 32) deep, instead of once per key compared,
+ *        and the position inside a node is found with one vectorized compare of the whole key line
+ *        (AVX2 or NEON when the target has it). The interface is AVLmap's (operator[], find, erase, iterators),
+ *        but inserts and erases move entries between nodes, so they invalidate every iterator and reference.
+ */
+
+#ifndef FAT_AVLMAP_H
+#define FAT_AVLMAP_H
+
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <limits>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+#include "key-line.h"
+
+namespace CS280 {
+
+    // keys are ordered by <, ALLOCATOR supplies the memory for the nodes (it is rebound internally)
+    template< typename KEY_TYPE, typename VALUE_TYPE,
+              typename ALLOCATOR = std::allocator< std::pair<const KEY_TYPE, VALUE_TYPE> > >
+    class FatAVLmap {
+			static_assert(std::is_integral<KEY_TYPE>::value, "FatAVLmap needs an integral key type");
+			static_assert(std::is_nothrow_move_constructible<VALUE_TYPE>::value, "FatAVLmap moves values between nodes, they need a noexcept move constructor");
+		public:
+
+			// one entry of a leaf, so iterators can be used like AVLmap's (it->Key(), it->Value())
+			class Node
+			{
+				public:
+					KEY_TYPE const & Key() const;   // return a const reference
+					VALUE_TYPE  &    Value();       // return a reference
+					VALUE_TYPE const & Value() const; // return a const reference
+				private:
+					template< typename... ARGS >
+					Node( KEY_TYPE k, ARGS&&... args );
+
+					KEY_TYPE    key; // copy of the leaf's key, the searches only read the key line
+					VALUE_TYPE  value;
+
+					friend class FatAVLmap;
+			};
+
+		private:
+
+			static constexpr std::size_t CACHE_LINE = KeyLine<KEY_TYPE>::CACHE_LINE;
+			// keys per node, a cache line of them
+			static constexpr unsigned int NODE_KEYS = KeyLine<KEY_TYPE>::KEYS;
+			// fewest keys a node other than the root keeps, fewer and it borrows from or merges with a sibling
+			static constexpr unsigned int MIN_LEAF_KEYS = NODE_KEYS / 2;
+			static constexpr unsigned int MIN_INNER_KEYS = NODE_KEYS / 2 - 1;
+
+			struct Inner;
+
+			// what leaves and inner nodes share, the key line comes first so a search touches one line
+			struct Block
+			{
+				alignas(CACHE_LINE) KEY_TYPE keys[NODE_KEYS] = {}; // sorted, the ones past count are unused
+				unsigned int count = 0;
+				Inner* parent = nullptr;
+			};
+
+			struct Leaf : Block
+			{
+				Leaf* previous = nullptr; // leaves in key order, for the iterators
+				Leaf* next = nullptr;
+				alignas(Node) unsigned char entries[NODE_KEYS * sizeof(Node)]; // raw storage, the first count are live
+
+				Node* Entries();
+				Node const* Entries() const;
+			};
+
+			struct Inner : Block
+			{
+				Block* children[NODE_KEYS + 1]; // count + 1 of them, keys[i] <= every key under children[i + 1] < keys[i + 1]
+			};
+
+			typedef typename std::allocator_traits<ALLOCATOR>::template rebind_alloc<Leaf> LeafAllocator;
+			typedef typename std::allocator_traits<ALLOCATOR>::template rebind_alloc<Inner> InnerAllocator;
+
+			struct FatAVLmap_iterator
+			{
+				private:
+					FatAVLmap* mMap;
+					Leaf* mLeaf; // nullptr is end
+					unsigned int mSlot;
+				public:
+					typedef std::bidirectional_iterator_tag iterator_category;
+					typedef Node                      value_type;
+					typedef std::ptrdiff_t            difference_type;
+					typedef Node*                     pointer;
+					typedef Node&                     reference;
+
+					FatAVLmap_iterator(FatAVLmap* map=nullptr, Leaf* leaf=nullptr, unsigned int slot=0);
+					FatAVLmap_iterator& operator++();
+					FatAVLmap_iterator operator++(int);
+					FatAVLmap_iterator& operator--();
+					FatAVLmap_iterator operator--(int);
+					Node & operator*() const;
+					Node * operator->() const;
+					bool operator!=(const FatAVLmap_iterator& rhs) const;
+					bool operator==(const FatAVLmap_iterator& rhs) const;
+					friend class FatAVLmap;
+			};
+
+			struct FatAVLmap_iterator_const
+			{
+				private:
+					FatAVLmap const* mMap;
+					Leaf const* mLeaf; // nullptr is end
+					unsigned int mSlot;
+				public:
+					typedef std::bidirectional_iterator_tag iterator_category;
+					typedef Node                      value_type;
+					typedef std::ptrdiff_t            difference_type;
+					typedef Node const*               pointer;
+					typedef Node const&               reference;
+
+					FatAVLmap_iterator_const(FatAVLmap const* map=nullptr, Leaf const* leaf=nullptr, unsigned int slot=0);
+					FatAVLmap_iterator_const(const FatAVLmap_iterator& rhs);
+					FatAVLmap_iterator_const& operator++();
+					FatAVLmap_iterator_const operator++(int);
+					FatAVLmap_iterator_const& operator--();
+					FatAVLmap_iterator_const operator--(int);
+					Node const& operator*() const;
+					Node const* operator->() const;
+					bool operator!=(const FatAVLmap_iterator_const& rhs) const;
+					bool operator==(const FatAVLmap_iterator_const& rhs) const;
+					friend class FatAVLmap;
+			};
+
+			// FatAVLmap implementation
+			Block*         mRoot = nullptr;
+			unsigned int   mLevels = 0; // inner levels above the leaves
+			unsigned int   size_ = 0;
+			LeafAllocator  mLeafAlloc;
+			InnerAllocator mInnerAlloc;
+
+		public:
+			FatAVLmap();
+			explicit FatAVLmap(ALLOCATOR const& alloc);
+			FatAVLmap(const FatAVLmap& rhs);
+			FatAVLmap(FatAVLmap&& rhs);
+			FatAVLmap& operator=(const FatAVLmap& rhs);
+			FatAVLmap& operator=(FatAVLmap&& rhs);
+			~FatAVLmap();
+
+			unsigned int size() const;
+			ALLOCATOR get_allocator() const;
+			void clear();
+
+			//value setter and getter
+			VALUE_TYPE& operator[](KEY_TYPE const& key);
+
+			//standard names for iterator types
+			typedef FatAVLmap_iterator       iterator;
+			typedef FatAVLmap_iterator_const const_iterator;
+			typedef std::pair<KEY_TYPE, VALUE_TYPE> value_type;
+			typedef std::reverse_iterator<FatAVLmap_iterator>       reverse_iterator;
+			typedef std::reverse_iterator<FatAVLmap_iterator_const> const_reverse_iterator;
+
+			FatAVLmap_iterator begin();
+			FatAVLmap_iterator end();
+			reverse_iterator rbegin();
+			reverse_iterator rend();
+			FatAVLmap_iterator find(KEY_TYPE const& key);
+			FatAVLmap_iterator erase(FatAVLmap_iterator it); // returns the entry after the erased one
+			unsigned int erase(KEY_TYPE const& key); // returns the number of nodes erased
+			FatAVLmap_iterator lower_bound(KEY_TYPE const& key); // first node with key >= given key
+			FatAVLmap_iterator upper_bound(KEY_TYPE const& key); // first node with key > given key
+
+			//insertion in a single descent, returns the node with the key and whether it was inserted
+			std::pair<FatAVLmap_iterator, bool> insert(value_type const& item);
+			std::pair<FatAVLmap_iterator, bool> insert(value_type&& item);
+			template< typename... ARGS >
+			std::pair<FatAVLmap_iterator, bool> try_emplace(KEY_TYPE const& key, ARGS&&... args);
+
+			FatAVLmap_iterator_const begin() const;
+			FatAVLmap_iterator_const end() const;
+			const_reverse_iterator rbegin() const;
+			const_reverse_iterator rend() const;
+			FatAVLmap_iterator_const find(KEY_TYPE const& key) const;
+			FatAVLmap_iterator_const lower_bound(KEY_TYPE const& key) const;
+			FatAVLmap_iterator_const upper_bound(KEY_TYPE const& key) const;
+
+			bool sanityCheck() const;
+
+			friend struct FatAVLmap_iterator;
+			friend struct FatAVLmap_iterator_const;
+		private:
+			Leaf* FindLeaf(KEY_TYPE key) const;
+			Leaf* FindEntry(KEY_TYPE key, unsigned int& slot) const;
+			Leaf* LowerBound(KEY_TYPE key, unsigned int& slot) const;
+			Leaf* UpperBound(KEY_TYPE key, unsigned int& slot) const;
+			Leaf* FirstLeaf() const;
+			Leaf* LastLeaf() const;
+
+			template< typename... ARGS >
+			std::pair<FatAVLmap_iterator, bool> TryEmplace(KEY_TYPE key, ARGS&&... args);
+			Leaf* SplitLeaf(Leaf* leaf);
+			void InsertIntoParent(Block* left, KEY_TYPE separator, Block* right, Inner*& spares);
+			static void InsertChild(Inner* inner, unsigned int index, KEY_TYPE separator, Block* child);
+			static void RemoveChild(Inner* inner, unsigned int index);
+			static unsigned int ChildIndex(Inner const* parent, Block const* child);
+
+			void EraseEntry(Leaf* leaf, unsigned int slot);
+			void FixLeaf(Leaf* leaf);
+			void MergeLeaves(Leaf* left, Leaf* right, unsigned int separator);
+			void FixInner(Inner* inner);
+			void MergeInners(Inner* left, Inner* right, unsigned int separator);
+
+			static void MoveEntries(Leaf* from, unsigned int first, unsigned int count, Leaf* to, unsigned int destination);
+			Leaf* CreateLeaf();
+			Inner* CreateInner();
+			static Inner* TakeSpare(Inner*& spares);
+			void FreeSpares(Inner* spares);
+			void FreeLeaf(Leaf* leaf);
+			void FreeInner(Inner* inner);
+			void DestroyTree(Block* block, unsigned int level);
+			Block* CopyTree(Block const* block, unsigned int level, Inner* parent, Leaf*& last);
+
+			bool CheckBlock(Block const* block, unsigned int level, KEY_TYPE const* low, KEY_TYPE const* high,
+			                Leaf const*& previous, unsigned int& count) const;
+	};
+}
+
+#include "fat-avl-map.cpp"
+#endif
@@ -0,0 +1,644 @@
+/**
+ * @file frozen-avl-map.cpp
+ * @brief This implements the frozen snapshot of a map. Node k of the implicit tree has children 2k and 2k + 1,
+ *        so a lookup only computes indices: it goes right when the node's key is less than the key and left otherwise,
+ *        and the answer is the last node where it went left. That node is recovered from the final index
+ *        by dropping the right turns taken after it. The blocked index of integral keys is searched the same way
+ *        with LINE_KEYS + 1 children per block: the number of keys of the block below the key picks the child,
+ *        and the answer is the last block key the search stopped in front of.
+ */
+
+#include "frozen-avl-map.h"
+
+/**
+ * @brief Construct an empty snapshot
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename COMPARE >
+CS280::FrozenAVLmap<KEY_TYPE,VALUE_TYPE,COMPARE>::FrozenAVLmap()
+{
+
+}
+
+/**
+ * @brief Construct an empty snapshot that orders its keys with the given comparator
+ *
+ * @param comp - key comparator
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename COMPARE >
+CS280::FrozenAVLmap<KEY_TYPE,VALUE_TYPE,COMPARE>::FrozenAVLmap(COMPARE const& comp) : mCompare(comp)
+{
+
+}
+
+/**
+ * @brief Builds the snapshot from a range sorted by key. The range is walked once to skip repeated keys,
+ *        then every element is copied straight into its slot of the implicit tree. O(n).
+ *
+ * @param first - first element of the range (a pair, or a node with Key() and Value())
+ * @param last - end of the range
+ * @param comp - key comparator
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename COMPARE >
+template< typename ITER >
+CS280::FrozenAVLmap<KEY_TYPE,VALUE_TYPE,COMPARE>::FrozenAVLmap(ITER first, ITER last, COMPARE const& comp) : mCompare(comp)
+{
+    std::vector<ITER> sorted;
+
+    for(; first != last; ++first)
+    {
+        // The first of equal keys is kept, like the AVLmap range constructor
+        if(sorted.empty() || mCompare(ElementKey(*sorted.back()), ElementKey(*first)))
+            sorted.push_back(first);
+    }
+
+    std::size_t count = sorted.size();
+
+    // The in-order walk of the implicit tree visits its nodes in key order
+    std::vector<std::size_t> rank(count);
+    std::size_t index = First(count);
+
+    for(std::size_t position = 0; position < count; ++position)
+    {
+        rank[index - 1] = position;
+        index = Next(index, count);
+    }
+
+    mKeys.reserve(count);
+    mNodes.reserve(count);
+
+    for(std::size_t slot = 0; slot < count; ++slot)
+    {
+        mKeys.push_back(ElementKey(*sorted[rank[slot]]));
+        mNodes.push_back(Node(nullptr, ElementValue(*sorted[rank[slot]])));
+    }
+
+    LinkKeys();
+    BuildBlocks();
+}
+
+/**
+ * @brief Copy constructor. The nodes of the copy point at the copy's keys.
+ *
+ * @param rhs - snapshot to copy
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename COMPARE >
+CS280::FrozenAVLmap<KEY_TYPE,VALUE_TYPE,COMPARE>::FrozenAVLmap(const FrozenAVLmap& rhs)
+    : mKeys(rhs.mKeys), mNodes(rhs.mNodes), mBlocks(rhs.mBlocks), mBlockNodes(rhs.mBlockNodes), mCompare(rhs.mCompare)
+{
+    LinkKeys();
+}
+
+/**
+ * @brief Assignment operator. Copies rhs first, so this snapshot is unchanged if a copy throws.
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename COMPARE >
+CS280::FrozenAVLmap<KEY_TYPE,VALUE_TYPE,COMPARE>& CS280::FrozenAVLmap<KEY_TYPE,VALUE_TYPE,COMPARE>::operator=(const FrozenAVLmap& rhs)
+{
+    if(this != &rhs)
+    {
+        FrozenAVLmap copy(rhs);
+        *this = std::move(copy);
+    }
+
+    return *this;
+}
+
+/**
+ * @brief Returns the number of entries in the snapshot
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename COMPARE >
+unsigned int CS280::FrozenAVLmap<KEY_TYPE,VALUE_TYPE,COMPARE>::size() const
+{
+    return static_cast<unsigned int>(mKeys.size());
+}
+
+/**
+ * @brief Returns the comparator that orders the keys
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename COMPARE >
+COMPARE CS280::FrozenAVLmap<KEY_TYPE,VALUE_TYPE,COMPARE>::key_comp() const
+{
+    return mCompare;
+}
+
+/**
+ * @brief Returns the begin iterator of the snapshot
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename COMPARE >
+typename CS280::FrozenAVLmap<KEY_TYPE,VALUE_TYPE,COMPARE>::FrozenAVLmap_iterator_const CS280::FrozenAVLmap<KEY_TYPE,VALUE_TYPE,COMPARE>::begin() const
+{
+    return FrozenAVLmap_iterator_const(this, First(mKeys.size()));
+}
+
+/**
+ * @brief Returns the end iterator
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename COMPARE >
+typename CS280::FrozenAVLmap<KEY_TYPE,VALUE_TYPE,COMPARE>::FrozenAVLmap_iterator_const CS280::FrozenAVLmap<KEY_TYPE,VALUE_TYPE,COMPARE>::end() const
+{
+    return FrozenAVLmap_iterator_const(this, 0);
+}
+
+/**
+ * @brief Returns the reverse begin iterator (the last entry)
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename COMPARE >
+typename CS280::FrozenAVLmap<KEY_TYPE,VALUE_TYPE,COMPARE>::const_reverse_iterator CS280::FrozenAVLmap<KEY_TYPE,VALUE_TYPE,COMPARE>::rbegin() const
+{
+    return const_reverse_iterator(end());
+}
+
+/**
+ * @brief Returns the reverse end iterator (before the first entry)
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename COMPARE >
+typename CS280::FrozenAVLmap<KEY_TYPE,VALUE_TYPE,COMPARE>::const_reverse_iterator CS280::FrozenAVLmap<KEY_TYPE,VALUE_TYPE,COMPARE>::rend() const
+{
+    return const_reverse_iterator(begin());
+}
+
+/**
+ * @brief Finds the entry of given key and returns as an iterator
+ *
+ * @param key - key to find
+ * @return the entry, or end if the key is missing
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename COMPARE >
+typename CS280::FrozenAVLmap<KEY_TYPE,VALUE_TYPE,COMPARE>::FrozenAVLmap_iterator_const CS280::FrozenAVLmap<KEY_TYPE,VALUE_TYPE,COMPARE>::find(KEY_TYPE const& key) const
+{
+    std::size_t bound = LowerBound(key);
+
+    // The bound is not less than the key, so it is the key if the key is not less either
+    if(bound != 0 && !mCompare(key, mKeys[bound - 1]))
+        return FrozenAVLmap_iterator_const(this, bound);
+
+    return end();
+}
+
+/**
+ * @brief Returns the first entry with a key not less than the given key
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename COMPARE >
+typename CS280::FrozenAVLmap<KEY_TYPE,VALUE_TYPE,COMPARE>::FrozenAVLmap_iterator_const CS280::FrozenAVLmap<KEY_TYPE,VALUE_TYPE,COMPARE>::lower_bound(KEY_TYPE const& key) const
+{
+    return FrozenAVLmap_iterator_const(this, LowerBound(key));
+}
+
+/**
+ * @brief Returns the first entry with a key greater than the given key
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename COMPARE >
+typename CS280::FrozenAVLmap<KEY_TYPE,VALUE_TYPE,COMPARE>::FrozenAVLmap_iterator_const CS280::FrozenAVLmap<KEY_TYPE,VALUE_TYPE,COMPARE>::upper_bound(KEY_TYPE const& key) const
+{
+    return FrozenAVLmap_iterator_const(this, UpperBound(key));
+}
+
+/**
+ * @brief Returns the range of entries with the given key (empty or one entry)
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename COMPARE >
+std::pair<typename CS280::FrozenAVLmap<KEY_TYPE,VALUE_TYPE,COMPARE>::FrozenAVLmap_iterator_const, typename CS280::FrozenAVLmap<KEY_TYPE,VALUE_TYPE,COMPARE>::FrozenAVLmap_iterator_const> CS280::FrozenAVLmap<KEY_TYPE,VALUE_TYPE,COMPARE>::equal_range(KEY_TYPE const& key) const
+{
+    FrozenAVLmap_iterator_const lower = lower_bound(key);
+    FrozenAVLmap_iterator_const upper = lower;
+
+    if(lower.mIndex != 0 && !mCompare(key, lower->Key()))
+        ++upper;
+
+    return std::make_pair(lower, upper);
+}
+
+/**
+ * @brief Finds the first node with a key not less than the given key. The comparison only picks the next index,
+ *        so the loop has no data dependent branch and runs the same number of steps for every key.
+ *
+ * @return the node index, 0 if every key is less
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename COMPARE >
+std::size_t CS280::FrozenAVLmap<KEY_TYPE,VALUE_TYPE,COMPARE>::LowerBound(KEY_TYPE const& key) const
+{
+    if constexpr(BLOCKED)
+    {
+        return BlockedBound<false>(key);
+    }
+
+    KEY_TYPE const* keys = mKeys.data();
+    std::size_t count = mKeys.size();
+    std::size_t index = 1;
+
+    while(index <= count)
+    {
+        Prefetch(index);
+        index = 2 * index + static_cast<std::size_t>(mCompare(keys[index - 1], key));
+    }
+
+    // Drop the right turns after the last left turn, then the left turn itself
+    while(index & 1)
+    {
+        index >>= 1;
+    }
+
+    return index >> 1;
+}
+
+/**
+ * @brief Finds the first node with a key greater than the given key, with the same branchless descent as LowerBound.
+ *
+ * @return the node index, 0 if no key is greater
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename COMPARE >
+std::size_t CS280::FrozenAVLmap<KEY_TYPE,VALUE_TYPE,COMPARE>::UpperBound(KEY_TYPE const& key) const
+{
+    if constexpr(BLOCKED)
+    {
+        // The padding holds the largest key, which would count as not greater than it
+        if(key == std::numeric_limits<KEY_TYPE>::max())
+            return 0;
+
+        return BlockedBound<true>(key);
+    }
+
+    KEY_TYPE const* keys = mKeys.data();
+    std::size_t count = mKeys.size();
+    std::size_t index = 1;
+
+    while(index <= count)
+    {
+        Prefetch(index);
+        index = 2 * index + static_cast<std::size_t>(!mCompare(key, keys[index - 1]));
+    }
+
+    while(index & 1)
+    {
+        index >>= 1;
+    }
+
+    return index >> 1;
+}
+
+/**
+ * @brief Searches the blocked index for the first node with a key not less than the given key (greater, with OR_EQUAL).
+ *        Each level counts the keys of one block below the key with a single line compare and goes to that child,
+ *        and the block key right after them, if there is one, is the best answer so far: the child only holds
+ *        keys between it and the block key before it. Padding slots hold the largest key, so they are never below
+ *        the key, and an answer that lands on one is node 0, the end.
+ *
+ * @return the node index, 0 if there is none
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename COMPARE >
+template< bool OR_EQUAL >
+std::size_t CS280::FrozenAVLmap<KEY_TYPE,VALUE_TYPE,COMPARE>::BlockedBound(KEY_TYPE const& key) const
+{
+    KeyBlock const* blocks = mBlocks.data();
+    std::size_t count = mBlocks.size();
+    std::size_t block = 0;
+    std::size_t found = 0;
+
+    while(block < count)
+    {
+        unsigned int below = KeyLine<LineKey>::template CountBelow<OR_EQUAL>(blocks[block].keys, LINE_KEYS, key);
+
+        if(below < LINE_KEYS)
+            found = mBlockNodes[block * LINE_KEYS + below];
+
+        block = block * (LINE_KEYS + 1) + below + 1;
+    }
+
+    return found;
+}
+
+/**
+ * @brief Builds the blocked index of an integral key map, with as few blocks as hold every key. Does nothing
+ *        unless BLOCKED.
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename COMPARE >
+void CS280::FrozenAVLmap<KEY_TYPE,VALUE_TYPE,COMPARE>::BuildBlocks()
+{
+    if constexpr(BLOCKED)
+    {
+        std::size_t count = mKeys.size();
+
+        mBlocks.resize((count + LINE_KEYS - 1) / LINE_KEYS);
+        mBlockNodes.resize(mBlocks.size() * LINE_KEYS);
+
+        std::size_t index = First(count);
+        FillBlock(0, index);
+    }
+}
+
+/**
+ * @brief Fills a block and its subtree with the next keys in order, using inorder traversal: each child
+ *        comes before the block key that follows it. Past the last key the slots get the largest key and node 0.
+ *
+ * @param block - block to fill
+ * @param index - next node in key order, 0 once every key is placed
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename COMPARE >
+void CS280::FrozenAVLmap<KEY_TYPE,VALUE_TYPE,COMPARE>::FillBlock(std::size_t block, std::size_t& index)
+{
+    if(block >= mBlocks.size())
+        return;
+
+    for(unsigned int slot = 0; slot < LINE_KEYS; ++slot)
+    {
+        FillBlock(block * (LINE_KEYS + 1) + slot + 1, index);
+
+        mBlocks[block].keys[slot] = index != 0 ? mKeys[index - 1] : std::numeric_limits<LineKey>::max();
+        mBlockNodes[block * LINE_KEYS + slot] = static_cast<unsigned int>(index);
+
+        if(index != 0)
+            index = Next(index, mKeys.size());
+    }
+
+    FillBlock(block * (LINE_KEYS + 1) + LINE_KEYS + 1, index);
+}
+
+/**
+ * @brief Starts loading the cache line holding the descendants of a node a few levels down, so they are
+ *        in cache by the time the search gets there. Does nothing when the compiler has no prefetch builtin.
+ *
+ * @param index - node the search is at
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename COMPARE >
+void CS280::FrozenAVLmap<KEY_TYPE,VALUE_TYPE,COMPARE>::Prefetch(std::size_t index) const
+{
+#if defined(__GNUC__)
+    std::size_t ahead = index * PREFETCH_STRIDE;
+
+    if(PREFETCH_STRIDE > 1 && ahead <= mKeys.size())
+        __builtin_prefetch(mKeys.data() + (ahead - 1));
+#else
+    (void)index;
+#endif
+}
+
+/**
+ * @brief Points every node at its key. Needed whenever the key array was built or copied
+ *        (moving a vector keeps its buffer, so moved snapshots stay linked).
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename COMPARE >
+void CS280::FrozenAVLmap<KEY_TYPE,VALUE_TYPE,COMPARE>::LinkKeys()
+{
+    for(std::size_t slot = 0; slot < mNodes.size(); ++slot)
+    {
+        mNodes[slot].key = mKeys.data() + slot;
+    }
+}
+
+/**
+ * @brief Returns the first node in key order (the leftmost), 0 for an empty tree
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename COMPARE >
+std::size_t CS280::FrozenAVLmap<KEY_TYPE,VALUE_TYPE,COMPARE>::First(std::size_t count)
+{
+    if(count == 0)
+        return 0;
+
+    std::size_t index = 1;
+
+    while(2 * index <= count)
+    {
+        index = 2 * index;
+    }
+
+    return index;
+}
+
+/**
+ * @brief Returns the last node in key order (the rightmost), 0 for an empty tree
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename COMPARE >
+std::size_t CS280::FrozenAVLmap<KEY_TYPE,VALUE_TYPE,COMPARE>::Last(std::size_t count)
+{
+    if(count == 0)
+        return 0;
+
+    std::size_t index = 1;
+
+    while(2 * index + 1 <= count)
+    {
+        index = 2 * index + 1;
+    }
+
+    return index;
+}
+
+/**
+ * @brief Returns the in-order successor of a node (0 after the last one)
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename COMPARE >
+std::size_t CS280::FrozenAVLmap<KEY_TYPE,VALUE_TYPE,COMPARE>::Next(std::size_t index, std::size_t count)
+{
+    if(2 * index + 1 <= count)
+    {
+        // Leftmost node of the right subtree
+        index = 2 * index + 1;
+
+        while(2 * index <= count)
+        {
+            index = 2 * index;
+        }
+
+        return index;
+    }
+
+    // Up past every ancestor we are the right child of, then one more
+    while(index & 1)
+    {
+        index >>= 1;
+    }
+
+    return index >> 1;
+}
+
+/**
+ * @brief Returns the in-order predecessor of a node (0 before the first one)
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename COMPARE >
+std::size_t CS280::FrozenAVLmap<KEY_TYPE,VALUE_TYPE,COMPARE>::Previous(std::size_t index, std::size_t count)
+{
+    if(2 * index <= count)
+    {
+        // Rightmost node of the left subtree
+        index = 2 * index;
+
+        while(2 * index + 1 <= count)
+        {
+            index = 2 * index + 1;
+        }
+
+        return index;
+    }
+
+    // Up past every ancestor we are the left child of, then one more
+    while(index != 0 && (index & 1) == 0)
+    {
+        index >>= 1;
+    }
+
+    return index >> 1;
+}
+
+/**
+ * @brief Returns the key of a pair in a build range
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename COMPARE >
+template< typename FIRST, typename SECOND >
+FIRST const& CS280::FrozenAVLmap<KEY_TYPE,VALUE_TYPE,COMPARE>::ElementKey(std::pair<FIRST, SECOND> const& item)
+{
+    return item.first;
+}
+
+/**
+ * @brief Returns the key of a node in a build range
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename COMPARE >
+template< typename NODE >
+auto CS280::FrozenAVLmap<KEY_TYPE,VALUE_TYPE,COMPARE>::ElementKey(NODE const& node) -> decltype(node.Key())
+{
+    return node.Key();
+}
+
+/**
+ * @brief Returns the value of a pair in a build range
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename COMPARE >
+template< typename FIRST, typename SECOND >
+SECOND const& CS280::FrozenAVLmap<KEY_TYPE,VALUE_TYPE,COMPARE>::ElementValue(std::pair<FIRST, SECOND> const& item)
+{
+    return item.second;
+}
+
+/**
+ * @brief Returns the value of a node in a build range
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename COMPARE >
+template< typename NODE >
+auto CS280::FrozenAVLmap<KEY_TYPE,VALUE_TYPE,COMPARE>::ElementValue(NODE const& node) -> decltype(node.Value())
+{
+    return node.Value();
+}
+
+/**
+ * @brief Construct a node
+ *
+ * @param k - the key in the key array (linked later when the array is still being built)
+ * @param val - value
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename COMPARE >
+CS280::FrozenAVLmap<KEY_TYPE,VALUE_TYPE,COMPARE>::Node::Node(KEY_TYPE const* k, VALUE_TYPE const& val) : key(k), value(val)
+{
+
+}
+
+/**
+ * @brief Returns the key of the node
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename COMPARE >
+KEY_TYPE const& CS280::FrozenAVLmap<KEY_TYPE,VALUE_TYPE,COMPARE>::Node::Key() const
+{
+    return *key;
+}
+
+/**
+ * @brief Returns the value of the node
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename COMPARE >
+VALUE_TYPE const& CS280::FrozenAVLmap<KEY_TYPE,VALUE_TYPE,COMPARE>::Node::Value() const
+{
+    return value;
+}
+
+/**
+ * @brief Constructor for const iterator
+ *
+ * @param map - snapshot the entry is in
+ * @param index - node index, 0 for end
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename COMPARE >
+CS280::FrozenAVLmap<KEY_TYPE,VALUE_TYPE,COMPARE>::FrozenAVLmap_iterator_const::FrozenAVLmap_iterator_const(FrozenAVLmap const* map, std::size_t index) : mMap(map), mIndex(index)
+{
+
+}
+
+/**
+ * @brief Prefix increment operator for const iterators
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename COMPARE >
+typename CS280::FrozenAVLmap<KEY_TYPE,VALUE_TYPE,COMPARE>::FrozenAVLmap_iterator_const& CS280::FrozenAVLmap<KEY_TYPE,VALUE_TYPE,COMPARE>::FrozenAVLmap_iterator_const::operator++()
+{
+    mIndex = Next(mIndex, mMap->mKeys.size());
+    return *this;
+}
+
+/**
+ * @brief Postfix increment operator for const iterators
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename COMPARE >
+typename CS280::FrozenAVLmap<KEY_TYPE,VALUE_TYPE,COMPARE>::FrozenAVLmap_iterator_const CS280::FrozenAVLmap<KEY_TYPE,VALUE_TYPE,COMPARE>::FrozenAVLmap_iterator_const::operator++(int)
+{
+    FrozenAVLmap_iterator_const temp = *this;
+    ++*this;
+    return temp;
+}
+
+/**
+ * @brief Prefix decrement operator for const iterators. Decrementing end gives the last entry.
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename COMPARE >
+typename CS280::FrozenAVLmap<KEY_TYPE,VALUE_TYPE,COMPARE>::FrozenAVLmap_iterator_const& CS280::FrozenAVLmap<KEY_TYPE,VALUE_TYPE,COMPARE>::FrozenAVLmap_iterator_const::operator--()
+{
+    std::size_t count = mMap->mKeys.size();
+
+    mIndex = mIndex == 0 ? Last(count) : Previous(mIndex, count);
+    return *this;
+}
+
+/**
+ * @brief Postfix decrement operator for const iterators
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename COMPARE >
+typename CS280::FrozenAVLmap<KEY_TYPE,VALUE_TYPE,COMPARE>::FrozenAVLmap_iterator_const CS280::FrozenAVLmap<KEY_TYPE,VALUE_TYPE,COMPARE>::FrozenAVLmap_iterator_const::operator--(int)
+{
+    FrozenAVLmap_iterator_const temp = *this;
+    --*this;
+    return temp;
+}
+
+/**
+ * @brief Dereference operator for const iterator
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename COMPARE >
+typename CS280::FrozenAVLmap<KEY_TYPE,VALUE_TYPE,COMPARE>::Node const& CS280::FrozenAVLmap<KEY_TYPE,VALUE_TYPE,COMPARE>::FrozenAVLmap_iterator_const::operator*() const
+{
+    return mMap->mNodes[mIndex - 1];
+}
+
+/**
+ * @brief Arrow operator for const iterator
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename COMPARE >
+typename CS280::FrozenAVLmap<KEY_TYPE,VALUE_TYPE,COMPARE>::Node const* CS280::FrozenAVLmap<KEY_TYPE,VALUE_TYPE,COMPARE>::FrozenAVLmap_iterator_const::operator->() const
+{
+    return mMap->mNodes.data() + (mIndex - 1);
+}
+
+/**
+ * @brief Not equal operator for const iterator.
+ * @param rhs - check value against
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename COMPARE >
+bool CS280::FrozenAVLmap<KEY_TYPE,VALUE_TYPE,COMPARE>::FrozenAVLmap_iterator_const::operator!=(const FrozenAVLmap_iterator_const& rhs) const
+{
+    return mIndex != rhs.mIndex;
+}
+
+/**
+ * @brief Equal operator for const iterator.
+ * @param rhs - check value against
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename COMPARE >
+bool CS280::FrozenAVLmap<KEY_TYPE,VALUE_TYPE,COMPARE>::FrozenAVLmap_iterator_const::operator==(const FrozenAVLmap_iterator_const& rhs) const
+{
+    return mIndex == rhs.mIndex;
+}
@@ -0,0 +1,156 @@
+/**
+ * @file frozen-avl-map.h
+ * @brief A read-only snapshot of a map (see AVLmap::freeze). The keys are kept in one array in Eytzinger
+ *        (breadth first) order, with the values in a parallel array of nodes, so a lookup walks down an implicit tree
+ *        that only holds keys, without pointers and without branching on the comparisons. Integral keys in their
+ *        natural order are also kept in cache line blocks laid out like a B-tree in breadth first order, and
+ *        a lookup there compares a whole block per level at once (AVX2 or NEON when the target has it, see KeyLine).
+ *        The snapshot never changes, so any number of threads can read it at the same time.
+ */
+
+#ifndef FROZEN_AVLMAP_H
+#define FROZEN_AVLMAP_H
+
+#include <cstddef>
+#include <functional>
+#include <iterator>
+#include <limits>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "key-line.h"
+
+namespace CS280 {
+
+    // COMPARE orders the keys, the same way as the map the snapshot is taken of
+    template< typename KEY_TYPE, typename VALUE_TYPE, typename COMPARE = std::less<KEY_TYPE> >
+    class FrozenAVLmap {
+		public:
+
+			// value of one entry, so iterators can be used like AVLmap's (it->Key(), it->Value())
+			class Node
+			{
+				public:
+					Node( KEY_TYPE const* k, VALUE_TYPE const& val );
+
+					KEY_TYPE const & Key() const;   // return a const reference
+					VALUE_TYPE const & Value() const; // return a const reference
+				private:
+					KEY_TYPE const* key; // the key in the key array, the search never touches the nodes
+					VALUE_TYPE  value;
+
+					friend class FrozenAVLmap;
+			};
+
+		private:
+
+			// elements per cache line, a lookup prefetches the line holding the nodes that many levels down
+			static constexpr std::size_t PREFETCH_STRIDE = sizeof(KEY_TYPE) < 64 ? 64 / sizeof(KEY_TYPE) : 1;
+
+			// whether the lookups use the blocked index: integral keys ordered by <, which is the order the vector compares use
+			static constexpr bool BLOCKED = std::is_integral<KEY_TYPE>::value && !std::is_same<KEY_TYPE, bool>::value &&
+			                                (std::is_same<COMPARE, std::less<KEY_TYPE> >::value || std::is_same<COMPARE, std::less<> >::value);
+			typedef typename std::conditional<BLOCKED, KEY_TYPE, int>::type LineKey; // KEY_TYPE when BLOCKED
+			// keys per block, a cache line of them, and every block has one child more
+			static constexpr unsigned int LINE_KEYS = KeyLine<LineKey>::KEYS;
+
+			struct KeyBlock
+			{
+				alignas(KeyLine<LineKey>::CACHE_LINE) LineKey keys[LINE_KEYS]; // in order, the slots past the last key hold the largest key
+			};
+
+			struct FrozenAVLmap_iterator_const
+			{
+				private:
+					FrozenAVLmap const* mMap;
+					std::size_t mIndex; // position in the implicit tree, 1 is the root and 0 is end
+				public:
+					typedef std::bidirectional_iterator_tag iterator_category;
+					typedef Node                      value_type;
+					typedef std::ptrdiff_t            difference_type;
+					typedef Node const*               pointer;
+					typedef Node const&               reference;
+
+					FrozenAVLmap_iterator_const(FrozenAVLmap const* map=nullptr, std::size_t index=0);
+					FrozenAVLmap_iterator_const& operator++();
+					FrozenAVLmap_iterator_const operator++(int);
+					FrozenAVLmap_iterator_const& operator--();
+					FrozenAVLmap_iterator_const operator--(int);
+					Node const& operator*() const;
+					Node const* operator->() const;
+					bool operator!=(const FrozenAVLmap_iterator_const& rhs) const;
+					bool operator==(const FrozenAVLmap_iterator_const& rhs) const;
+					friend class FrozenAVLmap;
+			};
+
+			// FrozenAVLmap implementation
+			std::vector<KEY_TYPE>   mKeys; // node k of the implicit tree is mKeys[k - 1], its children are 2k and 2k + 1
+			std::vector<Node>       mNodes; // same order as the keys
+			// blocked index, only built when BLOCKED: block b's children are blocks b * (LINE_KEYS + 1) + 1 and on
+			std::vector<KeyBlock>       mBlocks;
+			std::vector<unsigned int>   mBlockNodes; // index of the node of every slot of mBlocks, 0 past the last key
+			COMPARE                 mCompare;
+
+		public:
+			FrozenAVLmap();
+			explicit FrozenAVLmap(COMPARE const& comp);
+			//linear time build from a forward range of pairs or nodes sorted by key (the first of equal keys is kept)
+			template< typename ITER >
+			FrozenAVLmap(ITER first, ITER last, COMPARE const& comp = COMPARE());
+			FrozenAVLmap(const FrozenAVLmap& rhs);
+			FrozenAVLmap(FrozenAVLmap&& rhs) = default;
+			FrozenAVLmap& operator=(const FrozenAVLmap& rhs);
+			FrozenAVLmap& operator=(FrozenAVLmap&& rhs) = default;
+
+			unsigned int size() const;
+			COMPARE key_comp() const;
+
+			//standard names for iterator types, every iterator is const
+			typedef FrozenAVLmap_iterator_const iterator;
+			typedef FrozenAVLmap_iterator_const const_iterator;
+			typedef std::pair<KEY_TYPE, VALUE_TYPE> value_type;
+			typedef std::reverse_iterator<FrozenAVLmap_iterator_const> const_reverse_iterator;
+			typedef const_reverse_iterator reverse_iterator;
+
+			FrozenAVLmap_iterator_const begin() const;
+			FrozenAVLmap_iterator_const end() const;
+			const_reverse_iterator rbegin() const;
+			const_reverse_iterator rend() const;
+
+			//branchless searches, one comparison per level of the implicit tree (one block compare per level when BLOCKED)
+			FrozenAVLmap_iterator_const find(KEY_TYPE const& key) const;
+			FrozenAVLmap_iterator_const lower_bound(KEY_TYPE const& key) const; // first node with key >= given key
+			FrozenAVLmap_iterator_const upper_bound(KEY_TYPE const& key) const; // first node with key > given key
+			std::pair<FrozenAVLmap_iterator_const, FrozenAVLmap_iterator_const> equal_range(KEY_TYPE const& key) const;
+
+			friend struct FrozenAVLmap_iterator_const;
+		private:
+			std::size_t LowerBound(KEY_TYPE const& key) const;
+			std::size_t UpperBound(KEY_TYPE const& key) const;
+			void Prefetch(std::size_t index) const;
+			void LinkKeys();
+			template< bool OR_EQUAL >
+			std::size_t BlockedBound(KEY_TYPE const& key) const;
+			void BuildBlocks();
+			void FillBlock(std::size_t block, std::size_t& index);
+
+			// in-order walk of an implicit tree with count nodes
+			static std::size_t First(std::size_t count);
+			static std::size_t Last(std::size_t count);
+			static std::size_t Next(std::size_t index, std::size_t count);
+			static std::size_t Previous(std::size_t index, std::size_t count);
+
+			template< typename FIRST, typename SECOND >
+			static FIRST const& ElementKey(std::pair<FIRST, SECOND> const& item);
+			template< typename NODE >
+			static auto ElementKey(NODE const& node) -> decltype(node.Key());
+			template< typename FIRST, typename SECOND >
+			static SECOND const& ElementValue(std::pair<FIRST, SECOND> const& item);
+			template< typename NODE >
+			static auto ElementValue(NODE const& node) -> decltype(node.Value());
+	};
+}
+
+#include "frozen-avl-map.cpp"
+#endif
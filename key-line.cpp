@@ -0,0 +1,221 @@
+/**
+ * @file key-line.cpp
+ * @brief This implements the key line search. With AVX2 a line of 32 or 64 bit keys is two 256 bit registers
+ *        compared at once into a bit mask whose set bits are counted, with NEON the lanes' all ones results are
+ *        summed, and everything else counts in a plain loop.
+ */
+
+#include "key-line.h"
+
+/**
+ * @brief Counts the keys of a line that are less than the given key (or not greater, with OR_EQUAL),
+ *        which is where the key goes among them (or which child to take in a search tree). 32 and 64 bit keys
+ *        fill the key line exactly, so with AVX2 or NEON the whole line is compared at once and the lanes
+ *        past count are masked off, without a branch per key. Other keys, and other targets, count
+ *        in a loop without a branch that the compiler is free to vectorize.
+ *
+ * @param keys - the key line, KEYS keys aligned to a cache line (the ones past count are ignored)
+ * @param count - keys in use
+ * @param key - key to compare with
+ * @return the number of keys below the key
+ */
+template< typename KEY_TYPE >
+template< bool OR_EQUAL >
+unsigned int CS280::KeyLine<KEY_TYPE>::CountBelow(KEY_TYPE const* keys, unsigned int count, KEY_TYPE key)
+{
+#if defined(__AVX2__)
+    if constexpr(sizeof(KEY_TYPE) == 4 || sizeof(KEY_TYPE) == 8)
+    {
+        unsigned int live = (1u << count) - 1;
+
+        if constexpr(OR_EQUAL)
+            return count - CountBits(GreaterMask(keys, key) & live);
+        else
+            return CountBits(LessMask(keys, key) & live);
+    }
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+    if constexpr(sizeof(KEY_TYPE) == 4)
+    {
+        // A true lane is all ones, so subtracting the masks counts them
+        uint32x4_t const lanes = { 0, 1, 2, 3 };
+        uint32x4_t const limit = vdupq_n_u32(count);
+        uint32x4_t below = vdupq_n_u32(0);
+
+        for(unsigned int first = 0; first < KEYS; first += 4)
+        {
+            uint32x4_t hits;
+
+            if constexpr(std::is_signed<KEY_TYPE>::value)
+            {
+                int32x4_t line = vld1q_s32(reinterpret_cast<std::int32_t const*>(keys + first));
+                int32x4_t probe = vdupq_n_s32(static_cast<std::int32_t>(key));
+                hits = OR_EQUAL ? vcleq_s32(line, probe) : vcltq_s32(line, probe);
+            }
+            else
+            {
+                uint32x4_t line = vld1q_u32(reinterpret_cast<std::uint32_t const*>(keys + first));
+                uint32x4_t probe = vdupq_n_u32(static_cast<std::uint32_t>(key));
+                hits = OR_EQUAL ? vcleq_u32(line, probe) : vcltq_u32(line, probe);
+            }
+
+            uint32x4_t inUse = vcltq_u32(vaddq_u32(lanes, vdupq_n_u32(first)), limit);
+            below = vsubq_u32(below, vandq_u32(hits, inUse));
+        }
+
+        return vaddvq_u32(below);
+    }
+    else if constexpr(sizeof(KEY_TYPE) == 8)
+    {
+        uint64x2_t const lanes = { 0, 1 };
+        uint64x2_t const limit = vdupq_n_u64(count);
+        uint64x2_t below = vdupq_n_u64(0);
+
+        for(unsigned int first = 0; first < KEYS; first += 2)
+        {
+            uint64x2_t hits;
+
+            if constexpr(std::is_signed<KEY_TYPE>::value)
+            {
+                int64x2_t line = vld1q_s64(reinterpret_cast<std::int64_t const*>(keys + first));
+                int64x2_t probe = vdupq_n_s64(static_cast<std::int64_t>(key));
+                hits = OR_EQUAL ? vcleq_s64(line, probe) : vcltq_s64(line, probe);
+            }
+            else
+            {
+                uint64x2_t line = vld1q_u64(reinterpret_cast<std::uint64_t const*>(keys + first));
+                uint64x2_t probe = vdupq_n_u64(static_cast<std::uint64_t>(key));
+                hits = OR_EQUAL ? vcleq_u64(line, probe) : vcltq_u64(line, probe);
+            }
+
+            uint64x2_t inUse = vcltq_u64(vaddq_u64(lanes, vdupq_n_u64(first)), limit);
+            below = vsubq_u64(below, vandq_u64(hits, inUse));
+        }
+
+        return static_cast<unsigned int>(vaddvq_u64(below));
+    }
+#endif
+
+    unsigned int below = 0;
+
+    for(unsigned int i = 0; i < count; ++i)
+        below += OR_EQUAL ? !(key < keys[i]) : keys[i] < key;
+
+    return below;
+}
+
+#if defined(__AVX2__)
+/**
+ * @brief Compares a whole key line of 32 or 64 bit keys with a key, two 256 bit registers.
+ *        AVX2 only compares signed lanes, so unsigned keys have their top bit flipped first, which keeps their order.
+ *
+ * @param keys - the key line, cache line aligned
+ * @param key - key to compare with
+ * @return a bit per key, set where the key in the line is less than the given key
+ */
+template< typename KEY_TYPE >
+unsigned int CS280::KeyLine<KEY_TYPE>::LessMask(KEY_TYPE const* keys, KEY_TYPE key)
+{
+    __m256i const* line = reinterpret_cast<__m256i const*>(keys);
+    __m256i low = _mm256_load_si256(line);
+    __m256i high = _mm256_load_si256(line + 1);
+
+    if constexpr(sizeof(KEY_TYPE) == 4)
+    {
+        __m256i probe = _mm256_set1_epi32(static_cast<int>(key));
+
+        if constexpr(std::is_unsigned<KEY_TYPE>::value)
+        {
+            __m256i flip = _mm256_set1_epi32(std::numeric_limits<int>::min());
+            low = _mm256_xor_si256(low, flip);
+            high = _mm256_xor_si256(high, flip);
+            probe = _mm256_xor_si256(probe, flip);
+        }
+
+        unsigned int lowBits = static_cast<unsigned int>(_mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpgt_epi32(probe, low))));
+        unsigned int highBits = static_cast<unsigned int>(_mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpgt_epi32(probe, high))));
+
+        return lowBits | highBits << 8;
+    }
+    else
+    {
+        __m256i probe = _mm256_set1_epi64x(static_cast<long long>(key));
+
+        if constexpr(std::is_unsigned<KEY_TYPE>::value)
+        {
+            __m256i flip = _mm256_set1_epi64x(std::numeric_limits<long long>::min());
+            low = _mm256_xor_si256(low, flip);
+            high = _mm256_xor_si256(high, flip);
+            probe = _mm256_xor_si256(probe, flip);
+        }
+
+        unsigned int lowBits = static_cast<unsigned int>(_mm256_movemask_pd(_mm256_castsi256_pd(_mm256_cmpgt_epi64(probe, low))));
+        unsigned int highBits = static_cast<unsigned int>(_mm256_movemask_pd(_mm256_castsi256_pd(_mm256_cmpgt_epi64(probe, high))));
+
+        return lowBits | highBits << 4;
+    }
+}
+
+/**
+ * @brief Like LessMask, with a bit set where the key in the line is greater than the given key
+ */
+template< typename KEY_TYPE >
+unsigned int CS280::KeyLine<KEY_TYPE>::GreaterMask(KEY_TYPE const* keys, KEY_TYPE key)
+{
+    __m256i const* line = reinterpret_cast<__m256i const*>(keys);
+    __m256i low = _mm256_load_si256(line);
+    __m256i high = _mm256_load_si256(line + 1);
+
+    if constexpr(sizeof(KEY_TYPE) == 4)
+    {
+        __m256i probe = _mm256_set1_epi32(static_cast<int>(key));
+
+        if constexpr(std::is_unsigned<KEY_TYPE>::value)
+        {
+            __m256i flip = _mm256_set1_epi32(std::numeric_limits<int>::min());
+            low = _mm256_xor_si256(low, flip);
+            high = _mm256_xor_si256(high, flip);
+            probe = _mm256_xor_si256(probe, flip);
+        }
+
+        unsigned int lowBits = static_cast<unsigned int>(_mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpgt_epi32(low, probe))));
+        unsigned int highBits = static_cast<unsigned int>(_mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpgt_epi32(high, probe))));
+
+        return lowBits | highBits << 8;
+    }
+    else
+    {
+        __m256i probe = _mm256_set1_epi64x(static_cast<long long>(key));
+
+        if constexpr(std::is_unsigned<KEY_TYPE>::value)
+        {
+            __m256i flip = _mm256_set1_epi64x(std::numeric_limits<long long>::min());
+            low = _mm256_xor_si256(low, flip);
+            high = _mm256_xor_si256(high, flip);
+            probe = _mm256_xor_si256(probe, flip);
+        }
+
+        unsigned int lowBits = static_cast<unsigned int>(_mm256_movemask_pd(_mm256_castsi256_pd(_mm256_cmpgt_epi64(low, probe))));
+        unsigned int highBits = static_cast<unsigned int>(_mm256_movemask_pd(_mm256_castsi256_pd(_mm256_cmpgt_epi64(high, probe))));
+
+        return lowBits | highBits << 4;
+    }
+}
+
+/**
+ * @brief Returns the number of set bits
+ */
+template< typename KEY_TYPE >
+unsigned int CS280::KeyLine<KEY_TYPE>::CountBits(unsigned int mask)
+{
+#if defined(__GNUC__)
+    return static_cast<unsigned int>(__builtin_popcount(mask));
+#else
+    unsigned int bits = 0;
+
+    for(; mask != 0; mask &= mask - 1)
+        ++bits;
+
+    return bits;
+#endif
+}
+#endif
@@ -0,0 +1,46 @@
+/**
+ * @file key-line.h
+ * @brief Search of a cache line of integral keys, shared by the maps that keep their keys in fat, cache line
+ *        aligned nodes (FatAVLmap's nodes, FrozenAVLmap's blocked index). Counting the keys below a key gives
+ *        the position to go to, and with AVX2 or NEON the whole line is compared at once, without a branch per key.
+ */
+
+#ifndef KEY_LINE_H
+#define KEY_LINE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <type_traits>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+#include <arm_neon.h>
+#endif
+
+namespace CS280 {
+
+    template< typename KEY_TYPE >
+    class KeyLine {
+			static_assert(std::is_integral<KEY_TYPE>::value, "key lines hold integral keys");
+		public:
+			static constexpr std::size_t CACHE_LINE = 64;
+			// keys per line, a cache line of them
+			static constexpr unsigned int KEYS = CACHE_LINE / sizeof(KEY_TYPE) < 8 ? 8 :
+			                                     CACHE_LINE / sizeof(KEY_TYPE) > 32 ? 32 : CACHE_LINE / sizeof(KEY_TYPE);
+
+			// position of a key in a line of KEYS keys (keys less than it, or not greater), only the first count are read
+			template< bool OR_EQUAL >
+			static unsigned int CountBelow(KEY_TYPE const* keys, unsigned int count, KEY_TYPE key);
+		private:
+#if defined(__AVX2__)
+			static unsigned int LessMask(KEY_TYPE const* keys, KEY_TYPE key);
+			static unsigned int GreaterMask(KEY_TYPE const* keys, KEY_TYPE key);
+			static unsigned int CountBits(unsigned int mask);
+#endif
+	};
+}
+
+#include "key-line.cpp"
+#endif
@@ -0,0 +1,265 @@
+/**
+ * @file mapped-avl-map.cpp
+ * @brief This implements the memory mapped snapshot of a map. A snapshot file is a fixed header followed by
+ *        the nodes sorted by key. Opening one maps it and checks the header, the nodes are then used in place,
+ *        and a lookup is a binary search that leaves the comparison to a conditional move instead of a branch.
+ */
+
+#include "mapped-avl-map.h"
+
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+/**
+ * @brief Maps a snapshot file for reading. Only the header is read, the entries are paged in as they are used.
+ *
+ * @param path - file written by save or write
+ * @param comp - key comparator, the one the file was saved with
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename COMPARE >
+CS280::MappedAVLmap<KEY_TYPE,VALUE_TYPE,COMPARE>::MappedAVLmap(std::string const& path, COMPARE const& comp) : mCompare(comp)
+{
+    int file = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+
+    if(file < 0)
+        throw std::runtime_error("can't open " + path + ": " + std::strerror(errno));
+
+    struct stat info;
+
+    if(::fstat(file, &info) != 0 || static_cast<std::size_t>(info.st_size) < sizeof(typename Snapshot::FileHeader))
+    {
+        ::close(file);
+        throw std::runtime_error(path + " is not a map snapshot");
+    }
+
+    mLength = static_cast<std::size_t>(info.st_size);
+    mMapping = ::mmap(nullptr, mLength, PROT_READ, MAP_SHARED, file, 0);
+
+    // The mapping keeps the file alive
+    ::close(file);
+
+    if(mMapping == MAP_FAILED)
+    {
+        mMapping = nullptr;
+        throw std::runtime_error("can't map " + path + ": " + std::strerror(errno));
+    }
+
+    typename Snapshot::FileHeader header;
+    std::memcpy(&header, mMapping, sizeof(header));
+
+    // The destructor won't run for a constructor that throws
+    if(!Snapshot::valid(header, mLength))
+    {
+        Unmap();
+        throw std::runtime_error(path + " is not a snapshot of this map type");
+    }
+
+    mNodes = reinterpret_cast<Node const*>(static_cast<char const*>(mMapping) + header.entriesOffset);
+    mCount = static_cast<std::size_t>(header.count);
+}
+
+/**
+ * @brief Move constructor, takes rhs's mapping and leaves rhs empty
+ *
+ * @param rhs - snapshot to move
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename COMPARE >
+CS280::MappedAVLmap<KEY_TYPE,VALUE_TYPE,COMPARE>::MappedAVLmap(MappedAVLmap&& rhs)
+    : mMapping(rhs.mMapping), mLength(rhs.mLength), mNodes(rhs.mNodes), mCount(rhs.mCount), mCompare(rhs.mCompare)
+{
+    rhs.mMapping = nullptr;
+    rhs.mLength = 0;
+    rhs.mNodes = nullptr;
+    rhs.mCount = 0;
+}
+
+/**
+ * @brief Move assignment operator, swaps the mappings so rhs unmaps this one's
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename COMPARE >
+CS280::MappedAVLmap<KEY_TYPE,VALUE_TYPE,COMPARE>& CS280::MappedAVLmap<KEY_TYPE,VALUE_TYPE,COMPARE>::operator=(MappedAVLmap&& rhs)
+{
+    std::swap(mMapping, rhs.mMapping);
+    std::swap(mLength, rhs.mLength);
+    std::swap(mNodes, rhs.mNodes);
+    std::swap(mCount, rhs.mCount);
+    std::swap(mCompare, rhs.mCompare);
+
+    return *this;
+}
+
+/**
+ * @brief Destructor, unmaps the file
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename COMPARE >
+CS280::MappedAVLmap<KEY_TYPE,VALUE_TYPE,COMPARE>::~MappedAVLmap()
+{
+    Unmap();
+}
+
+/**
+ * @brief Returns the number of entries in the snapshot
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename COMPARE >
+unsigned int CS280::MappedAVLmap<KEY_TYPE,VALUE_TYPE,COMPARE>::size() const
+{
+    return static_cast<unsigned int>(mCount);
+}
+
+/**
+ * @brief Returns the comparator that orders the keys
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename COMPARE >
+COMPARE CS280::MappedAVLmap<KEY_TYPE,VALUE_TYPE,COMPARE>::key_comp() const
+{
+    return mCompare;
+}
+
+/**
+ * @brief Returns the begin iterator of the snapshot
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename COMPARE >
+typename CS280::MappedAVLmap<KEY_TYPE,VALUE_TYPE,COMPARE>::const_iterator CS280::MappedAVLmap<KEY_TYPE,VALUE_TYPE,COMPARE>::begin() const
+{
+    return mNodes;
+}
+
+/**
+ * @brief Returns the end iterator
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename COMPARE >
+typename CS280::MappedAVLmap<KEY_TYPE,VALUE_TYPE,COMPARE>::const_iterator CS280::MappedAVLmap<KEY_TYPE,VALUE_TYPE,COMPARE>::end() const
+{
+    return mNodes + mCount;
+}
+
+/**
+ * @brief Returns the reverse begin iterator (the last entry)
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename COMPARE >
+typename CS280::MappedAVLmap<KEY_TYPE,VALUE_TYPE,COMPARE>::const_reverse_iterator CS280::MappedAVLmap<KEY_TYPE,VALUE_TYPE,COMPARE>::rbegin() const
+{
+    return const_reverse_iterator(end());
+}
+
+/**
+ * @brief Returns the reverse end iterator (before the first entry)
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename COMPARE >
+typename CS280::MappedAVLmap<KEY_TYPE,VALUE_TYPE,COMPARE>::const_reverse_iterator CS280::MappedAVLmap<KEY_TYPE,VALUE_TYPE,COMPARE>::rend() const
+{
+    return const_reverse_iterator(begin());
+}
+
+/**
+ * @brief Finds the entry of given key and returns as an iterator
+ *
+ * @param key - key to find
+ * @return the entry, or end if the key is missing
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename COMPARE >
+typename CS280::MappedAVLmap<KEY_TYPE,VALUE_TYPE,COMPARE>::const_iterator CS280::MappedAVLmap<KEY_TYPE,VALUE_TYPE,COMPARE>::find(KEY_TYPE const& key) const
+{
+    const_iterator bound = lower_bound(key);
+
+    // The bound is not less than the key, so it is the key if the key is not less either
+    if(bound != end() && !mCompare(key, bound->Key()))
+        return bound;
+
+    return end();
+}
+
+/**
+ * @brief Returns the first entry with a key not less than the given key. Each step halves the range and only
+ *        picks which half with the comparison, so the loop runs the same number of steps for every key.
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename COMPARE >
+typename CS280::MappedAVLmap<KEY_TYPE,VALUE_TYPE,COMPARE>::const_iterator CS280::MappedAVLmap<KEY_TYPE,VALUE_TYPE,COMPARE>::lower_bound(KEY_TYPE const& key) const
+{
+    if(mCount == 0)
+        return end();
+
+    Node const* base = mNodes;
+    std::size_t count = mCount;
+
+    while(count > 1)
+    {
+        std::size_t half = count / 2;
+        base = mCompare(base[half].Key(), key) ? base + half : base;
+        count -= half;
+    }
+
+    return base + static_cast<std::size_t>(mCompare(base->Key(), key));
+}
+
+/**
+ * @brief Returns the first entry with a key greater than the given key, with the same search as lower_bound
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename COMPARE >
+typename CS280::MappedAVLmap<KEY_TYPE,VALUE_TYPE,COMPARE>::const_iterator CS280::MappedAVLmap<KEY_TYPE,VALUE_TYPE,COMPARE>::upper_bound(KEY_TYPE const& key) const
+{
+    if(mCount == 0)
+        return end();
+
+    Node const* base = mNodes;
+    std::size_t count = mCount;
+
+    while(count > 1)
+    {
+        std::size_t half = count / 2;
+        base = !mCompare(key, base[half].Key()) ? base + half : base;
+        count -= half;
+    }
+
+    return base + static_cast<std::size_t>(!mCompare(key, base->Key()));
+}
+
+/**
+ * @brief Returns the range of entries with the given key (empty or one entry)
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename COMPARE >
+std::pair<typename CS280::MappedAVLmap<KEY_TYPE,VALUE_TYPE,COMPARE>::const_iterator, typename CS280::MappedAVLmap<KEY_TYPE,VALUE_TYPE,COMPARE>::const_iterator> CS280::MappedAVLmap<KEY_TYPE,VALUE_TYPE,COMPARE>::equal_range(KEY_TYPE const& key) const
+{
+    const_iterator lower = lower_bound(key);
+    const_iterator upper = lower;
+
+    if(lower != end() && !mCompare(key, lower->Key()))
+        ++upper;
+
+    return std::make_pair(lower, upper);
+}
+
+/**
+ * @brief Writes a snapshot file (see AVLmap_snapshot::write), under a temporary name renamed over path at the end.
+ *
+ * @param path - file to write
+ * @param first - first element of a forward range sorted by key with distinct keys (pairs, or nodes with Key() and Value())
+ * @param last - end of the range
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename COMPARE >
+template< typename ITER >
+void CS280::MappedAVLmap<KEY_TYPE,VALUE_TYPE,COMPARE>::write(std::string const& path, ITER first, ITER last)
+{
+    Snapshot::write(path, first, last);
+}
+
+/**
+ * @brief Unmaps the file, if one is mapped
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename COMPARE >
+void CS280::MappedAVLmap<KEY_TYPE,VALUE_TYPE,COMPARE>::Unmap()
+{
+    if(mMapping != nullptr)
+        ::munmap(mMapping, mLength);
+
+    mMapping = nullptr;
+    mLength = 0;
+    mNodes = nullptr;
+    mCount = 0;
+}
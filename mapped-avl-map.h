@@ -0,0 +1,87 @@
+/**
+ * @file mapped-avl-map.h
+ * @brief A read-only map served straight from a memory mapped snapshot file (see AVLmap::save). The file holds
+ *        the entries sorted by key in one array, laid out exactly like this class's nodes, so opening it only maps
+ *        it: nothing is read or built, and a lookup or iteration only touches the pages it needs.
+ *        Keys and values must be trivially copyable. Uses POSIX mmap, so unlike avl-map.h it is included on its own
+ *        where it is wanted; the file format is in avl-map-snapshot.h.
+ */
+
+#ifndef MAPPED_AVLMAP_H
+#define MAPPED_AVLMAP_H
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <iterator>
+#include <string>
+#include <type_traits>
+#include <utility>
+
+#include "avl-map-snapshot.h"
+
+namespace CS280 {
+
+    // COMPARE orders the keys, it must be the comparator the file was saved with
+    // The file is in the machine's byte order and layout, it is checked on open but not converted
+    template< typename KEY_TYPE, typename VALUE_TYPE, typename COMPARE = std::less<KEY_TYPE> >
+    class MappedAVLmap {
+			static_assert(std::is_trivially_copyable<KEY_TYPE>::value && std::is_trivially_copyable<VALUE_TYPE>::value,
+			              "snapshots need trivially copyable keys and values");
+		public:
+
+			// one entry of the file, so iterators can be used like AVLmap's (it->Key(), it->Value())
+			typedef typename AVLmap_snapshot<KEY_TYPE, VALUE_TYPE>::Node Node;
+
+		private:
+
+			typedef AVLmap_snapshot<KEY_TYPE, VALUE_TYPE> Snapshot;
+
+			// MappedAVLmap implementation
+			void*           mMapping = nullptr;
+			std::size_t     mLength = 0;
+			Node const*     mNodes = nullptr; // sorted by key, in the mapped pages
+			std::size_t     mCount = 0;
+			COMPARE         mCompare;
+
+		public:
+			//maps the file for reading, throws std::runtime_error if it can't be opened or isn't a snapshot of this type
+			explicit MappedAVLmap(std::string const& path, COMPARE const& comp = COMPARE());
+			MappedAVLmap(MappedAVLmap&& rhs);
+			MappedAVLmap& operator=(MappedAVLmap&& rhs);
+			MappedAVLmap(const MappedAVLmap&)               = delete;
+			MappedAVLmap& operator=(const MappedAVLmap&)    = delete;
+			~MappedAVLmap(); // unmaps the file, iterators into it are no longer valid
+
+			unsigned int size() const;
+			COMPARE key_comp() const;
+
+			//standard names for iterator types, every iterator is const and points into the mapped file
+			typedef Node const* iterator;
+			typedef Node const* const_iterator;
+			typedef std::pair<KEY_TYPE, VALUE_TYPE> value_type;
+			typedef std::reverse_iterator<const_iterator> const_reverse_iterator;
+			typedef const_reverse_iterator reverse_iterator;
+
+			const_iterator begin() const;
+			const_iterator end() const;
+			const_reverse_iterator rbegin() const;
+			const_reverse_iterator rend() const;
+
+			//branchless binary searches over the sorted entries
+			const_iterator find(KEY_TYPE const& key) const;
+			const_iterator lower_bound(KEY_TYPE const& key) const; // first entry with key >= given key
+			const_iterator upper_bound(KEY_TYPE const& key) const; // first entry with key > given key
+			std::pair<const_iterator, const_iterator> equal_range(KEY_TYPE const& key) const;
+
+			//writes a range sorted by key, with distinct keys, as a snapshot file (pairs or nodes with Key() and Value())
+			//the file is written next to path and renamed over it when complete, so readers never map a partial file
+			template< typename ITER >
+			static void write(std::string const& path, ITER first, ITER last);
+		private:
+			void Unmap();
+	};
+}
+
+#include "mapped-avl-map.cpp"
+#endif
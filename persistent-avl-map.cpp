@@ -0,0 +1,820 @@
+/**
+ * @file persistent-avl-map.cpp
+ * @brief This implements the persistent AVL map. An update rebuilds the root path out of fresh nodes without
+ *        touching the current version, and only then counts the new links and releases the old root:
+ *        the old path nodes go away if no other version holds them, the shared subtrees just lose one count.
+ *        A failed update only has fresh nodes to throw away, so the map is unchanged.
+ */
+
+#include "persistent-avl-map.h"
+
+/**
+ * @brief Construct an empty map
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename COMPARE, typename ALLOCATOR >
+CS280::PersistentAVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR>::PersistentAVLmap()
+{
+
+}
+
+/**
+ * @brief Construct an empty map with the allocator that supplies the nodes
+ *
+ * @param alloc - allocator for the nodes
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename COMPARE, typename ALLOCATOR >
+CS280::PersistentAVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR>::PersistentAVLmap(ALLOCATOR const& alloc) : mAlloc(alloc)
+{
+
+}
+
+/**
+ * @brief Construct an empty map that orders its keys with the given comparator
+ *
+ * @param comp - key comparator
+ * @param alloc - allocator for the nodes
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename COMPARE, typename ALLOCATOR >
+CS280::PersistentAVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR>::PersistentAVLmap(COMPARE const& comp, ALLOCATOR const& alloc) : mCompare(comp), mAlloc(alloc)
+{
+
+}
+
+/**
+ * @brief Copy constructor. Shares rhs's tree, O(1).
+ *
+ * @param rhs - map to copy
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename COMPARE, typename ALLOCATOR >
+CS280::PersistentAVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR>::PersistentAVLmap(const PersistentAVLmap& rhs)
+    : mRoot(rhs.mRoot), size_(rhs.size_), mCompare(rhs.mCompare), mAlloc(rhs.mAlloc)
+{
+    Acquire(mRoot);
+}
+
+/**
+ * @brief Move constructor. Takes rhs's tree.
+ *
+ * @param rhs - map to move
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename COMPARE, typename ALLOCATOR >
+CS280::PersistentAVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR>::PersistentAVLmap(PersistentAVLmap&& rhs)
+    : mRoot(rhs.mRoot), size_(rhs.size_), mCompare(rhs.mCompare), mAlloc(rhs.mAlloc)
+{
+    rhs.mRoot = nullptr;
+    rhs.size_ = 0;
+}
+
+/**
+ * @brief Assignment operator. Shares rhs's tree and lets go of this one, O(1) unless this map held
+ *        nodes no other version holds.
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename COMPARE, typename ALLOCATOR >
+CS280::PersistentAVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR>& CS280::PersistentAVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR>::operator=(const PersistentAVLmap& rhs)
+{
+    // Counted first, so assigning a map to itself keeps its nodes
+    Acquire(rhs.mRoot);
+    Release(mRoot);
+
+    mRoot = rhs.mRoot;
+    size_ = rhs.size_;
+    mCompare = rhs.mCompare;
+
+    return *this;
+}
+
+/**
+ * @brief Move assignment operator. Swaps the trees with rhs.
+ *
+ * @param rhs - map to move into this map
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename COMPARE, typename ALLOCATOR >
+CS280::PersistentAVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR>& CS280::PersistentAVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR>::operator=(PersistentAVLmap&& rhs)
+{
+    std::swap(mRoot, rhs.mRoot);
+    std::swap(size_, rhs.size_);
+    std::swap(mCompare, rhs.mCompare);
+    std::swap(mAlloc, rhs.mAlloc);
+
+    return *this;
+}
+
+/**
+ * @brief Destructor. Frees the nodes no other version holds.
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename COMPARE, typename ALLOCATOR >
+CS280::PersistentAVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR>::~PersistentAVLmap()
+{
+    Release(mRoot);
+}
+
+/**
+ * @brief Returns a copy of the current version. Updates to either map don't show in the other.
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename COMPARE, typename ALLOCATOR >
+CS280::PersistentAVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR> CS280::PersistentAVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR>::snapshot() const
+{
+    return PersistentAVLmap(*this);
+}
+
+/**
+ * @brief Returns the size (number of nodes) in the map
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename COMPARE, typename ALLOCATOR >
+unsigned int CS280::PersistentAVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR>::size() const
+{
+    return size_;
+}
+
+/**
+ * @brief Returns the comparator that orders the keys
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename COMPARE, typename ALLOCATOR >
+COMPARE CS280::PersistentAVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR>::key_comp() const
+{
+    return mCompare;
+}
+
+/**
+ * @brief Returns the allocator the nodes come from
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename COMPARE, typename ALLOCATOR >
+ALLOCATOR CS280::PersistentAVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR>::get_allocator() const
+{
+    return ALLOCATOR(mAlloc);
+}
+
+/**
+ * @brief Returns the begin iterator of the map
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename COMPARE, typename ALLOCATOR >
+typename CS280::PersistentAVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR>::PersistentAVLmap_iterator_const CS280::PersistentAVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR>::begin() const
+{
+    PersistentAVLmap_iterator_const it;
+
+    it.mPath.reserve(mRoot == nullptr ? 0 : mRoot->height + 1);
+    it.PushLeft(mRoot);
+
+    return it;
+}
+
+/**
+ * @brief Returns the end iterator
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename COMPARE, typename ALLOCATOR >
+typename CS280::PersistentAVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR>::PersistentAVLmap_iterator_const CS280::PersistentAVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR>::end() const
+{
+    return PersistentAVLmap_iterator_const();
+}
+
+/**
+ * @brief Finds the node of given key and returns as an iterator
+ *
+ * @param key - key to find
+ * @return the node, or end if the key is missing
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename COMPARE, typename ALLOCATOR >
+typename CS280::PersistentAVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR>::PersistentAVLmap_iterator_const CS280::PersistentAVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR>::find(KEY_TYPE const& key) const
+{
+    PersistentAVLmap_iterator_const it = lower_bound(key);
+
+    // The bound is not less than the key, so it is the key if the key is not less either
+    if(it != end() && mCompare(key, it->Key()))
+        return end();
+
+    return it;
+}
+
+/**
+ * @brief Returns the first node with a key not less than the given key. The descent keeps the nodes it went left at,
+ *        the last of them is the bound and the ones before are where the iterator goes after it.
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename COMPARE, typename ALLOCATOR >
+typename CS280::PersistentAVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR>::PersistentAVLmap_iterator_const CS280::PersistentAVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR>::lower_bound(KEY_TYPE const& key) const
+{
+    PersistentAVLmap_iterator_const it;
+    Node const* walker = mRoot;
+
+    while(walker != nullptr)
+    {
+        if(mCompare(walker->key, key))
+        {
+            walker = walker->right;
+        }
+        else
+        {
+            it.mPath.push_back(walker);
+            walker = walker->left;
+        }
+    }
+
+    return it;
+}
+
+/**
+ * @brief Returns the first node with a key greater than the given key
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename COMPARE, typename ALLOCATOR >
+typename CS280::PersistentAVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR>::PersistentAVLmap_iterator_const CS280::PersistentAVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR>::upper_bound(KEY_TYPE const& key) const
+{
+    PersistentAVLmap_iterator_const it;
+    Node const* walker = mRoot;
+
+    while(walker != nullptr)
+    {
+        if(mCompare(key, walker->key))
+        {
+            it.mPath.push_back(walker);
+            walker = walker->left;
+        }
+        else
+        {
+            walker = walker->right;
+        }
+    }
+
+    return it;
+}
+
+/**
+ * @brief Inserts a copy of the pair if its key is not in the map yet.
+ *
+ * @param item - key and value to insert
+ * @return whether it was inserted
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename COMPARE, typename ALLOCATOR >
+bool CS280::PersistentAVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR>::insert(value_type const& item)
+{
+    return try_emplace(item.first, item.second);
+}
+
+/**
+ * @brief Builds the value from args only if the key is missing.
+ *
+ * @param key - key to insert
+ * @param args - value constructor arguments
+ * @return whether it was inserted
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename COMPARE, typename ALLOCATOR >
+template< typename... ARGS >
+bool CS280::PersistentAVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR>::try_emplace(KEY_TYPE const& key, ARGS&&... args)
+{
+    bool inserted = false;
+
+    try
+    {
+        Node* root = InsertNode(mRoot, key, false, inserted, std::forward<ARGS>(args)...);
+
+        if(inserted)
+            Commit(root, size_ + 1);
+    }
+    catch(...)
+    {
+        Abandon();
+        throw;
+    }
+
+    return inserted;
+}
+
+/**
+ * @brief Inserts the key with the value, or gives the key the value if it is already there
+ *        (in a copy of its node, other versions keep the old value).
+ *
+ * @param key - key to insert or assign
+ * @param obj - value
+ * @return true if the key was inserted, false if it was assigned
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename COMPARE, typename ALLOCATOR >
+template< typename M >
+bool CS280::PersistentAVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR>::insert_or_assign(KEY_TYPE const& key, M&& obj)
+{
+    bool inserted = false;
+
+    try
+    {
+        Node* root = InsertNode(mRoot, key, true, inserted, std::forward<M>(obj));
+
+        Commit(root, size_ + (inserted ? 1 : 0));
+    }
+    catch(...)
+    {
+        Abandon();
+        throw;
+    }
+
+    return inserted;
+}
+
+/**
+ * @brief Erases the node with the given key, if there is one.
+ *
+ * @param key - key to erase
+ * @return the number of nodes erased (0 or 1)
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename COMPARE, typename ALLOCATOR >
+unsigned int CS280::PersistentAVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR>::erase(KEY_TYPE const& key)
+{
+    bool erased = false;
+
+    try
+    {
+        Node* root = EraseNode(mRoot, key, erased);
+
+        if(erased)
+            Commit(root, size_ - 1);
+    }
+    catch(...)
+    {
+        Abandon();
+        throw;
+    }
+
+    return erased ? 1 : 0;
+}
+
+/**
+ * @brief Erases every node of this version. Other versions keep theirs.
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename COMPARE, typename ALLOCATOR >
+void CS280::PersistentAVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR>::clear()
+{
+    Release(mRoot);
+
+    mRoot = nullptr;
+    size_ = 0;
+}
+
+/**
+ * @brief Checks the key order, heights and balance of this version, and that no node is left fresh
+ *
+ * @return whether the tree is a valid AVL tree holding size() nodes
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename COMPARE, typename ALLOCATOR >
+bool CS280::PersistentAVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR>::sanityCheck() const
+{
+    unsigned int count = 0;
+
+    if(CheckSubtree(mRoot, count) < -1)
+        return false;
+
+    return count == size_;
+}
+
+/**
+ * @brief Inserts the key into a copy of a subtree. Only the nodes on the path to the key are copied,
+ *        a subtree that doesn't change is returned as it is.
+ *
+ * @param tree - subtree to insert into
+ * @param key - key to insert
+ * @param assign - whether a node already holding the key gets a copy with the new value
+ * @param inserted - set to true when a node was added
+ * @param args - value constructor arguments
+ * @return the new (or unchanged) subtree
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename COMPARE, typename ALLOCATOR >
+template< typename... ARGS >
+typename CS280::PersistentAVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR>::Node* CS280::PersistentAVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR>::InsertNode(Node* tree, KEY_TYPE const& key, bool assign, bool& inserted, ARGS&&... args)
+{
+    if(tree == nullptr)
+    {
+        inserted = true;
+        return CreateNode(key, std::forward<ARGS>(args)...);
+    }
+
+    if(mCompare(key, tree->key))
+    {
+        Node* left = InsertNode(tree->left, key, assign, inserted, std::forward<ARGS>(args)...);
+
+        if(left == tree->left)
+            return tree;
+
+        return Rebalance(Rebuild(tree, left, tree->right));
+    }
+
+    if(mCompare(tree->key, key))
+    {
+        Node* right = InsertNode(tree->right, key, assign, inserted, std::forward<ARGS>(args)...);
+
+        if(right == tree->right)
+            return tree;
+
+        return Rebalance(Rebuild(tree, tree->left, right));
+    }
+
+    if(!assign)
+        return tree;
+
+    // Same shape, new value
+    Node* node = CreateNode(tree->key, std::forward<ARGS>(args)...);
+    node->left = tree->left;
+    node->right = tree->right;
+    node->height = tree->height;
+
+    return node;
+}
+
+/**
+ * @brief Erases the key from a copy of a subtree. A node with two children is replaced by a copy of its successor.
+ *
+ * @param tree - subtree to erase from
+ * @param key - key to erase
+ * @param erased - set to true when a node was removed
+ * @return the new (or unchanged) subtree
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename COMPARE, typename ALLOCATOR >
+typename CS280::PersistentAVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR>::Node* CS280::PersistentAVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR>::EraseNode(Node* tree, KEY_TYPE const& key, bool& erased)
+{
+    if(tree == nullptr)
+        return nullptr;
+
+    if(mCompare(key, tree->key))
+    {
+        Node* left = EraseNode(tree->left, key, erased);
+
+        if(left == tree->left)
+            return tree;
+
+        return Rebalance(Rebuild(tree, left, tree->right));
+    }
+
+    if(mCompare(tree->key, key))
+    {
+        Node* right = EraseNode(tree->right, key, erased);
+
+        if(right == tree->right)
+            return tree;
+
+        return Rebalance(Rebuild(tree, tree->left, right));
+    }
+
+    erased = true;
+
+    if(tree->left == nullptr)
+        return tree->right;
+
+    if(tree->right == nullptr)
+        return tree->left;
+
+    Node* first;
+    Node* right = RemoveFirst(tree->right, first);
+
+    return Rebalance(Rebuild(first, tree->left, right));
+}
+
+/**
+ * @brief Unlinks the minimum from a copy of a subtree
+ *
+ * @param tree - subtree, not empty
+ * @param first - set to the minimum (the caller rebuilds it in its new place)
+ * @return the new subtree
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename COMPARE, typename ALLOCATOR >
+typename CS280::PersistentAVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR>::Node* CS280::PersistentAVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR>::RemoveFirst(Node* tree, Node*& first)
+{
+    if(tree->left == nullptr)
+    {
+        first = tree;
+        return tree->right;
+    }
+
+    Node* left = RemoveFirst(tree->left, first);
+
+    return Rebalance(Rebuild(tree, left, tree->right));
+}
+
+/**
+ * @brief Restores the balance of a fresh node whose subtrees differ in height by at most 2,
+ *        rebuilding the nodes the rotation moves.
+ *
+ * @param node - fresh node
+ * @return root of the balanced subtree
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename COMPARE, typename ALLOCATOR >
+typename CS280::PersistentAVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR>::Node* CS280::PersistentAVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR>::Rebalance(Node* node)
+{
+    int balance = Height(node->left) - Height(node->right);
+
+    if(balance > 1)
+    {
+        Node* child = node->left;
+
+        if(Height(child->left) >= Height(child->right))
+        {
+            // Single right rotation
+            Node* lower = Rebuild(node, child->right, node->right);
+            return Rebuild(child, child->left, lower);
+        }
+
+        // Left-right, the child's right child comes up two levels
+        Node* grandchild = child->right;
+        Node* left = Rebuild(child, child->left, grandchild->left);
+        Node* right = Rebuild(node, grandchild->right, node->right);
+
+        return Rebuild(grandchild, left, right);
+    }
+
+    if(balance < -1)
+    {
+        Node* child = node->right;
+
+        if(Height(child->right) >= Height(child->left))
+        {
+            // Single left rotation
+            Node* lower = Rebuild(node, node->left, child->left);
+            return Rebuild(child, lower, child->right);
+        }
+
+        // Right-left, the child's left child comes up two levels
+        Node* grandchild = child->left;
+        Node* left = Rebuild(node, node->left, grandchild->left);
+        Node* right = Rebuild(child, grandchild->right, child->right);
+
+        return Rebuild(grandchild, left, right);
+    }
+
+    return node;
+}
+
+/**
+ * @brief Gives a node new children. A fresh node is changed in place, a node of the current version
+ *        is copied (the original is only let go of when the update commits).
+ *
+ * @param node - node to rebuild
+ * @param left - new left subtree
+ * @param right - new right subtree
+ * @return the fresh node with the new children and height
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename COMPARE, typename ALLOCATOR >
+typename CS280::PersistentAVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR>::Node* CS280::PersistentAVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR>::Rebuild(Node* node, Node* left, Node* right)
+{
+    if(!node->fresh)
+        node = CreateNode(node->key, node->value);
+
+    node->left = left;
+    node->right = right;
+    node->height = 1 + std::max(Height(left), Height(right));
+
+    return node;
+}
+
+/**
+ * @brief Builds a fresh leaf and tracks it, so it is freed if the update fails
+ *
+ * @param args - key and value constructor arguments
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename COMPARE, typename ALLOCATOR >
+template< typename... ARGS >
+typename CS280::PersistentAVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR>::Node* CS280::PersistentAVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR>::CreateNode(ARGS&&... args)
+{
+    // Room first, so a built node is never left untracked
+    mFresh.push_back(nullptr);
+
+    Node* node = std::allocator_traits<NodeAllocator>::allocate(mAlloc, 1);
+
+    try
+    {
+        std::allocator_traits<NodeAllocator>::construct(mAlloc, node, std::forward<ARGS>(args)...);
+    }
+    catch(...)
+    {
+        std::allocator_traits<NodeAllocator>::deallocate(mAlloc, node, 1);
+        mFresh.pop_back();
+        throw;
+    }
+
+    mFresh.back() = node;
+    return node;
+}
+
+/**
+ * @brief Makes the update the current version. Every link out of a fresh node is counted
+ *        (each fresh node has exactly one parent, or is the root), then the old root is let go of.
+ *
+ * @param root - new root
+ * @param size - new number of nodes
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename COMPARE, typename ALLOCATOR >
+void CS280::PersistentAVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR>::Commit(Node* root, unsigned int size)
+{
+    for(Node* node : mFresh)
+    {
+        Acquire(node->left);
+        Acquire(node->right);
+    }
+
+    Acquire(root);
+
+    for(Node* node : mFresh)
+    {
+        node->fresh = false;
+    }
+
+    mFresh.clear();
+
+    Node* old = mRoot;
+
+    mRoot = root;
+    size_ = size;
+
+    Release(old);
+}
+
+/**
+ * @brief Throws away an update that failed part way. Nothing was counted yet, so the fresh nodes are simply freed.
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename COMPARE, typename ALLOCATOR >
+void CS280::PersistentAVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR>::Abandon()
+{
+    for(Node* node : mFresh)
+    {
+        std::allocator_traits<NodeAllocator>::destroy(mAlloc, node);
+        std::allocator_traits<NodeAllocator>::deallocate(mAlloc, node, 1);
+    }
+
+    mFresh.clear();
+}
+
+/**
+ * @brief Counts one more holder of a node (nothing for an empty subtree)
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename COMPARE, typename ALLOCATOR >
+void CS280::PersistentAVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR>::Acquire(Node* node)
+{
+    if(node != nullptr)
+        node->refs.fetch_add(1, std::memory_order_relaxed);
+}
+
+/**
+ * @brief Counts one holder of a node less. The last holder frees it and lets go of its children.
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename COMPARE, typename ALLOCATOR >
+void CS280::PersistentAVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR>::Release(Node* node)
+{
+    if(node == nullptr || node->refs.fetch_sub(1, std::memory_order_acq_rel) != 1)
+        return;
+
+    Release(node->left);
+    Release(node->right);
+
+    std::allocator_traits<NodeAllocator>::destroy(mAlloc, node);
+    std::allocator_traits<NodeAllocator>::deallocate(mAlloc, node, 1);
+}
+
+/**
+ * @brief Returns the height of a subtree (-1 when empty)
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename COMPARE, typename ALLOCATOR >
+int CS280::PersistentAVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR>::Height(Node* node)
+{
+    return node == nullptr ? -1 : node->height;
+}
+
+/**
+ * @brief Checks a subtree for sanityCheck
+ *
+ * @param node - subtree root
+ * @param count - incremented for every node
+ * @return height of the subtree (-1 when empty), or -2 if something is wrong
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename COMPARE, typename ALLOCATOR >
+int CS280::PersistentAVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR>::CheckSubtree(Node* node, unsigned int& count) const
+{
+    if(node == nullptr)
+        return -1;
+
+    if(node->fresh || node->refs.load(std::memory_order_relaxed) == 0 || ++count > size_)
+        return -2;
+
+    if(node->left != nullptr && !mCompare(node->left->key, node->key))
+        return -2;
+
+    if(node->right != nullptr && !mCompare(node->key, node->right->key))
+        return -2;
+
+    int leftHeight = CheckSubtree(node->left, count);
+    int rightHeight = CheckSubtree(node->right, count);
+
+    if(leftHeight < -1 || rightHeight < -1 || std::abs(leftHeight - rightHeight) > 1 || node->height != 1 + std::max(leftHeight, rightHeight))
+        return -2;
+
+    return node->height;
+}
+
+/**
+ * @brief Builds a fresh leaf: the key from k, the value from val
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename COMPARE, typename ALLOCATOR >
+template< typename KEY_ARG, typename... VALUE_ARGS >
+CS280::PersistentAVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR>::Node::Node(KEY_ARG&& k, VALUE_ARGS&&... val)
+    : key(std::forward<KEY_ARG>(k)), value(std::forward<VALUE_ARGS>(val)...), height(0), left(nullptr), right(nullptr), refs(0), fresh(true)
+{
+
+}
+
+/**
+ * @brief Returns the key of the node
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename COMPARE, typename ALLOCATOR >
+KEY_TYPE const& CS280::PersistentAVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR>::Node::Key() const
+{
+    return key;
+}
+
+/**
+ * @brief Returns the value of the node
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename COMPARE, typename ALLOCATOR >
+VALUE_TYPE const& CS280::PersistentAVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR>::Node::Value() const
+{
+    return value;
+}
+
+/**
+ * @brief Constructor for const iterator, makes an end iterator
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename COMPARE, typename ALLOCATOR >
+CS280::PersistentAVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR>::PersistentAVLmap_iterator_const::PersistentAVLmap_iterator_const()
+{
+
+}
+
+/**
+ * @brief Prefix increment operator for const iterators. The successor is the minimum of the right subtree,
+ *        or else the nearest ancestor the current node is left of, which is the next one on the path.
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename COMPARE, typename ALLOCATOR >
+typename CS280::PersistentAVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR>::PersistentAVLmap_iterator_const& CS280::PersistentAVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR>::PersistentAVLmap_iterator_const::operator++()
+{
+    Node const* node = mPath.back();
+
+    mPath.pop_back();
+    PushLeft(node->right);
+
+    return *this;
+}
+
+/**
+ * @brief Postfix increment operator for const iterators
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename COMPARE, typename ALLOCATOR >
+typename CS280::PersistentAVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR>::PersistentAVLmap_iterator_const CS280::PersistentAVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR>::PersistentAVLmap_iterator_const::operator++(int)
+{
+    PersistentAVLmap_iterator_const temp = *this;
+    ++*this;
+    return temp;
+}
+
+/**
+ * @brief Dereference operator for const iterator
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename COMPARE, typename ALLOCATOR >
+typename CS280::PersistentAVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR>::Node const& CS280::PersistentAVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR>::PersistentAVLmap_iterator_const::operator*() const
+{
+    return *mPath.back();
+}
+
+/**
+ * @brief Arrow operator for const iterator
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename COMPARE, typename ALLOCATOR >
+typename CS280::PersistentAVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR>::Node const* CS280::PersistentAVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR>::PersistentAVLmap_iterator_const::operator->() const
+{
+    return mPath.back();
+}
+
+/**
+ * @brief Not equal operator for const iterator. Only the current nodes are compared.
+ * @param rhs - check value against
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename COMPARE, typename ALLOCATOR >
+bool CS280::PersistentAVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR>::PersistentAVLmap_iterator_const::operator!=(const PersistentAVLmap_iterator_const& rhs) const
+{
+    return !(*this == rhs);
+}
+
+/**
+ * @brief Equal operator for const iterator. Only the current nodes are compared.
+ * @param rhs - check value against
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename COMPARE, typename ALLOCATOR >
+bool CS280::PersistentAVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR>::PersistentAVLmap_iterator_const::operator==(const PersistentAVLmap_iterator_const& rhs) const
+{
+    if(mPath.empty() || rhs.mPath.empty())
+        return mPath.empty() == rhs.mPath.empty();
+
+    return mPath.back() == rhs.mPath.back();
+}
+
+/**
+ * @brief Pushes a node and its chain of left children, so the minimum of the subtree becomes current
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename COMPARE, typename ALLOCATOR >
+void CS280::PersistentAVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,ALLOCATOR>::PersistentAVLmap_iterator_const::PushLeft(Node const* node)
+{
+    while(node != nullptr)
+    {
+        mPath.push_back(node);
+        node = node->left;
+    }
+}
@@ -0,0 +1,146 @@
+/**
+ * @file persistent-avl-map.h
+ * @brief A persistent AVL map: copies and snapshots share their nodes, so taking one is O(1).
+ *        An update copies only the nodes on its root path (and the ones its rotations move) and shares
+ *        the rest of the tree with every other version through reference counts, so older versions keep
+ *        reading what they saw and the memory of a snapshot grows with the changes made since, not with the map.
+ */
+
+#ifndef PERSISTENT_AVLMAP_H
+#define PERSISTENT_AVLMAP_H
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdlib>
+#include <functional>
+#include <iterator>
+#include <memory>
+#include <utility>
+#include <vector>
+
+namespace CS280 {
+
+    // COMPARE orders the keys, ALLOCATOR supplies the memory for the nodes (it is rebound internally)
+    // Updates copy nodes, so keys and values must be copy constructible. Versions of a map can be used from
+    // different threads, like copies of a shared_ptr, but one version must not be used by two threads at once.
+    template< typename KEY_TYPE, typename VALUE_TYPE, typename COMPARE = std::less<KEY_TYPE>,
+              typename ALLOCATOR = std::allocator< std::pair<const KEY_TYPE, VALUE_TYPE> > >
+    class PersistentAVLmap {
+		public:
+
+			class Node
+			{
+				public:
+					template< typename KEY_ARG, typename... VALUE_ARGS >
+					Node( KEY_ARG&& k, VALUE_ARGS&&... val );
+
+					KEY_TYPE const & Key() const;   // return a const reference
+					VALUE_TYPE const & Value() const; // return a const reference, nodes are shared so they never change
+				private:
+					KEY_TYPE    key;
+					VALUE_TYPE  value;
+					int         height; // subtree height (leaf is 0)
+					Node        *left;
+					Node        *right;
+					std::atomic<unsigned int> refs; // parents and versions holding the node
+					bool        fresh; // built by the update in progress, not counted or shared yet
+
+					friend class PersistentAVLmap;
+			};
+
+		private:
+
+			typedef typename std::allocator_traits<ALLOCATOR>::template rebind_alloc<Node> NodeAllocator;
+
+			// nodes have no parent links (a shared node has many parents), so the iterator keeps the ancestors
+			// whose left subtree it is in
+			struct PersistentAVLmap_iterator_const
+			{
+				private:
+					std::vector<Node const*> mPath; // top is the current node, empty at end
+				public:
+					typedef std::forward_iterator_tag iterator_category;
+					typedef Node                      value_type;
+					typedef std::ptrdiff_t            difference_type;
+					typedef Node const*               pointer;
+					typedef Node const&               reference;
+
+					PersistentAVLmap_iterator_const();
+					PersistentAVLmap_iterator_const& operator++();
+					PersistentAVLmap_iterator_const operator++(int);
+					Node const& operator*() const;
+					Node const* operator->() const;
+					bool operator!=(const PersistentAVLmap_iterator_const& rhs) const;
+					bool operator==(const PersistentAVLmap_iterator_const& rhs) const;
+					friend class PersistentAVLmap;
+				private:
+					void PushLeft(Node const* node);
+			};
+
+			// PersistentAVLmap implementation
+			Node*               mRoot = nullptr;
+			unsigned int        size_ = 0;
+			COMPARE             mCompare;
+			NodeAllocator       mAlloc;
+			std::vector<Node*>  mFresh; // nodes built by the update in progress, always empty in between
+
+		public:
+			PersistentAVLmap();
+			explicit PersistentAVLmap(ALLOCATOR const& alloc);
+			explicit PersistentAVLmap(COMPARE const& comp, ALLOCATOR const& alloc = ALLOCATOR());
+			PersistentAVLmap(const PersistentAVLmap& rhs); // O(1), the copy shares every node
+			PersistentAVLmap(PersistentAVLmap&& rhs);
+			PersistentAVLmap& operator=(const PersistentAVLmap& rhs);
+			PersistentAVLmap& operator=(PersistentAVLmap&& rhs);
+			~PersistentAVLmap();
+
+			PersistentAVLmap snapshot() const; // O(1) copy of the current version
+			unsigned int size() const;
+			COMPARE key_comp() const;
+			ALLOCATOR get_allocator() const;
+
+			//standard names for iterator types, every iterator is const
+			//an iterator stays valid as long as some version holding its node is alive and unchanged
+			typedef PersistentAVLmap_iterator_const iterator;
+			typedef PersistentAVLmap_iterator_const const_iterator;
+			typedef std::pair<KEY_TYPE, VALUE_TYPE> value_type;
+
+			PersistentAVLmap_iterator_const begin() const;
+			PersistentAVLmap_iterator_const end() const;
+			PersistentAVLmap_iterator_const find(KEY_TYPE const& key) const;
+			PersistentAVLmap_iterator_const lower_bound(KEY_TYPE const& key) const; // first node with key >= given key
+			PersistentAVLmap_iterator_const upper_bound(KEY_TYPE const& key) const; // first node with key > given key
+
+			//updates only change this version, O(log n) new nodes each
+			bool insert(value_type const& item); // false if the key is already there
+			template< typename... ARGS >
+			bool try_emplace(KEY_TYPE const& key, ARGS&&... args); // value is only built if the key is missing
+			template< typename M >
+			bool insert_or_assign(KEY_TYPE const& key, M&& obj); // true if the key was inserted, false if assigned
+			unsigned int erase(KEY_TYPE const& key); // returns the number of nodes erased
+			void clear();
+
+			bool sanityCheck() const;
+		private:
+			template< typename... ARGS >
+			Node* InsertNode(Node* tree, KEY_TYPE const& key, bool assign, bool& inserted, ARGS&&... args);
+			Node* EraseNode(Node* tree, KEY_TYPE const& key, bool& erased);
+			Node* RemoveFirst(Node* tree, Node*& first);
+			Node* Rebalance(Node* node);
+			Node* Rebuild(Node* node, Node* left, Node* right);
+
+			template< typename... ARGS >
+			Node* CreateNode(ARGS&&... args);
+			void Commit(Node* root, unsigned int size);
+			void Abandon();
+			static void Acquire(Node* node);
+			void Release(Node* node);
+
+			static int Height(Node* node);
+			int CheckSubtree(Node* node, unsigned int& count) const;
+	};
+}
+
+#include "persistent-avl-map.cpp"
+#endif
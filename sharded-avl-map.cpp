@@ -0,0 +1,530 @@
+/**
+ * @file sharded-avl-map.cpp
+ * @brief This implements the sharded AVL map. An operation on one key finds the key's shard (by hash, or by
+ *        binary search over the splitters), takes that shard's lock and runs on its AVLmap. Operations on
+ *        several shards take the locks in shard order.
+ */
+
+#include <algorithm>
+#include <thread>
+
+#include "sharded-avl-map.h"
+
+/**
+ * @brief Construct an empty map partitioned by hash
+ *
+ * @param shards - number of shards, 0 for SHARDS_PER_THREAD per hardware thread
+ * @param comp - key comparator
+ * @param hash - key hash, its result is mixed before it picks a shard so an identity hash is fine
+ * @param alloc - allocator for the shards' node pools
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename COMPARE, typename HASH, typename ALLOCATOR, typename TRAITS >
+CS280::ShardedAVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,HASH,ALLOCATOR,TRAITS>::ShardedAVLmap(unsigned int shards, COMPARE const& comp, HASH const& hash, ALLOCATOR const& alloc)
+    : mCount(0), mRanged(false), mCompare(comp), mHash(hash), mAlloc(alloc)
+{
+    if(shards == 0)
+        shards = std::max(1u, std::thread::hardware_concurrency()) * SHARDS_PER_THREAD;
+
+    InitShards(shards);
+}
+
+/**
+ * @brief Construct an empty map partitioned by key range. With k distinct splitters s0 < s1 < ... there are
+ *        k + 1 shards: the keys less than s0, the keys in [s0, s1), ..., the keys from the last splitter up.
+ *
+ * @param splitters - keys where the shards start, any order, duplicates are dropped
+ * @param comp - key comparator
+ * @param alloc - allocator for the shards' node pools
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename COMPARE, typename HASH, typename ALLOCATOR, typename TRAITS >
+CS280::ShardedAVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,HASH,ALLOCATOR,TRAITS>::ShardedAVLmap(std::vector<KEY_TYPE> splitters, COMPARE const& comp, ALLOCATOR const& alloc)
+    : mCount(0), mSplitters(std::move(splitters)), mRanged(true), mCompare(comp), mHash(), mAlloc(alloc)
+{
+    std::sort(mSplitters.begin(), mSplitters.end(), mCompare);
+    mSplitters.erase(std::unique(mSplitters.begin(), mSplitters.end(), [this](KEY_TYPE const& a, KEY_TYPE const& b)
+    {
+        return !mCompare(a, b);
+    }), mSplitters.end());
+
+    InitShards(mSplitters.size() + 1);
+}
+
+/**
+ * @brief Destructor. The shards free their trees.
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename COMPARE, typename HASH, typename ALLOCATOR, typename TRAITS >
+CS280::ShardedAVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,HASH,ALLOCATOR,TRAITS>::~ShardedAVLmap()
+{
+
+}
+
+/**
+ * @brief Returns the number of nodes in all shards. The shards are read one after the other without
+ *        their locks, so with writes running the sum is only close.
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename COMPARE, typename HASH, typename ALLOCATOR, typename TRAITS >
+unsigned int CS280::ShardedAVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,HASH,ALLOCATOR,TRAITS>::size() const
+{
+    unsigned int total = 0;
+
+    for(std::size_t shard = 0; shard < mCount; ++shard)
+    {
+        total += mShards[shard].size.load(std::memory_order_relaxed);
+    }
+
+    return total;
+}
+
+/**
+ * @brief Returns the number of shards
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename COMPARE, typename HASH, typename ALLOCATOR, typename TRAITS >
+unsigned int CS280::ShardedAVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,HASH,ALLOCATOR,TRAITS>::shards() const
+{
+    return static_cast<unsigned int>(mCount);
+}
+
+/**
+ * @brief Returns whether the keys are partitioned by key range (otherwise by hash)
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename COMPARE, typename HASH, typename ALLOCATOR, typename TRAITS >
+bool CS280::ShardedAVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,HASH,ALLOCATOR,TRAITS>::ranged() const
+{
+    return mRanged;
+}
+
+/**
+ * @brief Returns the comparator that orders the keys
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename COMPARE, typename HASH, typename ALLOCATOR, typename TRAITS >
+COMPARE CS280::ShardedAVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,HASH,ALLOCATOR,TRAITS>::key_comp() const
+{
+    return mCompare;
+}
+
+/**
+ * @brief Checks whether the key is in the map
+ *
+ * @param key - key to find
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename COMPARE, typename HASH, typename ALLOCATOR, typename TRAITS >
+bool CS280::ShardedAVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,HASH,ALLOCATOR,TRAITS>::contains(KEY_TYPE const& key) const
+{
+    Shard& shard = mShards[ShardOf(key)];
+    std::lock_guard<std::mutex> lock(shard.lock);
+
+    return shard.map.find(key) != shard.map.end();
+}
+
+/**
+ * @brief Copies the value of the key out of the map
+ *
+ * @param key - key to find
+ * @param value - set to the value of the key, unchanged if the key is missing
+ * @return whether the key was found
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename COMPARE, typename HASH, typename ALLOCATOR, typename TRAITS >
+bool CS280::ShardedAVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,HASH,ALLOCATOR,TRAITS>::get(KEY_TYPE const& key, VALUE_TYPE& value) const
+{
+    Shard& shard = mShards[ShardOf(key)];
+    std::lock_guard<std::mutex> lock(shard.lock);
+
+    auto it = shard.map.find(key);
+
+    if(it == shard.map.end())
+        return false;
+
+    value = it->Value();
+    return true;
+}
+
+/**
+ * @brief Calls a function with the value of the key while its shard is locked, so it can change
+ *        the value in place (it must not keep a reference to it, or use the map).
+ *
+ * @param key - key to find
+ * @param f - called as f(value) with a VALUE_TYPE&
+ * @return whether the key was found
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename COMPARE, typename HASH, typename ALLOCATOR, typename TRAITS >
+template< typename FUNC >
+bool CS280::ShardedAVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,HASH,ALLOCATOR,TRAITS>::visit(KEY_TYPE const& key, FUNC&& f)
+{
+    Shard& shard = mShards[ShardOf(key)];
+    std::lock_guard<std::mutex> lock(shard.lock);
+
+    auto it = shard.map.find(key);
+
+    if(it == shard.map.end())
+        return false;
+
+    f(it->Value());
+    return true;
+}
+
+/**
+ * @brief Calls a function with the value of the key while its shard is locked (see the non-const visit)
+ *
+ * @param key - key to find
+ * @param f - called as f(value) with a VALUE_TYPE const&
+ * @return whether the key was found
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename COMPARE, typename HASH, typename ALLOCATOR, typename TRAITS >
+template< typename FUNC >
+bool CS280::ShardedAVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,HASH,ALLOCATOR,TRAITS>::visit(KEY_TYPE const& key, FUNC&& f) const
+{
+    Shard& shard = mShards[ShardOf(key)];
+    std::lock_guard<std::mutex> lock(shard.lock);
+
+    auto it = shard.map.find(key);
+
+    if(it == shard.map.end())
+        return false;
+
+    f(static_cast<VALUE_TYPE const&>(it->Value()));
+    return true;
+}
+
+/**
+ * @brief Inserts a copy of the pair if its key is not in the map yet.
+ *
+ * @param item - key and value to insert
+ * @return whether it was inserted
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename COMPARE, typename HASH, typename ALLOCATOR, typename TRAITS >
+bool CS280::ShardedAVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,HASH,ALLOCATOR,TRAITS>::insert(value_type const& item)
+{
+    return try_emplace(item.first, item.second);
+}
+
+/**
+ * @brief Builds the value from args only if the key is missing.
+ *
+ * @param key - key to insert
+ * @param args - value constructor arguments
+ * @return whether it was inserted
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename COMPARE, typename HASH, typename ALLOCATOR, typename TRAITS >
+template< typename... ARGS >
+bool CS280::ShardedAVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,HASH,ALLOCATOR,TRAITS>::try_emplace(KEY_TYPE const& key, ARGS&&... args)
+{
+    Shard& shard = mShards[ShardOf(key)];
+    std::lock_guard<std::mutex> lock(shard.lock);
+
+    bool inserted = shard.map.try_emplace(key, std::forward<ARGS>(args)...).second;
+
+    shard.size.store(shard.map.size(), std::memory_order_relaxed);
+
+    return inserted;
+}
+
+/**
+ * @brief Inserts the key with the value, or gives the key the value if it is already there.
+ *
+ * @param key - key to insert or assign
+ * @param obj - value
+ * @return true if the key was inserted, false if it was assigned
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename COMPARE, typename HASH, typename ALLOCATOR, typename TRAITS >
+template< typename M >
+bool CS280::ShardedAVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,HASH,ALLOCATOR,TRAITS>::insert_or_assign(KEY_TYPE const& key, M&& obj)
+{
+    Shard& shard = mShards[ShardOf(key)];
+    std::lock_guard<std::mutex> lock(shard.lock);
+
+    bool inserted = shard.map.insert_or_assign(key, std::forward<M>(obj)).second;
+
+    shard.size.store(shard.map.size(), std::memory_order_relaxed);
+
+    return inserted;
+}
+
+/**
+ * @brief Erases the node with the given key, if there is one.
+ *
+ * @param key - key to erase
+ * @return the number of nodes erased (0 or 1)
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename COMPARE, typename HASH, typename ALLOCATOR, typename TRAITS >
+unsigned int CS280::ShardedAVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,HASH,ALLOCATOR,TRAITS>::erase(KEY_TYPE const& key)
+{
+    Shard& shard = mShards[ShardOf(key)];
+    std::lock_guard<std::mutex> lock(shard.lock);
+
+    unsigned int erased = shard.map.erase(key);
+
+    shard.size.store(shard.map.size(), std::memory_order_relaxed);
+
+    return erased;
+}
+
+/**
+ * @brief Erases every node, one shard at a time. Each shard's pool is released whole.
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename COMPARE, typename HASH, typename ALLOCATOR, typename TRAITS >
+void CS280::ShardedAVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,HASH,ALLOCATOR,TRAITS>::clear()
+{
+    for(std::size_t index = 0; index < mCount; ++index)
+    {
+        Shard& shard = mShards[index];
+        std::lock_guard<std::mutex> lock(shard.lock);
+
+        shard.map = shard_type(mCompare, mAlloc);
+        shard.size.store(0, std::memory_order_relaxed);
+    }
+}
+
+/**
+ * @brief Calls a function for every node, holding one shard's lock at a time.
+ *
+ * @param f - called as f(key, value)
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename COMPARE, typename HASH, typename ALLOCATOR, typename TRAITS >
+template< typename FUNC >
+void CS280::ShardedAVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,HASH,ALLOCATOR,TRAITS>::for_each(FUNC&& f) const
+{
+    for(std::size_t index = 0; index < mCount; ++index)
+    {
+        Shard& shard = mShards[index];
+        std::lock_guard<std::mutex> lock(shard.lock);
+
+        for(Node const& node : static_cast<shard_type const&>(shard.map))
+        {
+            f(node.Key(), node.Value());
+        }
+    }
+}
+
+/**
+ * @brief Locks every shard and returns a view to iterate over them in key order
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename COMPARE, typename HASH, typename ALLOCATOR, typename TRAITS >
+typename CS280::ShardedAVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,HASH,ALLOCATOR,TRAITS>::view_type CS280::ShardedAVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,HASH,ALLOCATOR,TRAITS>::view() const
+{
+    return ShardedAVLmap_view(*this);
+}
+
+/**
+ * @brief Checks every shard, holding one shard's lock at a time: its tree is a valid AVLmap (see AVLmap::sanityCheck),
+ *        each of its keys belongs to it and its published size is the tree's. O(n).
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename COMPARE, typename HASH, typename ALLOCATOR, typename TRAITS >
+bool CS280::ShardedAVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,HASH,ALLOCATOR,TRAITS>::sanityCheck() const
+{
+    for(std::size_t index = 0; index < mCount; ++index)
+    {
+        Shard& shard = mShards[index];
+        std::lock_guard<std::mutex> lock(shard.lock);
+
+        if(!shard.map.sanityCheck() || shard.size.load(std::memory_order_relaxed) != shard.map.size())
+            return false;
+
+        for(Node const& node : static_cast<shard_type const&>(shard.map))
+        {
+            if(ShardOf(node.Key()) != index)
+                return false;
+        }
+    }
+
+    return true;
+}
+
+/**
+ * @brief Returns the shard a key belongs to. By key range it is the number of splitters not greater than the key,
+ *        by hash the hash is mixed with a multiplicative (Fibonacci) hash first, since hashes like std::hash<int>
+ *        are the identity and strided keys would pile up in a few shards.
+ *
+ * @param key - key to place
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename COMPARE, typename HASH, typename ALLOCATOR, typename TRAITS >
+std::size_t CS280::ShardedAVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,HASH,ALLOCATOR,TRAITS>::ShardOf(KEY_TYPE const& key) const
+{
+    if(mRanged)
+        return static_cast<std::size_t>(std::upper_bound(mSplitters.begin(), mSplitters.end(), key, mCompare) - mSplitters.begin());
+
+    std::uint64_t mixed = static_cast<std::uint64_t>(mHash(key)) * 0x9E3779B97F4A7C15ull;
+
+    return static_cast<std::size_t>((mixed >> 32) % mCount);
+}
+
+/**
+ * @brief Makes the shards, each with an empty map using the map's comparator and allocator
+ *
+ * @param count - number of shards
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename COMPARE, typename HASH, typename ALLOCATOR, typename TRAITS >
+void CS280::ShardedAVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,HASH,ALLOCATOR,TRAITS>::InitShards(std::size_t count)
+{
+    mShards.reset(new Shard[count]);
+    mCount = count;
+
+    for(std::size_t index = 0; index < count; ++index)
+    {
+        mShards[index].map = shard_type(mCompare, mAlloc);
+        mShards[index].size.store(0, std::memory_order_relaxed);
+    }
+}
+
+/**
+ * @brief Locks every shard, in shard order
+ *
+ * @param map - map to lock
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename COMPARE, typename HASH, typename ALLOCATOR, typename TRAITS >
+CS280::ShardedAVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,HASH,ALLOCATOR,TRAITS>::ShardedAVLmap_view::ShardedAVLmap_view(ShardedAVLmap const& map) : mMap(&map)
+{
+    mLocks.reserve(map.mCount);
+
+    for(std::size_t index = 0; index < map.mCount; ++index)
+    {
+        mLocks.emplace_back(map.mShards[index].lock);
+    }
+}
+
+/**
+ * @brief Returns an iterator to the smallest key of all shards
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename COMPARE, typename HASH, typename ALLOCATOR, typename TRAITS >
+typename CS280::ShardedAVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,HASH,ALLOCATOR,TRAITS>::ShardedAVLmap_iterator CS280::ShardedAVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,HASH,ALLOCATOR,TRAITS>::ShardedAVLmap_view::begin() const
+{
+    ShardedAVLmap_iterator it;
+
+    it.mMap = mMap;
+    it.mCursors.reserve(mMap->mCount);
+
+    for(std::size_t index = 0; index < mMap->mCount; ++index)
+    {
+        shard_type const& shard = mMap->mShards[index].map;
+
+        it.mCursors.emplace_back(shard.begin(), shard.end());
+    }
+
+    it.Settle();
+
+    return it;
+}
+
+/**
+ * @brief Returns the end iterator
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename COMPARE, typename HASH, typename ALLOCATOR, typename TRAITS >
+typename CS280::ShardedAVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,HASH,ALLOCATOR,TRAITS>::ShardedAVLmap_iterator CS280::ShardedAVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,HASH,ALLOCATOR,TRAITS>::ShardedAVLmap_view::end() const
+{
+    return ShardedAVLmap_iterator();
+}
+
+/**
+ * @brief Returns the number of nodes in all shards, exact since no shard can change
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename COMPARE, typename HASH, typename ALLOCATOR, typename TRAITS >
+unsigned int CS280::ShardedAVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,HASH,ALLOCATOR,TRAITS>::ShardedAVLmap_view::size() const
+{
+    return mMap->size();
+}
+
+/**
+ * @brief Constructs the end iterator
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename COMPARE, typename HASH, typename ALLOCATOR, typename TRAITS >
+CS280::ShardedAVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,HASH,ALLOCATOR,TRAITS>::ShardedAVLmap_iterator::ShardedAVLmap_iterator() : mCurrent(0), mMap(nullptr)
+{
+
+}
+
+/**
+ * @brief Pre-increment. A key range shard is followed to its end before the next one starts, hash shards
+ *        are merged by picking the smallest next key of all of them, O(shards) per step.
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename COMPARE, typename HASH, typename ALLOCATOR, typename TRAITS >
+typename CS280::ShardedAVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,HASH,ALLOCATOR,TRAITS>::ShardedAVLmap_iterator& CS280::ShardedAVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,HASH,ALLOCATOR,TRAITS>::ShardedAVLmap_iterator::operator++()
+{
+    ++mCursors[mCurrent].first;
+
+    Settle();
+
+    return *this;
+}
+
+/**
+ * @brief Post-increment (copies the cursors of every shard, prefer pre-increment)
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename COMPARE, typename HASH, typename ALLOCATOR, typename TRAITS >
+typename CS280::ShardedAVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,HASH,ALLOCATOR,TRAITS>::ShardedAVLmap_iterator CS280::ShardedAVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,HASH,ALLOCATOR,TRAITS>::ShardedAVLmap_iterator::operator++(int)
+{
+    ShardedAVLmap_iterator previous(*this);
+
+    ++(*this);
+
+    return previous;
+}
+
+/**
+ * @brief Dereferences to the current node
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename COMPARE, typename HASH, typename ALLOCATOR, typename TRAITS >
+typename CS280::ShardedAVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,HASH,ALLOCATOR,TRAITS>::Node const& CS280::ShardedAVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,HASH,ALLOCATOR,TRAITS>::ShardedAVLmap_iterator::operator*() const
+{
+    return *mCursors[mCurrent].first;
+}
+
+/**
+ * @brief Accesses the current node's members
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename COMPARE, typename HASH, typename ALLOCATOR, typename TRAITS >
+typename CS280::ShardedAVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,HASH,ALLOCATOR,TRAITS>::Node const* CS280::ShardedAVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,HASH,ALLOCATOR,TRAITS>::ShardedAVLmap_iterator::operator->() const
+{
+    return &*mCursors[mCurrent].first;
+}
+
+/**
+ * @brief Checks whether two iterators are on different nodes
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename COMPARE, typename HASH, typename ALLOCATOR, typename TRAITS >
+bool CS280::ShardedAVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,HASH,ALLOCATOR,TRAITS>::ShardedAVLmap_iterator::operator!=(const ShardedAVLmap_iterator& rhs) const
+{
+    return !(*this == rhs);
+}
+
+/**
+ * @brief Checks whether two iterators are on the same node, every end iterator is equal
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename COMPARE, typename HASH, typename ALLOCATOR, typename TRAITS >
+bool CS280::ShardedAVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,HASH,ALLOCATOR,TRAITS>::ShardedAVLmap_iterator::operator==(const ShardedAVLmap_iterator& rhs) const
+{
+    bool atEnd = mCurrent == mCursors.size();
+    bool rhsAtEnd = rhs.mCurrent == rhs.mCursors.size();
+
+    if(atEnd || rhsAtEnd)
+        return atEnd == rhsAtEnd;
+
+    return mCurrent == rhs.mCurrent && mCursors[mCurrent].first == rhs.mCursors[mCurrent].first;
+}
+
+/**
+ * @brief Moves to the shard holding the next node: for key ranges the first shard from the current one that
+ *        has nodes left, for hash shards the one whose next key is smallest (the first of them on a tie).
+ */
+template< typename KEY_TYPE, typename VALUE_TYPE, typename COMPARE, typename HASH, typename ALLOCATOR, typename TRAITS >
+void CS280::ShardedAVLmap<KEY_TYPE,VALUE_TYPE,COMPARE,HASH,ALLOCATOR,TRAITS>::ShardedAVLmap_iterator::Settle()
+{
+    if(mMap->mRanged)
+    {
+        while(mCurrent < mCursors.size() && mCursors[mCurrent].first == mCursors[mCurrent].second)
+        {
+            ++mCurrent;
+        }
+
+        return;
+    }
+
+    mCurrent = mCursors.size();
+
+    for(std::size_t index = 0; index < mCursors.size(); ++index)
+    {
+        if(mCursors[index].first == mCursors[index].second)
+            continue;
+
+        if(mCurrent == mCursors.size() || mMap->mCompare(mCursors[index].first->Key(), mCursors[mCurrent].first->Key()))
+            mCurrent = index;
+    }
+}
@@ -0,0 +1,154 @@
+/**
+ * @file sharded-avl-map.h
+ * @brief A map for many writing threads: the keys are partitioned over a number of AVLmap shards, each behind
+ *        its own lock on its own cache lines, so threads writing different shards never wait for each other.
+ *        Keys go to a shard by hash (even spread for point lookups and updates) or by key range (the shards
+ *        hold consecutive key ranges, so a walk over the shards in order is a walk over the keys in order).
+ */
+
+#ifndef SHARDED_AVLMAP_H
+#define SHARDED_AVLMAP_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <iterator>
+#include <memory>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+#include "avl-map.h"
+
+namespace CS280 {
+
+    // COMPARE orders the keys within a shard (and picks a key range's shard), HASH picks a key's shard otherwise
+    // ALLOCATOR and TRAITS are passed on to the shards' AVLmaps
+    template< typename KEY_TYPE, typename VALUE_TYPE, typename COMPARE = std::less<KEY_TYPE>, typename HASH = std::hash<KEY_TYPE>,
+              typename ALLOCATOR = std::allocator< std::pair<const KEY_TYPE, VALUE_TYPE> >, typename TRAITS = AVLmap_traits >
+    class ShardedAVLmap {
+		public:
+			typedef AVLmap<KEY_TYPE, VALUE_TYPE, COMPARE, ALLOCATOR, TRAITS> shard_type;
+			typedef typename shard_type::Node Node;
+
+		private:
+
+			// a shard starts on a cache line and fills whole ones, so no two locks (or maps) share a line
+			struct alignas(64) Shard
+			{
+				std::mutex                  lock;
+				shard_type                  map;
+				std::atomic<unsigned int>   size; // map's size, readable without the lock
+			};
+
+			// walks the nodes of every shard: in key order, merging the shards unless they hold key ranges
+			struct ShardedAVLmap_iterator
+			{
+				private:
+					typedef typename shard_type::const_iterator shard_iterator;
+
+					std::vector< std::pair<shard_iterator, shard_iterator> > mCursors; // next node and end of each shard
+					std::size_t     mCurrent; // shard of the current node, mCursors.size() at end
+					ShardedAVLmap const* mMap;
+				public:
+					typedef std::forward_iterator_tag iterator_category;
+					typedef Node                      value_type;
+					typedef std::ptrdiff_t            difference_type;
+					typedef Node const*               pointer;
+					typedef Node const&               reference;
+
+					ShardedAVLmap_iterator();
+					ShardedAVLmap_iterator& operator++();
+					ShardedAVLmap_iterator operator++(int);
+					Node const& operator*() const;
+					Node const* operator->() const;
+					bool operator!=(const ShardedAVLmap_iterator& rhs) const;
+					bool operator==(const ShardedAVLmap_iterator& rhs) const;
+					friend class ShardedAVLmap;
+				private:
+					void Settle();
+			};
+
+			// holds every shard's lock, taken in shard order like all multi-shard operations so they can't deadlock
+			class ShardedAVLmap_view
+			{
+				public:
+					ShardedAVLmap_view(ShardedAVLmap_view&& rhs)            = default;
+					ShardedAVLmap_view(const ShardedAVLmap_view&)           = delete;
+					ShardedAVLmap_view& operator=(const ShardedAVLmap_view&) = delete;
+
+					ShardedAVLmap_iterator begin() const;
+					ShardedAVLmap_iterator end() const;
+					unsigned int size() const;
+				private:
+					explicit ShardedAVLmap_view(ShardedAVLmap const& map);
+
+					ShardedAVLmap const*                        mMap;
+					std::vector< std::unique_lock<std::mutex> > mLocks;
+					friend class ShardedAVLmap;
+			};
+
+			static constexpr unsigned int SHARDS_PER_THREAD = 4; // default shards per hardware thread
+
+			// ShardedAVLmap implementation
+			std::unique_ptr<Shard[]>    mShards;
+			std::size_t                 mCount; // number of shards
+			std::vector<KEY_TYPE>       mSplitters; // shard i holds the keys in [mSplitters[i - 1], mSplitters[i])
+			bool                        mRanged; // partitioned by key range rather than by hash
+			COMPARE                     mCompare;
+			HASH                        mHash;
+			ALLOCATOR                   mAlloc;
+
+		public:
+			//partitioned by hash into the given number of shards, 0 for SHARDS_PER_THREAD per hardware thread
+			explicit ShardedAVLmap(unsigned int shards = 0, COMPARE const& comp = COMPARE(), HASH const& hash = HASH(),
+			                       ALLOCATOR const& alloc = ALLOCATOR());
+			//partitioned by key range, one shard more than there are (distinct) splitters, which can come in any order
+			explicit ShardedAVLmap(std::vector<KEY_TYPE> splitters, COMPARE const& comp = COMPARE(), ALLOCATOR const& alloc = ALLOCATOR());
+			ShardedAVLmap(const ShardedAVLmap&)               = delete;
+			ShardedAVLmap& operator=(const ShardedAVLmap&)    = delete;
+			~ShardedAVLmap(); // no thread may still be using the map
+
+			typedef std::pair<KEY_TYPE, VALUE_TYPE> value_type;
+			typedef ShardedAVLmap_iterator          const_iterator;
+			typedef ShardedAVLmap_view              view_type;
+
+			unsigned int size() const; // sum of the shards' sizes, exact when no write is running
+			unsigned int shards() const;
+			bool ranged() const;
+			COMPARE key_comp() const;
+
+			//every operation on one key locks only that key's shard, safe to call from any number of threads at once
+			bool contains(KEY_TYPE const& key) const;
+			bool get(KEY_TYPE const& key, VALUE_TYPE& value) const; // copies the value out, false if the key is missing
+			//calls f(value) holding the shard's lock, so f can read or change the value in place, false if the key is missing
+			template< typename FUNC >
+			bool visit(KEY_TYPE const& key, FUNC&& f);
+			template< typename FUNC >
+			bool visit(KEY_TYPE const& key, FUNC&& f) const;
+			bool insert(value_type const& item); // false if the key is already there
+			template< typename... ARGS >
+			bool try_emplace(KEY_TYPE const& key, ARGS&&... args); // value is only built if the key is missing
+			template< typename M >
+			bool insert_or_assign(KEY_TYPE const& key, M&& obj); // true if the key was inserted, false if assigned
+			unsigned int erase(KEY_TYPE const& key); // returns the number of nodes erased
+			void clear(); // one shard at a time
+
+			//calls f(key, value) for every node, locking one shard at a time: every shard is seen consistently but
+			//writes to later shards can land meanwhile. Key ranges are walked in key order, hash shards shard by shard.
+			template< typename FUNC >
+			void for_each(FUNC&& f) const;
+			//locks every shard for as long as the view lives, writers wait. Its iterators walk a consistent
+			//snapshot in key order: range shards one after the other, hash shards merged by key.
+			view_type view() const;
+
+			bool sanityCheck() const; // every shard is a valid AVLmap, holds only its own keys and has the size it says
+		private:
+			std::size_t ShardOf(KEY_TYPE const& key) const;
+			void InitShards(std::size_t count);
+	};
+}
+
+#include "sharded-avl-map.cpp"
+#endif